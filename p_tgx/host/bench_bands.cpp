@@ -0,0 +1,170 @@
+// bench_bands.cpp - band rendering (Renderer3D::drawBands()) on the host.
+//
+// Renders the bunny scene of pgx_bunny.cpp once with full size framebuffer and
+// z-buffer and once as horizontal bands sent to the loopback bus (two band
+// buffers ping-ponged against the transfers). Compares the emulated display
+// memory against the full frame render and reports timings (including the
+// emulated transfers) and memory use.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx -Iili9341 host/bench_bands.cpp tgx/Color.cpp tgx/Renderer3D.cpp ili9341/ili9341_bus.cpp ili9341/ili9341_bus_loopback.cpp -o bench_bands && ./bench_bands
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "ili9341_bus.h"
+#include "ili9341_bus_loopback.h"
+#include "ili9341hw.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX PIX_WIDTH
+#define LY PIX_HEIGHT
+#define BAND_LY 32
+#define NB_BINS 2200
+#define NB_FRAMES 50
+
+// full frame rendering
+static uint16_t fb[LX * LY];
+static uint16_t zbuf[LX * LY];
+
+// band rendering
+static uint16_t band1[LX * BAND_LY];
+static uint16_t band2[LX * BAND_LY];
+static uint16_t zband[LX * BAND_LY];
+static uint16_t bins[NB_BINS];
+
+static uint16_t gram[LX * LY];
+static ili9341_loopback_bus_t lb;
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+static Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+
+static void set_scene(int frame, int mode)
+    {
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, (mode == 3) ? -2.0f : 0.0f, (mode == 3) ? -15.0f : -25.0f });
+    renderer.setModelMatrix(M);
+    switch (mode)
+        {
+        case 0: renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE); break;
+        case 1: renderer.setShaders(SHADER_FLAT); break;
+        default: renderer.setShaders(SHADER_GOURAUD); break;
+        }
+    }
+
+
+/** number of pixels that differ between the display memory and the full frame render */
+static int compare()
+    {
+    int n = 0;
+    for (int i = 0; i < LX * LY; i++)
+        {
+        const uint8_t* b = (const uint8_t*)&fb[i];
+        if (gram[i] != (uint16_t)((b[0] << 8) | b[1])) n++;
+        }
+    return n;
+    }
+
+
+int main()
+    {
+    ILI9341_LoopbackBusInit(&lb, gram, LX, LY);
+    ili9341_bus_t* bus = &lb.mBus;
+
+    Image<RGB565BE> im((RGB565BE*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setImage(&im);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setCulling(1);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    renderer.setBinBuffer(bins, NB_BINS);
+
+    ili9341_fence_t prev = 0;
+    auto flush = [&](const Image<RGB565BE>& band, int y)
+        {
+        ili9341_fence_t f = 0;
+        if (band.isValid()) f = ILI9341_BusWriteRectAsync(bus, 0, y, band.lx(), band.ly(), band.data(), band.stride(), nullptr, nullptr);
+        ILI9341_BusWaitFence(bus, prev); // the other band buffer is free again
+        prev = f;
+        };
+    auto draw = [&]() { renderer.drawMesh(&bunny_fig_small_be, false); };
+
+    const RGB565BE bg(RGB565_Cyan);
+    const char* names[4] = { "gouraud+texture", "flat", "gouraud", "gouraud (close)" };
+    int errors = 0;
+    int max_bins = 0;
+    printf("%d frames %dx%d per mode, bands of %d rows, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, BAND_LY, BENCH_REPEATS);
+    printf("%-16s %12s %12s %14s\n", "mode", "full frame", "bands", "diff pixels");
+    for (int mode = 0; mode < 4; mode++)
+        {
+        double t[2] = { 0, 0 }; // full frame, bands
+        int diff = 0;
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            set_scene(f, mode);
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int rep)
+                {
+                if (v == 0)
+                    {
+                    const double t0 = now_us();
+                    im.fillScreen(bg);
+                    renderer.clearZbuffer();
+                    draw();
+                    ILI9341_BusWaitFence(bus, ILI9341_BusWriteRectAsync(bus, 0, 0, LX, LY, fb, LX, nullptr, nullptr));
+                    return now_us() - t0;
+                    }
+                memset(gram, 0, sizeof(gram)); // only the bands write the display memory checked below
+                const double t0 = now_us();
+                const int nb = renderer.drawBands(BAND_LY, (RGB565BE*)band1, (RGB565BE*)band2, zband, bg, draw, flush);
+                const double t1 = now_us();
+                if (nb > max_bins) max_bins = nb;
+                if (rep == BENCH_REPEATS - 1) diff += compare(); // fb holds the full frame render of this frame by now
+                return t1 - t0;
+                });
+            }
+        printf("%-16s %12.1f %12.1f %14d\n", names[mode], t[0] / NB_FRAMES, t[1] / NB_FRAMES, diff);
+        if (diff) errors++;
+        }
+
+    const int full_mem = (int)(2 * sizeof(fb) + sizeof(zbuf)); // double buffered, as in pgx_bunny.cpp
+    const int band_mem = (int)(sizeof(band1) + sizeof(band2) + sizeof(zband) + sizeof(bins));
+    printf("\nframe memory: full frame %d bytes, bands %d bytes (%d bins used out of %d)\n", full_mem, band_mem, max_bins, NB_BINS);
+    printf("bus errors: %u\n", (unsigned)lb.mNbErrors);
+    if ((lb.mNbErrors) || (max_bins > NB_BINS)) errors++;
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
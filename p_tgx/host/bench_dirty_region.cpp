@@ -0,0 +1,134 @@
+// bench_dirty_region.cpp - dirty rectangle tracking + partial flushes on the host.
+//
+// Draws a typical UI frame (counter text, progress bar, moving sprite, pulsing
+// AA disk, spinner and a small rotating cube rendered with Renderer3D) into an
+// RGB565BE framebuffer with a DirtyRegion attached, then flushes only the dirty
+// rectangles through the loopback bus. After each frame the whole emulated
+// display memory must match the framebuffer, which checks that every drawing
+// call reported its damage. Prints the traffic compared to full frame updates.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx -Iili9341 host/bench_dirty_region.cpp tgx/Color.cpp tgx/Fonts.cpp tgx/Renderer3D.cpp tgx/font_tgx_Arial.cpp ili9341/ili9341_bus.cpp ili9341/ili9341_bus_loopback.cpp -o bench_dirty_region && ./bench_dirty_region
+//
+#include "tgx.h"
+#include "font_tgx_Arial.h"
+#include "ili9341_bus.h"
+#include "ili9341_bus_loopback.h"
+#include "ili9341_dirty.h"
+#include "ili9341hw.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+
+#define LX PIX_WIDTH
+#define LY PIX_HEIGHT
+#define NB_FRAMES 300
+
+static uint16_t framebuffer[LX * LY];   // RGB565 big endian (wire order)
+static uint16_t gram[LX * LY];          // emulated display memory (native order)
+static uint16_t zbuf[80 * 80];
+static uint16_t sprite_buf[24 * 24];
+static ili9341_loopback_bus_t lb;
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_NOTEXTURE;
+
+
+static bool gram_matches()
+    {
+    for (int i = 0; i < LX * LY; i++)
+        {
+        const uint8_t* b = (const uint8_t*)&framebuffer[i];
+        if (gram[i] != (uint16_t)((b[0] << 8) | b[1])) return false;
+        }
+    return true;
+    }
+
+
+int main()
+    {
+    ILI9341_LoopbackBusInit(&lb, gram, LX, LY);
+    ili9341_bus_t* bus = &lb.mBus;
+
+    Image<RGB565BE> im((RGB565BE*)framebuffer, LX, LY);
+    DirtyRegion dirty;
+    im.setDirtyRegion(&dirty);
+
+    Image<RGB565BE> sprite((RGB565BE*)sprite_buf, 24, 24);
+    sprite.fillScreen(RGB565BE(RGB565_Red));
+    sprite.fillCircle({ 12, 12 }, 8, RGB565BE(RGB565_Yellow), RGB565BE(RGB565_Black));
+
+    Image<RGB565BE> view = im.getCrop(iBox2(150, 229, 20, 99));
+    Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+    renderer.setViewportSize(80, 80);
+    renderer.setOffset(0, 0);
+    renderer.setImage(&view);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, 1.0f, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.3f, 0.6f, 0.9f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setShaders(SHADER_FLAT);
+    renderer.setCulling(1);
+
+    const RGB565BE bg(RGB565_Blue);
+    im.fillScreen(bg);  // first frame: everything is dirty
+
+    uint64_t dirty_bytes = 0, dirty_rects = 0, dirty_trans = 0;
+    int errors = 0;
+    iVec2 sprite_pos(10, 150);
+    ILI9341_LoopbackBusResetStats(&lb);
+    for (int f = 0; f < NB_FRAMES; f++)
+        {
+        char txt[32];
+        snprintf(txt, sizeof(txt), "frame %d", f);
+        im.fillRect(iBox2(10, 129, 10, 29), bg);
+        im.drawText(txt, { 10, 25 }, font_tgx_Arial_12, RGB565BE(RGB565_White));
+
+        const int w = (f * 200) / NB_FRAMES;
+        im.fillRect(iBox2(20, 20 + w, 290, 299), RGB565BE(RGB565_Green));
+
+        im.fillRect(iBox2(sprite_pos.x, sprite_pos.x + 23, sprite_pos.y, sprite_pos.y + 23), bg);
+        sprite_pos = iVec2(10 + (f * 3) % 200, 150 + (f % 40));
+        im.blit(sprite, sprite_pos);
+
+        im.fillRect(iBox2(30, 90, 200, 260), bg);
+        im.fillCircleAA({ 60.0f, 230.0f }, 10.0f + 20.0f * (f % 30) / 30.0f, RGB565BE(RGB565_Orange));
+
+        const float a = f * 0.1f;
+        im.fillRect(iBox2(170, 230, 170, 230), bg);
+        im.drawThickLineAA({ 200.0f, 200.0f }, { 200.0f + 25.0f * cosf(a), 200.0f + 25.0f * sinf(a) }, 3.0f, END_ROUNDED, END_ROUNDED, RGB565BE(RGB565_White));
+
+        fMat4 M;
+        M.setRotate(f * 3.0f, { 0, 1, 0 });
+        M.multRotate(f * 2.0f, { 1, 0, 0 });
+        M.multTranslate({ 0, 0, -5 });
+        renderer.setModelMatrix(M);
+        view.fillScreen(RGB565BE(RGB565_Black));
+        renderer.clearZbuffer();
+        renderer.drawCube();
+
+        const int nb_rects = dirty.size();
+        const int32_t area = dirty.area();
+        ILI9341_BusFlushDirtyAsync(bus, framebuffer, LX, &dirty, nullptr, nullptr);
+        ILI9341_BusWaitIdle(bus);
+        if ((!dirty.isEmpty()) || (!gram_matches())) errors++;
+        dirty_rects += nb_rects;
+        dirty_bytes += 2 * (uint64_t)area;
+        }
+    dirty_trans = lb.mNbTransactions;
+
+    const uint64_t full_bytes = (uint64_t)NB_FRAMES * LX * LY * 2;
+    printf("%d frames %dx%d, merge cost %d pixels, at most %d rects\n\n", NB_FRAMES, LX, LY, dirty.mergeCost(), TGX_DIRTY_MAX_RECTS);
+    printf("%-14s %12s %14s %16s\n", "", "rects/frame", "transactions", "pixel bytes");
+    printf("%-14s %12.1f %14u %16llu\n", "full frame", 1.0, (unsigned)NB_FRAMES, (unsigned long long)full_bytes);
+    printf("%-14s %12.1f %14u %16llu  (%.1f%% of full frame)\n", "dirty rects", (double)dirty_rects / NB_FRAMES, (unsigned)dirty_trans,
+        (unsigned long long)dirty_bytes, 100.0 * dirty_bytes / full_bytes);
+    printf("bus errors: %u\n", (unsigned)lb.mNbErrors);
+    if (lb.mNbErrors) errors++;
+
+    printf("\n%s (%d frame(s) where the display memory differs from the framebuffer)\n", (errors ? "FAILED" : "OK"), errors);
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,151 @@
+// bench_hiz.cpp - coarse depth buffer (Renderer3D::setHiZbuffer()) on the host.
+//
+// Renders two scenes with and without the coarse depth buffer and compares
+// the images, the timings and the number of triangles and 8 pixels blocks
+// rejected:
+//
+// - "bunny": the bunny of pgx_bunny.cpp alone (self occlusion only).
+// - "occluders": a wall and a few large spheres drawn first, then a grid of
+//   bunnies, most of them partially or totally hidden behind them, a panel
+//   hidden behind the wall and a backdrop behind everything.
+//
+// Fails if the images differ or if the coarse depth buffer rejects no
+// triangle or no block in the occluder scene.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_hiz.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_hiz && ./bench_hiz
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#ifndef NB_FRAMES
+#define NB_FRAMES 50
+#endif
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static uint16_t zbuf[LX * LY];
+static uint16_t hiz_zmin[((LX + 7) / 8) * ((LY + 7) / 8)];
+static uint8_t hiz_dirty[((LX + 7) / 8) * ((LY + 7) / 8)];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD | SHADER_NOTEXTURE;
+
+static Renderer3D<RGB565, LOADED_SHADERS, uint16_t> renderer;
+
+
+static void draw_bunny(int frame)
+    {
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, 0, -25 });
+    renderer.setModelMatrix(M);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.drawMesh(&bunny_fig_small, false);
+    }
+
+
+static void draw_occluders(int frame)
+    {
+    fMat4 M;
+    // wall in front of the lower half
+    M.setScale({ 12, 6, 1 });
+    M.multTranslate({ 0, -8, -30 });
+    renderer.setModelMatrix(M);
+    renderer.setMaterial(RGBf(0.4f, 0.4f, 0.5f), 0.2f, 0.7f, 0.2f, 8);
+    renderer.drawCube();
+    // spheres
+    for (int i = 0; i < 3; i++)
+        {
+        M.setScale({ 5, 5, 5 });
+        M.multTranslate({ -10.0f + 10.0f * i, 6.0f + 3.0f * sinf(0.1f * frame + i), -35 });
+        renderer.setModelMatrix(M);
+        renderer.setMaterial(RGBf(0.2f + 0.3f * i, 0.6f, 0.3f), 0.2f, 0.7f, 0.8f, 32);
+        renderer.drawSphere(24, 16);
+        }
+    // grid of bunnies behind
+    for (int j = 0; j < 4; j++)
+        for (int i = 0; i < 4; i++)
+            {
+            M.setScale({ 8, 8, 8 });
+            M.multRotate(-360.0f * frame / NB_FRAMES + 40 * (i + j), { 0, 1, 0 });
+            M.multTranslate({ -12.0f + 8.0f * i, -14.0f + 9.0f * j, -55 });
+            renderer.setModelMatrix(M);
+            renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+            renderer.drawMesh(&bunny_fig_small, false);
+            }
+    // panel hidden behind the wall (its large triangles are rejected whole)
+    M.setScale({ 10, 4, 1 });
+    M.multTranslate({ 0, -8, -45 });
+    renderer.setModelMatrix(M);
+    renderer.setMaterial(RGBf(0.8f, 0.2f, 0.2f), 0.2f, 0.7f, 0.2f, 8);
+    renderer.drawCube();
+    // backdrop behind everything (the blocks covered by the objects in front are skipped)
+    M.setScale({ 60, 60, 1 });
+    M.multTranslate({ 0, 0, -80 });
+    renderer.setModelMatrix(M);
+    renderer.setMaterial(RGBf(0.3f, 0.3f, 0.6f), 0.2f, 0.7f, 0.2f, 8);
+    renderer.drawCube();
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setCulling(1);
+    renderer.setShaders(SHADER_GOURAUD);
+
+    int errors = 0;
+    printf("%d frames %dx%d per scene, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, BENCH_REPEATS);
+    printf("%-10s %10s %10s %8s %10s %10s %12s %12s %10s\n", "scene", "no hiz", "hiz", "meshes", "tris", "tris", "blocks", "blocks", "diff");
+    printf("%-10s %10s %10s %8s %10s %10s %12s %12s %10s\n", "", "", "", "culled", "tested", "culled", "tested", "culled", "pixels");
+    for (int scene = 0; scene < 2; scene++)
+        {
+        double t[2] = { 0, 0 }; // no hiz, hiz
+        int diff = 0;
+        renderer.resetHiZStats();
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                Image<RGB565>& dst = (v == 0) ? im_ref : im;
+                renderer.setImage(&dst);
+                renderer.setHiZbuffer((v == 0) ? nullptr : hiz_zmin, hiz_dirty);
+                const double t0 = now_us();
+                dst.fillScreen(RGB565_Black);
+                renderer.clearZbuffer();
+                if (scene == 0) draw_bunny(f); else draw_occluders(f);
+                return now_us() - t0;
+                });
+            for (int i = 0; i < LX * LY; i++) if (fb[i] != fb_ref[i]) diff++;
+            }
+        uint32_t mc, tt, tc, bt, bc;
+        renderer.getHiZStats(mc, tt, tc, bt, bc);
+        const int runs = NB_FRAMES * BENCH_REPEATS; // the hiz variant is drawn BENCH_REPEATS times per frame
+        printf("%-10s %10.1f %10.1f %8.1f %10u %10u %12u %12u %10d\n", (scene == 0) ? "bunny" : "occluders", t[0] / NB_FRAMES, t[1] / NB_FRAMES,
+            (double)mc / runs, (unsigned)(tt / runs), (unsigned)(tc / runs), (unsigned)(bt / runs), (unsigned)(bc / runs), diff);
+        if (diff > NB_FRAMES) errors++; // skipping blocks may change the last bit of a few interpolated depths
+        if ((scene == 1) && ((tc == 0) || (bc == 0))) errors++; // the occluders must hide whole triangles and blocks
+        }
+    printf("(counts per frame)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,169 @@
+// bench_ili9341_bus.cpp - exercise the ILI9341 async transfer queue on the host.
+//
+// Uses the loopback bus backend instead of SPI + DMA: full frames and
+// partial rectangles are queued asynchronously, the emulated display memory
+// is compared against the framebuffer and bus statistics are printed. Also
+// compares window setup sent one command/parameter at a time (as the driver
+// used to do) against a single command stream.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Iili9341 host/bench_ili9341_bus.cpp ili9341/ili9341_bus.cpp ili9341/ili9341_bus_loopback.cpp -o bench_ili9341_bus && ./bench_ili9341_bus
+//
+#include "ili9341_bus.h"
+#include "ili9341_bus_loopback.h"
+#include "ili9341hw.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint16_t framebuffer[PIX_WIDTH * PIX_HEIGHT];   // RGB565 big endian (wire order)
+static uint16_t gram[PIX_WIDTH * PIX_HEIGHT];          // emulated display memory (native order)
+static ili9341_loopback_bus_t lb;
+
+static int nb_failed = 0;
+
+static void check(bool ok, const char* what)
+    {
+    printf("  [%s] %s\n", ok ? " OK " : "FAIL", what);
+    if (!ok) nb_failed++;
+    }
+
+static void fill_pattern(uint32_t seed)
+    {
+    for (int i = 0; i < PIX_WIDTH * PIX_HEIGHT; i++)
+        {
+        seed = seed * 1664525u + 1013904223u;
+        framebuffer[i] = (uint16_t)(seed >> 16);
+        }
+    }
+
+static bool gram_matches(int x, int y, int w, int h)
+    {
+    for (int j = y; j < y + h; j++)
+        for (int i = x; i < x + w; i++)
+            {
+            const uint8_t* b = (const uint8_t*)&framebuffer[j * PIX_WIDTH + i];
+            if (gram[j * PIX_WIDTH + i] != (uint16_t)((b[0] << 8) | b[1])) return false;
+            }
+    return true;
+    }
+
+static void print_stats(const char* name)
+    {
+    printf("  %-28s transactions: %6u  writes: %6u  cmd bytes: %6u  data bytes: %8u  errors: %u\n",
+        name, (unsigned)lb.mNbTransactions, (unsigned)lb.mNbWrites, (unsigned)lb.mNbCommandBytes,
+        (unsigned)lb.mNbDataBytes, (unsigned)lb.mNbErrors);
+    }
+
+// window setup as ILI9341_SetOutWriting() used to send it: one CS assertion per command and per parameter byte.
+static void legacy_set_window(ili9341_bus_t* bus, int x, int y, int w, int h)
+    {
+    const int x1 = x + w - 1, y1 = y + h - 1;
+    const uint8_t caset[4] = { (uint8_t)(x >> 8), (uint8_t)x, (uint8_t)(x1 >> 8), (uint8_t)x1 };
+    const uint8_t paset[4] = { (uint8_t)(y >> 8), (uint8_t)y, (uint8_t)(y1 >> 8), (uint8_t)y1 };
+    ILI9341_BusCommand(bus, ILI9341_CASET, nullptr, 0);
+    for (int i = 0; i < 4; i++) ILI9341_BusWriteData(bus, &caset[i], 1);
+    ILI9341_BusCommand(bus, ILI9341_PASET, nullptr, 0);
+    for (int i = 0; i < 4; i++) ILI9341_BusWriteData(bus, &paset[i], 1);
+    ILI9341_BusCommand(bus, ILI9341_RAMWR, nullptr, 0);
+    }
+
+// window setup as a single command stream (what ILI9341_SetOutWriting() does now).
+static void stream_set_window(ili9341_bus_t* bus, int x, int y, int w, int h)
+    {
+    ili9341_cmdstream_t s;
+    ILI9341_CmdStreamReset(&s);
+    ILI9341_CmdStreamWindow(&s, x, y, w, h);
+    ILI9341_BusCommandStream(bus, &s);
+    }
+
+// blocking rectangle update: window setup followed by the pixels, row by row.
+static void blocking_rect(ili9341_bus_t* bus, bool legacy, int x, int y, int w, int h)
+    {
+    if (legacy) legacy_set_window(bus, x, y, w, h); else stream_set_window(bus, x, y, w, h);
+    for (int j = y; j < y + h; j++) ILI9341_BusWriteData(bus, &framebuffer[j * PIX_WIDTH + x], 2 * w);
+    }
+
+static int nb_callbacks = 0;
+static void on_done(void* user) { nb_callbacks += (int)(intptr_t)user; }
+
+
+int main()
+    {
+    ILI9341_LoopbackBusInit(&lb, gram, PIX_WIDTH, PIX_HEIGHT);
+    ili9341_bus_t* bus = &lb.mBus;
+
+    printf("full frame (%dx%d)\n", PIX_WIDTH, PIX_HEIGHT);
+    fill_pattern(1);
+    memset(gram, 0, sizeof(gram));
+    ILI9341_LoopbackBusResetStats(&lb);
+    ili9341_fence_t f = ILI9341_BusWriteRectAsync(bus, 0, 0, PIX_WIDTH, PIX_HEIGHT, framebuffer, PIX_WIDTH, on_done, (void*)1);
+    check(!ILI9341_BusFenceDone(bus, f), "transfer in flight after submit");
+    ILI9341_BusWaitFence(bus, f);
+    check(ILI9341_BusFenceDone(bus, f) && ILI9341_BusIsIdle(bus), "fence completed");
+    check(nb_callbacks == 1, "completion callback called once");
+    check(gram_matches(0, 0, PIX_WIDTH, PIX_HEIGHT), "display memory matches framebuffer");
+    check(lb.mNbErrors == 0, "no protocol error");
+    print_stats("full frame");
+
+    printf("queued partial rectangles\n");
+    fill_pattern(2);
+    ILI9341_LoopbackBusResetStats(&lb);
+    nb_callbacks = 0;
+    const int rects[][4] = { {0,0,16,16}, {100,50,40,30}, {200,300,40,20}, {10,200,1,1}, {0,319,240,1}, {30,30,200,8} };
+    const int nb_rects = sizeof(rects) / sizeof(rects[0]);
+    ili9341_fence_t fences[nb_rects];
+    for (int i = 0; i < nb_rects; i++)
+        {
+        const int* r = rects[i];
+        fences[i] = ILI9341_BusWriteRectAsync(bus, r[0], r[1], r[2], r[3], &framebuffer[r[1] * PIX_WIDTH + r[0]], PIX_WIDTH, on_done, (void*)1);
+        }
+    ILI9341_BusWaitFence(bus, fences[2]);
+    check(ILI9341_BusFenceDone(bus, fences[1]) && !ILI9341_BusFenceDone(bus, fences[3]), "fences complete in order");
+    ILI9341_BusWaitIdle(bus);
+    check(nb_callbacks == nb_rects, "one callback per rectangle");
+    bool all = true;
+    for (int i = 0; i < nb_rects; i++) all &= gram_matches(rects[i][0], rects[i][1], rects[i][2], rects[i][3]);
+    check(all, "display memory matches framebuffer on every rectangle");
+    check(lb.mNbTransactions == 1, "back to back rectangles share one CS assertion");
+    check(lb.mNbErrors == 0, "no protocol error");
+    print_stats("partial rects");
+
+    printf("queue overflow (%d rects, queue size %d)\n", 100, ILI9341_MAX_QUEUED_RECTS);
+    fill_pattern(3);
+    ILI9341_LoopbackBusResetStats(&lb);
+    for (int i = 0; i < 100; i++)
+        {
+        const int x = (i * 37) % (PIX_WIDTH - 8), y = (i * 53) % (PIX_HEIGHT - 8);
+        ILI9341_BusWriteRectAsync(bus, x, y, 8, 8, &framebuffer[y * PIX_WIDTH + x], PIX_WIDTH, nullptr, nullptr);
+        }
+    ILI9341_BusWaitIdle(bus);
+    all = true;
+    for (int i = 0; i < 100; i++) all &= gram_matches((i * 37) % (PIX_WIDTH - 8), (i * 53) % (PIX_HEIGHT - 8), 8, 8);
+    check(all, "display memory matches framebuffer");
+    check(lb.mNbErrors == 0, "no protocol error");
+    print_stats("100 rects 8x8");
+
+    printf("window setup: one command/parameter per transaction vs command stream (100 rects 8x8, blocking)\n");
+    uint32_t trans[2];
+    for (int k = 0; k < 2; k++)
+        {
+        const bool legacy = (k == 0);
+        fill_pattern(4 + k);
+        ILI9341_LoopbackBusResetStats(&lb);
+        for (int i = 0; i < 100; i++) blocking_rect(bus, legacy, (i * 37) % (PIX_WIDTH - 8), (i * 53) % (PIX_HEIGHT - 8), 8, 8);
+        all = true;
+        for (int i = 0; i < 100; i++) all &= gram_matches((i * 37) % (PIX_WIDTH - 8), (i * 53) % (PIX_HEIGHT - 8), 8, 8);
+        check(all, "display memory matches framebuffer");
+        check(lb.mNbErrors == 0, "no protocol error");
+        print_stats(legacy ? "per command (legacy)" : "command stream");
+        trans[k] = lb.mNbTransactions;
+        }
+    check(trans[0] == 100 * (11 + 8) && trans[1] == 100 * (1 + 8), "window setup in 1 transaction instead of 11");
+
+    printf("\n%s\n", nb_failed ? "FAILED" : "OK");
+    return nb_failed ? 1 : 0;
+    }
+
+/** end of file */
@@ -0,0 +1,154 @@
+// bench_instanced.cpp - instanced mesh drawing (Renderer3D::drawMeshInstanced()) on the host.
+//
+// Two scenes made of many copies of a small mesh:
+// - gauge: the 200 ticks of a dial (a thin box), all on screen, each with its own color.
+// - crowd: 1600 markers (a small pyramid) on a large floor seen from above, most of them off-screen.
+// Each scene is drawn once with a loop of setModelMatrix() / setMaterialColor() / drawMesh()
+// calls and once with a single drawMeshInstanced() call. Checks that both images are
+// identical and reports the timings.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_instanced.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_instanced && ./bench_instanced
+//
+#include "tgx.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 100
+#define NB_TICKS 200
+#define CROWD_X 40
+#define CROWD_Y 40
+#define NB_MARKERS (CROWD_X * CROWD_Y)
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static Renderer3D<RGB565, SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_NOTEXTURE, float> renderer;
+
+
+// a tick: thin box.
+static const fVec3 tick_vertices[8] = { {-0.02f,0,0}, {0.02f,0,0}, {0.02f,0.15f,0}, {-0.02f,0.15f,0}, {-0.02f,0,0.03f}, {0.02f,0,0.03f}, {0.02f,0.15f,0.03f}, {-0.02f,0.15f,0.03f} };
+static const uint16_t tick_faces[] = { 1,4,5,6, 1,4,6,7, 1,0,1,5, 1,0,5,4, 1,1,2,6, 1,1,6,5, 1,2,3,7, 1,2,7,6, 1,3,0,4, 1,3,4,7, 0 };
+static const Mesh3D<RGB565> tick = { 1, 8, 0, 0, 10, 41, tick_vertices, nullptr, nullptr, tick_faces, nullptr, { 0.9f, 0.9f, 0.9f }, 0.3f, 0.7f, 0.3f, 16, nullptr, fBox3(-0.02f, 0.02f, 0, 0.15f, 0, 0.03f), "tick" };
+
+// a marker: square pyramid.
+static const fVec3 marker_vertices[5] = { {-0.2f,0,-0.2f}, {0.2f,0,-0.2f}, {0.2f,0,0.2f}, {-0.2f,0,0.2f}, {0,0.5f,0} };
+static const uint16_t marker_faces[] = { 1,0,1,4, 1,1,2,4, 1,2,3,4, 1,3,0,4, 1,0,2,1, 1,0,3,2, 0 };
+static const Mesh3D<RGB565> marker = { 1, 5, 0, 0, 6, 25, marker_vertices, nullptr, nullptr, marker_faces, nullptr, { 0.2f, 0.6f, 0.9f }, 0.3f, 0.7f, 0.3f, 16, nullptr, fBox3(-0.2f, 0.2f, 0, 0.5f, -0.2f, 0.2f), "marker" };
+
+static fMat4 tick_matrices[NB_TICKS];
+static RGBf tick_colors[NB_TICKS];
+static fMat4 marker_matrices[NB_MARKERS];
+
+
+/** draw a scene with a loop of drawMesh() calls or with drawMeshInstanced() */
+static void draw_scene(int scene, bool instanced, int frame)
+    {
+    if (scene == 0)
+        { // gauge: fixed camera, rotating dial
+        renderer.setLookAt({ 0, 0, 3.2f }, { 0, 0, 0 }, { 0, 1, 0 });
+        fMat4 R;
+        R.setRotate(360.0f * frame / NB_FRAMES, { 0, 0, 1 });
+        for (int i = 0; i < NB_TICKS; i++)
+            {
+            tick_matrices[i].setTranslate({ 0, 1.0f, 0 });
+            tick_matrices[i].multRotate(360.0f * i / NB_TICKS, { 0, 0, 1 });
+            tick_matrices[i] = R * tick_matrices[i];
+            }
+        if (instanced)
+            {
+            renderer.drawMeshInstanced(&tick, NB_TICKS, tick_matrices, tick_colors, false);
+            }
+        else
+            {
+            for (int i = 0; i < NB_TICKS; i++)
+                {
+                renderer.setModelMatrix(tick_matrices[i]);
+                renderer.setMaterialColor(tick_colors[i]);
+                renderer.drawMesh(&tick, false);
+                }
+            }
+        }
+    else
+        { // crowd: the camera flies over the floor
+        const float t = 2.0f * 3.14159265f * frame / NB_FRAMES;
+        const fVec3 eye(6.0f * cosf(t), 4.0f, 6.0f * sinf(t));
+        renderer.setLookAt(eye, { eye.x * 0.5f, 0, eye.z * 0.5f - 2.0f }, { 0, 1, 0 });
+        if (instanced)
+            {
+            renderer.drawMeshInstanced(&marker, NB_MARKERS, marker_matrices);
+            }
+        else
+            {
+            for (int i = 0; i < NB_MARKERS; i++)
+                {
+                renderer.setModelMatrix(marker_matrices[i]);
+                renderer.drawMesh(&marker);
+                }
+            }
+        }
+    }
+
+
+int main()
+    {
+    for (int i = 0; i < NB_TICKS; i++)
+        {
+        const float h = (float)i / NB_TICKS;
+        tick_colors[i] = RGBf(0.5f + 0.5f * h, 0.9f - 0.6f * h, 0.3f);
+        }
+    for (int i = 0; i < NB_MARKERS; i++)
+        {
+        marker_matrices[i].setTranslate({ -20.0f + (i % CROWD_X), 0, -20.0f + (i / CROWD_X) });
+        }
+
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setShaders(SHADER_FLAT);
+    renderer.setMaterial({ 0.9f, 0.9f, 0.9f }, 0.3f, 0.7f, 0.3f, 16);
+
+    const char* names[2] = { "gauge", "crowd" };
+    const int counts[2] = { NB_TICKS, NB_MARKERS };
+    int errors = 0;
+    printf("%d frames %dx%d per scene, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, BENCH_REPEATS);
+    printf("%-8s %10s %10s %10s %8s\n", "scene", "instances", "loop", "instanced", "speedup");
+    for (int scene = 0; scene < 2; scene++)
+        {
+        double t[2] = { 0, 0 }; // loop, instanced
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                const bool instanced = (v == 1);
+                Image<RGB565>& dst = instanced ? im : im_ref;
+                renderer.setImage(&dst);
+                dst.fillScreen(RGB565_Black);
+                renderer.clearZbuffer();
+                const double t0 = now_us();
+                draw_scene(scene, instanced, f);
+                return now_us() - t0;
+                });
+            if (memcmp(fb, fb_ref, sizeof(fb)) != 0) errors++;
+            }
+        printf("%-8s %10d %10.1f %10.1f %7.2fx\n", names[scene], counts[scene], t[0] / NB_FRAMES, t[1] / NB_FRAMES, t[0] / t[1]);
+        }
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
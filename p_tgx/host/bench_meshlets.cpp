@@ -0,0 +1,146 @@
+// bench_meshlets.cpp - meshlet clusters (MeshCluster) in Renderer3D::drawMesh() on the host.
+//
+// Splits the bunny of pgx_bunny.cpp into clusters with the helpers of
+// mesh_tools.h (as host/mesh_meshlets.cpp does) and renders it with and
+// without the cluster array (the face array is the same in both cases) in
+// several situations: whole mesh on screen, close-up with most clusters
+// off-screen, no back-face culling and orthographic projection. Checks that
+// the images match and reports the timings and the number of clusters
+// rejected by the frustum and by the normal cones.
+//
+// The images are not required to be bit identical: drawMesh() rotates its three
+// vertex slots along the chains and this rotation carries over to the next
+// chain, so skipping a cluster changes the order in which the vertices of the
+// following triangles reach the rasterizer. The covered pixels are the same
+// but Gouraud colors may differ by rounding: the check requires the same
+// coverage and at most 4 units of difference per channel.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_meshlets.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_meshlets && ./bench_meshlets
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "mesh_tools.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace mesh_tools;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 100
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ORTHO | SHADER_ZBUFFER | SHADER_GOURAUD | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+
+/** return true if the two images cover the same pixels with colors that differ at most by rounding */
+static bool same_image(const uint16_t* A, const uint16_t* B)
+    {
+    for (int i = 0; i < LX * LY; i++)
+        {
+        if (A[i] == B[i]) continue;
+        if ((A[i] == 0) || (B[i] == 0)) return false;
+        const RGB565 a(A[i]), b(B[i]);
+        if ((abs(a.R - b.R) > 4) || (abs(a.G - b.G) > 4) || (abs(a.B - b.B) > 4)) return false;
+        }
+    return true;
+    }
+
+
+/** modes: 0 = whole mesh, 1 = close-up, 2 = no culling, 3 = ortho */
+static void draw_scene(Image<RGB565>& im, const Mesh3D<RGB565>* mesh, int frame, int mode)
+    {
+    if (mode == 3) renderer.setOrtho(-1.6f, 1.6f, -2.1f, 2.1f, 1, 100); else renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setCulling((mode == 2) ? 0 : 1);
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    if (mode == 1) M.multTranslate({ 0.3f, -0.5f, -1.2f }); else M.multTranslate({ 0, 0, -3.5f });
+    renderer.setModelMatrix(M);
+    im.fillScreen(RGB565_Black);
+    renderer.clearZbuffer();
+    renderer.drawMesh(mesh, true);
+    }
+
+
+int main()
+    {
+    // build the clusters (same as host/mesh_meshlets.cpp with the default options)
+    MeshData D = loadMesh(bunny_fig_small);
+    compactMesh(D);
+    std::vector<MeshCluster> clusters;
+    std::vector<Chain> chains = encodeClusters(D, buildClusters(D, 64), clusters);
+    reorderMesh(D, chains);
+    std::vector<uint16_t> face;
+    for (const Chain& C : chains) face.insert(face.end(), C.begin(), C.end());
+    face.push_back(0);
+
+    Mesh3D<RGB565> plain = bunny_fig_small;
+    plain.nb_vertices = (uint16_t)D.vert.size();
+    plain.nb_texcoords = (uint16_t)D.tex.size();
+    plain.nb_normals = (uint16_t)D.norm.size();
+    plain.nb_faces = (uint16_t)D.tri.size();
+    plain.len_face = (uint16_t)face.size();
+    plain.vertice = D.vert.data();
+    plain.texcoord = D.tex.data();
+    plain.normal = D.norm.data();
+    plain.face = face.data();
+    plain.nb_clusters = 0;
+    plain.cluster = nullptr;
+    Mesh3D<RGB565> clustered = plain;
+    clustered.nb_clusters = (uint16_t)clusters.size();
+    clustered.cluster = clusters.data();
+
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+
+    const char* modes[4] = { "whole mesh", "close-up", "no culling", "ortho" };
+    int errors = 0;
+    printf("%d frames %dx%d per mode, bunny with %d triangles in %d clusters, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, (int)D.tri.size(), (int)clusters.size(), BENCH_REPEATS);
+    printf("%-12s %10s %10s %10s %10s %10s\n", "mode", "plain", "clusters", "tested", "frustum", "backface");
+    for (int mode = 0; mode < 4; mode++)
+        {
+        double t[2] = { 0, 0 }; // plain, clusters
+        renderer.resetMeshletStats();
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                const bool use_clusters = (v == 1);
+                renderer.setImage(use_clusters ? &im : &im_ref);
+                const double t0 = now_us();
+                draw_scene(use_clusters ? im : im_ref, use_clusters ? &clustered : &plain, f, mode);
+                return now_us() - t0;
+                });
+            if (!same_image(fb, fb_ref)) errors++;
+            }
+        uint32_t tested, frustum, backface;
+        renderer.getMeshletStats(tested, frustum, backface);
+        const double runs = (double)NB_FRAMES * BENCH_REPEATS; // the clustered mesh is drawn BENCH_REPEATS times per frame
+        printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.1f\n", modes[mode], t[0] / NB_FRAMES, t[1] / NB_FRAMES, tested / runs, frustum / runs, backface / runs);
+        }
+    printf("(tested, frustum, backface: clusters per frame)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
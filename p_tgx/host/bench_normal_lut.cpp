@@ -0,0 +1,129 @@
+// bench_normal_lut.cpp - lighting from quantized normals (Renderer3D::setNormalLUT()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp (no texture, z-buffer) rotating in front
+// of the camera with Gouraud and with flat shading, lit exactly and with the
+// normal lighting table for 5, 6 and 8 bits per axis. Reports the timings and
+// the error against the exact lighting (the largest difference on a color
+// channel, in RGB565 steps, and the fraction of pixels that differ) and checks
+// that the error stays small. Each lighting has its own renderer so that the
+// tables are only built once (only the model matrix moves). Each frame is drawn
+// BENCH_REPEATS times with each lighting and the fastest run is kept.
+//
+// On the host, the table is barely faster: with a floating point unit, the
+// division of the octahedral quantization costs about as much as the Phong
+// model it replaces, the lighting is a small part of the frame and the 768KB
+// table of 8 bits misses the cache. The gain is for microcontrollers without floating point
+// unit, where the Phong model costs far more than the quantization.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_normal_lut.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_normal_lut && ./bench_normal_lut
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 100
+#define NB_LUTS 3
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static const int lut_bits[NB_LUTS] = { 5, 6, 8 };
+static const int max_error[NB_LUTS] = { 6, 4, 2 };
+static RGBf lut5[1 << 10], lut6[1 << 12], lut8[1 << 16];
+static RGBf* luts[NB_LUTS] = { lut5, lut6, lut8 };
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD | SHADER_NOTEXTURE;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer[NB_LUTS + 1]; // exact lighting, then one per table
+
+
+static void draw_bunny(Renderer3D<RGB565, LOADED_SHADERS, float>& R, Image<RGB565>& im, int frame)
+    {
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate({ 0, 0, -2.5f });
+    R.setImage(&im);
+    R.setModelMatrix(M);
+    im.fillScreen(RGB565_Black);
+    R.clearZbuffer();
+    R.drawMesh(&bunny_fig_small, false);
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    for (int r = 0; r <= NB_LUTS; r++)
+        {
+        renderer[r].setViewportSize(LX, LY);
+        renderer[r].setOffset(0, 0);
+        renderer[r].setZbuffer(zbuf);
+        renderer[r].setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+        renderer[r].setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.15f, 0.7f, 0.7f, 32);
+        if (r > 0) renderer[r].setNormalLUT(luts[r - 1], lut_bits[r - 1]);
+        }
+
+    const Shader shaders[2] = { SHADER_GOURAUD, SHADER_FLAT };
+    const char* names[2] = { "Gouraud", "flat" };
+    int errors = 0;
+    printf("%d frames %dx%d, bunny with %d triangles, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, bunny_fig_small.nb_faces, BENCH_REPEATS);
+    printf("%-10s %-8s %10s %10s %14s\n", "shading", "lighting", "time", "max error", "pixels differ");
+    for (int s = 0; s < 2; s++)
+        {
+        for (int r = 0; r <= NB_LUTS; r++) renderer[r].setShaders(shaders[s]);
+        double t[NB_LUTS + 1] = { 0 }, differ[NB_LUTS] = { 0 }, covered = 0; // t[0]: exact, t[l + 1]: table l
+        int max_err[NB_LUTS] = { 0 };
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(NB_LUTS + 1, f, BENCH_REPEATS, t, [&](int v, int rep)
+                {
+                const double t0 = now_us();
+                draw_bunny(renderer[v], (v == 0) ? im_ref : im, f);
+                const double t1 = now_us();
+                if ((v > 0) && (rep == BENCH_REPEATS - 1)) // the exact lighting of this frame is in fb_ref by now
+                    {
+                    const int l = v - 1;
+                    for (int i = 0; i < LX * LY; i++)
+                        {
+                        if (fb[i] == fb_ref[i]) continue;
+                        differ[l]++;
+                        const RGB565 a(fb[i]), b(fb_ref[i]);
+                        const int e = std::max(std::max(abs(a.R - b.R), abs(a.G - b.G) / 2), abs(a.B - b.B));
+                        if (e > max_err[l]) max_err[l] = e;
+                        }
+                    }
+                return t1 - t0;
+                });
+            for (int i = 0; i < LX * LY; i++) if (fb_ref[i] != 0) covered++;
+            }
+        printf("%-10s %-8s %10.1f %10s %14s\n", names[s], "exact", t[0] / NB_FRAMES, "-", "-");
+        for (int l = 0; l < NB_LUTS; l++)
+            {
+            char title[16];
+            snprintf(title, sizeof(title), "%d bits", lut_bits[l]);
+            printf("%-10s %-8s %10.1f %10d %13.2f%%\n", names[s], title, t[l + 1] / NB_FRAMES, max_err[l], 100.0 * differ[l] / covered);
+            if (max_err[l] > max_error[l]) errors++;
+            }
+        printf("\n");
+        }
+    printf("(max error: largest difference on a color channel in RGB565 steps, green counted on 5 bits)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
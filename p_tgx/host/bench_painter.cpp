@@ -0,0 +1,117 @@
+// bench_painter.cpp - painter's mode of Renderer3D::drawMesh() (no z-buffer, see setTriangleSortBuffer()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp (textured, Gouraud shading) rotating in
+// front of the camera three times per frame: with a z-buffer (the reference,
+// drawn front to back so that each triangle is lit with its own side when
+// culling is disabled, as in the painter's mode), without z-buffer in the
+// order of the face array, and without z-buffer with the triangle sort buffer
+// (painter's mode: triangles drawn back to front).
+// Three views: the whole bunny, the bunny with back-face culling disabled and
+// a close-up where part of the bunny is outside of the screen. Reports the
+// timings and the pixels that differ from the reference, and checks that the
+// painter's mode covers the same pixels and gets at least 98% of them right
+// in every frame (sorting triangles by their center is not exact where two
+// long triangles overlap, which mostly shows in the close-up). Also prints the memory used for the depth: the z-buffer versus the
+// sort buffer.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_painter.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_painter && ./bench_painter
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 100
+#define NB_SORT 2200
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb_order[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static VertexCacheEntry vcache[2048];
+static TriangleSortEntry tsort[NB_SORT];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_NOZBUFFER | SHADER_GOURAUD | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+
+/** draw the bunny: 0 = z-buffer, 1 = no z-buffer in order, 2 = painter's mode */
+static void draw_bunny(Image<RGB565>& im, int method, int view, int frame)
+    {
+    renderer.setImage(&im);
+    renderer.setZbuffer((method == 0) ? zbuf : nullptr);
+    renderer.setTriangleSortBuffer((method != 1) ? tsort : nullptr, NB_SORT);
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate((view == 2) ? fVec3(0.2f, 0.3f, -1.1f) : fVec3(0, 0, -2.5f));
+    renderer.setModelMatrix(M);
+    im.fillScreen(RGB565_Magenta); // not in the texture: tells the covered pixels
+    if (method == 0) renderer.clearZbuffer();
+    renderer.drawMesh(&bunny_fig_small, true);
+    }
+
+
+int main()
+    {
+    Image<RGB565> images[3] = { Image<RGB565>((RGB565*)fb_ref, LX, LY), Image<RGB565>((RGB565*)fb_order, LX, LY), Image<RGB565>((RGB565*)fb, LX, LY) };
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    renderer.setVertexCache(vcache, 2048);
+
+    const char* views[3] = { "bunny", "no culling", "close-up" };
+    int errors = 0;
+    printf("%d frames %dx%d, bunny with %d triangles, textured Gouraud, times in us/frame (fastest of %d runs)\n", NB_FRAMES, LX, LY, bunny_fig_small.nb_faces, BENCH_REPEATS);
+    printf("depth memory: z-buffer %d bytes, sort buffer %d bytes\n\n", (int)sizeof(zbuf), (int)(bunny_fig_small.nb_faces * sizeof(TriangleSortEntry)));
+    printf("%-12s %10s %10s %10s %12s %12s\n", "", "z-buffer", "in order", "painter", "wrong order", "wrong sort");
+    for (int view = 0; view < 3; view++)
+        {
+        renderer.setCulling((view == 1) ? 0 : 1);
+        double t[3] = { 0, 0, 0 };
+        double wrong_order = 0, wrong_sort = 0, covered = 0;
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(3, f, BENCH_REPEATS, t, [&](int method, int)
+                {
+                const double t0 = now_us();
+                draw_bunny(images[method], method, view, f);
+                return now_us() - t0;
+                });
+            const uint16_t bg = (uint16_t)RGB565_Magenta.val;
+            long diff_order = 0, diff_sort = 0, coverage = 0, cov = 0;
+            for (int i = 0; i < LX * LY; i++)
+                {
+                if (fb_ref[i] != bg) cov++;
+                if (fb_order[i] != fb_ref[i]) diff_order++;
+                if (fb[i] != fb_ref[i]) diff_sort++;
+                if ((fb[i] == bg) != (fb_ref[i] == bg)) coverage++;
+                }
+            covered += cov;
+            wrong_order += diff_order;
+            wrong_sort += diff_sort;
+            if ((coverage > 0) || (diff_sort * 50 > cov)) errors++; // same coverage and less than 2% of wrong pixels
+            }
+        printf("%-12s %10.1f %10.1f %10.1f %11.2f%% %11.2f%%\n", views[view], t[0] / NB_FRAMES, t[1] / NB_FRAMES, t[2] / NB_FRAMES, 100.0 * wrong_order / covered, 100.0 * wrong_sort / covered);
+        }
+    printf("(wrong: pixels covered by the bunny that differ from the z-buffer image, in order and with the painter's mode)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
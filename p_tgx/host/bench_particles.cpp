@@ -0,0 +1,234 @@
+// bench_particles.cpp - particle system (Particles3D and Renderer3D::drawParticles()) stress test on the host.
+//
+// A fountain of 10000 particles (SoA storage animated with Particles3D::update())
+// around the bunny of pgx_bunny.cpp. Each frame, the bunny is drawn with a
+// z-buffer and the particles are drawn on top of it in five ways:
+// - drawDots(): the previous per element path (opaque discs of radius 2, the
+//   z-buffer is written),
+// - drawParticles() with opaque discs, in index order,
+// - drawParticles() with discs blended at 50%, sorted back to front,
+// - drawParticles() with a tinted 16x16 sprite and an opacity per particle,
+//   sorted back to front,
+// - the same without z-buffer.
+// Reports the timings (update, projection + sort + sprites), the particles
+// drawn and the pixels written per frame, and checks that:
+// - drawParticles() does not write the z-buffer,
+// - the particles are hidden by a wall drawn in front of the left half of the
+//   fountain (depth test),
+// - the sorted order is back to front (up to the width of a sort bucket).
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_particles.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_particles && ./bench_particles
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 100
+#define NB_PARTICLES 10000
+#define SPRITE_LX 16
+
+static uint16_t fb[LX * LY];
+static uint16_t fb_ref[LX * LY];
+static float zbuf[LX * LY];
+static float zbuf_ref[LX * LY];
+
+// particle storage (one array per attribute)
+static fVec3 position[NB_PARTICLES];
+static fVec3 velocity[NB_PARTICLES];
+static float life[NB_PARTICLES];
+static RGB565 color[NB_PARTICLES];
+static uint8_t opacity[NB_PARTICLES];
+static ParticleScreenEntry screen[NB_PARTICLES];
+static uint16_t order[NB_PARTICLES];
+static Particles3D<RGB565> particles(position, NB_PARTICLES, screen, order);
+
+// drawDots() arrays
+static const int dot_radius[1] = { 2 };
+static const float dot_opacity[1] = { 1.0f };
+static int zero[NB_PARTICLES];
+static int color_ind[NB_PARTICLES];
+static RGB565 dot_colors[NB_PARTICLES];
+
+static uint16_t sprite_buf[SPRITE_LX * SPRITE_LX];
+static Image<RGB565> sprite((RGB565*)sprite_buf, SPRITE_LX, SPRITE_LX);
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_NOZBUFFER | SHADER_FLAT | SHADER_GOURAUD | SHADER_NOTEXTURE;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+
+static float frand(float a, float b) { return a + (b - a) * rand() / (float)RAND_MAX; }
+
+
+/** spawn a particle at the nozzle of the fountain */
+static void spawn()
+    {
+    const float a = frand(0, 6.2831853f), s = frand(0.5f, 0.9f);
+    const int i = particles.spawn(fVec3(0, -0.9f, 0), fVec3(s * cosf(a), frand(1.6f, 2.0f), s * sinf(a)), frand(0.5f, 1.6f)); // dies before reaching the wall of the depth test
+    if (i < 0) return;
+    color[i] = RGB565(RGBf(frand(0.5f, 1.0f), frand(0.5f, 1.0f), 1.0f));
+    opacity[i] = (uint8_t)frand(64, 255);
+    }
+
+
+/** draw the bunny and (optionally) the wall in front of the left half of the fountain */
+static void draw_background(bool wall)
+    {
+    renderer.setShaders(SHADER_GOURAUD);
+    renderer.drawMesh(&bunny_fig_small, false);
+    if (wall)
+        {
+        renderer.setShaders(SHADER_FLAT);
+        renderer.drawQuad({ -3, -3, 2.0f }, { 0, -3, 2.0f }, { 0, 3, 2.0f }, { -3, 3, 2.0f });
+        }
+    }
+
+
+/** draw the particles: 0 = drawDots, 1 = opaque discs, 2 = blended discs sorted, 3 = sprites sorted, 4 = sprites without z-buffer */
+static int draw_particles(int method)
+    {
+    switch (method)
+        {
+        case 0:
+            {
+            for (int i = 0; i < particles.nbParticles(); i++) dot_colors[i] = color[i];
+            renderer.drawDots(particles.nbParticles(), position, zero, dot_radius, color_ind, dot_colors, zero, dot_opacity);
+            return particles.nbParticles();
+            }
+        case 1:
+        case 2:
+            {
+            particles.setSprite(nullptr, RGB565_Black);
+            particles.setColors((method == 1) ? color : nullptr);
+            particles.setOpacities(nullptr);
+            particles.setOpacity((method == 1) ? 1.0f : 0.5f);
+            particles.setSortMode((method == 1) ? 0 : Particles3D<RGB565>::PARTICLES_SORT);
+            return renderer.drawParticles(&particles);
+            }
+        default:
+            {
+            particles.setSprite(&sprite, RGB565_Black);
+            particles.setColors(color);
+            particles.setOpacities(opacity);
+            particles.setSortMode(Particles3D<RGB565>::PARTICLES_SORT);
+            return renderer.drawParticles(&particles);
+            }
+        }
+    }
+
+
+int main()
+    {
+    // soft disc sprite (black is transparent)
+    sprite.fillScreen(RGB565_Black);
+    for (int j = 0; j < SPRITE_LX; j++) for (int i = 0; i < SPRITE_LX; i++)
+        {
+        const float dx = (i + 0.5f) / SPRITE_LX * 2 - 1, dy = (j + 0.5f) / SPRITE_LX * 2 - 1;
+        const float d = 1.0f - sqrtf(dx * dx + dy * dy);
+        if (d > 0.05f) sprite(i, j) = RGB565(RGBf(d, d, d));
+        }
+    for (int i = 0; i < NB_PARTICLES; i++) { zero[i] = 0; color_ind[i] = i; }
+
+    particles.setVelocities(velocity);
+    particles.setLives(life);
+    particles.setSize(0.02f);
+    srand(1);
+    for (int k = 0; k < 200; k++)
+        { // warm up the fountain
+        for (int n = 0; n < NB_PARTICLES / 100; n++) spawn();
+        particles.update(0.01f, { 0, -2.0f, 0 });
+        }
+
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.5f, 32);
+    renderer.setCulling(0);
+
+    const char* names[5] = { "drawDots", "discs", "discs blended", "sprites", "sprites no-z" };
+    double t_update = 0, t[5] = { 0, 0, 0, 0, 0 }, drawn[5] = { 0, 0, 0, 0, 0 }, pixels[5] = { 0, 0, 0, 0, 0 };
+    int errors_z = 0, errors_wall = 0, errors_sort = 0;
+    for (int f = 0; f < NB_FRAMES; f++)
+        {
+        const double t0 = now_us();
+        for (int n = 0; n < NB_PARTICLES / 100; n++) spawn();
+        particles.update(0.01f, { 0, -2.0f, 0 });
+        t_update += now_us() - t0;
+
+        fMat4 M;
+        M.setRotate(360.0f * f / NB_FRAMES, { 0, 1, 0 });
+        M.multTranslate({ 0, 0, -3.0f });
+        renderer.setModelMatrix(M);
+        timeVariants(5, f, BENCH_REPEATS, t, [&](int method, int rep)
+            {
+            renderer.setImage(&im);
+            renderer.setZbuffer((method == 4) ? nullptr : zbuf);
+            im.fillScreen(RGB565_Black);
+            if (method != 4) renderer.clearZbuffer();
+            draw_background(false);
+            if (method == 3) memcpy(zbuf_ref, zbuf, sizeof(zbuf));
+            renderer.resetFragmentStats();
+            const double t1 = now_us();
+            const int nv = draw_particles(method);
+            const double t2 = now_us();
+            if (rep > 0) return t2 - t1;
+            drawn[method] += nv;
+            pixels[method] += renderer.getFragmentStats();
+            if (method != 3) return t2 - t1;
+            if (memcmp(zbuf_ref, zbuf, sizeof(zbuf)) != 0) errors_z++;
+            // the screen buffer holds the particles drawn: back to front up to the width of a bucket.
+            float dmin = 1e30f, dmax = -1e30f;
+            for (int j = 0; j < nv; j++) { dmin = std::min(dmin, screen[j].depth); dmax = std::max(dmax, screen[j].depth); }
+            const float eps = (dmax - dmin) / Particles3D<RGB565>::NB_SORT_BUCKETS;
+            for (int j = 1; j < nv; j++) if (screen[particles.order(j)].depth > screen[particles.order(j - 1)].depth + eps) { errors_sort++; break; }
+            return t2 - t1;
+            });
+
+        // depth test: with a wall in front of the left half, the particles must not change it.
+        M.setTranslate({ 0, 0, -3.0f });
+        renderer.setModelMatrix(M);
+        renderer.setZbuffer(zbuf);
+        renderer.setImage(&im_ref);
+        im_ref.fillScreen(RGB565_Black);
+        renderer.clearZbuffer();
+        draw_background(true);
+        renderer.setImage(&im);
+        memcpy(fb, fb_ref, sizeof(fb));
+        draw_particles(3);
+        long changed_left = 0, changed_right = 0;
+        for (int y = 0; y < LY; y++) for (int x = 0; x < LX; x++)
+            {
+            if (fb[x + LX * y] == fb_ref[x + LX * y]) continue;
+            if (x < LX / 2 - 2) changed_left++; else changed_right++;
+            }
+        if ((changed_left > 0) || (changed_right == 0)) errors_wall++;
+        }
+
+    printf("%d frames %dx%d, fountain of %d particles around the bunny, times in us/frame\n\n", NB_FRAMES, LX, LY, particles.nbParticles());
+    printf("update (SoA, gravity and lives): %.1f us/frame (single run: the update moves the particles)\n\n", t_update / NB_FRAMES);
+    printf("%-14s %10s %10s %10s\n", "", "time", "drawn", "pixels");
+    printf("(time: fastest of %d runs)\n", BENCH_REPEATS);
+    for (int m = 0; m < 5; m++) printf("%-14s %10.1f %10.0f %10.0f\n", names[m], t[m] / NB_FRAMES, drawn[m] / NB_FRAMES, pixels[m] / NB_FRAMES);
+    printf("(drawn: particles inside the view frustum, pixels: pixels written, not counted by drawDots)\n\n");
+    printf("z-buffer written: %d frames, particles in front of the wall: %d frames, sort errors: %d frames\n", errors_z, errors_wall, errors_sort);
+
+    const int errors = errors_z + errors_wall + errors_sort;
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
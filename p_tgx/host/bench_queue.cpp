@@ -0,0 +1,158 @@
+// bench_queue.cpp - sorted render queue (RenderQueue3D and Renderer3D::drawQueue()) on the host.
+//
+// Draws a grid of 80 small bunnies whose shaders (flat, Gouraud, textured
+// Gouraud) and materials (4 specular exponents, 5 colors) are interleaved, as
+// an application drawing its objects in scene order would. The grid is drawn
+// once with a loop of setShaders() / setMaterial() / drawMesh() calls and once
+// through a render queue sorted by state (and front to back). Checks that both
+// images are identical (the bunnies do not overlap so the draw order does not
+// matter) and reports the timings and the number of state changes and of
+// rebuilds of the specular table per frame.
+//
+// Each frame is drawn REPEATS times with each method and the fastest run is
+// kept: the rasterization of the bunnies dominates the frame and a single run
+// varies by several percent, more than the difference between the two methods.
+// The overhead of the queue itself (submitting the items, computing their depth
+// and sorting them) is reported separately. On the host, the state changes the
+// queue saves are cheap (the specular table is 32 powf() in hardware) so both
+// methods take about the same time; on the Pico, each rebuild of the specular
+// table is 32 soft float powf().
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_queue.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_queue && ./bench_queue
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 30
+#define REPEATS 7
+#define GRID_X 10
+#define GRID_Y 8
+#define NB_OBJECTS (GRID_X * GRID_Y)
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static RenderItem<RGB565> items[NB_OBJECTS];
+static uint16_t order[NB_OBJECTS];
+static RenderQueue3D<RGB565> queue(items, order, NB_OBJECTS, RenderQueue3D<RGB565>::QUEUE_SORT_STATE | RenderQueue3D<RGB565>::QUEUE_SORT_DEPTH);
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+static const Shader shaders[3] = { SHADER_FLAT, SHADER_GOURAUD, (Shader)(SHADER_GOURAUD | SHADER_TEXTURE) };
+static const int exponents[4] = { 4, 8, 16, 32 };
+static const RGBf colors[5] = { RGBf(0.9f, 0.9f, 0.9f), RGBf(0.9f, 0.3f, 0.3f), RGBf(0.3f, 0.9f, 0.3f), RGBf(0.3f, 0.3f, 0.9f), RGBf(0.9f, 0.8f, 0.2f) };
+
+
+/** model matrix of object i at a given frame */
+static fMat4 model(int i, int frame)
+    {
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES + 37.0f * i, { 0, 1, 0 });
+    M.multScale({ 0.45f, 0.45f, 0.45f });
+    M.multTranslate({ -4.5f + (i % GRID_X), -3.5f + (i / GRID_X), -9.0f - 0.1f * (i % 3) });
+    return M;
+    }
+
+
+/** draw the objects in scene order, setting the state of each one */
+static void draw_loop(int frame)
+    {
+    for (int i = 0; i < NB_OBJECTS; i++)
+        {
+        renderer.setShaders(shaders[i % 3]);
+        renderer.setMaterial(colors[i % 5], 0.15f, 0.7f, 0.6f, exponents[i % 4]);
+        renderer.setModelMatrix(model(i, frame));
+        renderer.drawMesh(&bunny_fig_small, false);
+        }
+    }
+
+
+/** submit the objects to the queue and draw it */
+static void draw_queue(int frame)
+    {
+    queue.clear();
+    for (int i = 0; i < NB_OBJECTS; i++)
+        {
+        queue.submit(&bunny_fig_small, model(i, frame), shaders[i % 3], colors[i % 5], 0.15f, 0.7f, 0.6f, exponents[i % 4]);
+        }
+    renderer.drawQueue(&queue);
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+
+    int errors = 0;
+    double t[3] = { 0, 0, 0 }; // drawMesh loop, drawQueue, queue overhead
+    uint32_t loop_shaders = 0, loop_materials = 0, loop_rebuilds = 0;
+    uint32_t queue_shaders = 0, queue_materials = 0, queue_rebuilds = 0;
+    for (int f = 0; f < NB_FRAMES; f++)
+        {
+        timeVariants(3, f, REPEATS, t, [&](int v, int rep)
+            {
+            if (v == 2)
+                { // overhead of the queue: submit the items and sort them (without drawing)
+                const double t0 = now_us();
+                queue.clear();
+                for (int i = 0; i < NB_OBJECTS; i++)
+                    {
+                    queue.submit(&bunny_fig_small, model(i, f), shaders[i % 3], colors[i % 5], 0.15f, 0.7f, 0.6f, exponents[i % 4]);
+                    }
+                queue.sort();
+                return now_us() - t0;
+                }
+            const bool use_queue = (v == 1);
+            Image<RGB565>& dst = use_queue ? im : im_ref;
+            renderer.setImage(&dst);
+            dst.fillScreen(RGB565_Black);
+            renderer.clearZbuffer();
+            renderer.resetStateStats();
+            const double t0 = now_us();
+            if (use_queue) draw_queue(f); else draw_loop(f);
+            const double t1 = now_us();
+            if (rep == 0)
+                {
+                uint32_t s, m, rb;
+                renderer.getStateStats(s, m, rb);
+                if (use_queue) { queue_shaders += s; queue_materials += m; queue_rebuilds += rb; }
+                else { loop_shaders += s; loop_materials += m; loop_rebuilds += rb; }
+                }
+            return t1 - t0;
+            });
+        if (memcmp(fb, fb_ref, sizeof(fb)) != 0) errors++;
+        }
+
+    printf("%d frames %dx%d, %d bunnies with 3 shaders, 4 specular exponents and 5 colors interleaved, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, NB_OBJECTS, REPEATS);
+    printf("%-14s %12s %12s %12s %12s\n", "", "us/frame", "shaders", "materials", "specular");
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f\n", "drawMesh loop", t[0] / NB_FRAMES, (double)loop_shaders / NB_FRAMES, (double)loop_materials / NB_FRAMES, (double)loop_rebuilds / NB_FRAMES);
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f\n", "drawQueue", t[1] / NB_FRAMES, (double)queue_shaders / NB_FRAMES, (double)queue_materials / NB_FRAMES, (double)queue_rebuilds / NB_FRAMES);
+    printf("(shaders, materials, specular: state changes and specular table rebuilds per frame)\n");
+    printf("\nqueue overhead (submit + sort, included in drawQueue): %.1f us/frame\n", t[2] / NB_FRAMES);
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,136 @@
+// bench_rgb565be.cpp - host benchmark for the RGB565BE (big endian) color type.
+//
+// Renders the bunny mesh with Renderer3D<RGB565> + byte swap pass (the old
+// pgx_bunny pipeline) and with Renderer3D<RGB565BE> (framebuffer already in
+// wire order). Checks that both produce the same bytes and reports timings.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_rgb565be.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_rgb565be && ./bench_rgb565be
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 200
+
+static uint16_t fb_le[LX * LY];
+static uint16_t fb_be[LX * LY];
+static uint16_t fb_swap[LX * LY]; // copy of fb_le for the swap pass (which works in place)
+static uint16_t zbuf[LX * LY];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+
+/** same loop as the one formerly in pgx_bunny.cpp display_framebuffer_async() */
+static void swap_pass(uint16_t* fb)
+    {
+    uint8_t* fb_bytes = (uint8_t*)fb;
+    for (int i = 0; i < LX * LY * 2; i += 2)
+        {
+        uint8_t temp = fb_bytes[i];
+        fb_bytes[i] = fb_bytes[i + 1];
+        fb_bytes[i + 1] = temp;
+        }
+    }
+
+
+template<typename color_t> static void setup(Renderer3D<color_t, LOADED_SHADERS, uint16_t>& renderer, Image<color_t>& im)
+    {
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setImage(&im);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setCulling(1);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    }
+
+
+template<typename color_t> static void draw(Renderer3D<color_t, LOADED_SHADERS, uint16_t>& renderer, Image<color_t>& im, const Mesh3D<color_t>* mesh, int frame, int mode)
+    {
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, -2, -15 });
+    renderer.setModelMatrix(M);
+    im.fillScreen(color_t(RGB565_Cyan));
+    renderer.clearZbuffer();
+    switch (mode)
+        {
+        case 0: renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE); break;
+        case 1: renderer.setShaders(SHADER_FLAT); break;
+        default: renderer.setShaders(SHADER_GOURAUD); break;
+        }
+    renderer.drawMesh(mesh, false);
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_le((RGB565*)fb_le, LX, LY);
+    Image<RGB565BE> im_be((RGB565BE*)fb_be, LX, LY);
+    Renderer3D<RGB565, LOADED_SHADERS, uint16_t> r_le;
+    Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> r_be;
+    setup(r_le, im_le);
+    setup(r_be, im_be);
+
+    const char* names[3] = { "gouraud+texture", "flat", "gouraud" };
+    int errors = 0;
+    printf("%d frames %dx%d per mode, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, BENCH_REPEATS);
+    printf("%-16s %12s %12s %12s %12s\n", "mode", "RGB565", "swap pass", "RGB565+swap", "RGB565BE");
+    for (int mode = 0; mode < 3; mode++)
+        {
+        double t[3] = { 0, 0, 0 }; // RGB565, swap pass, RGB565BE
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(3, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                if (v == 1) memcpy(fb_swap, fb_le, sizeof(fb_swap));
+                const double t0 = now_us();
+                switch (v)
+                    {
+                    case 0: draw(r_le, im_le, &bunny_fig_small, f, mode); break;
+                    case 1: swap_pass(fb_swap); break;
+                    default: draw(r_be, im_be, &bunny_fig_small_be, f, mode); break;
+                    }
+                return now_us() - t0;
+                });
+            memcpy(fb_swap, fb_le, sizeof(fb_swap));
+            swap_pass(fb_swap);
+            if (memcmp(fb_swap, fb_be, sizeof(fb_swap)) != 0) errors++;
+            }
+        printf("%-16s %12.1f %12.1f %12.1f %12.1f\n", names[mode], t[0] / NB_FRAMES, t[1] / NB_FRAMES, (t[0] + t[1]) / NB_FRAMES, t[2] / NB_FRAMES);
+        }
+    printf("\n%s (%d frame(s) differ between RGB565+swap and RGB565BE)\n", (errors ? "FAILED" : "OK"), errors);
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
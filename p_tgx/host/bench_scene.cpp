@@ -0,0 +1,173 @@
+// bench_scene.cpp - retained scene with BVH frustum culling (Renderer3D::drawScene()) on the host.
+//
+// Builds a "dashboard" made of 24 panels holding 6 x 6 small instrument meshes
+// each (864 meshes) spread on a large wall, and flies the camera along the wall
+// so that only a few panels are on screen at a time. Every frame, one panel is
+// moved (the BVH is refitted). The scene is drawn once with a loop of
+// drawMesh() calls (one per instrument, each testing its own bounding box) and
+// once with drawScene(). Checks that both images are identical and reports the
+// timings and the culling statistics.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_scene.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_scene && ./bench_scene
+//
+#include "tgx.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 100
+#define PANELS_X 6
+#define PANELS_Y 4
+#define INSTR 6         // instruments per panel: INSTR x INSTR
+#define NB_NODES (PANELS_X * PANELS_Y * (1 + INSTR * INSTR) + 1)
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static SceneNode<RGB565> nodes[NB_NODES];
+static SceneBVHNode bvh[2 * NB_NODES];
+static Scene3D<RGB565> scene(nodes, bvh, NB_NODES);
+
+static Renderer3D<RGB565, SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_NOTEXTURE, float> renderer;
+
+
+// a small instrument: a flat box (a dial) with a needle on top.
+static const fVec3 box_vertices[8] = { {-0.4f,-0.4f,0}, {0.4f,-0.4f,0}, {0.4f,0.4f,0}, {-0.4f,0.4f,0}, {-0.4f,-0.4f,0.1f}, {0.4f,-0.4f,0.1f}, {0.4f,0.4f,0.1f}, {-0.4f,0.4f,0.1f} };
+static const uint16_t box_faces[] = { 1,4,5,6, 1,4,6,7, 1,0,1,5, 1,0,5,4, 1,1,2,6, 1,1,6,5, 1,2,3,7, 1,2,7,6, 1,3,0,4, 1,3,4,7, 0 };
+static const fVec3 needle_vertices[3] = { {-0.03f,0,0.11f}, {0.03f,0,0.11f}, {0,0.35f,0.11f} };
+static const uint16_t needle_faces[] = { 1,0,1,2, 0 };
+
+static const Mesh3D<RGB565> needle = { 1, 3, 0, 0, 1, 5, needle_vertices, nullptr, nullptr, needle_faces, nullptr, { 0.9f, 0.1f, 0.1f }, 0.3f, 0.7f, 0.0f, 8, nullptr, fBox3(-0.03f, 0.03f, 0, 0.35f, 0.11f, 0.11f), "needle" };
+static const Mesh3D<RGB565> dial = { 1, 8, 0, 0, 10, 41, box_vertices, nullptr, nullptr, box_faces, nullptr, { 0.8f, 0.8f, 0.7f }, 0.3f, 0.7f, 0.3f, 16, &needle, fBox3(-0.4f, 0.4f, -0.4f, 0.4f, 0, 0.1f), "dial" };
+
+static int panels[PANELS_X * PANELS_Y];
+
+
+static fMat4 translation(float x, float y, float z)
+    {
+    fMat4 M;
+    M.setTranslate({ x, y, z });
+    return M;
+    }
+
+
+static void build_scene()
+    {
+    const int root = scene.addNode(nullptr, translation(0, 0, 0));
+    int p = 0;
+    for (int j = 0; j < PANELS_Y; j++)
+        for (int i = 0; i < PANELS_X; i++)
+            {
+            panels[p] = scene.addNode(nullptr, translation(i * 8.0f - 20.0f, j * 8.0f - 12.0f, 0), root);
+            for (int b = 0; b < INSTR; b++)
+                for (int a = 0; a < INSTR; a++)
+                    {
+                    fMat4 M;
+                    M.setRotate(15.0f * (a + b), { 0, 0, 1 });
+                    M.multTranslate({ 1.2f * (a - 2.5f), 1.2f * (b - 2.5f), 0 });
+                    const int n = scene.addNode(&dial, M, panels[p]);
+                    if ((a + b) % 5 == 0) scene.setMaterial(n, RGBf(0.2f, 0.6f, 0.9f), 0.3f, 0.7f, 0.3f, 16);
+                    }
+            p++;
+            }
+    }
+
+
+/** draw every node with drawMesh() (what drawScene() replaces) */
+static void draw_immediate()
+    {
+    scene.update();
+    const fMat4 saved = renderer.getModelMatrix();
+    for (int i = 0; i < scene.nbNodes(); i++)
+        {
+        const SceneNode<RGB565>& N = scene.node(i);
+        if ((N.mesh == nullptr) || (!(N.flags & SceneNode<RGB565>::SCENE_SHOWN))) continue;
+        renderer.setModelMatrix(N.world);
+        if (N.flags & SceneNode<RGB565>::SCENE_MESH_MATERIAL)
+            {
+            renderer.drawMesh(N.mesh, true, true);
+            }
+        else
+            {
+            renderer.setMaterial(N.color, N.ambiant_strength, N.diffuse_strength, N.specular_strength, N.specular_exponent);
+            renderer.drawMesh(N.mesh, false, true);
+            }
+        }
+    renderer.setModelMatrix(saved);
+    }
+
+
+static void setup_frame(Image<RGB565>& im, int frame)
+    {
+    const float t = (float)frame / NB_FRAMES;
+    const float cx = -24.0f + 48.0f * t;
+    const float cy = 8.0f * (t - 0.5f);
+    renderer.setLookAt({ cx, cy, 9.0f }, { cx + 2.0f, cy, 0.0f }, { 0, 1, 0 });
+    const int p = frame % (PANELS_X * PANELS_Y);
+    fMat4 M;
+    M.setRotate(10.0f * frame, { 0, 0, 1 }); // spin one panel in front of the others (the BVH is refitted)
+    M.multTranslate({ (p % PANELS_X) * 8.0f - 20.0f, (p / PANELS_X) * 8.0f - 12.0f, 0.5f });
+    scene.setTransform(panels[p], M);
+    const int q = (p + PANELS_X * PANELS_Y - 1) % (PANELS_X * PANELS_Y); // put back the previous one
+    scene.setTransform(panels[q], translation((q % PANELS_X) * 8.0f - 20.0f, (q / PANELS_X) * 8.0f - 12.0f, 0));
+    renderer.setImage(&im);
+    im.fillScreen(RGB565_Black);
+    renderer.clearZbuffer();
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setShaders(SHADER_FLAT);
+    renderer.setCulling(1);
+    build_scene();
+
+    int errors = 0;
+    double t[2] = { 0, 0 }; // drawMesh() loop, drawScene()
+    uint32_t drawn = 0;
+    renderer.resetSceneStats();
+    for (int f = 0; f < NB_FRAMES; f++)
+        {
+        timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+            {
+            const bool use_scene = (v == 1);
+            setup_frame(use_scene ? im : im_ref, f);
+            const double t0 = now_us();
+            if (use_scene) renderer.drawScene(&scene); else draw_immediate();
+            return now_us() - t0;
+            });
+        if (memcmp(fb, fb_ref, sizeof(fb)) != 0) errors++;
+        }
+    uint32_t tested, culled;
+    renderer.getSceneStats(tested, culled, drawn);
+    const double runs = (double)NB_FRAMES * BENCH_REPEATS; // drawScene() runs BENCH_REPEATS times per frame
+
+    int nb_meshes = 0;
+    for (int i = 0; i < scene.nbNodes(); i++) if (scene.node(i).mesh) nb_meshes++;
+    printf("%d frames %dx%d, %d nodes, %d meshes (x2 chained), %d BVH nodes, times: fastest of %d runs\n\n", NB_FRAMES, LX, LY, scene.nbNodes(), nb_meshes, scene.nbBVHNodes(), BENCH_REPEATS);
+    printf("drawMesh() loop : %8.1f us/frame\n", t[0] / NB_FRAMES);
+    printf("drawScene()     : %8.1f us/frame\n", t[1] / NB_FRAMES);
+    printf("boxes tested    : %8.1f per frame\n", tested / runs);
+    printf("boxes culled    : %8.1f per frame\n", culled / runs);
+    printf("nodes drawn     : %8.1f per frame (out of %d)\n", drawn / runs, nb_meshes);
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,163 @@
+// bench_sphere_cache.cpp - cached sphere tessellations (Renderer3D::setSphereCache()) on the host.
+//
+// Draws 200 spheres of various sizes and colors packed in a rotating ball
+// with a loop of setModelMatrix() / setMaterialColor() / drawSphere() calls,
+// with and without a SphereMeshCache, in four ways:
+// - drawSphere(24, 12) with Gouraud shading,
+// - drawAdaptativeSphere() with Gouraud shading (a few tessellation levels
+//   per frame, depending on the distance of each sphere),
+// - drawSphere(24, 12) with a texture,
+// - drawSphere(24, 12) with a static mesh registered with addStatic().
+// Reports the timings and the cache statistics, checks that the cached meshes
+// give the same image as the direct tessellation (up to the diagonal chosen
+// for each quad) and that the cache only builds each level once. On the
+// host, the trigonometric functions and the vertex transforms are cheap
+// next to the rasterization so the gain is small: it is larger on
+// microcontrollers without floating point unit.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_sphere_cache.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_sphere_cache && ./bench_sphere_cache
+//
+#include "tgx.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 50
+#define NB_SPHERES 200
+#define TEX_LX 64
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+static uint16_t tex_buf[TEX_LX * TEX_LX];
+
+// cache: 8 slots of 12KB (a 24x12 sphere with texture coords needs 8.5KB)
+static uint32_t cache_buf[8 * 3072];
+static SphereMeshCache<RGB565> cache(cache_buf, sizeof(cache_buf), 8);
+
+// static mesh: built once in a separate buffer, as a generated header would provide it
+static uint32_t static_buf[sphereMeshSize(24, 12, false) / 4 + 1];
+static Mesh3D<RGB565> static_sphere;
+static SphereMeshCache<RGB565> static_cache(nullptr, 0);
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_GOURAUD | SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+static fVec3 centers[NB_SPHERES];
+static float radii[NB_SPHERES];
+static RGBf colors[NB_SPHERES];
+
+
+/** draw the spheres: 0 = drawSphere(24, 12), 1 = drawAdaptativeSphere(), 2 = textured drawSphere(24, 12), 3 = drawSphere(24, 12) (static mesh), return the time in us */
+static double draw_scene(Image<RGB565>& im, int method, int frame, SphereMeshCache<RGB565>* C)
+    {
+    static Image<RGB565> texture((RGB565*)tex_buf, TEX_LX, TEX_LX);
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate({ 0, 0, -4.0f });
+    renderer.setImage(&im);
+    renderer.setSphereCache(C);
+    renderer.setShaders((method == 2) ? (SHADER_GOURAUD | SHADER_TEXTURE) : SHADER_GOURAUD);
+    im.fillScreen(RGB565_Black);
+    renderer.clearZbuffer();
+    const double t0 = now_us();
+    for (int i = 0; i < NB_SPHERES; i++)
+        {
+        fMat4 S;
+        S.setScale(radii[i], radii[i], radii[i]);
+        S.multTranslate(centers[i]);
+        renderer.setModelMatrix(M * S);
+        renderer.setMaterialColor(colors[i]);
+        switch (method)
+            {
+            case 1: renderer.drawAdaptativeSphere(); break;
+            case 2: renderer.drawSphere(24, 12, &texture); break;
+            default: renderer.drawSphere(24, 12); break;
+            }
+        }
+    return now_us() - t0;
+    }
+
+
+int main()
+    {
+    Image<RGB565> texture((RGB565*)tex_buf, TEX_LX, TEX_LX);
+    for (int j = 0; j < TEX_LX; j++) for (int i = 0; i < TEX_LX; i++) texture(i, j) = (((i >> 3) + (j >> 3)) & 1) ? RGB565_White : RGB565_Red;
+    buildSphereMesh(&static_sphere, 24, 12, false, static_buf, sizeof(static_buf));
+    static_cache.addStatic(&static_sphere, 24, 12, false);
+
+    srand(1);
+    for (int i = 0; i < NB_SPHERES; i++)
+        {
+        fVec3 P;
+        do { P = fVec3(rand() * 2.0f / RAND_MAX - 1, rand() * 2.0f / RAND_MAX - 1, rand() * 2.0f / RAND_MAX - 1); } while (P.norm() > 1);
+        centers[i] = P * 1.2f;
+        radii[i] = 0.1f + 0.15f * rand() / RAND_MAX;
+        colors[i] = RGBf(0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX);
+        }
+
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setMaterial(RGBf(0.75f, 0.75f, 0.75f), 0.15f, 0.7f, 0.5f, 16);
+    renderer.setCulling(1);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+
+    const char* names[4] = { "24x12", "adaptive", "textured", "static" };
+    int errors = 0;
+    printf("%d frames %dx%d, %d spheres, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, NB_SPHERES, BENCH_REPEATS);
+    printf("%-10s %10s %10s %9s %8s %8s %10s %8s\n", "spheres", "direct", "cached", "speedup", "builds", "hits", "coverage", "color");
+    for (int method = 0; method < 4; method++)
+        {
+        SphereMeshCache<RGB565>* C = (method == 3) ? &static_cache : &cache;
+        C->clear();
+        C->resetStats();
+        double t[2] = { 0, 0 }, covered = 0, coverage = 0, color_err = 0, compared = 0; // t: direct, cached
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                return (v == 0) ? draw_scene(im_ref, method, f, nullptr) : draw_scene(im, method, f, C);
+                });
+            long cov = 0, diff = 0;
+            for (int i = 0; i < LX * LY; i++)
+                {
+                if (fb_ref[i] != 0) cov++;
+                if ((fb[i] == 0) != (fb_ref[i] == 0)) { diff++; continue; }
+                if (fb[i] == 0) continue;
+                const RGB565 a(fb[i]), b(fb_ref[i]);
+                color_err += (abs(a.R - b.R) + abs(a.G - b.G) / 2 + abs(a.B - b.B)) / 3.0;
+                compared++;
+                }
+            covered += cov;
+            coverage += diff;
+            if (diff * 200 > cov) errors++; // coverage differs on less than 0.5% of the pixels
+            }
+        const double mean_err = color_err / compared;
+        if (mean_err > 0.5) errors++; // less than half an RGB565 step on average
+        if ((int)C->nbBuilds() > ((method == 1) ? 8 : 1)) errors++; // each level is built once (less than 8 adaptive levels: no eviction)
+        printf("%-10s %10.1f %10.1f %8.2fx %8u %8u %9.2f%% %8.2f\n", names[method], t[0] / NB_FRAMES, t[1] / NB_FRAMES, t[0] / t[1], (unsigned)C->nbBuilds(), (unsigned)C->nbHits(), 100.0 * coverage / covered, mean_err);
+        }
+    printf("(builds and hits: for the whole run, coverage: pixels covered by only one of the two images,\n color: mean difference on a channel in RGB565 steps where both are covered)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
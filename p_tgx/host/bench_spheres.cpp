@@ -0,0 +1,183 @@
+// bench_spheres.cpp - sphere impostors (Renderer3D::drawSpheres()) on the host.
+//
+// Two scenes, each drawn with tessellated spheres (a loop of setModelMatrix() /
+// setMaterialColor() / drawSphere() calls, Gouraud shading), once finely
+// tessellated (48 sectors, 24 stacks: the reference) and once with
+// drawAdaptativeSphere(), and with a single drawSpheres() call:
+// - molecule: 400 spheres of various sizes and colors packed in a rotating
+//   ball, intersecting each other.
+// - bunny: the bunny of pgx_bunny.cpp crossed by 12 spheres, to check that
+//   impostors and meshes intersect correctly in the z-buffer.
+// Reports the timings and the vertices sent per frame by the adaptive
+// spheres. Checks that the impostors cover the same pixels as the reference
+// (up to the outline: a polygon versus an ellipse) and that the colors are
+// close (per pixel versus Gouraud lighting).
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_spheres.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_spheres && ./bench_spheres
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 50
+#define NB_ATOMS 400
+#define NB_BALLS 12
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb_adapt[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_GOURAUD | SHADER_NOTEXTURE;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+static fVec3 centers[NB_ATOMS];
+static float radii[NB_ATOMS];
+static RGBf colors[NB_ATOMS];
+static int nb_spheres;
+static long nb_vertices;
+
+
+/** draw the spheres of the scene (in model space): 0 = fine tessellation, 1 = adaptive tessellation, 2 = impostors */
+static void draw_spheres(const fMat4& M, int method)
+    {
+    if (method == 2)
+        {
+        renderer.setModelMatrix(M);
+        renderer.drawSpheres(nb_spheres, centers, radii, colors);
+        return;
+        }
+    for (int i = 0; i < nb_spheres; i++)
+        {
+        fMat4 S;
+        S.setScale(radii[i], radii[i], radii[i]);
+        S.multTranslate(centers[i]);
+        renderer.setModelMatrix(M * S);
+        renderer.setMaterialColor(colors[i]);
+        if (method == 0) renderer.drawSphere(48, 24); else renderer.drawAdaptativeSphere();
+        }
+    }
+
+
+/** draw a scene, return the time in us */
+static double draw_scene(int scene, int method, int frame)
+    {
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate({ 0, 0, (scene == 0) ? -4.0f : -2.5f });
+    const double t0 = now_us();
+    if (scene == 1)
+        {
+        renderer.setModelMatrix(M);
+        renderer.setMaterialColor(RGBf(0.75f, 0.75f, 0.75f));
+        renderer.drawMesh(&bunny_fig_small, false);
+        }
+    draw_spheres(M, method);
+    return now_us() - t0;
+    }
+
+
+/** number of vertices of drawAdaptativeSphere() for the spheres of the scene at a given frame (same rule as Renderer3D) */
+static long count_vertices(int scene, int frame)
+    {
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate({ 0, 0, (scene == 0) ? -4.0f : -2.5f });
+    long nb = 0;
+    for (int i = 0; i < nb_spheres; i++)
+        {
+        const fVec4 P = M.mult1(centers[i]);
+        const float l = radii[i] * 2.4142f * LY / -P.z; // diameter on the screen (fovy = 45 degrees)
+        const int nb_stacks = 2 + (int)sqrtf(l);
+        nb += (long)(nb_stacks * 2 - 2) * (nb_stacks - 1) + 2;
+        }
+    return nb;
+    }
+
+
+int main()
+    {
+    Image<RGB565> images[3] = { Image<RGB565>((RGB565*)fb_ref, LX, LY), Image<RGB565>((RGB565*)fb_adapt, LX, LY), Image<RGB565>((RGB565*)fb, LX, LY) };
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setShaders(SHADER_GOURAUD);
+    renderer.setMaterial(RGBf(0.75f, 0.75f, 0.75f), 0.15f, 0.7f, 0.5f, 16);
+
+    const char* names[2] = { "molecule", "bunny" };
+    int errors = 0;
+    printf("%d frames %dx%d, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, BENCH_REPEATS);
+    printf("%-10s %8s %10s %10s %10s %10s %9s %10s %8s\n", "scene", "spheres", "vertices", "48x24", "adaptive", "impostors", "speedup", "coverage", "color");
+    for (int scene = 0; scene < 2; scene++)
+        {
+        srand(1 + scene);
+        nb_spheres = (scene == 0) ? NB_ATOMS : NB_BALLS;
+        for (int i = 0; i < nb_spheres; i++)
+            {
+            fVec3 P;
+            do { P = fVec3(rand() * 2.0f / RAND_MAX - 1, rand() * 2.0f / RAND_MAX - 1, rand() * 2.0f / RAND_MAX - 1); } while (P.norm() > 1);
+            if (scene == 0)
+                {
+                centers[i] = P * 1.2f;
+                radii[i] = 0.08f + 0.1f * rand() / RAND_MAX;
+                }
+            else
+                {
+                centers[i] = fVec3(P.x * 0.5f, P.y * 0.9f, P.z * 0.4f);
+                radii[i] = 0.1f + 0.1f * rand() / RAND_MAX;
+                }
+            colors[i] = RGBf(0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX, 0.3f + 0.7f * rand() / RAND_MAX);
+            }
+        double t[3] = { 0, 0, 0 }, covered = 0, coverage = 0, color_err = 0, compared = 0;
+        nb_vertices = 0;
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(3, f, BENCH_REPEATS, t, [&](int method, int)
+                {
+                renderer.setImage(&images[method]);
+                images[method].fillScreen(RGB565_Black);
+                renderer.clearZbuffer();
+                return draw_scene(scene, method, f);
+                });
+            nb_vertices += count_vertices(scene, f);
+            long cov = 0, diff = 0;
+            for (int i = 0; i < LX * LY; i++)
+                {
+                if (fb_ref[i] != 0) cov++;
+                if ((fb[i] == 0) != (fb_ref[i] == 0)) { diff++; continue; }
+                if (fb[i] == 0) continue;
+                const RGB565 a(fb[i]), b(fb_ref[i]);
+                color_err += (abs(a.R - b.R) + abs(a.G - b.G) / 2 + abs(a.B - b.B)) / 3.0;
+                compared++;
+                }
+            covered += cov;
+            coverage += diff;
+            if (diff * 50 > cov) errors++; // coverage differs on less than 2% of the pixels
+            }
+        const double mean_err = color_err / compared;
+        if (mean_err > 1.0) errors++; // less than one RGB565 step on average
+        printf("%-10s %8d %10ld %10.1f %10.1f %10.1f %8.2fx %9.2f%% %8.2f\n", names[scene], nb_spheres, nb_vertices / NB_FRAMES, t[0] / NB_FRAMES, t[1] / NB_FRAMES, t[2] / NB_FRAMES, t[1] / t[2], 100.0 * coverage / covered, mean_err);
+        }
+    printf("(vertices: per frame for the adaptive spheres, speedup: impostors versus adaptive spheres,\n coverage: pixels covered by only one of the impostor and 48x24 images,\n color: mean difference on a channel in RGB565 steps where both are covered)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
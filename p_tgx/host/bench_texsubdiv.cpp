@@ -0,0 +1,147 @@
+// bench_texsubdiv.cpp - span subdivided perspective texturing (SHADER_TEXTURE_SUBDIV) on the host.
+//
+// Renders the textured bunny of pgx_bunny.cpp (and a large textured wall seen
+// at a grazing angle, the worst case for linear interpolation since the depth
+// varies quickly along the scanlines) once with the exact
+// per pixel perspective division and once with the division computed every
+// TGX_TEXTURE_SUBDIV_SPAN pixels. Reports the timings and the difference
+// between both images: number of differing pixels and mean / max error per
+// channel (in 8 bits units) over the differing pixels.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_texsubdiv.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_texsubdiv && ./bench_texsubdiv
+//
+// Add -DTGX_TEXTURE_SUBDIV_SPAN=8 to compare with shorter spans.
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#ifndef NB_FRAMES
+#define NB_FRAMES 50
+#endif
+
+static uint16_t fb_exact[LX * LY];
+static uint16_t fb_subdiv[LX * LY];
+static uint16_t zbuf[LX * LY];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_BILINEAR | SHADER_TEXTURE_SUBDIV | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+static Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+
+/** scenes: 0 = bunny, 1 = bunny (close), 2 = wall at a grazing angle */
+static void draw_scene(Image<RGB565BE>& im, int frame, int scene)
+    {
+    im.fillScreen(RGB565BE(RGB565_Cyan));
+    renderer.clearZbuffer();
+    fMat4 M;
+    if (scene < 2)
+        {
+        M.setScale({ 9, 9, 9 });
+        M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+        M.multTranslate({ 0, (scene == 1) ? -2.0f : 0.0f, (scene == 1) ? -15.0f : -25.0f });
+        renderer.setModelMatrix(M);
+        renderer.drawMesh(&bunny_fig_small_be, false);
+        return;
+        }
+    M.setRotate(90.0f, { 0, 0, 1 }); // vertical wall 
+    M.multRotate(60.0f - 120.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ -3, 0, -20 });
+    renderer.setModelMatrix(M);
+    const fVec3 P1(-30, 0, -30), P2(-30, 0, 30), P3(30, 0, 30), P4(30, 0, -30);
+    const fVec3 N(0, 1, 0);
+    const fVec2 T1(0, 0), T2(0, 8), T3(8, 8), T4(8, 0);
+    renderer.drawQuad(P1, P2, P3, P4, &N, &N, &N, &N, &T1, &T2, &T3, &T4, &bunny_fig_texture_be);
+    }
+
+
+int main()
+    {
+    Image<RGB565BE> im_exact((RGB565BE*)fb_exact, LX, LY);
+    Image<RGB565BE> im_subdiv((RGB565BE*)fb_subdiv, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setCulling(0);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+
+    const char* scenes[3] = { "bunny", "bunny (close)", "grazing wall" };
+    const Shader qualities[2] = { SHADER_TEXTURE_NEAREST, SHADER_TEXTURE_BILINEAR };
+    const char* qnames[2] = { "nearest", "bilinear" };
+    int errors = 0;
+    printf("%d frames %dx%d per scene, subdivision every %d pixels, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, TGX_TEXTURE_SUBDIV_SPAN, BENCH_REPEATS);
+    printf("%-14s %-9s %10s %10s %12s %10s %10s\n", "scene", "sampling", "exact", "subdiv", "diff pixels", "mean err", "max err");
+    for (int scene = 0; scene < 3; scene++)
+        {
+        for (int q = 0; q < 2; q++)
+            {
+            double t[2] = { 0, 0 }; // exact, subdiv
+            int64_t ndiff = 0, npix = 0, sum_err = 0;
+            int max_err = 0;
+            for (int f = 0; f < NB_FRAMES; f++)
+                {
+                timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                    {
+                    const bool subdiv = (v == 1);
+                    renderer.setTextureQuality(subdiv ? (qualities[q] | SHADER_TEXTURE_SUBDIV) : qualities[q]);
+                    renderer.setImage(subdiv ? &im_subdiv : &im_exact);
+                    const double t0 = now_us();
+                    draw_scene(subdiv ? im_subdiv : im_exact, f, scene);
+                    return now_us() - t0;
+                    });
+                for (int i = 0; i < LX * LY; i++)
+                    {
+                    if (zbuf[i]) npix++;
+                    if (fb_exact[i] == fb_subdiv[i]) continue;
+                    ndiff++;
+                    const RGB24 a((RGB565)((RGB565BE*)fb_exact)[i]);
+                    const RGB24 b((RGB565)((RGB565BE*)fb_subdiv)[i]);
+                    const int e = max(abs(a.R - b.R), max(abs(a.G - b.G), abs(a.B - b.B)));
+                    sum_err += e;
+                    if (e > max_err) max_err = e;
+                    }
+                }
+            const double pdiff = (npix ? 100.0 * ndiff / npix : 0.0);
+            printf("%-14s %-9s %10.1f %10.1f %11.2f%% %10.1f %10d\n", scenes[scene], qnames[q], t[0] / NB_FRAMES, t[1] / NB_FRAMES,
+                pdiff, (ndiff ? (double)sum_err / ndiff : 0.0), max_err);
+            if ((scene < 2) && (pdiff > 5.0)) errors++; // on the bunny, less than 5% of the rendered pixels may differ
+            }
+        }
+    printf("(diff pixels in percent of the rendered pixels, errors per channel over the differing pixels)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,147 @@
+// bench_tiles.cpp - tile rendering (Renderer3D::beginTiles() / endTiles()) on the host.
+//
+// Renders the bunny scene of pgx_bunny.cpp once directly into a full size
+// framebuffer with a full size z-buffer and once with the triangles binned
+// into tiles, each tile being rasterized into a small color buffer and
+// z-buffer then written back to the framebuffer. Checks that both images are
+// identical and reports timings and memory use for several tile sizes.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_tiles.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_tiles && ./bench_tiles
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 50
+#define MAX_TRIS 1200
+#define NB_BINS 4096
+
+static uint16_t fb[LX * LY];
+static uint16_t zbuf[LX * LY];
+static uint16_t fb_tiles[LX * LY];
+
+static uint16_t tile_buf[64 * 64];
+static uint16_t tile_zbuf[64 * 64];
+static uint16_t bins[NB_BINS];
+static uint8_t tri_buf[MAX_TRIS * 128];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+static Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+
+static void set_scene(int frame, int mode)
+    {
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, (mode == 3) ? -2.0f : 0.0f, (mode == 3) ? -15.0f : -25.0f });
+    renderer.setModelMatrix(M);
+    switch (mode)
+        {
+        case 0: renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE); break;
+        case 1: renderer.setShaders(SHADER_FLAT); break;
+        default: renderer.setShaders(SHADER_GOURAUD); break;
+        }
+    }
+
+
+int main()
+    {
+    Image<RGB565BE> im((RGB565BE*)fb, LX, LY);
+    Image<RGB565BE> im_tiles((RGB565BE*)fb_tiles, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setCulling(1);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    renderer.setTriangleBuffer(tri_buf, sizeof(tri_buf), bins, NB_BINS);
+
+    const RGB565BE bg(RGB565_Cyan);
+    const char* names[4] = { "gouraud+texture", "flat", "gouraud", "gouraud (close)" };
+    const int tiles[3][2] = { { 32, 32 }, { 64, 16 }, { 64, 64 } };
+    int errors = 0;
+    int max_tris = 0;
+    printf("%d frames %dx%d per mode, times in us/frame (fastest of %d runs), %d bytes per binned triangle\n\n", NB_FRAMES, LX, LY, BENCH_REPEATS, renderer.tileTriangleSize());
+    printf("%-16s %7s %12s %12s %14s\n", "mode", "tile", "full frame", "tiles", "diff pixels");
+    for (int mode = 0; mode < 4; mode++)
+        {
+        for (int k = 0; k < 3; k++)
+            {
+            renderer.setTileBuffers(tiles[k][0], tiles[k][1], (RGB565BE*)tile_buf, tile_zbuf);
+            double t[2] = { 0, 0 }; // full frame, tiles
+            int diff = 0;
+            for (int f = 0; f < NB_FRAMES; f++)
+                {
+                set_scene(f, mode);
+                timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int)
+                    {
+                    const double t0 = now_us();
+                    if (v == 0)
+                        {
+                        renderer.setImage(&im);
+                        renderer.setZbuffer(zbuf);
+                        im.fillScreen(bg);
+                        renderer.clearZbuffer();
+                        renderer.drawMesh(&bunny_fig_small_be, false);
+                        return now_us() - t0;
+                        }
+                    renderer.setImage(&im_tiles);
+                    renderer.setZbuffer(nullptr);
+                    im_tiles.fillScreen(bg);
+                    renderer.beginTiles();
+                    renderer.drawMesh(&bunny_fig_small_be, false);
+                    const int nb = renderer.endTiles();
+                    const double t1 = now_us();
+                    if (nb > max_tris) max_tris = nb;
+                    return t1 - t0;
+                    });
+                for (int i = 0; i < LX * LY; i++) if (fb[i] != fb_tiles[i]) diff++;
+                }
+            char tname[16];
+            snprintf(tname, sizeof(tname), "%dx%d", tiles[k][0], tiles[k][1]);
+            printf("%-16s %7s %12.1f %12.1f %14d\n", names[mode], tname, t[0] / NB_FRAMES, t[1] / NB_FRAMES, diff);
+            if (diff) errors++;
+            }
+        }
+
+    const int full_mem = (int)sizeof(zbuf);
+    const int tile_mem = 32 * 32 * 2 * 2 + max_tris * renderer.tileTriangleSize() + (int)sizeof(bins);
+    printf("\nmemory besides the framebuffer: full z-buffer %d bytes, 32x32 tiles %d bytes (%d triangles binned at most, buffer for %d)\n",
+        full_mem, tile_mem, max_tris, (int)(sizeof(tri_buf) / renderer.tileTriangleSize()));
+    if (max_tris * renderer.tileTriangleSize() > (int)sizeof(tri_buf)) errors++;
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,66 @@
+// bench_tools.h - timing helpers shared by the host benchmarks (bench_*.cpp).
+//
+// - now_us() reads the steady clock in microseconds.
+// - timeVariants() times the variants of a frame (e.g. the reference and the
+//   optimized rendering): each variant runs several times in a rotating order
+//   and only its fastest run is kept. A single run is too noisy on a desktop
+//   machine (5-20% from one run to the next) to compare variants that differ
+//   by a few percent.
+//
+// Host only: uses the standard library.
+//
+#pragma once
+
+#include <chrono>
+
+
+/** default number of runs of each variant of a frame (the fastest one is kept) */
+#ifndef BENCH_REPEATS
+#define BENCH_REPEATS 5
+#endif
+
+/** maximum number of variants timed together by timeVariants() */
+#define BENCH_MAX_VARIANTS 8
+
+
+namespace bench_tools
+{
+
+    /** current time in microseconds */
+    inline double now_us()
+        {
+        using namespace std::chrono;
+        return (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count() / 1000.0;
+        }
+
+
+    /**
+     * Time the 'nb' variants of a frame. Each variant runs 'repeats' times and
+     * its fastest run is added to total[v]. The order of the variants rotates
+     * with the frame and the repeat so that none always runs with the caches
+     * warmed (or evicted) by another.
+     *
+     * run(v, r) draws variant v for repeat r and returns its time in us, so
+     * that it can leave its setup out of the timing. Statistics and image
+     * checks are usually taken on the first repeat only (r == 0).
+     */
+    template<typename RUN> void timeVariants(int nb, int frame, int repeats, double* total, RUN run)
+        {
+        if ((nb <= 0) || (nb > BENCH_MAX_VARIANTS)) return;
+        double best[BENCH_MAX_VARIANTS];
+        for (int v = 0; v < nb; v++) best[v] = 1e30;
+        for (int r = 0; r < repeats; r++)
+            {
+            for (int k = 0; k < nb; k++)
+                {
+                const int v = (frame + r + k) % nb;
+                const double t = run(v, r);
+                if (t < best[v]) best[v] = t;
+                }
+            }
+        for (int v = 0; v < nb; v++) total[v] += best[v];
+        }
+
+}
+
+/** end of file */
@@ -0,0 +1,117 @@
+// bench_tsort.cpp - front to back mode of Renderer3D::drawMesh() (see setTriangleSortBuffer()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp (textured, Gouraud shading, z-buffer)
+// rotating in front of the camera, with and without the triangle sort buffer,
+// with the vertex cache, with the batched vertex stage and with back-face
+// culling disabled (the hidden side of the bunny is drawn too). Reports the
+// timings and the overdraw (fragments shaded per pixel covered, counted by the
+// renderer with getFragmentStats()), and checks that the images only differ
+// on a few pixels (fragments at exactly the same depth may be resolved
+// differently when the order of the triangles changes). Without culling, only
+// the coverage is compared: drawing in order reuses the color of a vertex lit
+// for the previous triangle of its strip even when that triangle faced the
+// other way, while the sorted triangles are each lit with their own side.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_tsort.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_tsort && ./bench_tsort
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 100
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static float zbuf[LX * LY];
+
+static VertexCacheEntry vcache[2048];
+static float vbatch[40000];
+static TriangleSortEntry tsort[4096];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_GOURAUD | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+static Renderer3D<RGB565, LOADED_SHADERS, float> renderer;
+
+
+static void draw_bunny(Image<RGB565>& im, int frame)
+    {
+    fMat4 M;
+    M.setRotate(360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multRotate(20.0f, { 1, 0, 0 });
+    M.multTranslate({ 0, 0, -2.5f });
+    renderer.setModelMatrix(M);
+    im.fillScreen(RGB565_Black);
+    renderer.clearZbuffer();
+    renderer.drawMesh(&bunny_fig_small, true);
+    }
+
+
+int main()
+    {
+    Image<RGB565> im_ref((RGB565*)fb_ref, LX, LY);
+    Image<RGB565> im((RGB565*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+    renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+
+    const char* modes[3] = { "vertex cache", "batch stage", "no culling" };
+    int errors = 0;
+    long max_diff = 0;
+    printf("%d frames %dx%d, bunny with %d triangles, textured Gouraud, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, bunny_fig_small.nb_faces, BENCH_REPEATS);
+    printf("%-14s %10s %10s %12s %12s\n", "", "in order", "sorted", "overdraw", "sorted");
+    for (int mode = 0; mode < 3; mode++)
+        {
+        renderer.setVertexCache((mode == 0) ? vcache : nullptr, 2048);
+        renderer.setVertexBatchBuffer((mode >= 1) ? vbatch : nullptr, 40000);
+        renderer.setCulling((mode == 2) ? 0 : 1);
+        double t[2] = { 0, 0 }; // in order, sorted
+        double frag_ref = 0, frag_sort = 0, covered = 0;
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(2, f, BENCH_REPEATS, t, [&](int v, int rep)
+                {
+                const bool sorted = (v == 1);
+                renderer.setTriangleSortBuffer(sorted ? tsort : nullptr, 4096);
+                renderer.setImage(sorted ? &im : &im_ref);
+                renderer.resetFragmentStats();
+                const double t0 = now_us();
+                draw_bunny(sorted ? im : im_ref, f);
+                const double t1 = now_us();
+                if (rep == 0) { if (sorted) frag_sort += renderer.getFragmentStats(); else frag_ref += renderer.getFragmentStats(); }
+                return t1 - t0;
+                });
+            long diff = 0, coverage = 0;
+            for (int i = 0; i < LX * LY; i++)
+                {
+                if (fb_ref[i] != 0) covered++;
+                if (fb[i] != fb_ref[i]) diff++;
+                if ((fb[i] == 0) != (fb_ref[i] == 0)) coverage++;
+                }
+            if (mode == 2) diff = coverage;
+            if (diff > max_diff) max_diff = diff;
+            if (diff > 20) errors++;
+            }
+        printf("%-14s %10.1f %10.1f %12.3f %12.3f\n", modes[mode], t[0] / NB_FRAMES, t[1] / NB_FRAMES, frag_ref / covered, frag_sort / covered);
+        }
+    printf("(overdraw: fragments shaded per pixel covered, in order and sorted front to back)\n");
+    printf("at most %ld pixels differ in a frame (coverage only without culling)\n", max_diff);
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
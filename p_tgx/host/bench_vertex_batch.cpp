@@ -0,0 +1,150 @@
+// bench_vertex_batch.cpp - batched vertex stage of drawMesh() (Renderer3D::setVertexBatchBuffer()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp with the per vertex (lazy) code path and
+// with the batched vertex stage and checks that the images are identical.
+// Reports the time of drawMesh() in both cases and, separately, the time of
+// the batch kernels alone (batchTransform() + batchProject() + batchNormalDots()
+// on the whole mesh) so that the geometry and raster parts can be profiled
+// independently.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_vertex_batch.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_vertex_batch && ./bench_vertex_batch
+//
+// Add -DTGX_VERTEX_BATCH_SIMD=0 to measure the plain C++ kernels (used on the RP2350).
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 50
+#define NB_VERTICES 1093 // number of vertices of the bunny
+#define NB_NORMALS 1093  // number of normals of the bunny
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static uint16_t zbuf[LX * LY];
+static float batch_buf[8 * 1096 + 1096 / 4 + 3 * NB_NORMALS]; // = vertexBatchBufferSize(NB_VERTICES, NB_NORMALS)
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ORTHO | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+static Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+
+static fMat4 model_matrix(int frame, int mode)
+    {
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, (mode == 4) ? -4.0f : 0.0f, (mode == 4) ? -8.0f : -25.0f });
+    return M;
+    }
+
+
+/** modes: 0 = gouraud+texture, 1 = gouraud, 2 = flat, 3 = gouraud without culling, 4 = gouraud (close, clipped), 5 = gouraud (ortho) */
+static void draw_scene(Image<RGB565BE>& im, int frame, int mode)
+    {
+    switch (mode)
+        {
+        case 0: renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE); break;
+        case 2: renderer.setShaders(SHADER_FLAT); break;
+        default: renderer.setShaders(SHADER_GOURAUD); break;
+        }
+    if (mode == 5) renderer.setOrtho(-8, 8, -10.7f, 10.7f, 1, 100); else renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setCulling((mode == 3) ? 0 : 1);
+    renderer.setModelMatrix(model_matrix(frame, mode));
+    im.fillScreen(RGB565BE(RGB565_Cyan));
+    renderer.clearZbuffer();
+    renderer.drawMesh(&bunny_fig_small_be, false);
+    }
+
+
+/** time of the batch kernels alone on the whole mesh */
+static double time_kernels(int frame, int mode)
+    {
+    static float d1[NB_NORMALS], d2[NB_NORMALS];
+    const int n4 = (NB_VERTICES + 3) & ~3;
+    float* p = batch_buf;
+    fMat4 P;
+    if (mode == 5) P.setOrtho(-8, 8, -10.7f, 10.7f, 1, 100); else P.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    const fMat4 M = model_matrix(frame, mode);
+    const fVec3 L(0.3f, 0.5f, 0.8f), H(0, 0, 1);
+    const double t0 = now_us();
+    batchTransform(M, bunny_fig_small.vertice, NB_VERTICES, p, p + n4, p + 2 * n4, p + 3 * n4);
+    batchProject(P, (mode == 5), 1.5f, NB_VERTICES, p, p + n4, p + 2 * n4, p + 3 * n4, p + 4 * n4, p + 5 * n4, p + 6 * n4, p + 7 * n4, (uint8_t*)(p + 8 * n4));
+    if (mode != 2) batchNormalDots(M, bunny_fig_small.normal, NB_NORMALS, L, H, d1, d2);
+    return now_us() - t0;
+    }
+
+
+int main()
+    {
+    Image<RGB565BE> im_ref((RGB565BE*)fb_ref, LX, LY);
+    Image<RGB565BE> im((RGB565BE*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+    if ((int)(sizeof(batch_buf) / sizeof(float)) != Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t>::vertexBatchBufferSize(NB_VERTICES, NB_NORMALS))
+        {
+        printf("wrong batch buffer size\n\nFAILED\n");
+        return 1;
+        }
+
+    const char* modes[6] = { "gouraud+texture", "gouraud", "flat", "gouraud/no cull", "gouraud (close)", "gouraud (ortho)" };
+    int errors = 0;
+    printf("%d frames %dx%d per mode, bunny with %d vertices, SIMD = %d, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, NB_VERTICES, TGX_VERTEX_BATCH_SIMD, BENCH_REPEATS);
+    printf("%-16s %12s %12s %14s\n", "mode", "per vertex", "batched", "batch kernels");
+    for (int mode = 0; mode < 6; mode++)
+        {
+        double t[3] = { 0, 0, 0 }; // per vertex, batched, batch kernels
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(3, f, BENCH_REPEATS, t, [&](int v, int)
+                {
+                if (v == 2) return time_kernels(f, mode);
+                const bool batched = (v == 1);
+                renderer.setVertexBatchBuffer(batched ? batch_buf : nullptr, (int)(sizeof(batch_buf) / sizeof(float)));
+                renderer.setImage(batched ? &im : &im_ref);
+                const double t0 = now_us();
+                draw_scene(batched ? im : im_ref, f, mode);
+                return now_us() - t0;
+                });
+            if (memcmp(fb, fb_ref, sizeof(fb)) != 0) errors++;
+            }
+        printf("%-16s %12.1f %12.1f %14.1f\n", modes[mode], t[0] / NB_FRAMES, t[1] / NB_FRAMES, t[2] / NB_FRAMES);
+        }
+    printf("(batch kernels: transform + projection + normal dot products of the whole mesh, without the Phong lookup)\n");
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
@@ -0,0 +1,132 @@
+// bench_vertex_cache.cpp - post-transform vertex cache (Renderer3D::setVertexCache()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp without vertex cache, with direct-mapped
+// caches of increasing size and with a full array cache (one entry per
+// vertex). Checks that the images are identical to the render without cache
+// and reports the hit rate (fraction of the vertices fetched at the start of a
+// triangle chain, or when a chain moves to a new vertex, that were already
+// transformed, projected and lit earlier in the same drawing call) and the
+// timings.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_vertex_cache.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_vertex_cache && ./bench_vertex_cache
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "example/bunny_fig_texture_be.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 240
+#define LY 320
+#define NB_FRAMES 50
+#define FULL_SIZE 1093 // number of vertices of the bunny
+
+static uint16_t fb_ref[LX * LY];
+static uint16_t fb[LX * LY];
+static uint16_t zbuf[LX * LY];
+static VertexCacheEntry vcache[FULL_SIZE];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_FLAT | SHADER_GOURAUD |
+                              SHADER_NOTEXTURE | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+static Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+
+/** modes: 0 = gouraud+texture, 1 = gouraud, 2 = flat, 3 = gouraud without culling, 4 = gouraud (close, clipped) */
+static void draw_scene(Image<RGB565BE>& im, int frame, int mode)
+    {
+    switch (mode)
+        {
+        case 0: renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE); break;
+        case 2: renderer.setShaders(SHADER_FLAT); break;
+        default: renderer.setShaders(SHADER_GOURAUD); break;
+        }
+    renderer.setCulling((mode == 3) ? 0 : 1);
+    fMat4 M;
+    M.setScale({ 9, 9, 9 });
+    M.multRotate(-360.0f * frame / NB_FRAMES, { 0, 1, 0 });
+    M.multTranslate({ 0, (mode == 4) ? -4.0f : 0.0f, (mode == 4) ? -8.0f : -25.0f });
+    renderer.setModelMatrix(M);
+    im.fillScreen(RGB565BE(RGB565_Cyan));
+    renderer.clearZbuffer();
+    renderer.drawMesh(&bunny_fig_small_be, false);
+    }
+
+
+int main()
+    {
+    Image<RGB565BE> im_ref((RGB565BE*)fb_ref, LX, LY);
+    Image<RGB565BE> im((RGB565BE*)fb, LX, LY);
+    renderer.setViewportSize(LX, LY);
+    renderer.setOffset(0, 0);
+    renderer.setZbuffer(zbuf);
+    renderer.setPerspective(45.0f, ((float)LX) / LY, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setTextureQuality(SHADER_TEXTURE_NEAREST);
+    renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+
+    const char* modes[5] = { "gouraud+texture", "gouraud", "flat", "gouraud/no cull", "gouraud (close)" };
+    const int sizes[5] = { 32, 64, 128, 256, FULL_SIZE };
+    int errors = 0;
+    printf("%d frames %dx%d per mode, bunny with %d vertices, times in us/frame (fastest of %d runs)\n\n", NB_FRAMES, LX, LY, FULL_SIZE, BENCH_REPEATS);
+    printf("%-16s %9s", "mode", "no cache");
+    for (int s = 0; s < 5; s++) printf((sizes[s] == FULL_SIZE) ? "   full (%4d)" : "   %4d entries", sizes[s]);
+    printf("\n");
+    for (int mode = 0; mode < 5; mode++)
+        {
+        double t[6] = { 0 }; // t[0]: no cache, t[s + 1]: cache of sizes[s] entries
+        uint32_t lookups[5] = { 0 }, hits[5] = { 0 };
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            timeVariants(6, f, BENCH_REPEATS, t, [&](int v, int rep)
+                {
+                const int s = v - 1;
+                renderer.setImage((v == 0) ? &im_ref : &im);
+                renderer.setVertexCache((v == 0) ? nullptr : vcache, (v == 0) ? 0 : sizes[s]);
+                renderer.resetVertexCacheStats();
+                const double t0 = now_us();
+                draw_scene((v == 0) ? im_ref : im, f, mode);
+                const double t1 = now_us();
+                if ((v > 0) && (rep == BENCH_REPEATS - 1)) // the render without cache of this frame is in fb_ref by now
+                    {
+                    uint32_t l, h;
+                    renderer.getVertexCacheStats(l, h);
+                    lookups[s] += l; hits[s] += h;
+                    if (memcmp(fb, fb_ref, sizeof(fb)) != 0) errors++;
+                    }
+                return t1 - t0;
+                });
+            }
+        printf("%-16s %9.1f", modes[mode], t[0] / NB_FRAMES);
+        for (int s = 0; s < 5; s++) printf("   %5.1f (%3.0f%%)", t[s + 1] / NB_FRAMES, (lookups[s] ? 100.0 * hits[s] / lookups[s] : 0.0));
+        printf("\n");
+        }
+    printf("(hit rate of the cache between parentheses, %d bytes per entry)\n", (int)sizeof(VertexCacheEntry));
+
+    printf("\n%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
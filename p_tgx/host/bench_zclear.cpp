@@ -0,0 +1,129 @@
+// bench_zclear.cpp - cost of clearing the frame with and without z-buffer epochs (Renderer3D::setZbufferEpochs()) on the host.
+//
+// Renders the bunny of pgx_bunny.cpp (textured, Gouraud shading) rotating in
+// front of the camera, with a float and with a uint16_t z-buffer, clearing the
+// frame in three ways:
+// - fillScreen() + clearZbuffer(): the z-buffer is cleared every frame,
+// - the same with 8 epochs: the z-buffer is cleared once every 8 frames,
+// - clearImageAndZbuffer() with 8 epochs: the remaining clears are done in
+//   the same pass as the image.
+// Reports the time spent clearing (averaged over all the runs: the full clear
+// of the epochs only happens every 8 frames) and drawing (fastest run of each
+// frame), and the clear cost as a fraction of the frame time (much smaller on the host than on a
+// microcontroller where the memory bandwidth is far lower). Checks that the
+// images only differ on a few pixels from those cleared every frame (the
+// epochs reduce the depth precision so fragments at almost the same depth may
+// be resolved differently).
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -DTGX_RGB565_ORDER_BGR=1 -Itgx host/bench_zclear.cpp tgx/Color.cpp tgx/Renderer3D.cpp -o bench_zclear && ./bench_zclear
+//
+#include "tgx.h"
+#include "example/bunny_fig_small.h"
+#include "bench_tools.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace tgx;
+using namespace bench_tools;
+
+#define LX 320
+#define LY 240
+#define NB_FRAMES 200
+#define NB_EPOCHS 8
+
+static uint16_t fb[3][LX * LY];
+
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | SHADER_GOURAUD | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_WRAP_POW2;
+
+
+/** one renderer and z-buffer per clearing method */
+template<typename ZBUFFER_t> struct ClearBench
+    {
+    Renderer3D<RGB565, LOADED_SHADERS, ZBUFFER_t> renderer[3];
+    ZBUFFER_t zbuf[3][LX * LY];
+
+    /** run the benchmark, return the number of frames with too many differing pixels */
+    int run(const char* name)
+        {
+        Image<RGB565> im[3] = { Image<RGB565>((RGB565*)fb[0], LX, LY), Image<RGB565>((RGB565*)fb[1], LX, LY), Image<RGB565>((RGB565*)fb[2], LX, LY) };
+        for (int m = 0; m < 3; m++)
+            {
+            Renderer3D<RGB565, LOADED_SHADERS, ZBUFFER_t>& R = renderer[m];
+            R.setViewportSize(LX, LY);
+            R.setOffset(0, 0);
+            R.setImage(&im[m]);
+            R.setZbuffer(zbuf[m]);
+            R.setPerspective(45.0f, ((float)LX) / LY, 0.5f, 100.0f);
+            R.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+            R.setTextureQuality(SHADER_TEXTURE_NEAREST);
+            R.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
+            R.setZbufferEpochs((m == 0) ? 1 : NB_EPOCHS);
+            }
+        int errors = 0;
+        long max_diff = 0;
+        double t_clear[3] = { 0, 0, 0 }, t_draw[3] = { 0, 0, 0 };
+        for (int f = 0; f < NB_FRAMES; f++)
+            {
+            fMat4 M;
+            M.setRotate(360.0f * f / NB_FRAMES, { 0, 1, 0 });
+            M.multRotate(20.0f, { 1, 0, 0 });
+            M.multTranslate({ 0, 0, -2.0f });
+            timeVariants(3, f, BENCH_REPEATS, t_draw, [&](int m, int)
+                {
+                Renderer3D<RGB565, LOADED_SHADERS, ZBUFFER_t>& R = renderer[m];
+                const double t0 = now_us();
+                if (m == 2)
+                    {
+                    R.clearImageAndZbuffer(RGB565_Black);
+                    }
+                else
+                    {
+                    im[m].fillScreen(RGB565_Black);
+                    R.clearZbuffer();
+                    }
+                const double t1 = now_us();
+                R.setModelMatrix(M);
+                R.drawMesh(&bunny_fig_small, true);
+                const double t2 = now_us();
+                t_clear[m] += t1 - t0;
+                return t2 - t1;
+                });
+            for (int m = 1; m < 3; m++)
+                {
+                long diff = 0;
+                for (int i = 0; i < LX * LY; i++) if (fb[m][i] != fb[0][i]) diff++;
+                if (diff > max_diff) max_diff = diff;
+                if (diff > 20) errors++;
+                }
+            }
+        const char* methods[3] = { "clear every frame", "epochs", "epochs + fused" };
+        for (int m = 0; m < 3; m++)
+            {
+            const double c = t_clear[m] / (NB_FRAMES * BENCH_REPEATS), d = t_draw[m] / NB_FRAMES;
+            printf("%-10s %-18s %10.1f %10.1f %10.1f %9.1f%%\n", name, methods[m], c, d, c + d, 100.0 * c / (c + d));
+            }
+        printf("%-10s at most %ld pixels differ from the frames cleared every time\n\n", name, max_diff);
+        return errors;
+        }
+    };
+
+
+static ClearBench<float> bench_float;
+static ClearBench<uint16_t> bench_u16;
+
+
+int main()
+    {
+    printf("%d frames %dx%d, bunny with %d triangles, textured Gouraud, %d epochs, times in us/frame (draw: fastest of %d runs)\n\n", NB_FRAMES, LX, LY, bunny_fig_small.nb_faces, NB_EPOCHS, BENCH_REPEATS);
+    printf("%-10s %-18s %10s %10s %10s %10s\n", "z-buffer", "", "clear", "draw", "frame", "clear");
+    int errors = bench_float.run("float");
+    errors += bench_u16.run("uint16_t");
+
+    printf("%s\n", (errors ? "FAILED" : "OK"));
+    return (errors ? 1 : 0);
+    }
+
+/** end of file */
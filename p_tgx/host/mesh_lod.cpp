@@ -0,0 +1,374 @@
+// mesh_lod.cpp - generate the levels of detail of a mesh for Renderer3D::drawMeshLOD() on the host.
+//
+// Loads a mesh header (e.g. example/bunny_fig_small.h), simplifies the mesh
+// with quadric error metrics (half edge collapses so that the remaining
+// vertices, texcoords and normals are the original ones) and writes a header
+// with the simplified meshes and a tgx::MeshLOD chain whose level 0 is the
+// original mesh. All the levels share the material and the texture of the
+// original mesh.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx -DMESH_HEADER='"example/bunny_fig_small.h"' -DMESH=bunny_fig_small -DMESH_TEXTURE='&bunny_fig_texture' host/mesh_lod.cpp -o mesh_lod
+//   ./mesh_lod 0.5 0.25 0.12 > tgx/example/bunny_fig_small_lod.h
+//
+// Arguments: the triangle count of each level relative to the original mesh
+// (decreasing, at most TGX_MESH_LOD_MAX - 1 levels, default 0.5 0.25 0.12).
+// Option -a <pixels> sets the projected area (in pixels) of the triangles of
+// a level below which the renderer switches to the next coarser level
+// (default 12). Statistics are written on stderr.
+//
+#include "tgx.h"
+#include MESH_HEADER
+#include "mesh_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+#ifndef MESH_TEXTURE
+#define MESH_TEXTURE nullptr
+#endif
+
+#ifndef MESH_COLOR_TYPE
+#define MESH_COLOR_TYPE tgx::RGB565
+#endif
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+using namespace tgx;
+using namespace mesh_tools;
+
+
+/** symmetric 4x4 quadric */
+struct Quadric
+    {
+    double a[10] = { 0 };
+
+    void addPlane(double nx, double ny, double nz, double d, double w)
+        {
+        const double p[4] = { nx, ny, nz, d };
+        int k = 0;
+        for (int i = 0; i < 4; i++) for (int j = i; j < 4; j++) a[k++] += w * p[i] * p[j];
+        }
+
+    Quadric& operator+=(const Quadric& Q) { for (int k = 0; k < 10; k++) a[k] += Q.a[k]; return *this; }
+
+    double error(const fVec3& V) const
+        {
+        const double x = V.x, y = V.y, z = V.z;
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+             + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+             + a[7] * z * z + 2 * a[8] * z
+             + a[9];
+        }
+    };
+
+
+/** candidate collapse of vertex u onto vertex w */
+struct Collapse
+    {
+    double cost;
+    int u, w;
+    int stamp_u, stamp_w;
+    bool operator<(const Collapse& c) const { return cost > c.cost; } // min heap
+    };
+
+
+/** half edge collapse simplifier */
+class Simplifier
+    {
+
+    public:
+
+        Simplifier(const MeshData& M) : _M(M)
+            {
+            const int nv = (int)_M.vert.size();
+            _vtri.resize(nv);
+            _Q.resize(nv);
+            _stamp.assign(nv, 0);
+            _alive.assign(_M.tri.size(), 1);
+            _nb_alive = (int)_M.tri.size();
+            for (int i = 0; i < (int)_M.tri.size(); i++)
+                for (int k = 0; k < 3; k++) _vtri[_M.tri[i].c[k].v].push_back(i);
+            for (int i = 0; i < (int)_M.tri.size(); i++)
+                { // face quadrics weighted by area
+                fVec3 N = _normal(i);
+                const double area = N.norm() * 0.5;
+                if (area <= 0) continue;
+                N.normalize();
+                const fVec3& P = _M.vert[_M.tri[i].c[0].v];
+                const double d = -(N.x * P.x + N.y * P.y + N.z * P.z);
+                for (int k = 0; k < 3; k++) _Q[_M.tri[i].c[k].v].addPlane(N.x, N.y, N.z, d, area);
+                }
+            for (int i = 0; i < (int)_M.tri.size(); i++)
+                { // boundary edges: add a heavy plane perpendicular to the face to keep the border in place
+                for (int k = 0; k < 3; k++)
+                    {
+                    const int a = _M.tri[i].c[k].v, b = _M.tri[i].c[(k + 1) % 3].v;
+                    if (_edgeTriangles(a, b) != 1) continue;
+                    fVec3 E = _M.vert[b] - _M.vert[a];
+                    fVec3 N = crossProduct(E, _normal(i));
+                    if (N.norm() <= 0) continue;
+                    N.normalize();
+                    const double d = -(N.x * _M.vert[a].x + N.y * _M.vert[a].y + N.z * _M.vert[a].z);
+                    const double w = 100.0 * E.norm2();
+                    _Q[a].addPlane(N.x, N.y, N.z, d, w);
+                    _Q[b].addPlane(N.x, N.y, N.z, d, w);
+                    }
+                }
+            for (int v = 0; v < nv; v++) _pushAround(v);
+            }
+
+
+        /** collapse edges until at most target triangles remain. Return the maximum error. */
+        double simplify(int target)
+            {
+            double maxerr = 0;
+            while ((_nb_alive > target) && (!_heap.empty()))
+                {
+                const Collapse C = _heap.top();
+                _heap.pop();
+                if ((C.stamp_u != _stamp[C.u]) || (C.stamp_w != _stamp[C.w])) continue; // outdated
+                if (!_collapse(C.u, C.w)) continue;
+                maxerr = std::max(maxerr, C.cost);
+                }
+            return maxerr;
+            }
+
+
+        /** current mesh (not compacted) */
+        MeshData mesh() const
+            {
+            MeshData R = _M;
+            R.tri.clear();
+            for (int i = 0; i < (int)_M.tri.size(); i++) if (_alive[i]) R.tri.push_back(_M.tri[i]);
+            return R;
+            }
+
+
+        int nbTriangles() const { return _nb_alive; }
+
+
+    private:
+
+        fVec3 _normal(int i) const
+            {
+            const Tri& T = _M.tri[i];
+            return crossProduct(_M.vert[T.c[1].v] - _M.vert[T.c[0].v], _M.vert[T.c[2].v] - _M.vert[T.c[0].v]);
+            }
+
+        /** number of alive triangles containing both vertices */
+        int _edgeTriangles(int a, int b) const
+            {
+            int n = 0;
+            for (int t : _vtri[a]) if (_alive[t] && _has(t, b)) n++;
+            return n;
+            }
+
+        bool _has(int t, int v) const
+            {
+            const Tri& T = _M.tri[t];
+            return (T.c[0].v == v) || (T.c[1].v == v) || (T.c[2].v == v);
+            }
+
+        void _neighbours(int v, std::vector<int>& nb) const
+            {
+            nb.clear();
+            for (int t : _vtri[v])
+                {
+                if (!_alive[t]) continue;
+                for (int k = 0; k < 3; k++) { const int x = _M.tri[t].c[k].v; if (x != v) nb.push_back(x); }
+                }
+            std::sort(nb.begin(), nb.end());
+            nb.erase(std::unique(nb.begin(), nb.end()), nb.end());
+            }
+
+        /** push the collapses of all the edges around v (in both directions) */
+        void _pushAround(int v)
+            {
+            std::vector<int> nb;
+            _neighbours(v, nb);
+            for (int x : nb)
+                {
+                _push(v, x);
+                _push(x, v);
+                }
+            }
+
+        void _push(int u, int w)
+            {
+            Quadric Q = _Q[u];
+            Q += _Q[w];
+            double cost = std::max(0.0, Q.error(_M.vert[w]));
+            if (_seam(u)) cost = cost * 10 + 1.0e-6; // collapsing a texture or normal seam vertex distorts the attributes
+            _heap.push({ cost, u, w, _stamp[u], _stamp[w] });
+            }
+
+        /** true if the corners around u do not all have the same texcoord and normal */
+        bool _seam(int u) const
+            {
+            int t = -2, n = -2;
+            for (int i : _vtri[u])
+                {
+                if (!_alive[i]) continue;
+                for (int k = 0; k < 3; k++)
+                    {
+                    const Corner& c = _M.tri[i].c[k];
+                    if (c.v != u) continue;
+                    if (t == -2) { t = c.t; n = c.n; }
+                    else if ((c.t != t) || (c.n != n)) return true;
+                    }
+                }
+            return false;
+            }
+
+        /** collapse u onto w. Return false if the collapse would damage the topology or flip a face */
+        bool _collapse(int u, int w)
+            {
+            // link condition: the common neighbours of u and w must be the opposite vertices of the shared triangles.
+            std::vector<int> nu, nw, common;
+            _neighbours(u, nu);
+            _neighbours(w, nw);
+            std::set_intersection(nu.begin(), nu.end(), nw.begin(), nw.end(), std::back_inserter(common));
+            const int shared = _edgeTriangles(u, w);
+            if ((shared == 0) || ((int)common.size() != shared)) return false;
+
+            // the triangles that remain must not flip or become degenerate.
+            for (int t : _vtri[u])
+                {
+                if ((!_alive[t]) || (_has(t, w))) continue;
+                const fVec3 N0 = _normal(t);
+                Tri T = _M.tri[t];
+                for (int k = 0; k < 3; k++) if (T.c[k].v == u) T.c[k].v = w;
+                const fVec3 N1 = crossProduct(_M.vert[T.c[1].v] - _M.vert[T.c[0].v], _M.vert[T.c[2].v] - _M.vert[T.c[0].v]);
+                const double l0 = N0.norm(), l1 = N1.norm();
+                if ((l1 <= 1.0e-12 * (1 + l0)) || (dotProduct(N0, N1) < 0.2 * l0 * l1)) return false;
+                }
+
+            // attributes: the corners of u in the removed triangles take the attributes of w in the same triangles.
+            std::vector<std::pair<Corner, Corner>> amap;
+            for (int t : _vtri[u])
+                {
+                if ((!_alive[t]) || (!_has(t, w))) continue;
+                Corner cu = { 0, 0, 0 }, cw = { 0, 0, 0 };
+                for (int k = 0; k < 3; k++) { if (_M.tri[t].c[k].v == u) cu = _M.tri[t].c[k]; if (_M.tri[t].c[k].v == w) cw = _M.tri[t].c[k]; }
+                amap.push_back({ cu, cw });
+                _alive[t] = 0;
+                _nb_alive--;
+                }
+            for (int t : _vtri[u])
+                {
+                if (!_alive[t]) continue;
+                for (int k = 0; k < 3; k++)
+                    {
+                    Corner& c = _M.tri[t].c[k];
+                    if (c.v != u) continue;
+                    Corner r = { w, c.t, c.n };
+                    bool found = false;
+                    for (auto& m : amap) if (m.first == c) { r = m.second; found = true; break; }
+                    if ((!found) && (c.n >= 0)) r.n = amap[0].second.n; // across a seam: keep the texcoord, take the normal of w
+                    c = r;
+                    }
+                _vtri[w].push_back(t);
+                }
+            _vtri[u].clear();
+            _Q[w] += _Q[u];
+            _stamp[u]++;
+            _stamp[w]++;
+            std::vector<int> nb;
+            _neighbours(w, nb);
+            for (int x : nb) _stamp[x]++;
+            _pushAround(w);
+            for (int x : nb) _pushAround(x);
+            return true;
+            }
+
+        MeshData _M;
+        std::vector<std::vector<int>> _vtri;    // alive and dead triangles around each vertex
+        std::vector<Quadric> _Q;
+        std::vector<int> _stamp;                // incremented when the neighbourhood of a vertex changes
+        std::vector<char> _alive;
+        int _nb_alive;
+        std::priority_queue<Collapse> _heap;
+    };
+
+
+int main(int argc, char** argv)
+    {
+    std::vector<float> ratios;
+    float area = 12.0f;
+    for (int i = 1; i < argc; i++)
+        {
+        if ((strcmp(argv[i], "-a") == 0) && (i + 1 < argc)) { area = (float)atof(argv[++i]); continue; }
+        ratios.push_back((float)atof(argv[i]));
+        }
+    if (ratios.empty()) ratios = { 0.5f, 0.25f, 0.12f };
+    if ((int)ratios.size() > TGX_MESH_LOD_MAX - 1) ratios.resize(TGX_MESH_LOD_MAX - 1);
+    for (size_t i = 0; i < ratios.size(); i++)
+        {
+        if ((ratios[i] <= 0) || (ratios[i] >= 1) || ((i > 0) && (ratios[i] >= ratios[i - 1])))
+            {
+            fprintf(stderr, "ratios must be decreasing in ]0,1[\n");
+            return 1;
+            }
+        }
+
+    const auto& src = MESH;
+    const char* name = STR(MESH);
+    MeshData M = loadMesh(src);
+    const int nbt0 = (int)M.tri.size();
+    fprintf(stderr, "%s: %d vertices, %d triangles\n", name, (int)M.vert.size(), nbt0);
+
+    printf("// levels of detail of the 3D model [%s] for tgx::Renderer3D::drawMeshLOD()\n", name);
+    printf("//\n// generated by host/mesh_lod.cpp with ratios");
+    for (float r : ratios) printf(" %g", r);
+    std::string header = MESH_HEADER; // the output goes in the same directory as the original mesh
+    header = header.substr(header.find_last_of('/') + 1);
+    printf(" (-a %g)\n\n#pragma once\n\n#include <tgx.h>\n\n#include \"%s\" // original mesh (level 0)\n\n\n", area, header.c_str());
+
+    // thresholds: level i is kept while the triangles of level i+1 would cover more than 'area' pixels.
+    // a mesh of diameter d pixels shows about half of its n triangles on a disk of area pi * d^2 / 4.
+    std::vector<int> nbt = { nbt0 };
+    Simplifier S(M);
+    for (size_t i = 0; i < ratios.size(); i++)
+        {
+        const double err = S.simplify((int)(nbt0 * ratios[i]));
+        MeshData L = S.mesh();
+        compactMesh(L);
+        nbt.push_back((int)L.tri.size());
+        fprintf(stderr, "level %d: %d vertices, %d triangles (max error %g)\n", (int)i + 1, (int)L.vert.size(), (int)L.tri.size(), sqrt(err));
+        MeshInfo info;
+        info.name = std::string(name) + "_lod" + std::to_string(i + 1);
+        info.color_type = STR(MESH_COLOR_TYPE);
+        info.texture = STR(MESH_TEXTURE);
+        info.next = "nullptr";
+        info.color = src.color;
+        info.ambiant_strength = src.ambiant_strength;
+        info.diffuse_strength = src.diffuse_strength;
+        info.specular_strength = src.specular_strength;
+        info.specular_exponent = src.specular_exponent;
+        writeMesh(stdout, L, info);
+        }
+
+    printf("// LOD chain for object %s (must be in RAM: the last selected level is stored in it)\n", name);
+    printf("tgx::MeshLOD<%s> %s_lod =\n    {\n    { &%s", STR(MESH_COLOR_TYPE), name, name);
+    for (size_t i = 0; i < ratios.size(); i++) printf(", &%s_lod%d", name, (int)i + 1);
+    printf(" }, // levels\n    { ");
+    for (size_t i = 0; i < nbt.size(); i++)
+        {
+        const float d = (i + 1 < nbt.size()) ? sqrtf(2.0f * area * nbt[i + 1] / 3.14159265f) : 0.0f;
+        printf("%.1ff%s", d, (i + 1 < nbt.size()) ? ", " : " }, // minimum diameter in pixels of each level\n");
+        fprintf(stderr, "level %d used above %.1f pixels\n", (int)i, d);
+        }
+    printf("    %d, // number of levels\n    -1 // current level\n    };\n\n\n", (int)nbt.size());
+    printf("/** end of %s_lod.h */\n", name);
+    return 0;
+    }
+
+/** end of file */
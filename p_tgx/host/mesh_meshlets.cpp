@@ -0,0 +1,172 @@
+// mesh_meshlets.cpp - split a Mesh3D into meshlet clusters for Renderer3D::drawMesh() on the host.
+//
+// Reads a mesh header (e.g. example/bunny_fig_small.h) or a Wavefront OBJ file,
+// groups the triangles in clusters of at most 64 triangles (see buildClusters()
+// in mesh_tools.h), encodes the chains cluster by cluster and writes a header
+// in the same format as the converted models with an extra array of
+// tgx::MeshCluster (bounding sphere, normal cone and range in the face array
+// of each cluster) referenced by the Mesh3D. drawMesh() uses it to reject the
+// clusters that are off-screen or back-facing before any vertex work.
+//
+// Reports the clusters, the cost in face array bytes compared to the same mesh
+// without clusters and the fraction of the triangles rejected by the normal
+// cones alone, averaged over views from every direction.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx -DMESH_HEADER='"example/bunny_fig_small.h"' -DMESH=bunny_fig_small host/mesh_meshlets.cpp -o mesh_meshlets
+//   ./mesh_meshlets -tex '&bunny_fig_texture' -inc bunny_fig_texture.h -name bunny_fig_small_meshlets > bunny_fig_small_meshlets.h
+//
+// Options:
+//   -obj <file>     read the mesh from an OBJ file instead of MESH.
+//   -name <name>    name of the output mesh (default: same as the input).
+//   -tex <expr>     texture of the output mesh (default nullptr).
+//   -inc <header>   header to include in the output (e.g. the texture), may be repeated.
+//   -faces <n>      maximum number of triangles per cluster (default 64).
+//   -cone <angle>   maximum angle in degrees between a normal and the mean normal of its cluster
+//                   (default 45, smaller: tighter normal cones but more clusters).
+//
+#include "tgx.h"
+#ifdef MESH_HEADER
+#include MESH_HEADER
+#endif
+#include "mesh_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#ifndef MESH_COLOR_TYPE
+#define MESH_COLOR_TYPE tgx::RGB565
+#endif
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+using namespace tgx;
+using namespace mesh_tools;
+
+
+/** fraction of the triangles in back-facing clusters, averaged over eyes on a sphere around the mesh */
+static double backfaceRatio(const std::vector<MeshCluster>& clusters, const fBox3& B)
+    {
+    const fVec3 center((B.minX + B.maxX) * 0.5f, (B.minY + B.maxY) * 0.5f, (B.minZ + B.maxZ) * 0.5f);
+    const float dist = 3.0f * fVec3(B.maxX - center.x, B.maxY - center.y, B.maxZ - center.z).norm();
+    const int N = 256;
+    long culled = 0, total = 0;
+    for (int i = 0; i < N; i++)
+        { // fibonacci sphere
+        const float z = 1.0f - (2.0f * i + 1.0f) / N;
+        const float r = sqrtf(1.0f - z * z);
+        const float a = 2.39996323f * i;
+        const fVec3 eye = center + fVec3(r * cosf(a), r * sinf(a), z) * dist;
+        for (const MeshCluster& C : clusters)
+            {
+            total += C.nb_faces;
+            if (C.cone_cutoff >= 1.0f) continue;
+            const fVec3 D = C.center - eye;
+            if (dotProduct(D, C.cone_axis) >= C.cone_cutoff * D.norm() + (1.0f + C.cone_cutoff) * C.radius) culled += C.nb_faces;
+            }
+        }
+    return (total) ? ((double)culled / total) : 0.0;
+    }
+
+
+int main(int argc, char** argv)
+    {
+    const char* obj = nullptr;
+    std::string name, texture = "nullptr";
+    std::vector<std::string> includes;
+    int max_faces = 64;
+    float max_angle = 45.0f;
+    for (int i = 1; i < argc; i++)
+        {
+        if ((strcmp(argv[i], "-obj") == 0) && (i + 1 < argc)) obj = argv[++i];
+        else if ((strcmp(argv[i], "-name") == 0) && (i + 1 < argc)) name = argv[++i];
+        else if ((strcmp(argv[i], "-tex") == 0) && (i + 1 < argc)) texture = argv[++i];
+        else if ((strcmp(argv[i], "-inc") == 0) && (i + 1 < argc)) includes.push_back(argv[++i]);
+        else if ((strcmp(argv[i], "-faces") == 0) && (i + 1 < argc)) max_faces = std::max(1, atoi(argv[++i]));
+        else if ((strcmp(argv[i], "-cone") == 0) && (i + 1 < argc)) max_angle = (float)atof(argv[++i]);
+        else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+        }
+
+    MeshData M;
+    MeshInfo info;
+    info.color_type = STR(MESH_COLOR_TYPE);
+    info.texture = texture;
+    info.next = "nullptr";
+    info.color = RGBf(0.75f, 0.75f, 0.75f);
+    info.ambiant_strength = 0.1f;
+    info.diffuse_strength = 0.7f;
+    info.specular_strength = 0.6f;
+    info.specular_exponent = 32;
+    if (obj)
+        {
+        if (!loadOBJ(obj, M)) { fprintf(stderr, "cannot read %s\n", obj); return 1; }
+        if (name.empty()) name = "mesh";
+        }
+    else
+        {
+#ifdef MESH
+        const auto& src = MESH;
+        if (name.empty()) name = STR(MESH);
+        M = loadMesh(src);
+        info.color = src.color;
+        info.ambiant_strength = src.ambiant_strength;
+        info.diffuse_strength = src.diffuse_strength;
+        info.specular_strength = src.specular_strength;
+        info.specular_exponent = src.specular_exponent;
+#else
+        fprintf(stderr, "no input: use -obj or compile with -DMESH_HEADER=... -DMESH=...\n");
+        return 1;
+#endif
+        }
+    compactMesh(M);
+    if ((M.vert.size() > 32767) || (M.tex.size() > 65535) || (M.norm.size() > 65535))
+        {
+        fprintf(stderr, "too many vertices for a Mesh3D\n");
+        return 1;
+        }
+    info.name = name;
+    const int per = 1 + (M.tex.size() ? 1 : 0) + (M.norm.size() ? 1 : 0);
+
+    const std::vector<std::vector<int>> clusters = buildClusters(M, max_faces, max_angle);
+    std::vector<Chain> chains = encodeClusters(M, clusters, info.clusters);
+    const ChainStats S = chainStats(chains, per, 64);
+    if (S.face_bytes > 2 * 65535)
+        {
+        fprintf(stderr, "face array too large for a Mesh3D\n");
+        return 1;
+        }
+    reorderMesh(M, chains);
+    const ChainStats S0 = chainStats(stripify(M), per, 64); // same mesh without clusters
+
+    const fBox3 B = boundingBox(M);
+    int spread = 0;
+    for (const MeshCluster& C : info.clusters) if (C.cone_cutoff >= 1.0f) spread++;
+    fprintf(stderr, "%s: %d vertices, %d triangles\n", name.c_str(), (int)M.vert.size(), (int)M.tri.size());
+    fprintf(stderr, "%d clusters, %.1f triangles/cluster, %d without usable normal cone\n", (int)clusters.size(), (double)M.tri.size() / clusters.size(), spread);
+    fprintf(stderr, "face array %d bytes (%d without clusters) + cluster array %d bytes\n", S.face_bytes, S0.face_bytes, (int)(clusters.size() * sizeof(MeshCluster)));
+    fprintf(stderr, "triangles rejected by the normal cones: %.1f%% on average (back-face culling rejects about 50%%)\n", 100.0 * backfaceRatio(info.clusters, B));
+
+    const int mem = (int)(M.vert.size() * 12 + M.tex.size() * 8 + M.norm.size() * 12 + clusters.size() * sizeof(MeshCluster)) + S.face_bytes;
+    printf("// 3D model [%s]\n//\n", name.c_str());
+    printf("// - vertices   : %d\n", (int)M.vert.size());
+    printf("// - textures   : %d\n", (int)M.tex.size());
+    printf("// - normals    : %d\n", (int)M.norm.size());
+    printf("// - triangles  : %d\n", (int)M.tri.size());
+    printf("// - clusters   : %d\n//\n", (int)clusters.size());
+    printf("// - memory size: %dkb\n//\n", (mem + 1023) / 1024);
+    printf("// - model bounding box: [%.2f,%.2f]x[%.2f,%.2f]x[%.2f,%.2f]\n//\n", B.minX, B.maxX, B.minY, B.maxY, B.minZ, B.maxZ);
+    printf("// meshlet clusters created by host/mesh_meshlets.cpp (at most %d triangles per cluster, -cone %g)\n\n", max_faces, max_angle);
+    printf("#pragma once\n\n#include <tgx.h>\n\n");
+    for (const std::string& h : includes) printf("#include \"%s\"\n", h.c_str());
+    printf("\n\n");
+    writeMesh(stdout, M, chains, info);
+    printf("/** end of %s.h */\n", name.c_str());
+    return 0;
+    }
+
+/** end of file */
@@ -0,0 +1,131 @@
+// mesh_normals.cpp - offline quantization of the normals of a Mesh3D on the host.
+//
+// Reads a mesh header (e.g. example/bunny_fig_small.h) or a Wavefront OBJ file,
+// snaps each normal to the center of its cell in the octahedral quantization
+// used by the normal lighting table of Renderer3D (see setNormalLUT() and
+// tgx::octahedralIndex()) and merges the normals that fall in the same cell,
+// which shrinks the normal array. Writes the new header in the same format on
+// stdout and reports the number of normals before and after and the angular
+// error of the quantization.
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx -DMESH_HEADER='"example/bunny_fig_small.h"' -DMESH=bunny_fig_small host/mesh_normals.cpp -o mesh_normals
+//   ./mesh_normals -bits 6 -tex '&bunny_fig_texture' -inc bunny_fig_texture.h > bunny_fig_small_qn.h
+//
+// or, for an OBJ file (MESH_HEADER and MESH are then optional):
+//
+//   ./mesh_normals -obj model.obj -name model > model.h
+//
+// Options:
+//   -obj <file>     read the mesh from an OBJ file instead of MESH.
+//   -name <name>    name of the output mesh (default: same as the input, so the new header can replace it).
+//   -tex <expr>     texture of the output mesh (default nullptr).
+//   -inc <header>   header to include in the output (e.g. the texture), may be repeated.
+//   -bits <n>       bits per axis of the octahedral quantization, 1 to 8 (default 6).
+//
+#include "tgx.h"
+#ifdef MESH_HEADER
+#include MESH_HEADER
+#endif
+#include "mesh_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#ifndef MESH_COLOR_TYPE
+#define MESH_COLOR_TYPE tgx::RGB565
+#endif
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+using namespace tgx;
+using namespace mesh_tools;
+
+
+int main(int argc, char** argv)
+    {
+    const char* obj = nullptr;
+    std::string name, texture = "nullptr";
+    std::vector<std::string> includes;
+    int bits = 6;
+    for (int i = 1; i < argc; i++)
+        {
+        if ((strcmp(argv[i], "-obj") == 0) && (i + 1 < argc)) obj = argv[++i];
+        else if ((strcmp(argv[i], "-name") == 0) && (i + 1 < argc)) name = argv[++i];
+        else if ((strcmp(argv[i], "-tex") == 0) && (i + 1 < argc)) texture = argv[++i];
+        else if ((strcmp(argv[i], "-inc") == 0) && (i + 1 < argc)) includes.push_back(argv[++i]);
+        else if ((strcmp(argv[i], "-bits") == 0) && (i + 1 < argc)) bits = std::max(1, std::min(8, atoi(argv[++i])));
+        else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+        }
+
+    MeshData M;
+    MeshInfo info;
+    info.color_type = STR(MESH_COLOR_TYPE);
+    info.texture = texture;
+    info.next = "nullptr";
+    info.color = RGBf(0.75f, 0.75f, 0.75f);
+    info.ambiant_strength = 0.1f;
+    info.diffuse_strength = 0.7f;
+    info.specular_strength = 0.6f;
+    info.specular_exponent = 32;
+    if (obj)
+        {
+        if (!loadOBJ(obj, M)) { fprintf(stderr, "cannot read %s\n", obj); return 1; }
+        if (name.empty()) name = "mesh";
+        }
+    else
+        {
+#ifdef MESH
+        const auto& src = MESH;
+        if (name.empty()) name = STR(MESH);
+        M = loadMesh(src);
+        info.color = src.color;
+        info.ambiant_strength = src.ambiant_strength;
+        info.diffuse_strength = src.diffuse_strength;
+        info.specular_strength = src.specular_strength;
+        info.specular_exponent = src.specular_exponent;
+#else
+        fprintf(stderr, "no input: use -obj or compile with -DMESH_HEADER=... -DMESH=...\n");
+        return 1;
+#endif
+        }
+    compactMesh(M);
+    if (M.norm.size() == 0)
+        {
+        fprintf(stderr, "%s has no normals\n", name.c_str());
+        return 1;
+        }
+    if ((M.vert.size() > 32767) || (M.tex.size() > 65535) || (M.norm.size() > 65535))
+        {
+        fprintf(stderr, "too many vertices for a Mesh3D\n");
+        return 1;
+        }
+    info.name = name;
+
+    const int nb_before = (int)M.norm.size();
+    const double max_angle = quantizeNormals(M, bits);
+    fprintf(stderr, "%s: %d vertices, %d texcoords, %d triangles\n", name.c_str(), (int)M.vert.size(), (int)M.tex.size(), (int)M.tri.size());
+    fprintf(stderr, "normals: %d before, %d after (%d bits per axis, %d cells), max error %.2f degrees\n", nb_before, (int)M.norm.size(), bits, 1 << (2 * bits), max_angle);
+
+    const fBox3 B = boundingBox(M);
+    printf("// 3D model [%s]\n//\n", name.c_str());
+    printf("// - vertices   : %d\n", (int)M.vert.size());
+    printf("// - textures   : %d\n", (int)M.tex.size());
+    printf("// - normals    : %d\n", (int)M.norm.size());
+    printf("// - triangles  : %d\n//\n", (int)M.tri.size());
+    printf("// - model bounding box: [%.2f,%.2f]x[%.2f,%.2f]x[%.2f,%.2f]\n//\n", B.minX, B.maxX, B.minY, B.maxY, B.minZ, B.maxZ);
+    printf("// normals quantized by host/mesh_normals.cpp: %d bits per axis, max error %.2f degrees\n\n", bits, max_angle);
+    printf("#pragma once\n\n#include <tgx.h>\n\n");
+    for (const std::string& h : includes) printf("#include \"%s\"\n", h.c_str());
+    printf("\n\n");
+    writeMesh(stdout, M, info);
+    printf("/** end of %s.h */\n", name.c_str());
+    return 0;
+    }
+
+/** end of file */
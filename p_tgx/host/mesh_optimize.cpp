@@ -0,0 +1,172 @@
+// mesh_optimize.cpp - offline optimizer for the face array of a Mesh3D on the host.
+//
+// Reads a mesh header (e.g. example/bunny_fig_small.h) or a Wavefront OBJ file,
+// re-encodes the triangles into longer chains and renumbers the vertices,
+// texcoords and normals in the order of their first use in the chains so that
+// drawMesh() reads the arrays (and fills the vertex cache) with good locality.
+// Writes the new header in the same format on stdout and reports, before and
+// after: the number of chains, the triangles per chain, the size of the face
+// array and the average cache miss ratio (ACMR: vertices transformed per
+// triangle) without and with the vertex cache of drawMesh().
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx -DMESH_HEADER='"example/bunny_fig_small.h"' -DMESH=bunny_fig_small host/mesh_optimize.cpp -o mesh_optimize
+//   ./mesh_optimize -tex '&bunny_fig_texture' -inc bunny_fig_texture.h > bunny_fig_small_opt.h
+//
+// or, for an OBJ file (MESH_HEADER and MESH are then optional):
+//
+//   ./mesh_optimize -obj model.obj -name model > model.h
+//
+// Options:
+//   -obj <file>     read the mesh from an OBJ file instead of MESH.
+//   -name <name>    name of the output mesh (default: same as the input, so the new header can replace it).
+//   -tex <expr>     texture of the output mesh (default nullptr).
+//   -inc <header>   header to include in the output (e.g. the texture), may be repeated.
+//   -tries <n>      number of encodings tried, the best one is kept (default 16).
+//   -cache <n>      size of the vertex cache for the ACMR report (default 64).
+//
+#include "tgx.h"
+#ifdef MESH_HEADER
+#include MESH_HEADER
+#endif
+#include "mesh_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#ifndef MESH_COLOR_TYPE
+#define MESH_COLOR_TYPE tgx::RGB565
+#endif
+
+#define STR2(x) #x
+#define STR(x) STR2(x)
+
+using namespace tgx;
+using namespace mesh_tools;
+
+
+static void report(const char* title, const ChainStats& S, int cache_size)
+    {
+    fprintf(stderr, "%-8s %6d chains, %7.2f triangles/chain, face array %6d bytes, ACMR %.3f (no cache) %.3f (cache %d)\n",
+            title, S.nb_chains, (double)S.nb_triangles / S.nb_chains, S.face_bytes, S.acmr, S.acmr_cache, cache_size);
+    }
+
+
+int main(int argc, char** argv)
+    {
+    const char* obj = nullptr;
+    std::string name, texture = "nullptr";
+    std::vector<std::string> includes;
+    int tries = 16, cache_size = 64;
+    for (int i = 1; i < argc; i++)
+        {
+        if ((strcmp(argv[i], "-obj") == 0) && (i + 1 < argc)) obj = argv[++i];
+        else if ((strcmp(argv[i], "-name") == 0) && (i + 1 < argc)) name = argv[++i];
+        else if ((strcmp(argv[i], "-tex") == 0) && (i + 1 < argc)) texture = argv[++i];
+        else if ((strcmp(argv[i], "-inc") == 0) && (i + 1 < argc)) includes.push_back(argv[++i]);
+        else if ((strcmp(argv[i], "-tries") == 0) && (i + 1 < argc)) tries = std::max(1, atoi(argv[++i]));
+        else if ((strcmp(argv[i], "-cache") == 0) && (i + 1 < argc)) cache_size = std::max(1, atoi(argv[++i]));
+        else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+        }
+
+    MeshData M;
+    MeshInfo info;
+    info.color_type = STR(MESH_COLOR_TYPE);
+    info.texture = texture;
+    info.next = "nullptr";
+    info.color = RGBf(0.75f, 0.75f, 0.75f);
+    info.ambiant_strength = 0.1f;
+    info.diffuse_strength = 0.7f;
+    info.specular_strength = 0.6f;
+    info.specular_exponent = 32;
+    std::vector<Chain> before;
+    if (obj)
+        {
+        if (!loadOBJ(obj, M)) { fprintf(stderr, "cannot read %s\n", obj); return 1; }
+        if (name.empty()) name = "mesh";
+        compactMesh(M);
+        for (const Tri& T : M.tri)
+            { // one chain per triangle, in the order of the file
+            Chain C = { 1 };
+            for (const Corner& c : T.c)
+                {
+                C.push_back((uint16_t)c.v);
+                if (c.t >= 0) C.push_back((uint16_t)c.t);
+                if (c.n >= 0) C.push_back((uint16_t)c.n);
+                }
+            before.push_back(C);
+            }
+        }
+    else
+        {
+#ifdef MESH
+        const auto& src = MESH;
+        if (name.empty()) name = STR(MESH);
+        M = loadMesh(src);
+        before = readChains(src);
+        compactMesh(M);
+        info.color = src.color;
+        info.ambiant_strength = src.ambiant_strength;
+        info.diffuse_strength = src.diffuse_strength;
+        info.specular_strength = src.specular_strength;
+        info.specular_exponent = src.specular_exponent;
+#else
+        fprintf(stderr, "no input: use -obj or compile with -DMESH_HEADER=... -DMESH=...\n");
+        return 1;
+#endif
+        }
+    if ((M.vert.size() > 32767) || (M.tex.size() > 65535) || (M.norm.size() > 65535))
+        {
+        fprintf(stderr, "too many vertices for a Mesh3D\n");
+        return 1;
+        }
+    info.name = name;
+    const int per = 1 + (M.tex.size() ? 1 : 0) + (M.norm.size() ? 1 : 0);
+
+    // keep the encoding with the fewest chains (= the smallest face array), then the lowest ACMR.
+    std::vector<Chain> best;
+    ChainStats best_stats = { 0, 0, 0, 0, 0 };
+    MeshData best_mesh;
+    for (int k = 0; k < tries; k++)
+        {
+        MeshData R = M;
+        std::vector<Chain> chains = stripify(R, (uint32_t)k);
+        reorderMesh(R, chains);
+        const ChainStats S = chainStats(chains, per, cache_size);
+        if ((k == 0) || (S.nb_chains < best_stats.nb_chains) || ((S.nb_chains == best_stats.nb_chains) && (S.acmr_cache < best_stats.acmr_cache)))
+            {
+            best.swap(chains);
+            best_stats = S;
+            best_mesh.vert.swap(R.vert);
+            best_mesh.tex.swap(R.tex);
+            best_mesh.norm.swap(R.norm);
+            best_mesh.tri.swap(R.tri);
+            }
+        }
+    fprintf(stderr, "%s: %d vertices, %d texcoords, %d normals, %d triangles\n", name.c_str(), (int)M.vert.size(), (int)M.tex.size(), (int)M.norm.size(), (int)M.tri.size());
+    report("before", chainStats(before, per, cache_size), cache_size);
+    report("after", best_stats, cache_size);
+
+    const fBox3 B = boundingBox(best_mesh);
+    const int mem = (int)(best_mesh.vert.size() * 12 + best_mesh.tex.size() * 8 + best_mesh.norm.size() * 12) + best_stats.face_bytes;
+    printf("// 3D model [%s]\n//\n", name.c_str());
+    printf("// - vertices   : %d\n", (int)best_mesh.vert.size());
+    printf("// - textures   : %d\n", (int)best_mesh.tex.size());
+    printf("// - normals    : %d\n", (int)best_mesh.norm.size());
+    printf("// - triangles  : %d\n//\n", (int)best_mesh.tri.size());
+    printf("// - memory size: %dkb\n//\n", (mem + 1023) / 1024);
+    printf("// - model bounding box: [%.2f,%.2f]x[%.2f,%.2f]x[%.2f,%.2f]\n//\n", B.minX, B.maxX, B.minY, B.maxY, B.minZ, B.maxZ);
+    printf("// optimized by host/mesh_optimize.cpp: %.2f triangles per chain, ACMR %.3f\n\n", (double)best_stats.nb_triangles / best_stats.nb_chains, best_stats.acmr);
+    printf("#pragma once\n\n#include <tgx.h>\n\n");
+    for (const std::string& h : includes) printf("#include \"%s\"\n", h.c_str());
+    printf("\n\n");
+    writeMesh(stdout, best_mesh, best, info);
+    printf("/** end of %s.h */\n", name.c_str());
+    return 0;
+    }
+
+/** end of file */
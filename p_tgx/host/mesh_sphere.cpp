@@ -0,0 +1,122 @@
+// mesh_sphere.cpp - constant sphere tessellations for SphereMeshCache::addStatic() on the host.
+//
+// Builds the unit sphere meshes of the requested tessellation levels with
+// tgx::buildSphereMesh() (the same meshes as the ones built at run time by a
+// SphereMeshCache for Renderer3D::drawSphere()) and writes them on stdout as
+// a header in the same format as the converted models, so that they can be
+// stored in flash. The header also defines a function that registers all the
+// levels in a cache:
+//
+//   #include "spheres.h"
+//   static tgx::SphereMeshCache<tgx::RGB565> cache(nullptr, 0); // static meshes only
+//   spheres_addStatic(cache);
+//   renderer.setSphereCache(&cache);
+//
+// Build & run on the host (from the p_tgx directory):
+//
+//   g++ -O2 -std=c++17 -Itgx host/mesh_sphere.cpp -o mesh_sphere
+//   ./mesh_sphere -name spheres -level 24x12 -adaptive 3 9 > spheres.h
+//
+// Options:
+//   -name <name>        prefix of the output meshes (default: sphere), the meshes are named <name>_<sectors>x<stacks>.
+//   -type <color_t>     color type of the meshes (default: tgx::RGB565).
+//   -tex                also create the texture coords (for drawSphere() with a texture).
+//   -level <s>x<t>      add the level with s sectors and t stacks, may be repeated.
+//   -adaptive <a> <b>   add the levels of drawAdaptativeSphere() from a to b stacks (2t - 2 sectors).
+//
+#include "tgx.h"
+#include "mesh_tools.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+using namespace tgx;
+using namespace mesh_tools;
+
+
+int main(int argc, char** argv)
+    {
+    std::string name = "sphere", color_type = "tgx::RGB565";
+    bool textured = false;
+    std::vector<std::pair<int, int>> levels;
+    for (int i = 1; i < argc; i++)
+        {
+        if ((strcmp(argv[i], "-name") == 0) && (i + 1 < argc)) name = argv[++i];
+        else if ((strcmp(argv[i], "-type") == 0) && (i + 1 < argc)) color_type = argv[++i];
+        else if (strcmp(argv[i], "-tex") == 0) textured = true;
+        else if ((strcmp(argv[i], "-level") == 0) && (i + 1 < argc))
+            {
+            int s = 0, t = 0;
+            if (sscanf(argv[++i], "%dx%d", &s, &t) != 2) { fprintf(stderr, "invalid level %s\n", argv[i]); return 1; }
+            levels.push_back({ s, t });
+            }
+        else if ((strcmp(argv[i], "-adaptive") == 0) && (i + 2 < argc))
+            {
+            const int a = atoi(argv[i + 1]), b = atoi(argv[i + 2]);
+            i += 2;
+            for (int t = a; t <= b; t++) levels.push_back({ 2 * t - 2, t });
+            }
+        else { fprintf(stderr, "unknown option %s\n", argv[i]); return 1; }
+        }
+    if (levels.size() == 0)
+        {
+        fprintf(stderr, "no level: use -level or -adaptive\n");
+        return 1;
+        }
+
+    printf("// unit sphere meshes [%s] for tgx::SphereMeshCache::addStatic()\n//\n", name.c_str());
+    printf("// generated by host/mesh_sphere.cpp (%s texture coords)\n\n", (textured) ? "with" : "without");
+    printf("#pragma once\n\n#include <tgx.h>\n\n\n");
+    std::vector<std::string> names;
+    for (const auto& L : levels)
+        {
+        const int nb_sectors = L.first, nb_stacks = L.second;
+        std::vector<uint32_t> buf((sphereMeshSize(nb_sectors, nb_stacks, textured) + 3) / 4);
+        Mesh3D<RGB565> S;
+        if (!buildSphereMesh(&S, nb_sectors, nb_stacks, textured, buf.data(), (int)(buf.size() * 4)))
+            {
+            fprintf(stderr, "invalid level %dx%d (sectors in [3,256], stacks >= 3, at most 32767 vertices)\n", nb_sectors, nb_stacks);
+            return 1;
+            }
+        const std::string nm = name + "_" + std::to_string(nb_sectors) + "x" + std::to_string(nb_stacks);
+
+        // keep the chains of buildSphereMesh(): one per stack
+        MeshData M = loadMesh(S);
+        std::vector<Chain> chains;
+        const int per = (textured) ? 3 : 2;
+        const uint16_t* face = S.face;
+        int nbt;
+        while ((nbt = *face) != 0)
+            {
+            const int len = 1 + (nbt + 2) * per;
+            chains.push_back(Chain(face, face + len));
+            face += len;
+            }
+
+        MeshInfo info;
+        info.name = nm;
+        info.color_type = color_type;
+        info.texture = "nullptr";
+        info.next = "nullptr";
+        info.color = S.color;
+        info.ambiant_strength = S.ambiant_strength;
+        info.diffuse_strength = S.diffuse_strength;
+        info.specular_strength = S.specular_strength;
+        info.specular_exponent = S.specular_exponent;
+        writeMesh(stdout, M, chains, info);
+        names.push_back(nm);
+        fprintf(stderr, "%s: %d vertices, %d texcoords, %d triangles, %d bytes of arrays\n", nm.c_str(), S.nb_vertices, S.nb_texcoords, S.nb_faces, sphereMeshSize(nb_sectors, nb_stacks, textured));
+        }
+
+    printf("// register all the levels in a sphere cache\n");
+    printf("inline void %s_addStatic(tgx::SphereMeshCache<%s>& cache)\n    {\n", name.c_str(), color_type.c_str());
+    for (size_t k = 0; k < levels.size(); k++) printf("    cache.addStatic(&%s, %d, %d, %s);\n", names[k].c_str(), levels[k].first, levels[k].second, (textured) ? "true" : "false");
+    printf("    }\n\n\n");
+    printf("/** end of %s.h */\n", name.c_str());
+    return 0;
+    }
+
+/** end of file */
@@ -0,0 +1,752 @@
+// mesh_tools.h - helpers shared by the host side mesh tools (mesh_lod.cpp, ...).
+//
+// - loadMesh() decodes the triangle chains of a tgx::Mesh3D into a plain
+//   triangle list where each corner holds its vertex, texcoord and normal
+//   indices.
+// - compactMesh() removes degenerate triangles and unused vertices, texcoords
+//   and normals.
+// - loadOBJ() reads a Wavefront OBJ file into the same triangle list.
+// - stripify() re-encodes a triangle list into chains (triangle strips) in the
+//   format expected by Renderer3D::drawMesh().
+// - chainStats() measures an encoding (chain lengths, face array size and
+//   average cache miss ratio) and reorderMesh() renumbers the vertices,
+//   texcoords and normals in the order of their first use in the chains.
+// - buildClusters() and encodeClusters() split a mesh into meshlet clusters
+//   with their bounding spheres and normal cones (see tgx::MeshCluster).
+// - quantizeNormals() snaps the normals to the octahedral directions of the
+//   normal lighting table of Renderer3D (see tgx::octahedralIndex()).
+// - writeMesh() writes a mesh header in the same format as the converted
+//   models of the example directory (e.g. example/bunny_fig_small.h).
+//
+// Host only: uses the standard library.
+//
+#pragma once
+
+#include "tgx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+
+
+namespace mesh_tools
+{
+
+    using namespace tgx;
+
+
+    /** corner of a triangle: indices in the vertex, texcoord and normal arrays (-1 when absent) */
+    struct Corner
+        {
+        int v, t, n;
+
+        bool operator==(const Corner& c) const { return (v == c.v) && (t == c.t) && (n == c.n); }
+        bool operator<(const Corner& c) const { return (v != c.v) ? (v < c.v) : ((t != c.t) ? (t < c.t) : (n < c.n)); }
+        };
+
+
+    /** triangle with its corners in drawing (winding) order */
+    struct Tri
+        {
+        Corner c[3];
+        };
+
+
+    /** plain (non chained) mesh */
+    struct MeshData
+        {
+        std::vector<fVec3> vert;
+        std::vector<fVec2> tex;     // empty if no texture coords
+        std::vector<fVec3> norm;    // empty if no normals
+        std::vector<Tri> tri;
+        };
+
+
+    /** chain of triangles encoded as in Mesh3D::face (without the 0 terminator) */
+    typedef std::vector<uint16_t> Chain;
+
+
+    /**
+     * Decode the face array of a mesh (the chained meshes are ignored).
+     */
+    template<typename color_t> MeshData loadMesh(const Mesh3D<color_t>& mesh)
+        {
+        MeshData M;
+        M.vert.assign(mesh.vertice, mesh.vertice + mesh.nb_vertices);
+        if (mesh.texcoord) M.tex.assign(mesh.texcoord, mesh.texcoord + mesh.nb_texcoords);
+        if (mesh.normal) M.norm.assign(mesh.normal, mesh.normal + mesh.nb_normals);
+        const uint16_t* face = mesh.face;
+        auto read = [&](bool& dbit)
+            {
+            Corner c;
+            const uint16_t e = *(face++);
+            dbit = ((e & 32768) != 0);
+            c.v = e & 32767;
+            c.t = (mesh.texcoord) ? *(face++) : -1;
+            c.n = (mesh.normal) ? *(face++) : -1;
+            return c;
+            };
+        int nbt;
+        while ((nbt = *(face++)) != 0)
+            {
+            bool dbit;
+            Corner P0 = read(dbit), P1 = read(dbit), P2 = read(dbit);
+            M.tri.push_back({ { P0, P1, P2 } });
+            while (--nbt > 0)
+                {
+                const Corner P = read(dbit);
+                if (dbit) P0 = P2; else P1 = P2;
+                P2 = P;
+                M.tri.push_back({ { P0, P1, P2 } });
+                }
+            }
+        return M;
+        }
+
+
+    /**
+     * Remove degenerate triangles and the unused vertices, texcoords and normals (the order of
+     * the remaining elements is kept).
+     */
+    inline void compactMesh(MeshData& M)
+        {
+        std::vector<Tri> tris;
+        for (const Tri& T : M.tri)
+            {
+            if ((T.c[0].v != T.c[1].v) && (T.c[1].v != T.c[2].v) && (T.c[2].v != T.c[0].v)) tris.push_back(T);
+            }
+        std::vector<int> rv(M.vert.size(), -1), rt(M.tex.size(), -1), rn(M.norm.size(), -1);
+        MeshData R;
+        for (Tri& T : tris)
+            {
+            for (Corner& c : T.c)
+                {
+                if (rv[c.v] < 0) { rv[c.v] = (int)R.vert.size(); R.vert.push_back(M.vert[c.v]); }
+                c.v = rv[c.v];
+                if (c.t >= 0) { if (rt[c.t] < 0) { rt[c.t] = (int)R.tex.size(); R.tex.push_back(M.tex[c.t]); } c.t = rt[c.t]; }
+                if (c.n >= 0) { if (rn[c.n] < 0) { rn[c.n] = (int)R.norm.size(); R.norm.push_back(M.norm[c.n]); } c.n = rn[c.n]; }
+                }
+            }
+        R.tri.swap(tris);
+        M.vert.swap(R.vert);
+        M.tex.swap(R.tex);
+        M.norm.swap(R.norm);
+        M.tri.swap(R.tri);
+        }
+
+
+    /**
+     * Encode the triangles into chains (greedy triangle strips).
+     *
+     * Consecutive triangles of a chain share two corners (same vertex, texcoord and normal). A
+     * chain starts with the triangle with the fewest free neighbours and, at each step, continues
+     * with the neighbour that itself has the fewest free neighbours so that few isolated
+     * triangles are left behind. The start of a new chain is searched first among the triangles
+     * touching the previous chain to keep the vertices of consecutive chains close together.
+     *
+     * A non zero seed breaks the ties at random (each seed gives a different valid encoding).
+     */
+    inline std::vector<Chain> stripify(const MeshData& M, uint32_t seed = 0)
+        {
+        const int nbt = (int)M.tri.size();
+        std::vector<std::vector<int>> vtri(M.vert.size()); // triangles around each vertex
+        for (int i = 0; i < nbt; i++)
+            for (int k = 0; k < 3; k++) vtri[M.tri[i].c[k].v].push_back(i);
+        uint32_t rnd = seed;
+        auto coin = [&]() { rnd = rnd * 1664525u + 1013904223u; return ((rnd >> 16) & 1) != 0; };
+        std::map<Corner, int> cid; // corner -> unique id
+        std::vector<int> tc(3 * nbt);
+        for (int i = 0; i < nbt; i++)
+            for (int k = 0; k < 3; k++)
+                {
+                auto it = cid.insert(std::make_pair(M.tri[i].c[k], (int)cid.size())).first;
+                tc[3 * i + k] = it->second;
+                }
+        std::map<std::pair<int, int>, int> edge; // directed corner edge -> triangle
+        for (int i = 0; i < nbt; i++)
+            for (int k = 0; k < 3; k++) edge[std::make_pair(tc[3 * i + k], tc[3 * i + (k + 1) % 3])] = i;
+        std::vector<char> used(nbt, 0);
+
+        // triangle containing the directed edge a -> b (-1 if none or used)
+        auto find = [&](int a, int b)
+            {
+            auto it = edge.find(std::make_pair(a, b));
+            return ((it == edge.end()) || (used[it->second])) ? -1 : it->second;
+            };
+        // number of free neighbours of a triangle
+        auto degree = [&](int i)
+            {
+            int d = 0;
+            for (int k = 0; k < 3; k++) if (find(tc[3 * i + (k + 1) % 3], tc[3 * i + k]) >= 0) d++;
+            return d;
+            };
+        // third corner of triangle i once a -> b is removed
+        auto third = [&](int i, int a, int b)
+            {
+            for (int k = 0; k < 3; k++) { const int x = tc[3 * i + k]; if ((x != a) && (x != b)) return k; }
+            return 0;
+            };
+
+        // build the chain starting with triangle s rotated by r, returns its triangles and dbits.
+        auto grow = [&](int s, int r, std::vector<int>& tris, std::vector<int>& corners, std::vector<char>& dbits)
+            {
+            tris.assign(1, s);
+            dbits.assign(3, 0);
+            corners = { 3 * s + r, 3 * s + (r + 1) % 3, 3 * s + (r + 2) % 3 };
+            used[s] = 1;
+            int p0 = corners[0], p1 = corners[1], p2 = corners[2];
+            while ((int)tris.size() < 32767)
+                {
+                const int a = find(tc[p0], tc[p2]); // dbit = 0: next is (P0, P2, X)
+                const int b = find(tc[p2], tc[p1]); // dbit = 1: next is (P2, P1, X)
+                if ((a < 0) && (b < 0)) break;
+                bool d;
+                if (a < 0) d = true;
+                else if (b < 0) d = false;
+                else { const int da = degree(a), db = degree(b); d = (da != db) ? (db < da) : ((seed) ? coin() : (dbits.back() == 0)); }
+                const int t = d ? b : a;
+                const int k = d ? third(t, tc[p2], tc[p1]) : third(t, tc[p0], tc[p2]);
+                used[t] = 1;
+                tris.push_back(t);
+                corners.push_back(3 * t + k);
+                dbits.push_back(d ? 1 : 0);
+                if (d) p0 = p2; else p1 = p2;
+                p2 = 3 * t + k;
+                }
+            for (int t : tris) used[t] = 0;
+            };
+
+        std::vector<Chain> chains;
+        std::vector<int> tris, corners, best_corners, best_tris;
+        std::vector<char> dbits, best_dbits;
+        while (true)
+            {
+            int s = -1, sd = 4;
+            auto candidate = [&](int i)
+                {
+                if (used[i]) return;
+                const int d = degree(i);
+                if ((d < sd) || ((d == sd) && (seed) && (coin()))) { s = i; sd = d; }
+                };
+            for (int c : best_corners)
+                { // near the previous chain first
+                for (int i : vtri[M.tri[c / 3].c[c % 3].v]) candidate(i);
+                }
+            if (s < 0)
+                { // anywhere else
+                for (int i = 0; i < nbt; i++)
+                    {
+                    if (used[i]) continue;
+                    const int d = degree(i);
+                    if (d < sd) { s = i; sd = d; if (d == 0) break; }
+                    }
+                }
+            if (s < 0) break;
+            size_t best = 0;
+            for (int r = 0; r < 3; r++)
+                {
+                grow(s, r, tris, corners, dbits);
+                if (tris.size() > best) { best = tris.size(); best_tris = tris; best_corners = corners; best_dbits = dbits; }
+                }
+            for (int t : best_tris) used[t] = 1;
+            Chain C;
+            C.push_back((uint16_t)best_tris.size());
+            for (size_t j = 0; j < best_corners.size(); j++)
+                {
+                const Corner& c = M.tri[best_corners[j] / 3].c[best_corners[j] % 3];
+                C.push_back((uint16_t)(c.v | (best_dbits[j] ? 32768 : 0)));
+                if (c.t >= 0) C.push_back((uint16_t)c.t);
+                if (c.n >= 0) C.push_back((uint16_t)c.n);
+                }
+            chains.push_back(C);
+            }
+        return chains;
+        }
+
+
+    /**
+     * Split the face array of a mesh into its chains.
+     */
+    template<typename color_t> std::vector<Chain> readChains(const Mesh3D<color_t>& mesh)
+        {
+        const int per = 1 + ((mesh.texcoord) ? 1 : 0) + ((mesh.normal) ? 1 : 0); // values per corner
+        std::vector<Chain> chains;
+        const uint16_t* face = mesh.face;
+        int nbt;
+        while ((nbt = *face) != 0)
+            {
+            chains.push_back(Chain(face, face + 1 + (nbt + 2) * per));
+            face += 1 + (nbt + 2) * per;
+            }
+        return chains;
+        }
+
+
+    /** statistics of an encoding */
+    struct ChainStats
+        {
+        int nb_chains;
+        int nb_triangles;
+        int face_bytes;         // size of the face array (with the terminating 0)
+        double acmr;            // vertices transformed per triangle without vertex cache
+        double acmr_cache;      // vertices transformed per triangle with the vertex cache of drawMesh()
+        };
+
+
+    /**
+     * Compute the statistics of an encoding. `per` is the number of values per corner (1 + has
+     * texcoords + has normals). The vertex cache is simulated as in Renderer3D: one entry per
+     * vertex if cache_size is at least the number of vertices, otherwise direct mapped on the
+     * vertex index with the largest power of two <= cache_size entries.
+     */
+    inline ChainStats chainStats(const std::vector<Chain>& chains, int per, int cache_size)
+        {
+        ChainStats S = { 0, 0, 2, 0, 0 };
+        int nbv = 0;
+        for (const Chain& C : chains)
+            for (size_t j = 1; j < C.size(); j += per) nbv = std::max(nbv, (C[j] & 32767) + 1);
+        int mask = 1;
+        while (2 * mask <= cache_size) mask *= 2;
+        mask--;
+        if (cache_size >= nbv) mask = 32767; // full array mode
+        std::vector<int> cache(mask + 1, -1);
+        long fetches = 0, misses = 0;
+        for (const Chain& C : chains)
+            {
+            S.nb_chains++;
+            S.nb_triangles += C[0];
+            S.face_bytes += 2 * (int)C.size();
+            for (size_t j = 1; j < C.size(); j += per)
+                {
+                const int v = C[j] & 32767;
+                fetches++;
+                if (cache[v & mask] != v) { misses++; cache[v & mask] = v; }
+                }
+            }
+        if (S.nb_triangles > 0)
+            {
+            S.acmr = (double)fetches / S.nb_triangles;
+            S.acmr_cache = (double)misses / S.nb_triangles;
+            }
+        return S;
+        }
+
+
+    /**
+     * Renumber the vertices, texcoords and normals in the order of their first use in the chains
+     * (the unused ones are removed) and update the chains accordingly.
+     */
+    inline void reorderMesh(MeshData& M, std::vector<Chain>& chains)
+        {
+        const bool tex = (M.tex.size() > 0), norm = (M.norm.size() > 0);
+        std::vector<int> rv(M.vert.size(), -1), rt(M.tex.size(), -1), rn(M.norm.size(), -1);
+        std::vector<fVec3> vert, normals;
+        std::vector<fVec2> texcoords;
+        for (Chain& C : chains)
+            {
+            for (size_t j = 1; j < C.size(); )
+                {
+                const int v = C[j] & 32767;
+                if (rv[v] < 0) { rv[v] = (int)vert.size(); vert.push_back(M.vert[v]); }
+                C[j] = (uint16_t)((C[j] & 32768) | rv[v]);
+                j++;
+                if (tex) { if (rt[C[j]] < 0) { rt[C[j]] = (int)texcoords.size(); texcoords.push_back(M.tex[C[j]]); } C[j] = (uint16_t)rt[C[j]]; j++; }
+                if (norm) { if (rn[C[j]] < 0) { rn[C[j]] = (int)normals.size(); normals.push_back(M.norm[C[j]]); } C[j] = (uint16_t)rn[C[j]]; j++; }
+                }
+            }
+        for (Tri& T : M.tri)
+            for (Corner& c : T.c)
+                {
+                c.v = rv[c.v];
+                if (tex) c.t = rt[c.t];
+                if (norm) c.n = rn[c.n];
+                }
+        M.vert.swap(vert);
+        M.tex.swap(texcoords);
+        M.norm.swap(normals);
+        }
+
+
+    /**
+     * Load a Wavefront OBJ file (v, vt, vn and f lines, polygons are split in fans). Texcoords
+     * (resp. normals) are dropped if some face corners do not have them. Return false on error.
+     */
+    inline bool loadOBJ(const char* filename, MeshData& M)
+        {
+        FILE* f = fopen(filename, "r");
+        if (!f) return false;
+        M = MeshData();
+        bool all_t = true, all_n = true;
+        char line[4096];
+        while (fgets(line, sizeof(line), f))
+            {
+            float x, y, z;
+            if ((line[0] == 'v') && (line[1] == ' ') && (sscanf(line + 2, "%f %f %f", &x, &y, &z) == 3)) M.vert.push_back(fVec3(x, y, z));
+            else if ((line[0] == 'v') && (line[1] == 't') && (sscanf(line + 3, "%f %f", &x, &y) == 2)) M.tex.push_back(fVec2(x, y));
+            else if ((line[0] == 'v') && (line[1] == 'n') && (sscanf(line + 3, "%f %f %f", &x, &y, &z) == 3)) M.norm.push_back(fVec3(x, y, z));
+            else if ((line[0] == 'f') && (line[1] == ' '))
+                {
+                std::vector<Corner> poly;
+                char* p = line + 2;
+                while (true)
+                    {
+                    while ((*p == ' ') || (*p == '\t')) p++;
+                    if ((*p == 0) || (*p == '\n') || (*p == '\r')) break;
+                    int idx[3] = { 0, 0, 0 };
+                    for (int k = 0; k < 3; k++)
+                        {
+                        if ((k > 0) && (*p != '/')) break;
+                        if (k > 0) p++;
+                        char* e;
+                        idx[k] = (int)strtol(p, &e, 10);
+                        p = e;
+                        }
+                    while ((*p != 0) && (*p != ' ') && (*p != '\t') && (*p != '\n') && (*p != '\r')) p++;
+                    const int sz[3] = { (int)M.vert.size(), (int)M.tex.size(), (int)M.norm.size() };
+                    for (int k = 0; k < 3; k++) idx[k] = (idx[k] < 0) ? (sz[k] + idx[k]) : (idx[k] - 1); // 1-based or relative
+                    if ((idx[0] < 0) || (idx[0] >= sz[0])) { fclose(f); return false; }
+                    if ((idx[1] < 0) || (idx[1] >= sz[1])) { all_t = false; idx[1] = -1; }
+                    if ((idx[2] < 0) || (idx[2] >= sz[2])) { all_n = false; idx[2] = -1; }
+                    poly.push_back({ idx[0], idx[1], idx[2] });
+                    }
+                for (size_t k = 2; k < poly.size(); k++) M.tri.push_back({ { poly[0], poly[k - 1], poly[k] } });
+                }
+            }
+        fclose(f);
+        if ((!all_t) || (M.tex.empty())) { M.tex.clear(); for (Tri& T : M.tri) for (Corner& c : T.c) c.t = -1; }
+        if ((!all_n) || (M.norm.empty())) { M.norm.clear(); for (Tri& T : M.tri) for (Corner& c : T.c) c.n = -1; }
+        return (M.tri.size() > 0);
+        }
+
+
+    /**
+     * Group the triangles in clusters (meshlets) of at most max_faces triangles.
+     *
+     * Clusters are grown greedily from a seed triangle by adding the neighbour triangle (sharing a
+     * vertex) that keeps the cluster compact and its normals close together. Triangles whose
+     * normal makes more than max_angle degrees with the mean normal of the cluster are not added:
+     * a small angle gives tight normal cones (more back-facing clusters rejected) but smaller
+     * clusters. The seed of a new cluster is taken next to the previous cluster when possible.
+     */
+    inline std::vector<std::vector<int>> buildClusters(const MeshData& M, int max_faces, float max_angle = 45.0f)
+        {
+        const float min_dp = cosf(max_angle * 3.14159265f / 180.0f);
+        const int nbt = (int)M.tri.size();
+        std::vector<std::vector<int>> vtri(M.vert.size());
+        std::vector<fVec3> normal(nbt), centroid(nbt);
+        double edges = 0;
+        for (int i = 0; i < nbt; i++)
+            {
+            const fVec3& A = M.vert[M.tri[i].c[0].v];
+            const fVec3& B = M.vert[M.tri[i].c[1].v];
+            const fVec3& C = M.vert[M.tri[i].c[2].v];
+            normal[i] = crossProduct(B - A, C - A);
+            if (normal[i].norm2() > 0) normal[i].normalize();
+            centroid[i] = (A + B + C) / 3.0f;
+            edges += (B - A).norm() + (C - B).norm() + (A - C).norm();
+            for (int k = 0; k < 3; k++) vtri[M.tri[i].c[k].v].push_back(i);
+            }
+        const float scale = (float)(edges / (3.0 * std::max(nbt, 1))) * sqrtf((float)max_faces); // typical diameter of a cluster
+        std::vector<int> owner(nbt, -1);
+        std::vector<int> vmark(M.vert.size(), -1);  // cluster using the vertex
+        std::vector<int> tmark(nbt, -1);            // cluster for which the triangle is a candidate
+        std::vector<std::vector<int>> clusters;
+        int scan = 0;
+        while (true)
+            {
+            const int id = (int)clusters.size();
+            int seed = -1;
+            if (id > 0)
+                { // next to the previous cluster
+                for (int t : clusters.back())
+                    {
+                    for (int k = 0; (k < 3) && (seed < 0); k++)
+                        for (int x : vtri[M.tri[t].c[k].v]) if (owner[x] < 0) { seed = x; break; }
+                    if (seed >= 0) break;
+                    }
+                }
+            while ((seed < 0) && (scan < nbt)) { if (owner[scan] < 0) seed = scan; else scan++; }
+            if (seed < 0) break;
+            std::vector<int> cl, cand;
+            fVec3 nsum(0, 0, 0), csum(0, 0, 0);
+            int t = seed;
+            while (true)
+                {
+                owner[t] = id;
+                cl.push_back(t);
+                nsum += normal[t];
+                csum += centroid[t];
+                for (int k = 0; k < 3; k++)
+                    {
+                    const int v = M.tri[t].c[k].v;
+                    vmark[v] = id;
+                    for (int x : vtri[v]) if ((owner[x] < 0) && (tmark[x] != id)) { tmark[x] = id; cand.push_back(x); }
+                    }
+                if ((int)cl.size() >= max_faces) break;
+                fVec3 axis = nsum;
+                if (axis.norm2() > 0) axis.normalize();
+                const fVec3 center = csum / (float)cl.size();
+                int best = -1;
+                float best_score = 0;
+                for (int x : cand)
+                    {
+                    if (owner[x] >= 0) continue;
+                    const float dp = dotProduct(normal[x], axis);
+                    if (dp < min_dp) continue;
+                    int shared = 0;
+                    for (int k = 0; k < 3; k++) if (vmark[M.tri[x].c[k].v] == id) shared++;
+                    const float score = 4.0f * (1.0f - dp) + (centroid[x] - center).norm() / scale - 0.25f * shared;
+                    if ((best < 0) || (score < best_score)) { best = x; best_score = score; }
+                    }
+                if (best < 0) break;
+                t = best;
+                }
+            clusters.push_back(cl);
+            }
+        return clusters;
+        }
+
+
+    /**
+     * Encode the triangles cluster by cluster (the chains of a cluster are consecutive) and
+     * compute the bounding sphere and the normal cone of each cluster.
+     */
+    inline std::vector<Chain> encodeClusters(const MeshData& M, const std::vector<std::vector<int>>& clusters, std::vector<MeshCluster>& out)
+        {
+        std::vector<Chain> chains;
+        out.clear();
+        int offset = 0;
+        MeshData sub;
+        sub.vert = M.vert;
+        for (const std::vector<int>& cl : clusters)
+            {
+            MeshCluster C;
+            // bounding sphere: center of the bounding box of the vertices.
+            fBox3 B(M.vert[M.tri[cl[0]].c[0].v]);
+            for (int t : cl) for (int k = 0; k < 3; k++) B |= M.vert[M.tri[t].c[k].v];
+            C.center = fVec3((B.minX + B.maxX) * 0.5f, (B.minY + B.maxY) * 0.5f, (B.minZ + B.maxZ) * 0.5f);
+            float r2 = 0;
+            for (int t : cl) for (int k = 0; k < 3; k++) r2 = std::max(r2, (M.vert[M.tri[t].c[k].v] - C.center).norm2());
+            C.radius = sqrtf(r2) * 1.0001f;
+            // normal cone: mean normal and largest deviation.
+            fVec3 axis(0, 0, 0);
+            std::vector<fVec3> N;
+            for (int t : cl)
+                {
+                const fVec3& P0 = M.vert[M.tri[t].c[0].v];
+                fVec3 n = crossProduct(M.vert[M.tri[t].c[1].v] - P0, M.vert[M.tri[t].c[2].v] - P0);
+                if (n.norm2() <= 0) continue; // degenerate triangles are never drawn
+                n.normalize();
+                N.push_back(n);
+                axis += n;
+                }
+            C.cone_axis = fVec3(0, 0, 1);
+            C.cone_cutoff = 2.0f; // disabled
+            if (axis.norm2() > 0)
+                {
+                axis.normalize();
+                float mindp = 1.0f;
+                for (const fVec3& n : N) mindp = std::min(mindp, dotProduct(n, axis));
+                C.cone_axis = axis;
+                if (mindp > 0.01f) C.cone_cutoff = sqrtf(std::max(0.0f, 1.0f - mindp * mindp)) + 0.0001f;
+                }
+            C.face_offset = (uint16_t)offset;
+            C.nb_faces = (uint16_t)cl.size();
+            out.push_back(C);
+            sub.tri.clear();
+            for (int t : cl) sub.tri.push_back(M.tri[t]);
+            for (const Chain& ch : stripify(sub))
+                {
+                chains.push_back(ch);
+                offset += (int)ch.size();
+                }
+            }
+        return chains;
+        }
+
+
+    /** bounding box of the vertices */
+    /**
+     * Replace each normal by the center direction of its cell in the octahedral quantization
+     * with `bits` bits per axis (see tgx::octahedralIndex()) and merge the normals that fall in
+     * the same cell (the unused ones are removed). Returns the largest angle, in degrees,
+     * between a normal and its quantized direction.
+     */
+    inline double quantizeNormals(MeshData& M, int bits)
+        {
+        std::map<int, int> cell; // cell -> index in the new normal array
+        std::vector<int> remap(M.norm.size());
+        std::vector<fVec3> norm;
+        double max_angle = 0;
+        for (size_t i = 0; i < M.norm.size(); i++)
+            {
+            const int c = octahedralIndex(M.norm[i], bits);
+            auto it = cell.find(c);
+            if (it == cell.end())
+                {
+                it = cell.insert(std::make_pair(c, (int)norm.size())).first;
+                norm.push_back(octahedralDirection(c, bits));
+                }
+            remap[i] = it->second;
+            fVec3 N = M.norm[i];
+            N.normalize();
+            const double d = std::min(1.0, std::max(-1.0, (double)dotProduct(N, norm[it->second])));
+            max_angle = std::max(max_angle, acos(d) * 180.0 / 3.14159265358979);
+            }
+        for (Tri& T : M.tri)
+            for (Corner& c : T.c) if (c.n >= 0) c.n = remap[c.n];
+        M.norm.swap(norm);
+        compactMesh(M);
+        return max_angle;
+        }
+
+
+    inline fBox3 boundingBox(const MeshData& M)
+        {
+        fBox3 B(M.vert[0]);
+        for (const fVec3& V : M.vert) B |= V;
+        return B;
+        }
+
+
+    /** float literal for C++ (always with a decimal point and the 'f' suffix) */
+    inline std::string floatLiteral(double x)
+        {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.9g", x);
+        std::string s = buf;
+        if (s.find_first_of(".en") == std::string::npos) s += ".0";
+        return s + "f";
+        }
+
+
+    /** material and links written with a mesh */
+    struct MeshInfo
+        {
+        std::string name;           // name of the mesh (C identifier)
+        std::string color_type;     // e.g. "tgx::RGB565"
+        std::string texture;        // texture expression, e.g. "&bunny_fig_texture" or "nullptr"
+        std::string next;           // next mesh expression or "nullptr"
+        RGBf color;
+        float ambiant_strength, diffuse_strength, specular_strength;
+        int specular_exponent;
+        std::vector<MeshCluster> clusters;  // meshlet clusters (empty if none)
+        };
+
+
+    /**
+     * Write a mesh (arrays + Mesh3D structure) in the format of the converted models, with the
+     * given encoding of the triangles.
+     */
+    inline void writeMesh(FILE* f, const MeshData& M, const std::vector<Chain>& chains, const MeshInfo& info)
+        {
+        size_t len = 1;
+        for (const Chain& C : chains) len += C.size();
+        const fBox3 B = boundingBox(M);
+        const char* nm = info.name.c_str();
+        fprintf(f, "// object [%s] with %d triangles (%d chains)\n\n", nm, (int)M.tri.size(), (int)chains.size());
+
+        fprintf(f, "// vertex array: %dkb.\n", (int)((M.vert.size() * 12 + 1023) / 1024));
+        fprintf(f, "const tgx::fVec3 %s_vert_array[%d] PROGMEM = {\n", nm, (int)M.vert.size());
+        for (size_t i = 0; i < M.vert.size(); i++) fprintf(f, "{%.9g,%.9g,%.9g}%s\n", M.vert[i].x, M.vert[i].y, M.vert[i].z, (i + 1 < M.vert.size()) ? "," : "");
+        fprintf(f, "};\n\n\n");
+        if (M.tex.size())
+            {
+            fprintf(f, "// texture array: %dkb.\n", (int)((M.tex.size() * 8 + 1023) / 1024));
+            fprintf(f, "const tgx::fVec2 %s_tex_array[%d] PROGMEM = {\n", nm, (int)M.tex.size());
+            for (size_t i = 0; i < M.tex.size(); i++) fprintf(f, "{%.9g,%.9g}%s\n", M.tex[i].x, M.tex[i].y, (i + 1 < M.tex.size()) ? "," : "");
+            fprintf(f, "};\n\n\n");
+            }
+        if (M.norm.size())
+            {
+            fprintf(f, "// normal array: %dkb.\n", (int)((M.norm.size() * 12 + 1023) / 1024));
+            fprintf(f, "const tgx::fVec3 %s_norm_array[%d] PROGMEM = {\n", nm, (int)M.norm.size());
+            for (size_t i = 0; i < M.norm.size(); i++) fprintf(f, "{%.9g,%.9g,%.9g}%s\n", M.norm[i].x, M.norm[i].y, M.norm[i].z, (i + 1 < M.norm.size()) ? "," : "");
+            fprintf(f, "};\n\n\n");
+            }
+        const int per = 1 + (M.tex.size() ? 1 : 0) + (M.norm.size() ? 1 : 0); // values per corner
+        fprintf(f, "// face array: %dkb.\n", (int)((len * 2 + 1023) / 1024));
+        fprintf(f, "const uint16_t %s_face[%d] PROGMEM = {\n", nm, (int)len);
+        for (size_t i = 0; i < chains.size(); i++)
+            {
+            const Chain& C = chains[i];
+            fprintf(f, "%d, // chain %d\n", C[0], (int)i);
+            for (size_t j = 1; j < C.size(); j += per)
+                {
+                for (int k = 0; k < per; k++) fprintf(f, "%d%s", C[j + k], (k + 1 < per) ? "," : ", ");
+                const int ci = (int)((j - 1) / per); // first triangle on one line then 10 corners per line
+                if ((ci == 2) || ((ci > 2) && ((ci - 2) % 10 == 0)) || (j + per >= C.size())) fprintf(f, "\n");
+                }
+            }
+        fprintf(f, "0};\n\n\n");
+
+        if (info.clusters.size())
+            {
+            fprintf(f, "// meshlet clusters: %dkb.\n", (int)((info.clusters.size() * sizeof(MeshCluster) + 1023) / 1024));
+            fprintf(f, "const tgx::MeshCluster %s_cluster_array[%d] PROGMEM = {\n", nm, (int)info.clusters.size());
+            for (size_t i = 0; i < info.clusters.size(); i++)
+                {
+                const MeshCluster& C = info.clusters[i];
+                fprintf(f, "{{%s,%s,%s},%s,{%s,%s,%s},%s,%d,%d}%s\n",
+                        floatLiteral(C.center.x).c_str(), floatLiteral(C.center.y).c_str(), floatLiteral(C.center.z).c_str(), floatLiteral(C.radius).c_str(),
+                        floatLiteral(C.cone_axis.x).c_str(), floatLiteral(C.cone_axis.y).c_str(), floatLiteral(C.cone_axis.z).c_str(), floatLiteral(C.cone_cutoff).c_str(),
+                        C.face_offset, C.nb_faces, (i + 1 < info.clusters.size()) ? "," : "");
+                }
+            fprintf(f, "};\n\n\n");
+            }
+
+        fprintf(f, "// mesh info for object %s\n", nm);
+        fprintf(f, "const tgx::Mesh3D<%s> %s PROGMEM = \n    {\n", info.color_type.c_str(), nm);
+        fprintf(f, "    1, // version/id\n    \n");
+        fprintf(f, "    %d, // number of vertices\n", (int)M.vert.size());
+        fprintf(f, "    %d, // number of texture coords\n", (int)M.tex.size());
+        fprintf(f, "    %d, // number of normal vectors\n", (int)M.norm.size());
+        fprintf(f, "    %d, // number of triangles\n", (int)M.tri.size());
+        fprintf(f, "    %d, // size of the face array. \n\n", (int)len);
+        fprintf(f, "    %s_vert_array, // array of vertices\n", nm);
+        if (M.tex.size()) fprintf(f, "    %s_tex_array, // array of texture coords\n", nm); else fprintf(f, "    nullptr, // array of texture coords\n");
+        if (M.norm.size()) fprintf(f, "    %s_norm_array, // array of normal vectors\n", nm); else fprintf(f, "    nullptr, // array of normal vectors\n");
+        fprintf(f, "    %s_face, // array of face vertex indexes\n    \n", nm);
+        fprintf(f, "    %s, // pointer to texture image \n    \n", info.texture.c_str());
+        fprintf(f, "    { %s , %s, %s }, // default color\n    \n", floatLiteral(info.color.R).c_str(), floatLiteral(info.color.G).c_str(), floatLiteral(info.color.B).c_str());
+        fprintf(f, "    %s, // ambiant light strength \n", floatLiteral(info.ambiant_strength).c_str());
+        fprintf(f, "    %s, // diffuse light strength\n", floatLiteral(info.diffuse_strength).c_str());
+        fprintf(f, "    %s, // specular light strength\n", floatLiteral(info.specular_strength).c_str());
+        fprintf(f, "    %d, // specular exponent\n    \n", info.specular_exponent);
+        fprintf(f, "    %s, // next mesh to draw after this one    \n    \n", info.next.c_str());
+        fprintf(f, "    { // mesh bounding box\n    %s, %s, \n    %s, %s, \n    %s, %s\n    },\n    \n",
+                floatLiteral(B.minX).c_str(), floatLiteral(B.maxX).c_str(), floatLiteral(B.minY).c_str(), floatLiteral(B.maxY).c_str(), floatLiteral(B.minZ).c_str(), floatLiteral(B.maxZ).c_str());
+        if (info.clusters.size())
+            {
+            fprintf(f, "    \"%s\", // model name    \n    \n", nm);
+            fprintf(f, "    %d, // number of meshlet clusters\n", (int)info.clusters.size());
+            fprintf(f, "    %s_cluster_array // array of meshlet clusters\n    };\n\n\n", nm);
+            }
+        else
+            {
+            fprintf(f, "    \"%s\" // model name    \n    };\n\n\n", nm);
+            }
+        }
+
+
+    /**
+     * Write a mesh in the format of the converted models: the triangles are encoded with
+     * stripify() and the arrays are reordered by first use.
+     */
+    inline void writeMesh(FILE* f, const MeshData& M, const MeshInfo& info)
+        {
+        MeshData R = M;
+        std::vector<Chain> chains = stripify(R);
+        reorderMesh(R, chains);
+        writeMesh(f, R, chains, info);
+        }
+
+
+}
+
+/** end of file */
@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus abstraction and asynchronous transfer queue
+//
+///////////////////////////////////////////////////////////////////////////////
+#include "ili9341_bus.h"
+#include "ili9341hw.h"
+
+extern "C" {
+
+static void BusWaitWhile(ili9341_bus_t *pbus, int (*pred)(const ili9341_bus_t *, ili9341_fence_t), ili9341_fence_t arg)
+{
+    while(pred(pbus, arg))
+    {
+        if(pbus->mfIdle) pbus->mfIdle(pbus->mpCtx);
+    }
+}
+
+static int BusQueueFull(const ili9341_bus_t *pbus, ili9341_fence_t)
+{
+    return ((pbus->mHead + 1) % ILI9341_MAX_QUEUED_RECTS) == pbus->mTail;
+}
+
+static int BusBusy(const ili9341_bus_t *pbus, ili9341_fence_t)
+{
+    return !ILI9341_BusIsIdle(pbus);
+}
+
+static int BusFencePending(const ili9341_bus_t *pbus, ili9341_fence_t fence)
+{
+    return !ILI9341_BusFenceDone(pbus, fence);
+}
+
+// Send a command stream. CS must already be asserted. DC goes low for each
+// command byte and high for its parameters. Leaves DC high (data mode).
+static void BusSendStream(ili9341_bus_t *pbus, const ili9341_cmdstream_t *ps)
+{
+    for(int i = 0; i < ps->mNCmds; i++)
+    {
+        const int pos = ps->mCmdPos[i];
+        const int end = (i + 1 < ps->mNCmds) ? ps->mCmdPos[i + 1] : ps->mNBytes;
+        pbus->mfSetDC(pbus->mpCtx, 0);
+        pbus->mfWrite(pbus->mpCtx, ps->mBytes + pos, 1);
+        pbus->mfSetDC(pbus->mpCtx, 1);
+        if(end > pos + 1)
+        {
+            pbus->mfWrite(pbus->mpCtx, ps->mBytes + pos + 1, end - pos - 1);
+        }
+    }
+}
+
+// Start the asynchronous write of the next part of the window of the active
+// transfer: part 2*i is the command byte of command i (DC low), part 2*i+1
+// its parameters (DC high). Returns 0, with DC high, once every part is sent.
+static int BusSendWindowPart(ili9341_bus_t *pbus)
+{
+    const ili9341_cmdstream_t *ps = &pbus->mWindow;
+    while(1)
+    {
+        const int part = pbus->mWindowPart;
+        const int i = part >> 1;
+        if(i >= ps->mNCmds)
+            return 0;
+        const int pos = ps->mCmdPos[i];
+        const int end = (i + 1 < ps->mNCmds) ? ps->mCmdPos[i + 1] : ps->mNBytes;
+        pbus->mWindowPart++;
+        if((part & 1) == 0)
+        {
+            pbus->mfSetDC(pbus->mpCtx, 0);
+            pbus->mfWriteAsync(pbus->mpCtx, ps->mBytes + pos, 1);
+            return 1;
+        }
+        pbus->mfSetDC(pbus->mpCtx, 1);
+        if(end > pos + 1)
+        {
+            pbus->mfWriteAsync(pbus->mpCtx, ps->mBytes + pos + 1, end - pos - 1);
+            return 1;
+        }
+    }
+}
+
+// Start the DMA for the current row (or the whole rectangle when it is contiguous).
+static void BusStartRow(ili9341_bus_t *pbus)
+{
+    const ili9341_transfer_t *t = &pbus->mQueue[pbus->mTail];
+    if(t->mStride == t->mW)
+    {
+        pbus->mfWriteAsync(pbus->mpCtx, t->mpPixels, 2 * t->mW * t->mH);
+    }
+    else
+    {
+        pbus->mfWriteAsync(pbus->mpCtx, t->mpPixels + 2 * pbus->mRow * t->mStride, 2 * t->mW);
+    }
+}
+
+// Start the transfer at the tail of the queue: CS stays asserted for the
+// window setup and the whole pixel payload. When 'chained' is set, CS is
+// still asserted from the previous transfer and the new CASET simply ends
+// the previous RAMWR. The window is sent asynchronously, part by part, like
+// the pixels: this runs from the completion IRQ when transfers are chained,
+// so it must not wait for the bus.
+static void BusStartTransfer(ili9341_bus_t *pbus, int chained)
+{
+    const ili9341_transfer_t *t = &pbus->mQueue[pbus->mTail];
+    pbus->mActive = 1;
+    pbus->mRow = 0;
+    if(!chained)
+    {
+        pbus->mfSetCS(pbus->mpCtx, CS_ENABLE);
+    }
+    ILI9341_CmdStreamReset(&pbus->mWindow);
+    ILI9341_CmdStreamWindow(&pbus->mWindow, t->mX, t->mY, t->mW, t->mH);
+    pbus->mWindowPart = 0;
+    BusSendWindowPart(pbus);
+}
+
+void ILI9341_BusInit(ili9341_bus_t *pbus)
+{
+    pbus->mHead = 0;
+    pbus->mTail = 0;
+    pbus->mActive = 0;
+    pbus->mRow = 0;
+    pbus->mWindowPart = -1;
+    pbus->mSubmitted = 0;
+    pbus->mCompleted = 0;
+}
+
+void ILI9341_CmdStreamReset(ili9341_cmdstream_t *ps)
+{
+    ps->mNBytes = 0;
+    ps->mNCmds = 0;
+}
+
+int ILI9341_CmdStreamAdd(ili9341_cmdstream_t *ps, uint8_t cmd, const uint8_t *params, int nparams)
+{
+    if(ps->mNCmds >= ILI9341_CMDSTREAM_MAX_CMDS || ps->mNBytes + 1 + nparams > ILI9341_CMDSTREAM_MAX_BYTES)
+        return 0;
+    ps->mCmdPos[ps->mNCmds++] = (uint8_t)ps->mNBytes;
+    ps->mBytes[ps->mNBytes++] = cmd;
+    for(int i = 0; i < nparams; i++)
+    {
+        ps->mBytes[ps->mNBytes++] = params[i];
+    }
+    return 1;
+}
+
+int ILI9341_CmdStreamWindow(ili9341_cmdstream_t *ps, int x, int y, int w, int h)
+{
+    if(ps->mNCmds + 3 > ILI9341_CMDSTREAM_MAX_CMDS || ps->mNBytes + 11 > ILI9341_CMDSTREAM_MAX_BYTES)
+        return 0;
+    const int x1 = x + w - 1;
+    const int y1 = y + h - 1;
+    const uint8_t caset[4] = { (uint8_t)(x >> 8), (uint8_t)x, (uint8_t)(x1 >> 8), (uint8_t)x1 };
+    const uint8_t paset[4] = { (uint8_t)(y >> 8), (uint8_t)y, (uint8_t)(y1 >> 8), (uint8_t)y1 };
+    ILI9341_CmdStreamAdd(ps, ILI9341_CASET, caset, 4);
+    ILI9341_CmdStreamAdd(ps, ILI9341_PASET, paset, 4);
+    ILI9341_CmdStreamAdd(ps, ILI9341_RAMWR, nullptr, 0);
+    return 1;
+}
+
+void ILI9341_BusCommandStream(ili9341_bus_t *pbus, const ili9341_cmdstream_t *ps)
+{
+    ILI9341_BusWaitIdle(pbus);
+    pbus->mfSetCS(pbus->mpCtx, CS_ENABLE);
+    BusSendStream(pbus, ps);
+    pbus->mfSetCS(pbus->mpCtx, CS_DISABLE);
+}
+
+void ILI9341_BusCommand(ili9341_bus_t *pbus, uint8_t cmd, const uint8_t *params, int nparams)
+{
+    ili9341_cmdstream_t s;
+    ILI9341_CmdStreamReset(&s);
+    if(!ILI9341_CmdStreamAdd(&s, cmd, params, nparams))
+        return;
+    ILI9341_BusCommandStream(pbus, &s);
+}
+
+void ILI9341_BusWriteData(ili9341_bus_t *pbus, const void *buffer, int bytes)
+{
+    ILI9341_BusWaitIdle(pbus);
+    pbus->mfSetCS(pbus->mpCtx, CS_ENABLE);
+    pbus->mfSetDC(pbus->mpCtx, 1);
+    pbus->mfWrite(pbus->mpCtx, (const uint8_t*)buffer, bytes);
+    pbus->mfSetCS(pbus->mpCtx, CS_DISABLE);
+}
+
+ili9341_fence_t ILI9341_BusWriteRectAsync(ili9341_bus_t *pbus, int x, int y, int w, int h,
+                                          const void *pixels, int stride,
+                                          ili9341_done_cb_t done_cb, void *user)
+{
+    if(w <= 0 || h <= 0 || pixels == nullptr)
+        return 0;
+
+    BusWaitWhile(pbus, BusQueueFull, 0);
+
+    const uint32_t state = pbus->mfLock(pbus->mpCtx);
+
+    ili9341_transfer_t *t = &pbus->mQueue[pbus->mHead];
+    t->mX = (int16_t)x;
+    t->mY = (int16_t)y;
+    t->mW = (int16_t)w;
+    t->mH = (int16_t)h;
+    t->mpPixels = (const uint8_t*)pixels;
+    t->mStride = (h == 1) ? w : stride;     // a single row is always contiguous
+    t->mfDone = done_cb;
+    t->mpUser = user;
+    t->mFence = ++pbus->mSubmitted;
+    if(t->mFence == 0) t->mFence = ++pbus->mSubmitted; // 0 is reserved for 'nothing submitted'
+
+    pbus->mHead = (pbus->mHead + 1) % ILI9341_MAX_QUEUED_RECTS;
+    const ili9341_fence_t fence = t->mFence;
+
+    if(!pbus->mActive)
+    {
+        BusStartTransfer(pbus, 0);
+    }
+
+    pbus->mfUnlock(pbus->mpCtx, state);
+    return fence;
+}
+
+int ILI9341_BusFenceDone(const ili9341_bus_t *pbus, ili9341_fence_t fence)
+{
+    return (int32_t)(pbus->mCompleted - fence) >= 0;
+}
+
+void ILI9341_BusWaitFence(ili9341_bus_t *pbus, ili9341_fence_t fence)
+{
+    BusWaitWhile(pbus, BusFencePending, fence);
+}
+
+int ILI9341_BusIsIdle(const ili9341_bus_t *pbus)
+{
+    return (!pbus->mActive) && (pbus->mHead == pbus->mTail);
+}
+
+void ILI9341_BusWaitIdle(ili9341_bus_t *pbus)
+{
+    BusWaitWhile(pbus, BusBusy, 0);
+}
+
+void ILI9341_BusTransferDone(ili9341_bus_t *pbus)
+{
+    if(!pbus->mActive)
+        return;
+
+    if(pbus->mWindowPart >= 0)
+    {
+        if(!BusSendWindowPart(pbus))
+        {
+            pbus->mWindowPart = -1;
+            BusStartRow(pbus);  // window set: send the pixels
+        }
+        return;
+    }
+
+    const ili9341_transfer_t *t = &pbus->mQueue[pbus->mTail];
+    if((t->mStride != t->mW) && (++pbus->mRow < t->mH))
+    {
+        BusStartRow(pbus);  // next row, CS stays asserted
+        return;
+    }
+
+    // transfer complete: chain the next one under the same CS assertion if there is one
+    const ili9341_done_cb_t done_cb = t->mfDone;
+    void *user = t->mpUser;
+    pbus->mCompleted = t->mFence;
+    pbus->mTail = (pbus->mTail + 1) % ILI9341_MAX_QUEUED_RECTS;
+    pbus->mActive = 0;
+
+    if(pbus->mHead != pbus->mTail)
+    {
+        BusStartTransfer(pbus, 1);
+    }
+    else
+    {
+        pbus->mfSetCS(pbus->mpCtx, CS_DISABLE);
+    }
+
+    if(done_cb)
+    {
+        done_cb(user);
+    }
+}
+
+} // end extern "C"
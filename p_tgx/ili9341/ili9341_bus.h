@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus abstraction and asynchronous transfer queue
+//
+//  The driver talks to the display only through an ili9341_bus_t: a small
+//  table of backend callbacks (CS, DC, blocking write, non-blocking write)
+//  plus a queue of pending rectangle transfers. The queue is serviced from
+//  the backend completion callback so rendering can overlap with transfers.
+//
+//  Backends:
+//      ili9341_bus_pico.h      - SPI + DMA on RP2040/RP2350
+//      ili9341_bus_loopback.h  - host emulation (no SDK needed) for tests
+//
+//  This file does not depend on the Pico SDK.
+//
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _ILI9341_BUS_H
+#define _ILI9341_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Maximum number of rectangle transfers waiting in the queue. Submitting
+// more blocks until a slot frees up.
+#ifndef ILI9341_MAX_QUEUED_RECTS
+#define ILI9341_MAX_QUEUED_RECTS    16
+#endif
+
+// Capacity of a command stream (bytes, including parameters, and commands).
+#ifndef ILI9341_CMDSTREAM_MAX_BYTES
+#define ILI9341_CMDSTREAM_MAX_BYTES 64
+#endif
+#ifndef ILI9341_CMDSTREAM_MAX_CMDS
+#define ILI9341_CMDSTREAM_MAX_CMDS  16
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Completion callback. Called once the last pixel of a transfer has been
+// shifted out (CS stays asserted if the next queued transfer follows right
+// away). On hardware it runs in IRQ context: keep it short.
+typedef void (*ili9341_done_cb_t)(void *user);
+
+// Monotonic transfer id. Fences complete in submission order.
+typedef uint32_t ili9341_fence_t;
+
+// One queued rectangle transfer
+typedef struct
+{
+    int16_t mX, mY;                     // upper left corner on screen
+    int16_t mW, mH;                     // size in pixels
+    const uint8_t *mpPixels;            // first pixel (2 bytes/pixel, wire order)
+    int mStride;                        // distance between rows, in pixels
+    ili9341_done_cb_t mfDone;           // optional completion callback
+    void *mpUser;                       // argument for mfDone
+    ili9341_fence_t mFence;             // fence of this transfer
+} ili9341_transfer_t;
+
+// Command stream: commands and their parameters encoded back to back in one
+// buffer so they can be sent under a single CS assertion, DC being toggled
+// only at command boundaries.
+typedef struct
+{
+    uint8_t mBytes[ILI9341_CMDSTREAM_MAX_BYTES];    // command byte followed by its parameters, for each command
+    uint8_t mCmdPos[ILI9341_CMDSTREAM_MAX_CMDS];    // offset of each command byte in mBytes
+    int mNBytes;
+    int mNCmds;
+} ili9341_cmdstream_t;
+
+// Bus: backend callbacks + transfer queue state
+typedef struct ili9341_bus_s
+{
+    void *mpCtx;                                                    // backend context
+
+    void (*mfSetCS)(void *ctx, int level);                          // drive CS pin
+    void (*mfSetDC)(void *ctx, int level);                          // drive DC pin (0 = command, 1 = data)
+    void (*mfWrite)(void *ctx, const uint8_t *data, int bytes);     // blocking write, returns once shifted out
+    void (*mfWriteAsync)(void *ctx, const uint8_t *data, int bytes);// start a non-blocking write. The backend must call
+                                                                    // ILI9341_BusTransferDone() once the last byte is shifted out
+                                                                    // (DC may be toggled right away, from the completion IRQ)
+    uint32_t (*mfLock)(void *ctx);                                  // enter critical section (mask completion IRQ)
+    void (*mfUnlock)(void *ctx, uint32_t state);                    // leave critical section
+    void (*mfIdle)(void *ctx);                                      // called repeatedly while busy waiting
+
+    // queue state (private, managed by ili9341_bus.cpp)
+    ili9341_transfer_t mQueue[ILI9341_MAX_QUEUED_RECTS];
+    volatile int mHead;                                             // next free slot
+    volatile int mTail;                                             // transfer in progress / next to start
+    volatile int mActive;                                           // 1 while a transfer is on the wire
+    int mRow;                                                       // current row of the active transfer
+    ili9341_cmdstream_t mWindow;                                    // CASET / PASET / RAMWR of the active transfer
+    int mWindowPart;                                                // next part of mWindow to send (-1 once the pixels are sent)
+    volatile ili9341_fence_t mSubmitted;                            // last fence handed out
+    volatile ili9341_fence_t mCompleted;                            // last fence completed
+
+} ili9341_bus_t;
+
+/* Reset the queue. Backend callbacks must already be set. */
+void ILI9341_BusInit(ili9341_bus_t *pbus);
+
+/* Blocking command with optional parameters (waits for the queue to drain first). */
+void ILI9341_BusCommand(ili9341_bus_t *pbus, uint8_t cmd, const uint8_t *params, int nparams);
+
+/* Empty a command stream. */
+void ILI9341_CmdStreamReset(ili9341_cmdstream_t *ps);
+
+/* Append a command and its parameters. Returns 0 (and leaves the stream unchanged) if it does not fit. */
+int ILI9341_CmdStreamAdd(ili9341_cmdstream_t *ps, uint8_t cmd, const uint8_t *params, int nparams);
+
+/* Append CASET / PASET / RAMWR for the window (x, y, w, h). Returns 0 if it does not fit. */
+int ILI9341_CmdStreamWindow(ili9341_cmdstream_t *ps, int x, int y, int w, int h);
+
+/* Blocking: send a command stream under a single CS assertion (waits for the queue to drain first). */
+void ILI9341_BusCommandStream(ili9341_bus_t *pbus, const ili9341_cmdstream_t *ps);
+
+/* Blocking raw data write under its own CS assertion (waits for the queue to drain first). */
+void ILI9341_BusWriteData(ili9341_bus_t *pbus, const void *buffer, int bytes);
+
+/* Queue a rectangle transfer. pixels points to pixel (x,y) of a buffer whose rows are
+   'stride' pixels apart. The buffer must stay untouched until the fence completes.
+   Transfers queued back to back are chained under the same CS assertion (the next
+   CASET ends the previous RAMWR). Returns the fence of the transfer (0 if the
+   rectangle is empty). */
+ili9341_fence_t ILI9341_BusWriteRectAsync(ili9341_bus_t *pbus, int x, int y, int w, int h,
+                                          const void *pixels, int stride,
+                                          ili9341_done_cb_t done_cb, void *user);
+
+/* Return 1 if the transfer with the given fence has completed. */
+int ILI9341_BusFenceDone(const ili9341_bus_t *pbus, ili9341_fence_t fence);
+
+/* Wait until the transfer with the given fence has completed. */
+void ILI9341_BusWaitFence(ili9341_bus_t *pbus, ili9341_fence_t fence);
+
+/* Return 1 if no transfer is queued or in progress. */
+int ILI9341_BusIsIdle(const ili9341_bus_t *pbus);
+
+/* Wait until all queued transfers have completed. */
+void ILI9341_BusWaitIdle(ili9341_bus_t *pbus);
+
+/* Called by the backend when the write started by mfWriteAsync() is complete. */
+void ILI9341_BusTransferDone(ili9341_bus_t *pbus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
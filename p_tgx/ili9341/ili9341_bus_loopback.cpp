@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus backend: host loopback
+//
+///////////////////////////////////////////////////////////////////////////////
+#include "ili9341_bus_loopback.h"
+#include "ili9341hw.h"
+
+extern "C" {
+
+static void LoopbackReceive(ili9341_loopback_bus_t *lb, const uint8_t *data, int bytes)
+{
+    if(lb->mCS != CS_ENABLE)
+    {
+        lb->mNbErrors++;
+        return;
+    }
+    if(lb->mDC == 0)
+    {
+        lb->mNbCommandBytes += bytes;
+        for(int i = 0; i < bytes; i++)
+        {
+            lb->mCmd = data[i];
+            lb->mNParams = 0;
+            lb->mHalf = 0;
+            if(lb->mCmd == ILI9341_RAMWR)
+            {
+                lb->mX = lb->mX0;
+                lb->mY = lb->mY0;
+            }
+        }
+        return;
+    }
+    lb->mNbDataBytes += bytes;
+    for(int i = 0; i < bytes; i++)
+    {
+        const uint8_t b = data[i];
+        if(lb->mCmd == ILI9341_CASET || lb->mCmd == ILI9341_PASET)
+        {
+            if(lb->mNParams < 4) lb->mParams[lb->mNParams++] = b;
+            if(lb->mNParams == 4)
+            {
+                const int a0 = (lb->mParams[0] << 8) | lb->mParams[1];
+                const int a1 = (lb->mParams[2] << 8) | lb->mParams[3];
+                if(lb->mCmd == ILI9341_CASET) { lb->mX0 = a0; lb->mX1 = a1; }
+                else { lb->mY0 = a0; lb->mY1 = a1; }
+            }
+        }
+        else if(lb->mCmd == ILI9341_RAMWR)
+        {
+            if(!lb->mHalf)
+            {
+                lb->mHighByte = b;
+                lb->mHalf = 1;
+                continue;
+            }
+            lb->mHalf = 0;
+            if(lb->mX < 0 || lb->mX >= lb->mWidth || lb->mY < 0 || lb->mY > lb->mY1 || lb->mY >= lb->mHeight)
+            {
+                lb->mNbErrors++;
+            }
+            else
+            {
+                lb->mpGRAM[lb->mY * lb->mWidth + lb->mX] = (uint16_t)((lb->mHighByte << 8) | b);
+                lb->mNbPixels++;
+            }
+            if(++lb->mX > lb->mX1)
+            {
+                lb->mX = lb->mX0;
+                lb->mY++;
+            }
+        }
+    }
+}
+
+static void LoopbackSetCS(void *ctx, int level)
+{
+    ili9341_loopback_bus_t *lb = (ili9341_loopback_bus_t*)ctx;
+    if(level == CS_ENABLE && lb->mCS != CS_ENABLE) lb->mNbTransactions++;
+    if(level != CS_ENABLE && lb->mpPending != nullptr) lb->mNbErrors++; // CS released while data still in flight
+    lb->mCS = level;
+}
+
+static void LoopbackSetDC(void *ctx, int level)
+{
+    ili9341_loopback_bus_t *lb = (ili9341_loopback_bus_t*)ctx;
+    if(lb->mpPending != nullptr) lb->mNbErrors++; // DC toggled while data still in flight
+    lb->mDC = level;
+}
+
+static void LoopbackWrite(void *ctx, const uint8_t *data, int bytes)
+{
+    ili9341_loopback_bus_t *lb = (ili9341_loopback_bus_t*)ctx;
+    if(lb->mpPending != nullptr) lb->mNbErrors++;
+    lb->mNbWrites++;
+    LoopbackReceive(lb, data, bytes);
+}
+
+static void LoopbackWriteAsync(void *ctx, const uint8_t *data, int bytes)
+{
+    ili9341_loopback_bus_t *lb = (ili9341_loopback_bus_t*)ctx;
+    if(lb->mpPending != nullptr) lb->mNbErrors++;
+    lb->mNbWrites++;
+    lb->mNbAsyncWrites++;
+    lb->mpPending = data;
+    lb->mPendingBytes = bytes;
+}
+
+static uint32_t LoopbackLock(void *)
+{
+    return 0;
+}
+
+static void LoopbackUnlock(void *, uint32_t)
+{
+}
+
+static void LoopbackIdle(void *ctx)
+{
+    ILI9341_LoopbackBusPump((ili9341_loopback_bus_t*)ctx);
+}
+
+void ILI9341_LoopbackBusInit(ili9341_loopback_bus_t *lb, uint16_t *gram, int width, int height)
+{
+    lb->mpGRAM = gram;
+    lb->mWidth = width;
+    lb->mHeight = height;
+    lb->mCS = CS_DISABLE;
+    lb->mDC = 1;
+    lb->mCmd = ILI9341_NOP;
+    lb->mNParams = 0;
+    lb->mX0 = 0; lb->mX1 = width - 1;
+    lb->mY0 = 0; lb->mY1 = height - 1;
+    lb->mX = 0; lb->mY = 0;
+    lb->mHalf = 0;
+    lb->mHighByte = 0;
+    lb->mpPending = nullptr;
+    lb->mPendingBytes = 0;
+    ILI9341_LoopbackBusResetStats(lb);
+
+    ili9341_bus_t *pbus = &lb->mBus;
+    pbus->mpCtx = lb;
+    pbus->mfSetCS = LoopbackSetCS;
+    pbus->mfSetDC = LoopbackSetDC;
+    pbus->mfWrite = LoopbackWrite;
+    pbus->mfWriteAsync = LoopbackWriteAsync;
+    pbus->mfLock = LoopbackLock;
+    pbus->mfUnlock = LoopbackUnlock;
+    pbus->mfIdle = LoopbackIdle;
+    ILI9341_BusInit(pbus);
+}
+
+int ILI9341_LoopbackBusPump(ili9341_loopback_bus_t *lb)
+{
+    if(lb->mpPending == nullptr)
+        return 0;
+    const uint8_t *data = lb->mpPending;
+    const int bytes = lb->mPendingBytes;
+    LoopbackReceive(lb, data, bytes);
+    lb->mpPending = nullptr;
+    lb->mPendingBytes = 0;
+    ILI9341_BusTransferDone(&lb->mBus);
+    return 1;
+}
+
+void ILI9341_LoopbackBusResetStats(ili9341_loopback_bus_t *lb)
+{
+    lb->mNbTransactions = 0;
+    lb->mNbWrites = 0;
+    lb->mNbAsyncWrites = 0;
+    lb->mNbCommandBytes = 0;
+    lb->mNbDataBytes = 0;
+    lb->mNbPixels = 0;
+    lb->mNbErrors = 0;
+}
+
+} // end extern "C"
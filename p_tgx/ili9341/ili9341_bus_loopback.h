@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus backend: host loopback
+//
+//  Stands in for SPI + DMA when running on a desktop machine. The bytes
+//  written on the bus are decoded as ILI9341 commands (CASET / PASET /
+//  RAMWR) and the pixels land in an emulated GRAM that tests can compare
+//  against the framebuffer. Asynchronous writes are only performed when
+//  the bus is pumped (ILI9341_LoopbackBusPump(), also called while the
+//  driver busy-waits) so tests can observe transfers in flight.
+//
+//  This backend does not depend on the Pico SDK.
+//
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _ILI9341_BUS_LOOPBACK_H
+#define _ILI9341_BUS_LOOPBACK_H
+
+#include "ili9341_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    ili9341_bus_t mBus;                 // must be first
+
+    uint16_t *mpGRAM;                   // emulated display memory (RGB565, native endianness)
+    int mWidth;                         // number of columns
+    int mHeight;                        // number of pages
+
+    // decoder state
+    int mCS;                            // current CS level
+    int mDC;                            // current DC level
+    uint8_t mCmd;                       // last command received
+    uint8_t mParams[4];                 // parameters of the last command
+    int mNParams;
+    int mX0, mX1, mY0, mY1;             // current window
+    int mX, mY;                         // RAMWR write position
+    int mHalf;                          // 1 if the high byte of a pixel is pending
+    uint8_t mHighByte;
+
+    // pending asynchronous write
+    const uint8_t *mpPending;
+    int mPendingBytes;
+
+    // statistics
+    uint32_t mNbTransactions;           // number of CS assertions
+    uint32_t mNbWrites;                 // number of write calls (blocking + async)
+    uint32_t mNbAsyncWrites;            // number of async write calls
+    uint32_t mNbCommandBytes;           // bytes sent with DC low
+    uint32_t mNbDataBytes;              // bytes sent with DC high
+    uint32_t mNbPixels;                 // pixels written to GRAM
+    uint32_t mNbErrors;                 // protocol errors (write with CS high, pixel outside window...)
+
+} ili9341_loopback_bus_t;
+
+/* Setup the loopback backend with an emulated GRAM of width x height pixels. */
+void ILI9341_LoopbackBusInit(ili9341_loopback_bus_t *lb, uint16_t *gram, int width, int height);
+
+/* Perform the pending asynchronous write (if any). Return 1 if something was done. */
+int ILI9341_LoopbackBusPump(ili9341_loopback_bus_t *lb);
+
+/* Reset the statistics counters. */
+void ILI9341_LoopbackBusResetStats(ili9341_loopback_bus_t *lb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
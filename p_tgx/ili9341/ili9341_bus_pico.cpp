@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus backend: hardware SPI + DMA (RP2040 / RP2350)
+//
+///////////////////////////////////////////////////////////////////////////////
+#include "ili9341_bus_pico.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+extern "C" {
+
+static ili9341_pico_bus_t *spPicoBuses[ILI9341_MAX_PICO_BUSES] = { nullptr };
+
+// sink of the RX DMA channels: the bytes clocked in are never used
+static uint8_t sPicoBusRxDummy;
+
+static void PicoBusSetCS(void *ctx, int level)
+{
+    ili9341_pico_bus_t *pb = (ili9341_pico_bus_t*)ctx;
+    asm volatile("nop \n nop \n nop");
+    gpio_put(pb->mGPIO_cs, level);
+    asm volatile("nop \n nop \n nop");
+}
+
+static void PicoBusSetDC(void *ctx, int level)
+{
+    ili9341_pico_bus_t *pb = (ili9341_pico_bus_t*)ctx;
+    gpio_put(pb->mGPIO_dc, level);
+    asm volatile("nop \n nop \n nop");
+}
+
+static void PicoBusWrite(void *ctx, const uint8_t *data, int bytes)
+{
+    ili9341_pico_bus_t *pb = (ili9341_pico_bus_t*)ctx;
+    spi_write_blocking(pb->mpSPIPort, data, bytes);
+}
+
+static void PicoBusWriteAsync(void *ctx, const uint8_t *data, int bytes)
+{
+    ili9341_pico_bus_t *pb = (ili9341_pico_bus_t*)ctx;
+    // RX first so that it is ready for the first byte clocked in
+    dma_channel_set_trans_count(pb->mDMAChannelRx, bytes, true);
+    dma_channel_set_read_addr(pb->mDMAChannel, data, false);
+    dma_channel_set_trans_count(pb->mDMAChannel, bytes, true);
+}
+
+static uint32_t PicoBusLock(void *)
+{
+    return save_and_disable_interrupts();
+}
+
+static void PicoBusUnlock(void *, uint32_t state)
+{
+    restore_interrupts(state);
+}
+
+static void PicoBusIdle(void *)
+{
+    tight_loop_contents();
+}
+
+static void PicoBusDMAHandler()
+{
+    for(int i = 0; i < ILI9341_MAX_PICO_BUSES; i++)
+    {
+        ili9341_pico_bus_t *pb = spPicoBuses[i];
+        if(pb == nullptr || !dma_channel_get_irq0_status(pb->mDMAChannelRx))
+            continue;
+
+        // The RX channel completes when the last byte has been clocked in, 
+        // i.e. once it is fully shifted out: nothing left on the wire.
+        dma_channel_acknowledge_irq0(pb->mDMAChannelRx);
+        ILI9341_BusTransferDone(&pb->mBus);
+    }
+}
+
+void ILI9341_PicoBusInit(ili9341_pico_bus_t *pb, spi_inst_t *pspi_port, int gpio_CS, int gpio_DC)
+{
+    assert_(pb);
+    assert_(pspi_port);
+
+    pb->mpSPIPort = pspi_port;
+    pb->mGPIO_cs = gpio_CS;
+    pb->mGPIO_dc = gpio_DC;
+
+    ili9341_bus_t *pbus = &pb->mBus;
+    pbus->mpCtx = pb;
+    pbus->mfSetCS = PicoBusSetCS;
+    pbus->mfSetDC = PicoBusSetDC;
+    pbus->mfWrite = PicoBusWrite;
+    pbus->mfWriteAsync = PicoBusWriteAsync;
+    pbus->mfLock = PicoBusLock;
+    pbus->mfUnlock = PicoBusUnlock;
+    pbus->mfIdle = PicoBusIdle;
+    ILI9341_BusInit(pbus);
+
+    pb->mDMAChannel = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(pb->mDMAChannel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(pspi_port, true));
+    dma_channel_configure(pb->mDMAChannel, &c, &spi_get_hw(pspi_port)->dr, nullptr, 0, false);
+
+    pb->mDMAChannelRx = dma_claim_unused_channel(true);
+    dma_channel_config crx = dma_channel_get_default_config(pb->mDMAChannelRx);
+    channel_config_set_transfer_data_size(&crx, DMA_SIZE_8);
+    channel_config_set_read_increment(&crx, false);
+    channel_config_set_write_increment(&crx, false);
+    channel_config_set_dreq(&crx, spi_get_dreq(pspi_port, false));
+    dma_channel_configure(pb->mDMAChannelRx, &crx, &sPicoBusRxDummy, &spi_get_hw(pspi_port)->dr, 0, false);
+
+    bool first = true;
+    int slot = -1;
+    for(int i = 0; i < ILI9341_MAX_PICO_BUSES; i++)
+    {
+        if(spPicoBuses[i] != nullptr) first = false;
+        else if(slot < 0) slot = i;
+    }
+    assert_(slot >= 0);
+    spPicoBuses[slot] = pb;
+
+    dma_channel_set_irq0_enabled(pb->mDMAChannelRx, true);
+    if(first)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, PicoBusDMAHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+}
+
+} // end extern "C"
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 bus backend: hardware SPI + DMA (RP2040 / RP2350)
+//
+//  Blocking writes use spi_write_blocking(). Asynchronous writes use a TX
+//  DMA channel paced by the SPI TX DREQ and an RX DMA channel which drains
+//  the bytes clocked in. Completion is signalled through a shared DMA_IRQ_0
+//  handler on the RX channel: it fires once the last byte is shifted out,
+//  so the transfer queue can toggle DC/CS right away (the handler never
+//  waits on the SPI).
+//
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _ILI9341_BUS_PICO_H
+#define _ILI9341_BUS_PICO_H
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+
+#include "../lib/assert.h"
+#include "ili9341_bus.h"
+
+// Maximum number of pico buses serviced by the shared DMA IRQ handler
+#define ILI9341_MAX_PICO_BUSES      2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    ili9341_bus_t mBus;                 // must be first
+    spi_inst_t *mpSPIPort;
+    int mGPIO_cs;
+    int mGPIO_dc;
+    int mDMAChannel;                    // TX: memory -> SPI
+    int mDMAChannelRx;                  // RX: SPI -> dummy byte, signals completion
+} ili9341_pico_bus_t;
+
+/* Setup the backend on an already initialized SPI port and CS/DC gpios. 
+   Claims two DMA channels and installs the shared DMA_IRQ_0 handler. */
+void ILI9341_PicoBusInit(ili9341_pico_bus_t *pb, spi_inst_t *pspi_port, int gpio_CS, int gpio_DC);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
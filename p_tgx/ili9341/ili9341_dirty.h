@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ILI9341 partial updates driven by a TGX dirty region
+//
+//  Queues one rectangle transfer per dirty rectangle recorded by a
+//  tgx::DirtyRegion (see tgx/DirtyRegion.h and Image::setDirtyRegion()),
+//  then clears the region. C++ only. Does not depend on the Pico SDK.
+//
+///////////////////////////////////////////////////////////////////////////////
+#ifndef _ILI9341_DIRTY_H
+#define _ILI9341_DIRTY_H
+
+#include "ili9341_bus.h"
+#include "../tgx/DirtyRegion.h"
+
+/* Queue the dirty rectangles of 'region' for transfer from the framebuffer 'fb'
+   (2 bytes/pixel, wire order, rows 'stride' pixels apart) and clear the region.
+   The optional callback is attached to the last rectangle only.
+   Returns the fence of the last rectangle (0 if the region was empty, in which
+   case the callback is not called). */
+inline ili9341_fence_t ILI9341_BusFlushDirtyAsync(ili9341_bus_t *pbus, const uint16_t *fb, int stride,
+                                                  tgx::DirtyRegion *region,
+                                                  ili9341_done_cb_t done_cb, void *user)
+{
+    ili9341_fence_t fence = 0;
+    const int n = region->size();
+    for(int i = 0; i < n; i++)
+    {
+        const tgx::iBox2 &B = (*region)[i];
+        const int last = (i == n - 1);
+        fence = ILI9341_BusWriteRectAsync(pbus, B.minX, B.minY, B.lx(), B.ly(),
+                                          fb + B.minY * stride + B.minX, stride,
+                                          last ? done_cb : nullptr, last ? user : nullptr);
+    }
+    region->clear();
+    return fence;
+}
+
+#endif
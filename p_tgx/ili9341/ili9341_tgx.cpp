@@ -12,28 +12,14 @@
 // =============================================================================
 extern "C" {
 
-static inline void ILI9341_CS_Set(const ili9341_config_t *pconfig, int state) 
-{
-    asm volatile("nop \n nop \n nop");
-    gpio_put(pconfig->mGPIO_cs, state);
-    asm volatile("nop \n nop \n nop");
-}
-
 void ILI9341_SetCommand(const ili9341_config_t *pconfig, uint8_t cmd) 
 {
-    ILI9341_CS_Set(pconfig, CS_ENABLE);
-    gpio_put(pconfig->mGPIO_dc, 0);
-    asm volatile("nop \n nop \n nop");
-    spi_write_blocking(pconfig->mpSPIPort, &cmd, 1);
-    gpio_put(pconfig->mGPIO_dc, 1);
-    ILI9341_CS_Set(pconfig, CS_DISABLE);
+    ILI9341_BusCommand(pconfig->mpBus, cmd, nullptr, 0);
 }
 
 void ILI9341_CommandParam(const ili9341_config_t *pconfig, uint8_t data) 
 {
-    ILI9341_CS_Set(pconfig, CS_ENABLE);
-    spi_write_blocking(pconfig->mpSPIPort, &data, 1);
-    ILI9341_CS_Set(pconfig, CS_DISABLE);
+    ILI9341_BusWriteData(pconfig->mpBus, &data, 1);
 }
 
 void ILI9341_SetOutWriting(const ili9341_config_t *pconfig,
@@ -42,26 +28,46 @@ void ILI9341_SetOutWriting(const ili9341_config_t *pconfig,
 {
     assert_(pconfig);
 
-    ILI9341_SetCommand(pconfig, ILI9341_CASET);
-    ILI9341_CommandParam(pconfig, (start_col >> 8) & 0xFF);
-    ILI9341_CommandParam(pconfig, start_col & 0xFF);
-    ILI9341_CommandParam(pconfig, (end_col >> 8) & 0xFF);
-    ILI9341_CommandParam(pconfig, end_col & 0xFF);
+    // CASET + PASET + RAMWR and their parameters in a single CS assertion
+    ili9341_cmdstream_t s;
+    ILI9341_CmdStreamReset(&s);
+    ILI9341_CmdStreamWindow(&s, start_col, start_page,
+                            end_col - start_col + 1, end_page - start_page + 1);
+    ILI9341_BusCommandStream(pconfig->mpBus, &s);
+}
 
-    ILI9341_SetCommand(pconfig, ILI9341_PASET);
-    ILI9341_CommandParam(pconfig, (start_page >> 8) & 0xFF);
-    ILI9341_CommandParam(pconfig, start_page & 0xFF);
-    ILI9341_CommandParam(pconfig, (end_page >> 8) & 0xFF);
-    ILI9341_CommandParam(pconfig, end_page & 0xFF);
+void ILI9341_WriteData(const ili9341_config_t *pconfig, void *buffer, int bytes)
+{
+    ILI9341_BusWriteData(pconfig->mpBus, buffer, bytes);
+}
 
-    ILI9341_SetCommand(pconfig, ILI9341_RAMWR);
+ili9341_fence_t ILI9341_WriteRectAsync(const ili9341_config_t *pconfig, 
+                                       int x, int y, int width, int height,
+                                       const uint16_t *pixels, int stride,
+                                       ili9341_done_cb_t done_cb, void *user)
+{
+    assert_(pconfig);
+
+    if(x < 0 || y < 0 || x + width > PIX_WIDTH || y + height > PIX_HEIGHT)
+        return 0;
+
+    return ILI9341_BusWriteRectAsync(pconfig->mpBus, x, y, width, height, 
+                                     pixels, stride, done_cb, user);
 }
 
-void ILI9341_WriteData(const ili9341_config_t *pconfig, void *buffer, int bytes)
+int ILI9341_FenceDone(const ili9341_config_t *pconfig, ili9341_fence_t fence)
+{
+    return ILI9341_BusFenceDone(pconfig->mpBus, fence);
+}
+
+void ILI9341_WaitFence(const ili9341_config_t *pconfig, ili9341_fence_t fence)
 {
-    ILI9341_CS_Set(pconfig, CS_ENABLE);
-    spi_write_blocking(pconfig->mpSPIPort, (uint8_t*)buffer, bytes);
-    ILI9341_CS_Set(pconfig, CS_DISABLE);
+    ILI9341_BusWaitFence(pconfig->mpBus, fence);
+}
+
+void ILI9341_WaitIdle(const ili9341_config_t *pconfig)
+{
+    ILI9341_BusWaitIdle(pconfig->mpBus);
 }
 
 void ILI9341_Init(ili9341_config_t *pconfig, spi_inst_t *pspi_port, 
@@ -98,6 +104,10 @@ void ILI9341_Init(ili9341_config_t *pconfig, spi_inst_t *pspi_port,
     gpio_set_dir(pconfig->mGPIO_dc, GPIO_OUT);
     gpio_put(pconfig->mGPIO_dc, 0);
 
+    ILI9341_PicoBusInit(&pconfig->mPicoBus, pconfig->mpSPIPort, 
+                        pconfig->mGPIO_cs, pconfig->mGPIO_dc);
+    pconfig->mpBus = &pconfig->mPicoBus.mBus;
+
     sleep_ms(10);
     gpio_put(pconfig->mGPIO_reset, 0);
     sleep_ms(10);
@@ -107,28 +117,31 @@ void ILI9341_Init(ili9341_config_t *pconfig, spi_inst_t *pspi_port,
     ILI9341_SetCommand(pconfig, 0x01);
     sleep_ms(100);
 
-    ILI9341_SetCommand(pconfig, ILI9341_GAMMASET);
-    ILI9341_CommandParam(pconfig, 0x01);
+    // register setup sent as one command stream (single CS assertion)
+    ili9341_cmdstream_t s;
+    ILI9341_CmdStreamReset(&s);
 
-    ILI9341_SetCommand(pconfig, ILI9341_GMCTRP1);
-    uint8_t gamma_p[] = {0x0f, 0x31, 0x2b, 0x0c, 0x0e, 0x08, 0x4e, 0xf1, 
-                         0x37, 0x07, 0x10, 0x03, 0x0e, 0x09, 0x00};
-    ILI9341_WriteData(pconfig, gamma_p, 15);
+    const uint8_t gammaset[] = {0x01};
+    ILI9341_CmdStreamAdd(&s, ILI9341_GAMMASET, gammaset, 1);
 
-    ILI9341_SetCommand(pconfig, ILI9341_GMCTRN1);
-    uint8_t gamma_n[] = {0x00, 0x0e, 0x14, 0x03, 0x11, 0x07, 0x31, 0xc1, 
-                         0x48, 0x08, 0x0f, 0x0c, 0x31, 0x36, 0x0f};
-    ILI9341_WriteData(pconfig, gamma_n, 15);
+    const uint8_t gamma_p[] = {0x0f, 0x31, 0x2b, 0x0c, 0x0e, 0x08, 0x4e, 0xf1, 
+                               0x37, 0x07, 0x10, 0x03, 0x0e, 0x09, 0x00};
+    ILI9341_CmdStreamAdd(&s, ILI9341_GMCTRP1, gamma_p, 15);
 
-    ILI9341_SetCommand(pconfig, ILI9341_MADCTL);
-    ILI9341_CommandParam(pconfig, 0x48);
+    const uint8_t gamma_n[] = {0x00, 0x0e, 0x14, 0x03, 0x11, 0x07, 0x31, 0xc1, 
+                               0x48, 0x08, 0x0f, 0x0c, 0x31, 0x36, 0x0f};
+    ILI9341_CmdStreamAdd(&s, ILI9341_GMCTRN1, gamma_n, 15);
+
+    const uint8_t madctl[] = {0x48};
+    ILI9341_CmdStreamAdd(&s, ILI9341_MADCTL, madctl, 1);
    
-    ILI9341_SetCommand(pconfig, ILI9341_PIXFMT);
-    ILI9341_CommandParam(pconfig, 0x55);
+    const uint8_t pixfmt[] = {0x55};
+    ILI9341_CmdStreamAdd(&s, ILI9341_PIXFMT, pixfmt, 1);
+
+    const uint8_t frmctr1[] = {0x00, 0x1B};
+    ILI9341_CmdStreamAdd(&s, ILI9341_FRMCTR1, frmctr1, 2);
 
-    ILI9341_SetCommand(pconfig, ILI9341_FRMCTR1);
-    ILI9341_CommandParam(pconfig, 0x00);
-    ILI9341_CommandParam(pconfig, 0x1B);
+    ILI9341_BusCommandStream(pconfig->mpBus, &s);
 
     ILI9341_SetCommand(pconfig, ILI9341_SLPOUT);
     ILI9341_SetCommand(pconfig, ILI9341_DISPON);
@@ -155,6 +168,7 @@ void TftInitScreen(screen_control_t *pscr, ili9341_config_t *pconfig,
 
     // Create TGX Image wrapper (C++ code in C function)
     pscr->mpTGXImage = new Image<RGB565>((RGB565*)framebuffer, PIX_WIDTH, PIX_HEIGHT);
+    pscr->mpDirty = nullptr;
 }
 
 void TftClearScreenBuffer(screen_control_t *pscr, color_t paper, color_t ink)
@@ -168,6 +182,8 @@ void TftClearScreenBuffer(screen_control_t *pscr, color_t paper, color_t ink)
         pscr->mpFrameBuffer[i] = color;
     }
 
+    pscr->mpTGXImage->markDirty();
+
     pscr->mCursorX = 0;
     pscr->mCursorY = 0;
     
@@ -203,6 +219,7 @@ void TftPutChar(screen_control_t *pscr, int x, int y, color_t paper,
 
     int pixX = x * 8;
     int pixY = y * 8;
+    pscr->mpTGXImage->markDirty(iBox2(pixX, pixX + 7, pixY, pixY + 7));
 
     for(int row = 0; row < 8; row++) {
         uint8_t line = glyph[row];
@@ -261,6 +278,7 @@ void TftPutPixel(screen_control_t *pscr, int x, int y, color_t color)
 
     if(x >= 0 && x < PIX_WIDTH && y >= 0 && y < PIX_HEIGHT) {
         pscr->mpFrameBuffer[y * PIX_WIDTH + x] = ColorToRGB565(color);
+        pscr->mpTGXImage->markDirty(iBox2(x, x, y, y));
     }
 }
 
@@ -298,9 +316,7 @@ void TftFullScreenWrite(screen_control_t *pscr)
     assert_(pscr->mpHWConfig);
     assert_(pscr->mpFrameBuffer);
 
-    ILI9341_SetOutWriting(pscr->mpHWConfig, 0, PIX_WIDTH-1, 0, PIX_HEIGHT-1);
-    ILI9341_WriteData(pscr->mpHWConfig, pscr->mpFrameBuffer, 
-                      PIX_WIDTH * PIX_HEIGHT * 2);
+    ILI9341_WaitFence(pscr->mpHWConfig, TftFullScreenWriteAsync(pscr, nullptr, nullptr));
 }
 
 void TftPartialScreenWrite(screen_control_t *pscr, int x, int y, 
@@ -310,15 +326,73 @@ void TftPartialScreenWrite(screen_control_t *pscr, int x, int y,
     assert_(pscr->mpHWConfig);
     assert_(pscr->mpFrameBuffer);
 
+    ILI9341_WaitFence(pscr->mpHWConfig, 
+                      TftPartialScreenWriteAsync(pscr, x, y, width, height, nullptr, nullptr));
+}
+
+ili9341_fence_t TftFullScreenWriteAsync(screen_control_t *pscr, 
+                                        ili9341_done_cb_t done_cb, void *user)
+{
+    assert_(pscr);
+    assert_(pscr->mpHWConfig);
+    assert_(pscr->mpFrameBuffer);
+
+    return ILI9341_WriteRectAsync(pscr->mpHWConfig, 0, 0, PIX_WIDTH, PIX_HEIGHT,
+                                  pscr->mpFrameBuffer, PIX_WIDTH, done_cb, user);
+}
+
+ili9341_fence_t TftPartialScreenWriteAsync(screen_control_t *pscr, int x, int y,
+                                           int width, int height,
+                                           ili9341_done_cb_t done_cb, void *user)
+{
+    assert_(pscr);
+    assert_(pscr->mpHWConfig);
+    assert_(pscr->mpFrameBuffer);
+
     if(x < 0 || y < 0 || x + width > PIX_WIDTH || y + height > PIX_HEIGHT)
-        return;
+        return 0;
+
+    return ILI9341_WriteRectAsync(pscr->mpHWConfig, x, y, width, height,
+                                  &pscr->mpFrameBuffer[y * PIX_WIDTH + x], PIX_WIDTH,
+                                  done_cb, user);
+}
 
-    ILI9341_SetOutWriting(pscr->mpHWConfig, x, x + width - 1, y, y + height - 1);
+void TftSetDirtyTracking(screen_control_t *pscr, int enable)
+{
+    assert_(pscr);
+    assert_(pscr->mpTGXImage);
 
-    for(int row = 0; row < height; row++) {
-        uint16_t *lineStart = &pscr->mpFrameBuffer[(y + row) * PIX_WIDTH + x];
-        ILI9341_WriteData(pscr->mpHWConfig, lineStart, width * 2);
+    if(enable && !pscr->mpDirty)
+    {
+        pscr->mpDirty = new DirtyRegion();
     }
+    pscr->mpTGXImage->setDirtyRegion(enable ? pscr->mpDirty : nullptr);
+    if(pscr->mpDirty)
+    {
+        pscr->mpDirty->clear();
+    }
+}
+
+void TftFlushDirty(screen_control_t *pscr)
+{
+    assert_(pscr);
+    assert_(pscr->mpHWConfig);
+
+    ILI9341_WaitFence(pscr->mpHWConfig, TftFlushDirtyAsync(pscr, nullptr, nullptr));
+}
+
+ili9341_fence_t TftFlushDirtyAsync(screen_control_t *pscr, 
+                                   ili9341_done_cb_t done_cb, void *user)
+{
+    assert_(pscr);
+    assert_(pscr->mpHWConfig);
+    assert_(pscr->mpFrameBuffer);
+
+    if(!pscr->mpTGXImage || !pscr->mpTGXImage->dirtyRegion())
+        return TftFullScreenWriteAsync(pscr, done_cb, user);    // tracking disabled: send everything
+
+    return ILI9341_FlushDirtyAsync(pscr->mpHWConfig, pscr->mpFrameBuffer, PIX_WIDTH,
+                                   pscr->mpDirty, done_cb, user);
 }
 
 } // end extern "C"
@@ -331,4 +405,16 @@ Image<RGB565>* TftGetTGXImage(screen_control_t *pscr)
 {
     assert_(pscr);
     return pscr->mpTGXImage;
-}
\ No newline at end of file
+}
+
+ili9341_fence_t ILI9341_FlushDirtyAsync(const ili9341_config_t *pconfig, 
+                                        const uint16_t *framebuffer, int stride,
+                                        DirtyRegion *region,
+                                        ili9341_done_cb_t done_cb, void *user)
+{
+    assert_(pconfig);
+    assert_(framebuffer);
+    assert_(region);
+
+    return ILI9341_BusFlushDirtyAsync(pconfig->mpBus, framebuffer, stride, region, done_cb, user);
+}
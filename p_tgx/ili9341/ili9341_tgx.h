@@ -17,10 +17,13 @@
 #include "../lib/assert.h"
 
 #include "ili9341hw.h"
+#include "ili9341_bus.h"
+#include "ili9341_bus_pico.h"
 
 // Include TGX headers for C++
 #ifdef __cplusplus
 #include "../tgx/tgx.h"
+#include "ili9341_dirty.h"
 using namespace tgx;
 #endif
 
@@ -37,7 +40,7 @@ typedef enum
     kWhite
 } color_t;
 
-// Hardware configuration structure (unchanged)
+// Hardware configuration structure
 typedef struct 
 {
     spi_inst_t *mpSPIPort;
@@ -47,6 +50,9 @@ typedef struct
     int mGPIO_mosi;
     int mGPIO_reset;
     int mGPIO_dc;
+
+    ili9341_pico_bus_t mPicoBus;        // SPI + DMA backend set up by ILI9341_Init()
+    ili9341_bus_t *mpBus;               // bus used for all transfers (defaults to &mPicoBus.mBus)
 } ili9341_config_t;
 
 // Screen control structure with RGB565 framebuffer
@@ -64,8 +70,10 @@ typedef struct
     
     #ifdef __cplusplus
     Image<RGB565>* mpTGXImage;          // TGX Image wrapper
+    DirtyRegion* mpDirty;               // damage tracking (allocated when first enabled, attached to mpTGXImage while enabled)
     #else
     void* mpTGXImage;                   
+    void* mpDirty;
     #endif
     
 } screen_control_t;
@@ -86,6 +94,16 @@ void ILI9341_SetOutWriting(const ili9341_config_t *pconfig,
                             const int start_page, const int end_page);
 void ILI9341_WriteData(const ili9341_config_t *pconfig, void *buffer, int bytes);
 
+/* Asynchronous transfers (queued, DMA driven). The buffer must stay untouched
+   until the returned fence completes. The callback runs in IRQ context. */
+ili9341_fence_t ILI9341_WriteRectAsync(const ili9341_config_t *pconfig, 
+                                       int x, int y, int width, int height,
+                                       const uint16_t *pixels, int stride,
+                                       ili9341_done_cb_t done_cb, void *user);
+int ILI9341_FenceDone(const ili9341_config_t *pconfig, ili9341_fence_t fence);
+void ILI9341_WaitFence(const ili9341_config_t *pconfig, ili9341_fence_t fence);
+void ILI9341_WaitIdle(const ili9341_config_t *pconfig);
+
 /* Screen initialization */
 void TftInitScreen(screen_control_t *pscr, ili9341_config_t *pconfig, 
                    uint16_t *framebuffer);
@@ -109,6 +127,19 @@ void TftPutLine(screen_control_t *pscr, int x0, int y0, int x1, int y1,
 void TftFullScreenWrite(screen_control_t *pscr);
 void TftPartialScreenWrite(screen_control_t *pscr, int x, int y, 
                            int width, int height);
+ili9341_fence_t TftFullScreenWriteAsync(screen_control_t *pscr, 
+                                        ili9341_done_cb_t done_cb, void *user);
+ili9341_fence_t TftPartialScreenWriteAsync(screen_control_t *pscr, int x, int y,
+                                           int width, int height,
+                                           ili9341_done_cb_t done_cb, void *user);
+
+/* Damage tracking: when enabled, every drawing made through the TGX image
+   (and the Tft* buffer operations) records the modified rectangles. A flush
+   then sends only those rectangles and clears the list. */
+void TftSetDirtyTracking(screen_control_t *pscr, int enable);
+void TftFlushDirty(screen_control_t *pscr);
+ili9341_fence_t TftFlushDirtyAsync(screen_control_t *pscr, 
+                                   ili9341_done_cb_t done_cb, void *user);
 
 /* Helper functions */
 uint16_t ColorToRGB565(color_t color);
@@ -116,6 +147,13 @@ uint16_t ColorToRGB565(color_t color);
 #ifdef __cplusplus
 Image<RGB565>* TftGetTGXImage(screen_control_t *pscr);
 
+/* Queue the rectangles of 'region' from a framebuffer with the given stride
+   (in pixels) and clear the region. Returns the fence of the last rectangle. */
+ili9341_fence_t ILI9341_FlushDirtyAsync(const ili9341_config_t *pconfig, 
+                                        const uint16_t *framebuffer, int stride,
+                                        DirtyRegion *region,
+                                        ili9341_done_cb_t done_cb, void *user);
+
 }
 #endif
 
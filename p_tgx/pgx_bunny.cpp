@@ -1,6 +1,5 @@
 // bunny_3d.cpp - 3D Bunny mesh rendering with TGX
 #include "pico/stdlib.h"
-#include "hardware/dma.h"
 #include "ili9341/ili9341_tgx.h"
 #include "tgx/tgx.h"
 #include <stdio.h>
@@ -8,7 +7,8 @@
 
 // Include the bunny mesh
 #include "tgx/example/bunny_fig_small.h"
-#define MESH &bunny_fig_small
+#include "tgx/example/bunny_fig_texture_be.h"
+#define MESH &bunny_fig_small_be
 
 using namespace tgx;
 
@@ -20,7 +20,35 @@ using namespace tgx;
 #define TFT_RST   8
 #define TFT_DC    9
 
-// Framebuffers for double buffering with DMA
+// Band rendering: render the screen as horizontal bands of BAND_LY rows with
+// two small band buffers and a band-sized z-buffer (about 50 KB in total)
+// instead of two full framebuffers and a full z-buffer (450 KB).
+// Set to 0 to use full framebuffers.
+#define BAND_RENDERING 1
+#define BAND_LY 32
+
+#if BAND_RENDERING
+
+// Band buffers (ping-ponged against the display transfer) and band z-buffer.
+static uint16_t band1[PIX_WIDTH * BAND_LY];
+static uint16_t band2[PIX_WIDTH * BAND_LY];
+static uint16_t zband[PIX_WIDTH * BAND_LY];
+
+// Bins: one entry per triangle of the mesh (+1 per mesh)
+#define NB_BINS 2200
+static uint16_t bins[NB_BINS];
+
+// Fence of the last band transfer
+ili9341_fence_t band_fence = 0;
+
+// TGX image wrapper (only used to set up the renderer, bands are handled by drawBands())
+Image<RGB565BE> img_render;
+
+#else
+
+// Framebuffers for double buffering with DMA. 
+// Pixels are stored as RGB565BE (big endian) so the buffers are already in 
+// ILI9341 wire order and can be DMA'd as-is (no byte swapping pass).
 static uint16_t framebuffer1[PIX_WIDTH * PIX_HEIGHT];
 static uint16_t framebuffer2[PIX_WIDTH * PIX_HEIGHT];
 uint16_t* render_fb = framebuffer1;   // Buffer we render to
@@ -30,11 +58,13 @@ uint16_t* display_fb = framebuffer2;  // Buffer being sent to display
 static uint16_t zbuffer[PIX_WIDTH * PIX_HEIGHT];
 
 // TGX image wrapper
-Image<RGB565> img_render;
+Image<RGB565BE> img_render;
+
+// Fences of the last transfer of each framebuffer
+ili9341_fence_t render_fence = 0;   // last transfer from render_fb
+ili9341_fence_t display_fence = 0;  // last transfer from display_fb
 
-// DMA channel for async transfers
-int dma_channel = -1;
-volatile bool dma_busy = false;
+#endif
 
 // Only load the shaders we need 
 const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | 
@@ -43,7 +73,24 @@ const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER |
                               SHADER_TEXTURE_WRAP_POW2;
 
 // 3D renderer 
-Renderer3D<RGB565, LOADED_SHADERS, uint16_t> renderer;
+Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+// Same mesh as bunny_fig_small but with the big endian texture so that 
+// it can be drawn by the RGB565BE renderer.
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    &bunny_fig_texture_be,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
 
 // Hardware config
 ili9341_config_t hwConfig;
@@ -57,69 +104,6 @@ float current_fps = 0.0f;
 // Animation state
 int loop_number = 0;
 
-// DMA interrupt handler
-void dma_handler() {
-    dma_hw->ints0 = 1u << dma_channel;
-    dma_busy = false;
-}
-
-// Initialize DMA for SPI transfers
-void init_dma() {
-    dma_channel = dma_claim_unused_channel(true);
-    dma_channel_config c = dma_channel_get_default_config(dma_channel);
-    
-    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
-    channel_config_set_dreq(&c, spi_get_dreq(spi0, true));
-    channel_config_set_irq_quiet(&c, false);
-    
-    dma_channel_configure(
-        dma_channel,
-        &c,
-        &spi_get_hw(spi0)->dr,    // Destination: SPI data register
-        NULL,                     // Source: set later
-        0,                        // Transfer count: set later
-        false                     // Don't start yet
-    );
-    
-    // Enable DMA interrupt
-    dma_channel_set_irq0_enabled(dma_channel, true);
-    irq_set_exclusive_handler(DMA_IRQ_0, dma_handler);
-    irq_set_enabled(DMA_IRQ_0, true);
-}
-
-// Non-blocking DMA transfer to display
-void display_framebuffer_async(uint16_t* fb) {
-    // Wait for any previous DMA to complete
-    while(dma_busy) {
-        tight_loop_contents();
-    }
-    
-    // Set up display window
-    ILI9341_SetOutWriting(screen.mpHWConfig, 0, PIX_WIDTH-1, 0, PIX_HEIGHT-1);
-    
-    // Byte swap for ILI9341 (big-endian RGB565)
-    uint8_t* fb_bytes = (uint8_t*)fb;
-    for(int i = 0; i < PIX_WIDTH * PIX_HEIGHT * 2; i += 2) {
-        uint8_t temp = fb_bytes[i];
-        fb_bytes[i] = fb_bytes[i+1];
-        fb_bytes[i+1] = temp;
-    }
-    
-    // Start DMA transfer
-    dma_busy = true;
-    gpio_put(hwConfig.mGPIO_cs, 0);  // CS low
-    dma_channel_set_read_addr(dma_channel, fb, false);
-    dma_channel_set_trans_count(dma_channel, PIX_WIDTH * PIX_HEIGHT * 2, true);
-}
-
-// Wait for DMA to complete
-void wait_for_dma() {
-    while(dma_busy) {
-        tight_loop_contents();
-    }
-    gpio_put(hwConfig.mGPIO_cs, 1);  // CS high
-}
-
 // Calculate FPS
 void update_fps() {
     frame_count++;
@@ -201,14 +185,20 @@ fMat4 compute_model_matrix(uint32_t time_ms, int& loop_num) {
 
 // Setup function
 void setup_3d_renderer() {
-    // Setup the image wrapper for current render buffer
-    img_render.set((RGB565*)render_fb, PIX_WIDTH, PIX_HEIGHT);
-    
     // Configure 3D renderer
     renderer.setViewportSize(PIX_WIDTH, PIX_HEIGHT);
     renderer.setOffset(0, 0);
+#if BAND_RENDERING
+    img_render.set((RGB565BE*)band1, PIX_WIDTH, BAND_LY);
+    renderer.setImage(&img_render);
+    renderer.setZbuffer(zband);
+    renderer.setBinBuffer(bins, NB_BINS);
+#else
+    // Setup the image wrapper for current render buffer
+    img_render.set((RGB565BE*)render_fb, PIX_WIDTH, PIX_HEIGHT);
     renderer.setImage(&img_render);
     renderer.setZbuffer(zbuffer);
+#endif
     
     // Set perspective projection
     // FOV: 45 degrees, aspect ratio, near: 1.0, far: 100.0
@@ -229,6 +219,30 @@ void setup_3d_renderer() {
     renderer.setTextureWrappingMode(SHADER_TEXTURE_WRAP_POW2);
 }
 
+// Render mesh based on current mode
+void draw_scene() {
+    switch(loop_number % 4) {
+        case 0: // Gouraud shading + texture
+            renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
+            renderer.drawMesh(MESH, false);
+            break;
+            
+        case 1: // Wireframe
+            renderer.drawWireFrameMesh(MESH, true);
+            break;
+            
+        case 2: // Flat shading
+            renderer.setShaders(SHADER_FLAT);
+            renderer.drawMesh(MESH, false);
+            break;
+            
+        case 3: // Gouraud shading (no texture)
+            renderer.setShaders(SHADER_GOURAUD);
+            renderer.drawMesh(MESH, false);
+            break;
+    }
+}
+
 int main() {
     stdio_init_all();
     printf("TGX 3D Bunny Mesh Demo\n");
@@ -238,10 +252,9 @@ int main() {
                  TFT_MISO, TFT_CS, TFT_SCK, 
                  TFT_MOSI, TFT_RST, TFT_DC);
     
+#if !BAND_RENDERING
     TftInitScreen(&screen, &hwConfig, render_fb);
-    
-    // Initialize DMA
-    init_dma();
+#endif
     
     // Setup 3D renderer
     setup_3d_renderer();
@@ -258,50 +271,51 @@ int main() {
         // Compute model transformation
         fMat4 model_matrix = compute_model_matrix(current_time, loop_number);
         renderer.setModelMatrix(model_matrix);
-        
+
+#if BAND_RENDERING
+        // Each band is queued for transfer as soon as it is drawn. The next band is
+        // drawn in the other buffer, which must be done transferring first.
+        auto flush = [](const Image<RGB565BE>& band, int y) {
+            ili9341_fence_t fence = 0;
+            if (band.isValid()) {
+                fence = ILI9341_WriteRectAsync(&hwConfig, 0, y, band.lx(), band.ly(),
+                                               (const uint16_t*)band.data(), band.stride(), nullptr, nullptr);
+            }
+            ILI9341_WaitFence(&hwConfig, band_fence);
+            band_fence = fence;
+        };
+        renderer.drawBands(BAND_LY, (RGB565BE*)band1, (RGB565BE*)band2, zband,
+                           RGB565BE(RGB565_Cyan), draw_scene, flush);
+#else
+        // Make sure the buffer we are about to draw into is not still being sent
+        ILI9341_WaitFence(&hwConfig, render_fence);
+
         // Clear buffers
-        img_render.fillScreen(RGB565_Cyan);  // Clear to cyan background
+        img_render.fillScreen(RGB565BE(RGB565_Cyan));  // Clear to cyan background
         renderer.clearZbuffer();              // Clear depth buffer
         
-        // Render mesh based on current mode
-        switch(loop_number % 4) {
-            case 0: // Gouraud shading + texture
-                renderer.setShaders(SHADER_GOURAUD | SHADER_TEXTURE);
-                renderer.drawMesh(MESH, false);
-                break;
-                
-            case 1: // Wireframe
-                renderer.drawWireFrameMesh(MESH, true);
-                break;
-                
-            case 2: // Flat shading
-                renderer.setShaders(SHADER_FLAT);
-                renderer.drawMesh(MESH, false);
-                break;
-                
-            case 3: // Gouraud shading (no texture)
-                renderer.setShaders(SHADER_GOURAUD);
-                renderer.drawMesh(MESH, false);
-                break;
-        }
+        draw_scene();
         
-        // Start async transfer of render buffer to display
-        display_framebuffer_async(render_fb);
+        // Queue async transfer of render buffer to display. The framebuffer is 
+        // already in RGB565BE (wire) order so it is sent as-is.
+        render_fence = ILI9341_WriteRectAsync(&hwConfig, 0, 0, PIX_WIDTH, PIX_HEIGHT,
+                                              render_fb, PIX_WIDTH, nullptr, nullptr);
         
         // Swap buffers - start rendering next frame while transfer happens
         uint16_t* temp = render_fb;
         render_fb = display_fb;
         display_fb = temp;
+        ili9341_fence_t temp_fence = render_fence;
+        render_fence = display_fence;
+        display_fence = temp_fence;
         
         // Update image wrapper to new render buffer
-        img_render.set((RGB565*)render_fb, PIX_WIDTH, PIX_HEIGHT);
+        img_render.set((RGB565BE*)render_fb, PIX_WIDTH, PIX_HEIGHT);
         renderer.setImage(&img_render);
+#endif
         
         // Update FPS counter
         update_fps();
-        
-        // If we finish rendering before DMA completes, wait
-        wait_for_dma();
     }
     
     return 0;
@@ -0,0 +1,207 @@
+// particles_3d.cpp - Particle fountain around the bunny with TGX (Particles3D / drawParticles)
+#include "pico/stdlib.h"
+#include "ili9341/ili9341_tgx.h"
+#include "tgx/tgx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Include the bunny mesh
+#include "tgx/example/bunny_fig_small.h"
+
+using namespace tgx;
+
+// Pin definitions for ILI9341 display
+#define TFT_MISO  4
+#define TFT_CS    5
+#define TFT_SCK   6
+#define TFT_MOSI  7
+#define TFT_RST   8
+#define TFT_DC    9
+
+// Band rendering (see pgx_bunny.cpp): the particles are projected again for
+// each band, the bands that they do not cross are skipped after the projection.
+#define BAND_LY 32
+
+// Band buffers (ping-ponged against the display transfer) and band z-buffer.
+static uint16_t band1[PIX_WIDTH * BAND_LY];
+static uint16_t band2[PIX_WIDTH * BAND_LY];
+static uint16_t zband[PIX_WIDTH * BAND_LY];
+
+// Bins: one entry per triangle of the mesh (+1 per mesh)
+#define NB_BINS 2200
+static uint16_t bins[NB_BINS];
+
+// Fence of the last band transfer
+ili9341_fence_t band_fence = 0;
+
+// TGX image wrapper (only used to set up the renderer, bands are handled by drawBands())
+Image<RGB565BE> img_render;
+
+// Particles: one array per attribute (about 30 KB for 1000 particles).
+#define NB_PARTICLES 1000
+static fVec3 position[NB_PARTICLES];
+static fVec3 velocity[NB_PARTICLES];
+static float life[NB_PARTICLES];
+static RGB565BE color[NB_PARTICLES];
+static uint8_t opacity[NB_PARTICLES];
+static ParticleScreenEntry screen_entries[NB_PARTICLES];
+static uint16_t order[NB_PARTICLES];
+Particles3D<RGB565BE> particles(position, NB_PARTICLES, screen_entries, order);
+
+// Sprite: soft disc, black is transparent
+#define SPRITE_LX 16
+static uint16_t sprite_buf[SPRITE_LX * SPRITE_LX];
+Image<RGB565BE> sprite((RGB565BE*)sprite_buf, SPRITE_LX, SPRITE_LX);
+
+// Only load the shaders we need 
+const Shader LOADED_SHADERS = SHADER_PERSPECTIVE | SHADER_ZBUFFER | 
+                              SHADER_GOURAUD | SHADER_NOTEXTURE;
+
+// 3D renderer 
+Renderer3D<RGB565BE, LOADED_SHADERS, uint16_t> renderer;
+
+// Same mesh as bunny_fig_small, for the RGB565BE renderer (no texture).
+const Mesh3D<RGB565BE> bunny_fig_small_be =
+    {
+    bunny_fig_small.id,
+    bunny_fig_small.nb_vertices, bunny_fig_small.nb_texcoords, bunny_fig_small.nb_normals,
+    bunny_fig_small.nb_faces, bunny_fig_small.len_face,
+    bunny_fig_small.vertice, bunny_fig_small.texcoord, bunny_fig_small.normal, bunny_fig_small.face,
+    nullptr,
+    bunny_fig_small.color,
+    bunny_fig_small.ambiant_strength, bunny_fig_small.diffuse_strength,
+    bunny_fig_small.specular_strength, bunny_fig_small.specular_exponent,
+    nullptr,
+    bunny_fig_small.bounding_box,
+    bunny_fig_small.name
+    };
+
+// Hardware config
+ili9341_config_t hwConfig;
+screen_control_t screen;
+
+// FPS tracking
+uint32_t frame_count = 0;
+uint64_t last_fps_time = 0;
+float current_fps = 0.0f;
+
+// Calculate FPS
+void update_fps() {
+    frame_count++;
+    uint64_t now = time_us_64();
+    
+    if (now - last_fps_time >= 1000000) {
+        current_fps = frame_count * 1000000.0f / (now - last_fps_time);
+        printf("FPS: %.2f | Particles: %d\n", current_fps, particles.nbParticles());
+        frame_count = 0;
+        last_fps_time = now;
+    }
+}
+
+float frand(float a, float b) {
+    return a + (b - a) * rand() / (float)RAND_MAX;
+}
+
+// Spawn a particle at the nozzle of the fountain, above the head of the bunny (model space)
+void spawn_particle() {
+    const float a = frand(0, 6.2831853f), s = frand(0.15f, 0.35f);
+    const int i = particles.spawn(fVec3(0, 1.05f, 0), fVec3(s * cosf(a), frand(0.7f, 0.9f), s * sinf(a)), frand(2.5f, 4.0f));
+    if (i < 0) return;
+    color[i] = RGB565BE(RGBf(frand(0.3f, 0.8f), frand(0.6f, 1.0f), 1.0f));
+    opacity[i] = (uint8_t)frand(96, 255);
+}
+
+// Setup function
+void setup_3d_renderer() {
+    // Configure 3D renderer
+    renderer.setViewportSize(PIX_WIDTH, PIX_HEIGHT);
+    renderer.setOffset(0, 0);
+    img_render.set((RGB565BE*)band1, PIX_WIDTH, BAND_LY);
+    renderer.setImage(&img_render);
+    renderer.setZbuffer(zband);
+    renderer.setBinBuffer(bins, NB_BINS);
+    renderer.setPerspective(45.0f, ((float)PIX_WIDTH) / PIX_HEIGHT, 1.0f, 100.0f);
+    renderer.setMaterial(RGBf(0.85f, 0.55f, 0.25f), 0.2f, 0.7f, 0.8f, 64);
+    renderer.setCulling(1);
+    renderer.setShaders(SHADER_GOURAUD);
+
+    // Particles: sprite tinted by the color of each particle, blended with its opacity, back to front
+    sprite.fillScreen(RGB565BE(RGB565_Black));
+    for (int j = 0; j < SPRITE_LX; j++) {
+        for (int i = 0; i < SPRITE_LX; i++) {
+            const float dx = (i + 0.5f) / SPRITE_LX * 2 - 1, dy = (j + 0.5f) / SPRITE_LX * 2 - 1;
+            const float d = 1.0f - sqrtf(dx * dx + dy * dy);
+            if (d > 0.05f) sprite(i, j) = RGB565BE(RGBf(d, d, d));
+        }
+    }
+    particles.setVelocities(velocity);
+    particles.setLives(life);
+    particles.setColors(color);
+    particles.setOpacities(opacity);
+    particles.setSize(0.03f);
+    particles.setSprite(&sprite, RGB565BE(RGB565_Black));
+}
+
+// Opaque bunny first, then the particles (depth tested, no z-buffer write)
+void draw_scene() {
+    renderer.drawMesh(&bunny_fig_small_be, false);
+    renderer.drawParticles(&particles);
+}
+
+int main() {
+    stdio_init_all();
+    printf("TGX 3D Particles Demo\n");
+    
+    // Initialize display hardware    
+    ILI9341_Init(&hwConfig, spi0, 62 * 1000 * 1000,  // 62.5 MHz SPI
+                 TFT_MISO, TFT_CS, TFT_SCK, 
+                 TFT_MOSI, TFT_RST, TFT_DC);
+    
+    // Setup 3D renderer
+    setup_3d_renderer();
+    
+    printf("Display initialized: %dx%d\n", PIX_WIDTH, PIX_HEIGHT);
+    printf("Starting 3D rendering...\n\n");
+    
+    last_fps_time = time_us_64();
+    uint64_t last_time = last_fps_time;
+    
+    // Main render loop
+    while(1) {
+        // Animate the particles with the elapsed time
+        const uint64_t now = time_us_64();
+        const float dt = (now - last_time) * 1.0e-6f;
+        last_time = now;
+        const int nb_spawn = (int)(dt * 300.0f) + 1; // about 300 particles per second
+        for (int n = 0; n < nb_spawn; n++) spawn_particle();
+        particles.update(dt, {0, -0.6f, 0});
+
+        // Rotate the scene slowly: 1 full rotation every 8 seconds
+        const float rotation_y = 360.0f * ((now / 1000) % 8000) / 8000.0f;
+        fMat4 M;
+        M.setScale({6.0f, 6.0f, 6.0f});
+        M.multRotate(-rotation_y, {0, 1, 0});
+        M.multTranslate({0, 0, -20.0f});
+        renderer.setModelMatrix(M);
+
+        // Each band is queued for transfer as soon as it is drawn. The next band is
+        // drawn in the other buffer, which must be done transferring first.
+        auto flush = [](const Image<RGB565BE>& band, int y) {
+            ili9341_fence_t fence = 0;
+            if (band.isValid()) {
+                fence = ILI9341_WriteRectAsync(&hwConfig, 0, y, band.lx(), band.ly(),
+                                               (const uint16_t*)band.data(), band.stride(), nullptr, nullptr);
+            }
+            ILI9341_WaitFence(&hwConfig, band_fence);
+            band_fence = fence;
+        };
+        renderer.drawBands(BAND_LY, (RGB565BE*)band1, (RGB565BE*)band2, zband,
+                           RGB565BE(RGB565_Black), draw_scene, flush);
+        
+        // Update FPS counter
+        update_fps();
+    }
+    
+    return 0;
+}
@@ -79,6 +79,12 @@ RGB565& RGB565::operator=(const HSV& hsv)
     }
 
 
+
+RGB565BE::RGB565BE(const HSV& hsv) : RGB565BE(RGB565(hsv))
+    {
+    }
+
+
 RGB24::RGB24(const HSV& hsv)
     {
     *this = (RGB24)(RGBf(hsv));
@@ -266,6 +272,18 @@ HSV& HSV::operator=(const RGB565& c)
     }
 
 
+HSV::HSV(const RGB565BE& c) : HSV(RGB565(c))
+    {
+    }
+
+
+HSV& HSV::operator=(const RGB565BE& c)
+    {
+    return (*this = RGB565(c));
+    }
+
+
+
 HSV& HSV::operator=(const RGB24 & c)
     {
     *this = HSV(RGBf(c));
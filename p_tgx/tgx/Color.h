@@ -44,6 +44,10 @@ namespace tgx
 //
 // - RGB565: 16bits, R:5 G:6 B:5 colors  
 //           no alpha channel wrapper around a uint16_t integer, aligned as uint16_t
+//
+// - RGB565BE: 16bits, same as RGB565 but the two bytes are stored in big endian
+//           (i.e. SPI wire) order so that a framebuffer can be sent as-is to 
+//           a display such as the ILI9341 without a byte swapping pass.
 //          
 // - RGB24:  24bits, R:8 G:8 B:8 colors.   
 //           no alpha channel, not aligned in memory
@@ -114,6 +118,8 @@ namespace tgx
 
 struct RGB565;  // color in 16-bit R5/G6/B5 format (2 bytes aligned) - convertible to/from uint16_t
 
+struct RGB565BE; // color in 16-bit R5/G6/B5 format stored in big endian order (2 bytes aligned)
+
 struct RGB24;   // color in 24-bit R8/G8/B8/ format (unaligned !). 
 
 struct RGB32;   // color in 32-bit R8/G8/B8/(A8) format (4 bytes aligned) - convertible to/from uint32_t
@@ -138,7 +144,8 @@ template<typename T> struct id_color_type
         (std::is_same<T, RGB32>::value) ? 3 : (
         (std::is_same<T, RGB64>::value) ? 4 : (
         (std::is_same<T, RGBf>::value) ? 5 : (
-        (std::is_same<T, HSV>::value) ? 6 : 0)))));
+        (std::is_same<T, HSV>::value) ? 6 : (
+        (std::is_same<T, RGB565BE>::value) ? 7 : 0))))));
     };
 
 
@@ -363,6 +370,12 @@ struct RGB565
         constexpr inline RGB565(const RGBf & c);
 
 
+        /**
+        * Constructor from a RGB565BE color (swap the bytes).
+        */
+        inline RGB565(const RGB565BE& c);
+
+
         /**
         * Constructor from a HSV color.
         */
@@ -423,6 +436,12 @@ struct RGB565
         inline RGB565& operator=(const RGBf& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color (swap the bytes).
+        */
+        inline RGB565& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a HSV color
         */
@@ -668,6 +687,366 @@ struct RGB565
 
 
 
+    /**
+    * Spread a RGB565BE raw value on 32 bits with 5 free bits above each channel: the low byte
+    * (channel of bits 11-15 in RGB565 and top of G) and the high byte (bottom of G and channel
+    * of bits 0-4 in RGB565) are duplicated so that G is contiguous, giving the channels at bits
+    * 0-4, 10-15 and 21-25. This is the equivalent of the 0b00000111111000001111100000011111 mask
+    * used by RGB565 and avoids swapping the bytes back and forth.
+    **/
+    TGX_INLINE inline uint32_t _rgb565be_expand(uint16_t v)
+        {
+        return ((((uint32_t)v) | (((uint32_t)v) << 16)) >> 3) & 0b00000011111000001111110000011111;
+        }
+
+
+    /**
+    * Inverse of _rgb565be_expand() (the value must be masked).
+    **/
+    TGX_INLINE inline uint16_t _rgb565be_contract(uint32_t r)
+        {
+        r <<= 3;
+        return (uint16_t)((r >> 16) | r);
+        }
+
+
+
+
+/**
+ * Color in R5/G6/B5 format stored in big endian byte order.
+ * 
+ * The object occupies 2 bytes in memory (aligned as uint16_t). The value has the same meaning
+ * as RGB565 but its two bytes are swapped so that the memory layout matches the byte order
+ * expected on the wire by SPI displays (ILI9341, ST7789...). A framebuffer of this type can
+ * thus be sent directly by DMA without any byte swapping pass.
+ * 
+ * Conversions from/to other color types go through RGB565 (a single byte swap, i.e. one
+ * `rev16` instruction on ARM). Blending and interpolation work directly on the swapped value
+ * (with its own channel masks) and give the same result as RGB565 followed by a byte swap.
+ */
+struct RGB565BE
+    {
+
+        uint16_t val; ///< raw color value, byte-swapped compared to RGB565.
+
+
+        /**
+        * Default constructor. ** color is undefined ***
+        */
+        RGB565BE() = default;
+
+
+        /**
+         * Constructor from R,G,B values.
+         *
+         * @param   r   in [0,31]
+         * @param   g   in [0,63]
+         * @param   b   in [0,31]
+         */
+        RGB565BE(int r, int g, int b) : RGB565BE(RGB565(r, g, b))
+        {}
+
+
+        /**
+        * Constructor from float r,g,b in [0.0f, 1.0f].
+        */
+        RGB565BE(float r, float g, float b) : RGB565BE(RGB565(r, g, b))
+        {}
+
+
+        /**
+        * Constructor from an #iVec3 vector (x=R, y=G, z=B). Raw values.
+        */
+        RGB565BE(iVec3 v) : RGB565BE(RGB565(v))
+        {}
+
+
+        /**
+        * Constructor from an #iVec4 vector (x=R, y=G, z=B, w=ignored). Raw values.
+        */
+        RGB565BE(iVec4 v) : RGB565BE(RGB565(v))
+        {}
+
+
+        /**
+        * Constructor from a #fVec3 vector with components (x=R, y=G, z=B) in [0.0f, 1.0f].
+        */
+        RGB565BE(fVec3 v) : RGB565BE(RGB565(v))
+        {}
+
+
+        /**
+        * Constructor from a #fVec4 vector with components (x=R, y=G, z=B, w=ignored) in [0.0f, 1.0f].
+        */
+        RGB565BE(fVec4 v) : RGB565BE(RGB565(v))
+        {}
+
+
+        /**
+        * Constructor from a uint16_t. 
+        * 
+        * **Raw value** : the integer is interpreted as already in big endian order.
+        */
+        constexpr RGB565BE(uint16_t c) : val(c) {}
+
+
+        /**
+        * Default Copy constructor
+        */
+        constexpr RGB565BE(const RGB565BE&) = default;
+
+
+        /**
+        * Constructor from a RGB565 color (swap the bytes).
+        */
+        RGB565BE(const RGB565& c) : val(BigEndian16(c.val)) {}
+
+
+        /**
+        * Constructor from a RGB24 color.
+        */
+        inline RGB565BE(const RGB24& c);
+
+
+        /**
+        * Constructor from a RGB32 color. The component A is ignored
+        */
+        inline RGB565BE(const RGB32& c);
+
+
+        /**
+        * Constructor from a RGB64 color. The component A is ignored
+        */
+        inline RGB565BE(const RGB64& c);
+
+
+        /**
+        * Constructor from a RGBf color.
+        */
+        inline RGB565BE(const RGBf& c);
+
+
+        /**
+        * Constructor from a HSV color.
+        */
+        RGB565BE(const HSV& c);
+
+
+        /**
+        * Cast into a uint16_t (non-const reference version). Raw big endian value.
+        */
+        explicit operator uint16_t&() { return val; }
+
+
+        /**
+        * Cast into a uint16_t (const reference version). Raw big endian value.
+        */
+        explicit operator const uint16_t& () const { return val; }
+
+
+        /**
+        * Cast into an #iVec3 vector. raw values.
+        */
+        explicit operator iVec3() const { return iVec3(RGB565(*this)); }
+
+
+        /**
+        * Cast into an #fVec3 vector. Values in [0.0f, 1.0f].
+        */
+        explicit operator fVec3() const { return fVec3(RGB565(*this)); }
+
+
+        /**
+        * Default assignement operator.
+        */
+        RGB565BE& operator=(const RGB565BE&) = default;
+
+
+        /**
+        * Assignement operator from a RGB565 color.
+        */
+        RGB565BE& operator=(const RGB565& c) { val = BigEndian16(c.val); return *this; }
+
+
+        /**
+        * Add another color, component by component.
+        */
+        void operator+=(const RGB565BE& c)
+            {
+            RGB565 a(*this);
+            a += RGB565(c);
+            *this = a;
+            }
+
+
+        /**
+        * Substract another color, component by component.
+        */
+        void operator-=(const RGB565BE& c)
+            {
+            RGB565 a(*this);
+            a -= RGB565(c);
+            *this = a;
+            }
+
+
+        /**
+        * Equality comparator
+        */
+        constexpr bool operator==(const RGB565BE& c) const
+            {
+            return(val == c.val);
+            }
+
+
+        /**
+        * Inequality comparator
+        */
+        constexpr bool operator!=(const RGB565BE& c) const
+            {
+            return !(*this == c);
+            }
+
+
+        /**
+         * alpha-blend `fg_col` over this one with a given opacity in the range 0.0f (fully transparent)
+         * to 1.0f (fully opaque).
+         */
+        inline void blend(RGB565BE fg_col, float alpha)
+            {
+            blend256(fg_col, (uint32_t)(alpha * 256));
+            }
+
+
+        /**
+         * alpha-blend `fg_col` over this one with a given opacity in the integer range 0 (fully
+         * transparent) to 256 (fully opaque).
+         */
+        inline void blend256(const RGB565BE & fg_col, uint32_t alpha)
+            {
+            const uint32_t a = (alpha >> 3); // map to 0 - 32.
+            const uint32_t bg = _rgb565be_expand(val);
+            const uint32_t fg = _rgb565be_expand(fg_col.val);
+            const uint32_t result = ((((fg - bg) * a) >> 5) + bg) & 0b00000011111000001111110000011111;
+            val = _rgb565be_contract(result);
+            }
+
+
+        /**
+         * Multiply each color component by a given factor m/256 with m in [0,256]
+         */
+        inline void mult256(int mr, int mg, int mb)
+            {
+            RGB565 c(*this);
+            c.mult256(mr, mg, mb);
+            *this = c;
+            }
+
+
+        /**
+        * Multiply each color component by a given factor x/256 with x in [0,256].
+        * 
+        * Parameter ma is ignored since there is not alpha channel.
+        */
+        inline void mult256(int mr, int mg, int mb, int /* ma */)
+            {
+            mult256(mr, mg, mb);
+            }
+
+
+        /**
+        * Dummy function for compatibility with color types having an alpha channel.
+        */
+        inline void premultiply()
+            {
+            return;
+            }
+
+
+        /**
+         * Dummy function for compatibility with color types having an alpha channel.
+         * 
+         * Return 1.0f (fully opaque)
+         */
+        float opacity() const
+            {
+            return 1.0f;
+            }
+
+
+        /**
+         * Dummy function for compatibility with color types having an alpha channel.
+         */
+        void setOpacity(float /* op */)
+            {
+            return;
+            }
+
+    };
+
+
+    /**
+    * Interpolate between 3 colors. 
+    * 
+    * Return the color (C1*col1 + C2*col2 + (totC-C1-C2)*col3) / totC.
+    **/
+    inline RGB565BE interpolateColorsTriangle(const RGB565BE & col1, int32_t C1, const  RGB565BE & col2, int32_t C2, const  RGB565BE & col3, const int32_t totC)
+        {
+        C1 <<= 5;
+        C1 /= totC;
+        C2 <<= 5;
+        C2 /= totC;
+        const uint32_t bg1 = _rgb565be_expand(col1.val);
+        const uint32_t bg2 = _rgb565be_expand(col2.val);
+        const uint32_t bg3 = _rgb565be_expand(col3.val);
+        const uint32_t result = ((bg1 * C1 + bg2 * C2 + bg3 * (32 - C1 - C2)) >> 5) & 0b00000011111000001111110000011111;
+        return RGB565BE(_rgb565be_contract(result));
+        }
+
+
+    /**
+     * Bilinear interpolation between 4 colors (see the RGB565 version for details).
+     */
+    inline RGB565BE interpolateColorsBilinear(const RGB565BE & C00, const RGB565BE & C10, const RGB565BE & C01, const RGB565BE & C11, const float ax, const float ay)
+        {
+        const int iax = (int)(ax * 256);
+        const int iay = (int)(ay * 256);
+        const int rax = 256 - iax;
+        const int ray = 256 - iay;
+        const uint32_t c00 = _rgb565be_expand(C00.val);
+        const uint32_t c10 = _rgb565be_expand(C10.val);
+        const uint32_t c01 = _rgb565be_expand(C01.val);
+        const uint32_t c11 = _rgb565be_expand(C11.val);
+        // the weights need 16 bits so the channels are interpolated one at a time
+        const uint32_t A = rax * (ray * (c00 & 31) + iay * (c01 & 31)) + iax * (ray * (c10 & 31) + iay * (c11 & 31));
+        const uint32_t G = rax * (ray * ((c00 >> 10) & 63) + iay * ((c01 >> 10) & 63)) + iax * (ray * ((c10 >> 10) & 63) + iay * ((c11 >> 10) & 63));
+        const uint32_t B = rax * (ray * (c00 >> 21) + iay * (c01 >> 21)) + iax * (ray * (c10 >> 21) + iay * (c11 >> 21));
+        return RGB565BE(_rgb565be_contract((A >> 16) | ((G >> 16) << 10) | ((B >> 16) << 21)));
+        }
+
+
+    /**
+    * Return the average color between colA and colB.
+    */
+    inline RGB565BE meanColor(RGB565BE colA, RGB565BE colB)
+        {
+        return RGB565BE(_rgb565be_contract(((_rgb565be_expand(colA.val) + _rgb565be_expand(colB.val)) >> 1) & 0b00000011111000001111110000011111));
+        }
+
+
+    /**
+    * Return the average color between 4 colors.
+    */
+    inline RGB565BE meanColor(RGB565BE colA, RGB565BE colB, RGB565BE colC, RGB565BE colD)
+        {
+        const uint32_t sum = _rgb565be_expand(colA.val) + _rgb565be_expand(colB.val) + _rgb565be_expand(colC.val) + _rgb565be_expand(colD.val);
+        return RGB565BE(_rgb565be_contract((sum >> 2) & 0b00000011111000001111110000011111));
+        }
+
+
+
+
+
 /**
  * Color in R8/G8/B8 format.
  * 
@@ -801,6 +1180,12 @@ struct RGB24
         constexpr inline RGB24(const RGB565& c);
 
 
+        /**
+        * Constructor from a RGB565BE color.
+        */
+        inline RGB24(const RGB565BE& c);
+
+
         /**
         * Constructor from a RGB32 color. The component A is ignored
         */
@@ -849,6 +1234,12 @@ struct RGB24
         inline RGB24& operator=(const RGB565& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color.
+        */
+        inline RGB24& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a RGB32 color. The component A is ignored.
         */
@@ -1302,6 +1693,12 @@ struct RGB32
         constexpr inline RGB32(const RGB565& c);
 
 
+        /**
+        * Constructor from a RGB565BE color. Component A is set to DEFAULT_A.
+        */
+        inline RGB32(const RGB565BE& c);
+
+
         /**
         * Constructor from a RGB24 color. Component A is set to DEFAULT_A.
         */
@@ -1374,6 +1771,12 @@ struct RGB32
         inline RGB32& operator=(const RGB565& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color. Component A is set to DEFAULT_A.
+        */
+        inline RGB32& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a RGB24 color. Component A is set to DEFAULT_A.
         */
@@ -1917,6 +2320,12 @@ struct RGB64
         inline RGB64(const RGB565& c);
 
 
+        /**
+        * Constructor from a RGB565BE color. Component A is set to DEFAULT_A.
+        */
+        inline RGB64(const RGB565BE& c);
+
+
         /**
         * Constructor from a RGB24 color. Component A is set to DEFAULT_A.
         */
@@ -1989,6 +2398,12 @@ struct RGB64
         inline RGB64& operator=(const RGB565& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color. Component A is set to DEFAULT_A.
+        */
+        inline RGB64& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a RGB24 color. Component A is set to DEFAULT_A.
         */
@@ -2485,6 +2900,12 @@ struct RGB64
         constexpr inline RGBf(const RGB565& c);
 
 
+        /**
+        * Constructor from a RGB565BE color.
+        */
+        inline RGBf(const RGB565BE& c);
+
+
         /**
         * Constructor from a RGB24 color.
         */
@@ -2527,6 +2948,12 @@ struct RGB64
         inline RGBf& operator=(const RGB565& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color.
+        */
+        inline RGBf& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a RGB24 color.
         */
@@ -2895,6 +3322,12 @@ struct HSV
         HSV(const RGB565& c);
 
 
+        /**
+        * Constructor from a RGB565BE color.
+        */
+        HSV(const RGB565BE& c);
+
+
         /**
         * Constructor from a RGB24 color.
         */
@@ -2937,6 +3370,12 @@ struct HSV
         HSV& operator=(const RGB565& c);
 
 
+        /**
+        * Assignement operator from a RGB565BE color.
+        */
+        HSV& operator=(const RGB565BE& c);
+
+
         /**
         * Assignement operator from a RGB24 color.
         */
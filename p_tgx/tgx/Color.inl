@@ -159,6 +159,89 @@ inline RGB565& RGB565::operator=(fVec4 v)
 
 
 
+/**********************************************************************
+* implementation of inline method for RGB565BE
+***********************************************************************/
+
+
+inline RGB565BE::RGB565BE(const RGB24& c) : RGB565BE(RGB565(c))
+        {
+        }
+
+
+inline RGB565BE::RGB565BE(const RGB32& c) : RGB565BE(RGB565(c))
+        {
+        }
+
+
+inline RGB565BE::RGB565BE(const RGB64& c) : RGB565BE(RGB565(c))
+        {
+        }
+
+
+inline RGB565BE::RGB565BE(const RGBf& c) : RGB565BE(RGB565(c))
+        {
+        }
+
+
+inline RGB565::RGB565(const RGB565BE& c) : val(BigEndian16(c.val))
+        {
+        }
+
+
+inline RGB565& RGB565::operator=(const RGB565BE& c)
+        {
+        val = BigEndian16(c.val);
+        return *this;
+        }
+
+
+inline RGB24::RGB24(const RGB565BE& c) : RGB24(RGB565(c))
+        {
+        }
+
+
+inline RGB24& RGB24::operator=(const RGB565BE& c)
+        {
+        return (*this = RGB565(c));
+        }
+
+
+inline RGB32::RGB32(const RGB565BE& c) : RGB32(RGB565(c))
+        {
+        }
+
+
+inline RGB32& RGB32::operator=(const RGB565BE& c)
+        {
+        return (*this = RGB565(c));
+        }
+
+
+inline RGB64::RGB64(const RGB565BE& c) : RGB64(RGB565(c))
+        {
+        }
+
+
+inline RGB64& RGB64::operator=(const RGB565BE& c)
+        {
+        return (*this = RGB565(c));
+        }
+
+
+inline RGBf::RGBf(const RGB565BE& c) : RGBf(RGB565(c))
+        {
+        }
+
+
+inline RGBf& RGBf::operator=(const RGB565BE& c)
+        {
+        return (*this = RGB565(c));
+        }
+
+
+
+
 /**********************************************************************
 * implementation of inline method for RGB24
 ***********************************************************************/
@@ -0,0 +1,232 @@
+/**
+ * @file DirtyRegion.h
+ * Damage tracking: bounded list of dirty rectangles.
+ */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _TGX_DIRTYREGION_H_
+#define _TGX_DIRTYREGION_H_
+
+// only C++, no plain C
+#ifdef __cplusplus
+
+
+#include "Misc.h"
+#include "Vec2.h"
+#include "Box2.h"
+
+#include <stdint.h>
+
+
+/** Maximum number of rectangles held by a DirtyRegion. When the list is full, new rectangles are merged into existing ones. */
+#ifndef TGX_DIRTY_MAX_RECTS
+#define TGX_DIRTY_MAX_RECTS 16
+#endif
+
+/** Default cost (in pixels) of setting up one more rectangle transfer (window commands, CS toggle, DMA start/IRQ). */
+#ifndef TGX_DIRTY_MERGE_COST
+#define TGX_DIRTY_MERGE_COST 128
+#endif
+
+
+namespace tgx
+{
+
+
+    /**
+     * Dirty region: a bounded list of rectangles that need to be sent to the screen.
+     *
+     * Attach it to an image with `Image::setDirtyRegion()`: every drawing primitive of the image
+     * then records the (clipped) bounding box of what it draws. The rectangles are merged on
+     * insertion according to a simple cost model: sending a rectangle costs `mergeCost()` pixels
+     * of overhead plus one unit per pixel. Two rectangles are replaced by their union whenever
+     * the union is not more expensive to send than the two rectangles separately, i.e. when
+     *
+     *       area(A | B) <= area(A) + area(B) + mergeCost()
+     *
+     * Overlapping rectangles are therefore almost always merged and near rectangles are merged
+     * when the gap between them is small compared to the setup cost. When the list is full, the
+     * new rectangle is merged with the rectangle for which the union wastes the fewest pixels.
+     *
+     * The rectangles in the list are disjoint up to the cost model (they may still overlap when
+     * merging would waste more than `mergeCost()` pixels). Once flushed to the screen, call
+     * `clear()` to start tracking the next frame.
+     *
+     * @remark
+     * 1. The DirtyRegion object is owned by the user, the image only keeps a pointer to it.
+     * 2. Coordinates are relative to the image that called `setDirtyRegion()`. Sub-images created
+     *    from that image share the region and report their damage in the parent's coordinates.
+     */
+    class DirtyRegion
+        {
+
+        public:
+
+            /**
+             * Constructor. Create an empty region.
+             *
+             * @param   merge_cost  (Optional) overhead of one rectangle transfer, in pixels.
+             */
+            DirtyRegion(int merge_cost = TGX_DIRTY_MERGE_COST) : _nb(0), _merge_cost(merge_cost), _origin(nullptr), _bounds(0, -1, 0, -1)
+                {
+                }
+
+
+            /**
+             * Set the overhead of one rectangle transfer, in pixels. Larger values produce fewer,
+             * bigger rectangles.
+             */
+            void setMergeCost(int merge_cost) { _merge_cost = merge_cost; }
+
+
+            /**
+             * Return the overhead of one rectangle transfer, in pixels.
+             */
+            int mergeCost() const { return _merge_cost; }
+
+
+            /**
+             * Remove all rectangles.
+             */
+            void clear() { _nb = 0; }
+
+
+            /**
+             * Return true if there is nothing to flush.
+             */
+            bool isEmpty() const { return (_nb == 0); }
+
+
+            /**
+             * Return the number of rectangles in the list.
+             */
+            int size() const { return _nb; }
+
+
+            /**
+             * Return the i-th rectangle (0 <= i < size()).
+             */
+            const iBox2& operator[](int i) const { return _rects[i]; }
+
+
+            /**
+             * Return the total number of pixels covered by the rectangles (pixels in overlapping
+             * rectangles are counted several times, as they will be sent several times).
+             */
+            int32_t area() const
+                {
+                int32_t a = 0;
+                for (int i = 0; i < _nb; i++) a += _area(_rects[i]);
+                return a;
+                }
+
+
+            /**
+             * Return the estimated cost of flushing the region: area() plus mergeCost() per rectangle.
+             */
+            int32_t cost() const { return area() + _nb * _merge_cost; }
+
+
+            /**
+             * Return the smallest box containing all the rectangles (empty if there are none).
+             */
+            iBox2 boundingBox() const
+                {
+                iBox2 B(0, -1, 0, -1);
+                for (int i = 0; i < _nb; i++) B |= _rects[i];
+                return B;
+                }
+
+
+            /**
+             * Add a rectangle to the region, merging it with the existing rectangles according to
+             * the cost model. The box should already be clipped to the image (Image does it).
+             */
+            void add(iBox2 B)
+                {
+                if (B.isEmpty()) return;
+                while (1)
+                    {
+                    int merge = -1;
+                    for (int i = 0; i < _nb; i++)
+                        {
+                        const iBox2& R = _rects[i];
+                        if (R.contains(B)) return; // already dirty
+                        if (_area(R | B) <= _area(R) + _area(B) + _merge_cost) { merge = i; break; }
+                        }
+                    if ((merge < 0) && (_nb < TGX_DIRTY_MAX_RECTS))
+                        {
+                        _rects[_nb++] = B;
+                        return;
+                        }
+                    if (merge < 0)
+                        { // list full: merge with the rectangle that wastes the fewest pixels.
+                        int32_t best = 0;
+                        for (int i = 0; i < _nb; i++)
+                            {
+                            const int32_t waste = _area(_rects[i] | B) - _area(_rects[i]);
+                            if ((merge < 0) || (waste < best)) { merge = i; best = waste; }
+                            }
+                        }
+                    // remove the rectangle and insert the union instead (which may now merge with others).
+                    B |= _rects[merge];
+                    _rects[merge] = _rects[--_nb];
+                    }
+                }
+
+
+            /**
+             * Mark the whole image attached with `Image::setDirtyRegion()` as dirty.
+             */
+            void addAll() { add(_bounds); }
+
+
+            /**
+             * Used by `Image::setDirtyRegion()`: set the first pixel of the tracked image and its bounds.
+             */
+            void setOrigin(const void* origin, const iBox2& bounds)
+                {
+                _origin = origin;
+                _bounds = bounds;
+                }
+
+
+            /**
+             * Return the first pixel of the tracked image.
+             */
+            const void* origin() const { return _origin; }
+
+
+        private:
+
+            static inline int32_t _area(const iBox2& B) { return ((int32_t)B.lx()) * ((int32_t)B.ly()); }
+
+            iBox2       _rects[TGX_DIRTY_MAX_RECTS];    // dirty rectangles
+            int         _nb;                            // number of rectangles in the list
+            int         _merge_cost;                    // overhead of one rectangle, in pixels
+            const void* _origin;                        // first pixel of the tracked image
+            iBox2       _bounds;                        // box of the tracked image
+        };
+
+
+}
+
+
+#endif
+
+#endif
+
+/** end of file **/
+
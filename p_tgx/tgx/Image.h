@@ -35,6 +35,7 @@
 #include "Shaders.h"
 #include "Rasterizer.h"
 #include "bseg.h"
+#include "DirtyRegion.h"
 
 #include <stdint.h>
 
@@ -71,8 +72,8 @@ namespace tgx
      *
      * **This is the main image class for the TGX library**.
      * 
-     * An image object is a thin wrapper (only 16 bytes) around a memory buffer which defines the type and
-     * dimension of the image.
+     * An image object is a thin wrapper (only 20 bytes) around a memory buffer which defines the type and
+     * dimension of the image (and holds an optional pointer to a DirtyRegion for damage tracking).
      * 
      * @tparam  color_t Color type of the image. Must be one of the color type defined in Color.h. Typical choice:
      *                  - `RGB32` when running on a desktop computer.
@@ -248,6 +249,8 @@ namespace tgx
          * @param   lx      image width.
          * @param   ly      image height.
          * @param   stride  (Optional) The stride. If not specified, the stride is set equal to the image width.
+         * 
+         * @remark If a DirtyRegion is attached to the image, it now tracks the new buffer.
          */
         template<typename T> void set(T* buffer, int lx, int ly, int stride = DEFAULT_STRIDE);
 
@@ -426,6 +429,63 @@ namespace tgx
        
 
 
+    ///@}
+    //*************************************************************************************************************
+    //*************************************************************************************************************
+    //*************************************************************************************************************
+    /**
+    * @name Damage tracking.
+    *       
+    * Optionally record the regions of the image modified by the drawing methods so that only those
+    * regions need to be sent to the screen. 
+    * 
+    * When a DirtyRegion is attached to the image, every drawing method adds the bounding box of the
+    * pixels it may modify (clipped to the image) to the region. The boxes are conservative: they
+    * always contain every pixel written but may contain a few more (e.g. anti-aliasing margin).
+    * Writing pixels directly through `operator()` or `data()` is not tracked: use `markDirty()`.
+    * 
+    * Damage tracking is disabled by default and costs a single test per drawing call when disabled.
+    */
+    ///@{
+    //*************************************************************************************************************
+    //*************************************************************************************************************
+    //*************************************************************************************************************
+
+
+        /**
+         * Attach a dirty region to this image (or detach it by passing nullptr).
+         * 
+         * The region is reset to track this image: coordinates of the dirty rectangles are relative
+         * to this image. Sub-images created afterward from this image share the same region (and
+         * report their damage in the coordinates of this image).
+         *
+         * @param   region  The region to fill (owned by the caller) or nullptr to disable tracking.
+         */
+        void setDirtyRegion(DirtyRegion* region);
+
+
+        /**
+         * Return the dirty region attached to this image (nullptr if damage tracking is disabled).
+         */
+        inline TGX_INLINE DirtyRegion* dirtyRegion() const { return _dirty; }
+
+
+        /**
+         * Mark a box of the image as dirty (clipped to the image). Does nothing if damage tracking is
+         * disabled. 
+         *
+         * @param   B   The box to mark. 
+         */
+        inline TGX_INLINE void markDirty(const iBox2& B) { _damage(B); }
+
+
+        /**
+         * Mark the whole image as dirty. Does nothing if damage tracking is disabled.
+         */
+        inline TGX_INLINE void markDirty() { _damage(imageBox()); }
+
+
+
     ///@}
     //*************************************************************************************************************
     //*************************************************************************************************************
@@ -450,7 +510,7 @@ namespace tgx
          * @param   pos         position.
          * @param   color       color to set.
          */
-        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixel(iVec2 pos, color_t color) { if ((CHECKRANGE) && (!isValid())) return; _drawPixel<CHECKRANGE>(pos, color); }
+        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixel(iVec2 pos, color_t color) { if ((CHECKRANGE) && (!isValid())) return; _damage(iBox2(pos)); _drawPixel<CHECKRANGE>(pos, color); }
 
 
         /**
@@ -462,7 +522,7 @@ namespace tgx
          * @param   pos     position given as a floating point value vector.  
          * @param   color   color to set.
          */
-        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixelf(fVec2 pos, color_t color) { if ((CHECKRANGE) && (!isValid())) return; _drawPixel<CHECKRANGE>({ (int32_t)roundf(pos.x) , (int32_t)roundf(pos.y) }, color); }
+        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixelf(fVec2 pos, color_t color) { drawPixel<CHECKRANGE>(iVec2((int32_t)roundf(pos.x), (int32_t)roundf(pos.y)), color); }
 
 
         /**
@@ -476,7 +536,7 @@ namespace tgx
          * @param   opacity     opacity multiplier from 0.0f (fully transparent) to 1.0f fully transparent.
          *                      if negative, then simple overwriting of color is used instead of blending.
          */
-        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixel(iVec2 pos, color_t color, float opacity) { if ((CHECKRANGE) && (!isValid())) return; _drawPixel<CHECKRANGE,true>(pos, color, opacity); }
+        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixel(iVec2 pos, color_t color, float opacity) { if ((CHECKRANGE) && (!isValid())) return; _damage(iBox2(pos)); _drawPixel<CHECKRANGE,true>(pos, color, opacity); }
         
         
         /**
@@ -492,7 +552,7 @@ namespace tgx
          * @param   opacity     opacity multiplier from 0.0f (fully transparent) to 1.0f fully transparent.
          *                      if negative, then simple overwriting of color is used instead of blending.
          */
-        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixelf(fVec2 pos, color_t color, float opacity) { if ((CHECKRANGE) && (!isValid())) return; _drawPixel<CHECKRANGE, true>({ (int32_t)roundf(pos.x) , (int32_t)roundf(pos.y) }, color, opacity); }
+        template<bool CHECKRANGE = true> TGX_INLINE inline void drawPixelf(fVec2 pos, color_t color, float opacity) { drawPixel<CHECKRANGE>(iVec2((int32_t)roundf(pos.x), (int32_t)roundf(pos.y)), color, opacity); }
 
 
         /**
@@ -3666,6 +3726,32 @@ private:
 
 
 
+        /***************************************
+        * DAMAGE TRACKING
+        ****************************************/
+
+        inline TGX_INLINE void _damage(const iBox2& B) { if (_dirty) _addDamage(B); } // record a box (integer coordinates)
+        inline TGX_INLINE void _damage(float minx, float maxx, float miny, float maxy, float margin) { if (_dirty) _addDamage(minx - margin, maxx + margin, miny - margin, maxy + margin); } // record a box (floating point coordinates + margin)
+        inline TGX_INLINE void _damage(const fBox2& B, float margin) { if (_dirty) _addDamage(B.minX - margin, B.maxX + margin, B.minY - margin, B.maxY + margin); } 
+        inline TGX_INLINE void _damage(fVec2 center, float rx, float ry, float margin) { if (_dirty) _addDamage(center.x - rx - margin, center.x + rx + margin, center.y - ry - margin, center.y + ry + margin); }
+        template<typename T> inline TGX_INLINE void _damage(int nbpoints, const Vec2<T>* tabPoints, float margin) { if (_dirty) _addDamagePoints(nbpoints, tabPoints, margin); } // record the bounding box of a list of points + margin
+        template<typename T> inline TGX_INLINE void _damage(Vec2<T> P1, Vec2<T> P2, float margin) { if (_dirty) _addDamage((float)min(P1.x, P2.x) - margin, (float)max(P1.x, P2.x) + margin, (float)min(P1.y, P2.y) - margin, (float)max(P1.y, P2.y) + margin); }
+        template<typename T> inline TGX_INLINE void _damage(Vec2<T> P1, Vec2<T> P2, Vec2<T> P3, float margin) { if (_dirty) { const Vec2<T> P[3] = { P1, P2, P3 }; _addDamagePoints(3, P, margin); } }
+        template<typename T> inline TGX_INLINE void _damage(Vec2<T> P1, Vec2<T> P2, Vec2<T> P3, Vec2<T> P4, float margin) { if (_dirty) { const Vec2<T> P[4] = { P1, P2, P3, P4 }; _addDamagePoints(4, P, margin); } }
+        template<typename color_t_src> inline TGX_INLINE void _damageScaledRotated(const Image<color_t_src>& src_im, fVec2 anchor_src, fVec2 anchor_dst, float scale) // record the disk swept by a scaled/rotated sprite
+            {
+            if (!_dirty) return;
+            const float dx = max(anchor_src.x, src_im.lx() - anchor_src.x), dy = max(anchor_src.y, src_im.ly() - anchor_src.y);
+            const float r = fabsf(scale) * sqrtf(dx * dx + dy * dy);
+            _addDamage(anchor_dst.x - r - 2, anchor_dst.x + r + 2, anchor_dst.y - r - 2, anchor_dst.y + r + 2);
+            }
+
+        void _addDamage(iBox2 B);
+        void _addDamage(float minx, float maxx, float miny, float maxy);
+        template<typename T> void _addDamagePoints(int nbpoints, const Vec2<T>* tabPoints, float margin);
+        static float _endPathMargin(EndPath e, float w) { const int k = (e == END_STRAIGHT) ? 0 : (e % 100); return (k + 1) * w + 2; } // extent of an end path around the end point.
+
+
         /***************************************
         * DRAWING LINES
         ****************************************/
@@ -3877,13 +3963,14 @@ private:
 
         /************************************************************************************************************
         *
-        * Image members variables (16 bytes).
+        * Image members variables (20 bytes).
         *
         *************************************************************************************************************/
 
         color_t* _buffer;       // pointer to the pixel buffer  - nullptr if the image is invalid.
         int     _lx, _ly;       // image size  - (0,0) if the image is invalid
         int     _stride;        // image stride - 0 if the image is invalid
+        DirtyRegion* _dirty;    // damage tracking - nullptr if disabled
 
 
     };
@@ -230,6 +230,7 @@ namespace tgx
         wrap.pImg = (void*)this;
         wrap.pos = topleft;
         wrap.opacity = opacity;
+        _damage(iBox2(topleft.x, topleft.x + png.getWidth() - 1, topleft.y, topleft.y + png.getHeight() - 1));
         return png.decode((void*)(&wrap), 0);
         }
 
@@ -248,6 +249,12 @@ namespace tgx
             if (((y >= 0) && (y < im->height())) && (x < im->width())) _pngdec_color_convert<PNGDraw_T, RGB565>(skip, im->width() - x, pDraw, im->data() + x + (y * im->stride()), pWrapper->opacity);
             break;
             }
+            case id_color_type<RGB565BE>::value:
+            {
+            Image<RGB565BE>* im = (Image<RGB565BE>*)pWrapper->pImg;
+            if (((y >= 0) && (y < im->height())) && (x < im->width())) _pngdec_color_convert<PNGDraw_T, RGB565BE>(skip, im->width() - x, pDraw, im->data() + x + (y * im->stride()), pWrapper->opacity);
+            break;
+            }
             case id_color_type<RGB24>::value:
             {
             Image<RGB24>* im = (Image<RGB24>*)pWrapper->pImg;
@@ -333,6 +340,7 @@ namespace tgx
     template<typename JPEG_T> TGX_NOINLINE int Image<color_t>::JPEGDecode(JPEG_T& jpeg, iVec2 topleft, int options, float opacity)
         {
         const int TGX_RGB565_LITTLE_ENDIAN = 0;     //  taken from JPEGDEC.h
+        const int TGX_RGB565_BIG_ENDIAN = 1;        //
         const int TGX_RGB8888 = 2;                  //        
 
         if (!isValid()) return 1000; // nothing to draw
@@ -344,7 +352,8 @@ namespace tgx
         wrap.pos = topleft;
         wrap.opacity = opacity;
         jpeg.setUserPointer((void*)(&wrap));
-        jpeg.setPixelType((wrap.imgType == id_color_type<RGB565>::value) ? TGX_RGB565_LITTLE_ENDIAN : TGX_RGB8888);
+        jpeg.setPixelType((wrap.imgType == id_color_type<RGB565>::value) ? TGX_RGB565_LITTLE_ENDIAN : ((wrap.imgType == id_color_type<RGB565BE>::value) ? TGX_RGB565_BIG_ENDIAN : TGX_RGB8888));
+        _damage(iBox2(topleft.x, topleft.x + jpeg.getWidth() - 1, topleft.y, topleft.y + jpeg.getHeight() - 1));
         return jpeg.decode(0, 0, options);
         }
 
@@ -385,8 +394,8 @@ namespace tgx
         }
 
 
-    template<typename JPEGDraw_T>
-    TGX_NOINLINE void _jpegdec_color_convert565(int x, int y, JPEGDraw_T* pDraw, Image<RGB565>* im, float op)
+    template<typename JPEGDraw_T, typename color_t>
+    TGX_NOINLINE void _jpegdec_color_convert565(int x, int y, JPEGDraw_T* pDraw, Image<color_t>* im, float op)
         {
         x += pDraw->x;
         y += pDraw->y;
@@ -409,7 +418,7 @@ namespace tgx
                 {
                 for (int i = 0; i < pDraw->iWidth; i++)
                     {
-                    im->template drawPixel<true>({ x + i, y + j }, RGB565(*(p++)), op);
+                    im->template drawPixel<true>({ x + i, y + j }, color_t(*(p++)), op);
                     }
                 }
             }
@@ -428,6 +437,12 @@ namespace tgx
                 _jpegdec_color_convert565(pWrapper->pos.x, pWrapper->pos.y, pDraw, im, pWrapper->opacity);
                 break;
                 }
+            case id_color_type<RGB565BE>::value:
+                { // decoded directly in big endian order
+                Image<RGB565BE>* im = (Image<RGB565BE>*)pWrapper->pImg;
+                _jpegdec_color_convert565(pWrapper->pos.x, pWrapper->pos.y, pDraw, im, pWrapper->opacity);
+                break;
+                }
             case id_color_type<RGB24>::value:
                 {
                 Image<RGB24>* im = (Image<RGB24>*)pWrapper->pImg;
@@ -515,6 +530,7 @@ namespace tgx
         wrap.pImg = (void*)this;
         wrap.pos = topleft;
         wrap.opacity = opacity;
+        _damage(iBox2(topleft.x, topleft.x + gif.getCanvasWidth() - 1, topleft.y, topleft.y + gif.getCanvasHeight() - 1));
         return gif.playFrame(false, nullptr, (void*)(&wrap));
         }
 
@@ -680,6 +696,7 @@ namespace tgx
         switch (pWrapper->imgType)
             {
             case id_color_type<RGB565>::value: { gif_decode(((Image<RGB565>*)pWrapper->pImg), pDraw); break; }
+            case id_color_type<RGB565BE>::value: { gif_decode(((Image<RGB565BE>*)pWrapper->pImg), pDraw); break; }
             case id_color_type<RGB24>::value: { gif_decode(((Image<RGB24>*)pWrapper->pImg), pDraw); break; }
             case id_color_type<RGB32>::value: { gif_decode(((Image<RGB32>*)pWrapper->pImg), pDraw); break; }
             case id_color_type<RGB64>::value: { gif_decode(((Image<RGB64>*)pWrapper->pImg), pDraw); break; }
@@ -742,13 +759,13 @@ namespace tgx
 
 
     template<typename color_t>
-    Image<color_t>::Image() : _buffer(nullptr), _lx(0), _ly(0), _stride(0)
+    Image<color_t>::Image() : _buffer(nullptr), _lx(0), _ly(0), _stride(0), _dirty(nullptr)
         {
         }
 
 
     template<typename color_t>
-    template<typename T> Image<color_t>::Image(T* buffer, int lx, int ly, int stride) : _buffer((color_t*)buffer), _lx(lx), _ly(ly), _stride(stride < 0 ? lx : stride)
+    template<typename T> Image<color_t>::Image(T* buffer, int lx, int ly, int stride) : _buffer((color_t*)buffer), _lx(lx), _ly(ly), _stride(stride < 0 ? lx : stride), _dirty(nullptr)
         {
         _checkvalid(); // make sure dimension/stride are ok else make the image invalid
         }
@@ -798,6 +815,7 @@ namespace tgx
     template<typename color_t>
     Image<color_t>::Image(const Image<color_t> & im, iBox2 subbox)
         {
+        _dirty = im._dirty; // sub-images share the dirty region of their parent
         if (!im.isValid()) { setInvalid();  return; }       
         subbox &= im.imageBox();
         if (subbox.isEmpty()) { setInvalid(); return; }
@@ -816,6 +834,7 @@ namespace tgx
         _ly = ly;
         _stride = (stride < 0) ? lx : stride;
         _checkvalid(); // make sure dimension/stride are ok else make the image invalid
+        if (_dirty) _dirty->setOrigin(_buffer, imageBox()); // keep tracking the new buffer
         }
 
 
@@ -831,6 +850,65 @@ namespace tgx
 
 
 
+    /************************************************************************************
+    *************************************************************************************
+    *
+    *  DAMAGE TRACKING
+    *
+    *************************************************************************************
+    *************************************************************************************/
+
+
+    template<typename color_t>
+    void Image<color_t>::setDirtyRegion(DirtyRegion* region)
+        {
+        _dirty = region;
+        if (region) region->setOrigin(_buffer, imageBox());
+        }
+
+
+    template<typename color_t>
+    void Image<color_t>::_addDamage(iBox2 B)
+        {
+        B &= imageBox();
+        if (B.isEmpty()) return;
+        const int32_t off = (int32_t)(_buffer - (const color_t*)_dirty->origin());
+        if (off != 0)
+            { // sub-image: move to the coordinates of the tracked image
+            B += iVec2(off % _stride, off / _stride);
+            }
+        _dirty->add(B);
+        }
+
+
+    template<typename color_t>
+    void Image<color_t>::_addDamage(float minx, float maxx, float miny, float maxy)
+        {
+        // clamp before converting to int (the box may be huge or contain NaN)
+        minx = (minx > -1.0f) ? ((minx < (float)_lx) ? minx : (float)_lx) : -1.0f;
+        maxx = (maxx > -1.0f) ? ((maxx < (float)_lx) ? maxx : (float)_lx) : -1.0f;
+        miny = (miny > -1.0f) ? ((miny < (float)_ly) ? miny : (float)_ly) : -1.0f;
+        maxy = (maxy > -1.0f) ? ((maxy < (float)_ly) ? maxy : (float)_ly) : -1.0f;
+        _addDamage(iBox2((int)floorf(minx), (int)ceilf(maxx), (int)floorf(miny), (int)ceilf(maxy)));
+        }
+
+
+    template<typename color_t>
+    template<typename T> void Image<color_t>::_addDamagePoints(int nbpoints, const Vec2<T>* tabPoints, float margin)
+        {
+        if ((nbpoints <= 0) || (tabPoints == nullptr)) return;
+        T minx = tabPoints[0].x, maxx = tabPoints[0].x, miny = tabPoints[0].y, maxy = tabPoints[0].y;
+        for (int i = 1; i < nbpoints; i++)
+            {
+            minx = min(minx, tabPoints[i].x); maxx = max(maxx, tabPoints[i].x);
+            miny = min(miny, tabPoints[i].y); maxy = max(maxy, tabPoints[i].y);
+            }
+        _addDamage((float)minx - margin, (float)maxx + margin, (float)miny - margin, (float)maxy + margin);
+        }
+
+
+
+
     /************************************************************************************
     *************************************************************************************
     *
@@ -904,6 +982,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::blit(const Image<color_t>& sprite, iVec2 upperleftpos, float opacity)
         {
+        _damage(iBox2(upperleftpos.x, upperleftpos.x + sprite.lx() - 1, upperleftpos.y, upperleftpos.y + sprite.ly() - 1));
         if ((opacity < 0) || (opacity > 1))
             _blit(sprite, upperleftpos.x, upperleftpos.y, 0, 0, sprite.lx(), sprite.ly());
         else
@@ -915,6 +994,7 @@ namespace tgx
     template<typename color_t_src, typename BLEND_OPERATOR>
     void Image<color_t>::blit(const Image<color_t_src>& sprite, iVec2 upperleftpos, const BLEND_OPERATOR& blend_op)
         {
+        _damage(iBox2(upperleftpos.x, upperleftpos.x + sprite.lx() - 1, upperleftpos.y, upperleftpos.y + sprite.ly() - 1));
         _blit<color_t_src,BLEND_OPERATOR>(sprite, upperleftpos.x, upperleftpos.y, 0, 0, sprite.lx(), sprite.ly(), blend_op);
         }
 
@@ -922,6 +1002,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::blitMasked(const Image<color_t>& sprite, color_t transparent_color, iVec2 upperleftpos, float opacity)
         {
+        _damage(iBox2(upperleftpos.x, upperleftpos.x + sprite.lx() - 1, upperleftpos.y, upperleftpos.y + sprite.ly() - 1));
         _blitMasked(sprite, transparent_color, upperleftpos.x, upperleftpos.y, 0, 0, sprite.lx(), sprite.ly(), opacity);
         }
 
@@ -929,6 +1010,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::blitBackward(Image<color_t>& dst_sprite, iVec2 upperleftpos) const
         {
+        dst_sprite.markDirty();
         dst_sprite._blit(*this, 0, 0, upperleftpos.x, upperleftpos.y, dst_sprite.lx(), dst_sprite.ly());
         }
 
@@ -937,6 +1019,7 @@ namespace tgx
     template<typename color_t_src, int CACHE_SIZE>
     void Image<color_t>::blitScaledRotated(const Image<color_t_src> src_im, fVec2 anchor_src, fVec2 anchor_dst, float scale, float angle_degrees, float opacity)
         {
+        _damageScaledRotated(src_im, anchor_src, anchor_dst, scale);
         if ((opacity < 0) || (opacity > 1))
             _blitScaledRotated<color_t_src, CACHE_SIZE, false, false, false>(src_im, color_t_src(), anchor_src, anchor_dst, scale, angle_degrees, 1.0f, [](color_t_src cola, color_t colb) {return colb; });
         else
@@ -948,6 +1031,7 @@ namespace tgx
     template<typename color_t_src, typename BLEND_OPERATOR, int CACHE_SIZE>
     void Image<color_t>::blitScaledRotated(const Image<color_t_src>& src_im, fVec2 anchor_src, fVec2 anchor_dst, float scale, float angle_degrees, const BLEND_OPERATOR& blend_op)
         {
+        _damageScaledRotated(src_im, anchor_src, anchor_dst, scale);
         _blitScaledRotated<color_t_src, CACHE_SIZE, true, false, true>(src_im, color_t_src(), anchor_src, anchor_dst, scale, angle_degrees, 1.0f, blend_op);
         }
 
@@ -956,6 +1040,7 @@ namespace tgx
     template<typename color_t_src, int CACHE_SIZE>
     void Image<color_t>::blitScaledRotatedMasked(const Image<color_t_src>& src_im, color_t_src transparent_color, fVec2 anchor_src, fVec2 anchor_dst, float scale, float angle_degrees, float opacity)
         {
+        _damageScaledRotated(src_im, anchor_src, anchor_dst, scale);
         _blitScaledRotated<color_t_src, CACHE_SIZE, true, true, false>(src_im, transparent_color, anchor_src, anchor_dst, scale, angle_degrees, ((opacity < 0.0f) || (opacity > 1.0f)) ? 1.0f : opacity, [](color_t_src cola, color_t colb) {return colb; });
         }
 
@@ -973,11 +1058,12 @@ namespace tgx
     template<typename color_t>
     inline void Image<color_t>::_fast_memset(color_t* p_dest, color_t color, int32_t len)
         {       
-        if(std::is_same <color_t, RGB565>::value) // optimized away at compile time
-            { // optimized code for RGB565.         
+        if((std::is_same <color_t, RGB565>::value) || (std::is_same <color_t, RGB565BE>::value)) // optimized away at compile time
+            { // optimized code for RGB565 and RGB565BE.         
             if (len <= 0) return;
             uint16_t* pdest = (uint16_t*)p_dest;                // recasting
-            const uint16_t col = (uint16_t)((RGB565)color);     // conversion to RGB565 does nothing but prevent compiler error when color_t is not RGB565
+            const uint16_t c16 = (uint16_t)((RGB565)color);     // conversion to RGB565 does nothing but prevent compiler error when color_t is not RGB565
+            const uint16_t col = (std::is_same <color_t, RGB565BE>::value) ? BigEndian16(c16) : c16; // back to raw big endian value for RGB565BE
             // ! We assume here that pdest is already aligned mod 2 (it should be) ! 
             if (((intptr_t)pdest) & 3)
                 {
@@ -1221,6 +1307,8 @@ namespace tgx
     void Image<color_t>::blitRotated(const Image<color_t> & sprite, iVec2 upperleftpos, int angle, float opacity)
         {
         if ((!sprite.isValid()) || (!isValid())) return; 
+        const bool swapxy = ((angle == 90) || (angle == 270));
+        _damage(iBox2(upperleftpos.x, upperleftpos.x + (swapxy ? sprite.ly() : sprite.lx()) - 1, upperleftpos.y, upperleftpos.y + (swapxy ? sprite.lx() : sprite.ly()) - 1));
         switch (angle)
             {
             case 0: 
@@ -1247,6 +1335,8 @@ namespace tgx
     void Image<color_t>::blitRotated(const Image<color_t_src>& sprite, iVec2 upperleftpos, int angle, const BLEND_OPERATOR& blend_op)
         {
         if ((!sprite.isValid()) || (!isValid())) return; 
+        const bool swapxy = ((angle == 90) || (angle == 270));
+        _damage(iBox2(upperleftpos.x, upperleftpos.x + (swapxy ? sprite.ly() : sprite.lx()) - 1, upperleftpos.y, upperleftpos.y + (swapxy ? sprite.lx() : sprite.ly()) - 1));
         switch (angle)
             {
             case 0: 
@@ -1461,6 +1551,9 @@ namespace tgx
     Image<color_t> Image<color_t>::copyReduceHalf(const Image<color_t>& src_image)
         {
         if ((!isValid())||(!src_image.isValid())) { return Image<color_t>(); }
+        const int dlx = max(src_image._lx >> 1, 1), dly = max(src_image._ly >> 1, 1); // size of the reduced image
+        if ((_lx < dlx) || (_ly < dly)) { return Image<color_t>(); }
+        _damage(iBox2(0, dlx - 1, 0, dly - 1));
         if (src_image._lx == 1)
             { 
             if (src_image._ly == 1)
@@ -1468,7 +1561,6 @@ namespace tgx
                 _buffer[0] = src_image._buffer[0];
                 return Image<color_t>(*this, iBox2(0, 0, 0, 0));
                 }
-            if (_ly < (src_image._ly >> 1)) { return Image<color_t>(); }
             const color_t * p_src = src_image._buffer;
             color_t * p_dest = _buffer;
             int ny = (src_image._ly >> 1); 
@@ -1482,7 +1574,6 @@ namespace tgx
             }
         if (src_image._ly == 1)
             {
-            if (_lx < (src_image._lx >> 1)) { return Image<color_t>(); }
             const color_t * p_src = src_image._buffer;
             color_t * p_dest = _buffer;
             int nx = (src_image._lx >> 1);
@@ -1495,7 +1586,6 @@ namespace tgx
             return Image<color_t>(*this, iBox2(0, (src_image._lx >> 1) - 1, 0, 0));
             }
         // source image dimension is strictly larger than 1 in each directions.
-        if ((_lx < (src_image._lx >> 1)) || (_ly < (src_image._ly >> 1))) { return Image<color_t>(); }
         const int32_t ny = (int32_t)(src_image._ly >> 1);
         for(int32_t j=0; j < ny; j++)
             {
@@ -1581,6 +1671,7 @@ namespace tgx
     template<typename src_color_t> 
     void Image<color_t>::copyFrom(const Image<src_color_t>& src_im, float opacity)
         {
+        _damage(imageBox());
         if ((!isValid()) || (!src_im.isValid())) return;
         const float ilx = (float)lx();
         const float ily = (float)ly();
@@ -1595,6 +1686,7 @@ namespace tgx
     template<typename src_color_t, typename BLEND_OPERATOR> 
     void Image<color_t>::copyFrom(const Image<src_color_t>& src_im, const BLEND_OPERATOR& blend_op)
         {
+        _damage(imageBox());
         if ((!isValid()) || (!src_im.isValid())) return;
         const float ilx = (float)lx();
         const float ily = (float)ly();
@@ -1616,6 +1708,7 @@ namespace tgx
         const int stride = (_stride == _lx) ? _stride : (_stride * (int)(sizeof(color_t) / sizeof(color_dst)));
         if ((!std::is_same<color_t, color_dst>::value)&&(isValid()))
             {
+            _damage(imageBox());
             color_t* p = _buffer;
             color_dst* q = (color_dst*)_buffer;
             for (int j = 0; j < _ly; j++)
@@ -1687,6 +1780,7 @@ namespace tgx
     template<typename color_t>
     template<int STACK_SIZE> int Image<color_t>::fill(iVec2 start_pos, color_t new_color)
         {
+        _damage(imageBox()); // the filled region is not known in advance
         return _scanfill<true, STACK_SIZE>(start_pos.x, start_pos.y, new_color, new_color);
         }
 
@@ -1694,6 +1788,7 @@ namespace tgx
     template<typename color_t>
     template<int STACK_SIZE > int Image<color_t>::fill(iVec2 start_pos, color_t border_color, color_t new_color)
         {
+        _damage(imageBox()); // the filled region is not known in advance
         return _scanfill<false, STACK_SIZE>(start_pos.x, start_pos.y, border_color, new_color);
         }
 
@@ -2774,6 +2869,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawFastVLine(iVec2 pos, int h, color_t color, float opacity)
         {
+        _damage(iBox2(pos.x, pos.x, pos.y, pos.y + h - 1));
         if (!isValid()) return;
         _drawFastVLine<true>(pos, h, color, opacity);
         }
@@ -2782,6 +2878,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawFastHLine(iVec2 pos, int w, color_t color, float opacity)
         {
+        _damage(iBox2(pos.x, pos.x + w - 1, pos.y, pos.y));
         if (!isValid()) return;
         _drawFastHLine<true>(pos, w, color, opacity);
         }
@@ -2887,6 +2984,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawLine(iVec2 P1, iVec2 P2, color_t color, float opacity)
         {
+        _damage(P1, P2, 0);
         if (!isValid()) return;
         _drawSeg(P1, true, P2, true, color, opacity);
         }
@@ -2896,6 +2994,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawSegment(iVec2 P1, bool drawP1, iVec2 P2, bool drawP2, color_t color, float opacity)
         {
+        _damage(P1, P2, 0);
         if (!isValid()) return;
         _drawSeg(P1, drawP1, P2, drawP2, color, opacity);
         }
@@ -2915,6 +3014,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawLineAA(fVec2 P1, fVec2 P2, color_t color, float opacity)
         {
+        _damage(P1, P2, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         int32_t op = (int32_t)(256 * opacity);
@@ -2938,6 +3038,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::_drawEnd(float distAB, fVec2 A, fVec2 B, BSeg& segAB, BSeg& segBA, BSeg& segAP, BSeg& segBQ, EndPath end, int w, color_t color, float opacity)
         {
+        _damage(A, B, _endPathMargin(end, distAB));
         const int op = (int)(opacity * 256);
         if (end < END_STRAIGHT) return;
         if (end == END_STRAIGHT)
@@ -2996,6 +3097,7 @@ namespace tgx
             tgx::swap(end_P1, end_P2);
             }
         if (line_width_P2 <= 0) return; 
+        _damage(P1, P2, max(_endPathMargin(end_P1, line_width_P1), _endPathMargin(end_P2, line_width_P2)));
         const int op = (int)(opacity * 256);
         if (line_width_P1 <= 1)
             { // draw triangle: here line_width_P1 <= 1
@@ -3150,6 +3252,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawRect(const iBox2& B, color_t color, float opacity)
         {
+        _damage(B);
         if (!isValid()) return;
         const int x = B.minX;
         const int y = B.minY;
@@ -3168,6 +3271,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRect(const iBox2 & B, color_t color, float opacity)
         {
+        _damage(B);
         if (!isValid()) return;
         _fillRect(B, color, opacity);
         }
@@ -3177,6 +3281,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawThickRect(const iBox2& B, int thickness, color_t color, float opacity)
         {
+        _damage(B);
         if (B.isEmpty() || (!isValid()) ||(thickness < 1)) return;        
         int r = tgx::min(B.lx(), B.ly()) / 2; 
         if (r <= 1) { fillRect(B, color, opacity); return; }
@@ -3192,6 +3297,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillThickRect(const iBox2& B, int thickness, color_t color_interior, color_t color_border, float opacity)
         {
+        _damage(B);
         if (B.isEmpty() || (!isValid()) || (thickness < 1)) return;
         int r = tgx::min(B.lx(), B.ly()) / 2;
         if (r <= 1) { fillRect(B, color_interior, opacity); return; }
@@ -3256,6 +3362,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRectHGradient(iBox2 B, color_t color1, color_t color2, float opacity)
         {
+        _damage(B);
         if (!isValid()) return;
         B &= imageBox();
         if (B.isEmpty()) return;        
@@ -3307,6 +3414,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRectVGradient(iBox2 B, color_t color1, color_t color2, float opacity)
         {
+        _damage(B);
         if (!isValid()) return;
         B &= imageBox();
         if (B.isEmpty()) return;
@@ -3362,6 +3470,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRectAA(const fBox2& B, color_t color, float opacity)
         {
+        _damage(B, 2);
         if ((!isValid()) || (B.isEmpty())) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _fillSmoothRect(B, color, opacity);
@@ -3394,6 +3503,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawRoundRect(const iBox2& B, int r, color_t color, float opacity)
         {
+        _damage(B);
         const int x = B.minX;
         const int y = B.minY;
         const int w = B.lx();
@@ -3425,6 +3535,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRoundRect(const iBox2& B, int r, color_t color, float opacity)
         {
+        _damage(B);
         const int x = B.minX;
         const int y = B.minY;
         const int w = B.lx();
@@ -3452,6 +3563,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawRoundRectAA(const fBox2& B, float corner_radius, color_t color, float opacity)
         {
+        _damage(B, 2);
         if ((!isValid()) || (B.isEmpty())) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _drawSmoothRoundRect(iBox2((int)roundf(B.minX), (int)roundf(B.maxX), (int)roundf(B.minY), (int)roundf(B.maxY)), corner_radius, color, opacity); // cheat, convert to iBox2 for the time being. todo improve this !
@@ -3461,6 +3573,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawThickRoundRectAA(const fBox2& B, float corner_radius, float thickness, color_t color, float opacity)
         {
+        _damage(B, 2);
         if ((!isValid()) || (B.isEmpty())) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         if (corner_radius - thickness < 1) thickness = corner_radius - 1.0f;
@@ -3471,6 +3584,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillRoundRectAA(const fBox2& B, float corner_radius, color_t color, float opacity)
         {
+        _damage(B, 2);
         if ((!isValid()) || (B.isEmpty())) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _fillSmoothRoundedRect(iBox2((int)roundf(B.minX), (int)roundf(B.maxX), (int)roundf(B.minY), (int)roundf(B.maxY)), corner_radius, color, opacity); // cheat, convert to iBox2 for the time being. todo improve this !
@@ -3632,6 +3746,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillThickRoundRectAA(const fBox2& B, float corner_radius, float thickness, color_t color_interior, color_t color_border, float opacity)
         {
+        _damage(B, 2);
         if (corner_radius - thickness < 1) thickness = corner_radius - 1.0f;
         if (thickness < 1)
             {
@@ -3665,6 +3780,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawTriangle(const iVec2& P1, const iVec2& P2, const iVec2& P3, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, 0);
         if (!isValid()) return;
         if ((opacity >= 0.0f)&&(opacity <= 1.0f))
             {
@@ -3691,6 +3807,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillTriangle(const iVec2& P1, const iVec2& P2, const iVec2& P3, color_t interior_color, color_t outline_color, float opacity)
         {
+        _damage(P1, P2, P3, 0);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         const int op = (int)(opacity * 256);
@@ -3712,6 +3829,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawTriangleAA(fVec2 P1, fVec2 P2, fVec2 P3, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         const int op = (int)(opacity * 256);
@@ -3737,6 +3855,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillTriangleAA(fVec2 P1, fVec2 P2, fVec2 P3, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         float a = _triangleAera(P1, P2, P3); // winding direction of the polygon            
@@ -3771,6 +3890,7 @@ namespace tgx
     template<typename color_alt>
     void Image<color_t>::drawGradientTriangle(fVec2 P1, fVec2 P2, fVec2 P3, color_alt colorP1, color_alt colorP2, color_alt colorP3, float opacity)
         {
+        _damage(P1, P2, P3, 1);
         if ((opacity >= 0) && (opacity <= 1))
             {
             _drawGradientTriangle<color_alt, true>(P1, P2, P3, colorP1, colorP2, colorP3, opacity);
@@ -3786,6 +3906,7 @@ namespace tgx
     template<typename color_t_tex>
     void Image<color_t>::drawTexturedTriangle(const Image<color_t_tex>& src_im, fVec2 srcP1, fVec2 srcP2, fVec2 srcP3, fVec2 dstP1, fVec2 dstP2, fVec2 dstP3, float opacity)
         {
+        _damage(dstP1, dstP2, dstP3, 1);
         if ((opacity >= 0) && (opacity <= 1))
             {
             _drawTexturedTriangle<color_t_tex, false, true, false>(src_im, color_t_tex(), srcP1, srcP2, srcP3, dstP1, dstP2, dstP3, color_t_tex(), color_t_tex(), color_t_tex(), opacity);
@@ -3801,6 +3922,7 @@ namespace tgx
     template<typename color_t_tex>
     void Image<color_t>::drawTexturedGradientTriangle(const Image<color_t_tex>& src_im, fVec2 srcP1, fVec2 srcP2, fVec2 srcP3, fVec2 dstP1, fVec2 dstP2, fVec2 dstP3, color_t_tex C1, color_t_tex C2, color_t_tex C3, float opacity)
         {
+        _damage(dstP1, dstP2, dstP3, 1);
         if ((opacity >= 0) && (opacity <= 1))
             {
             _drawTexturedTriangle<color_t_tex, true, true, false>(src_im, color_t_tex(), srcP1, srcP2, srcP3, dstP1, dstP2, dstP3, C1, C2, C3, opacity);
@@ -3816,6 +3938,7 @@ namespace tgx
     template<typename color_t_tex>
     void Image<color_t>::drawTexturedMaskedTriangle(const Image<color_t_tex>& src_im, color_t_tex transparent_color, fVec2 srcP1, fVec2 srcP2, fVec2 srcP3, fVec2 dstP1, fVec2 dstP2, fVec2 dstP3, float opacity)
         {
+        _damage(dstP1, dstP2, dstP3, 1);
         _drawTexturedTriangle<color_t_tex, false, true, true>(src_im, transparent_color, srcP1, srcP2, srcP3, dstP1, dstP2, dstP3, color_t_tex(), color_t_tex(), color_t_tex(), opacity);
         }
 
@@ -3824,6 +3947,7 @@ namespace tgx
     template<typename color_t_tex>
     void Image<color_t>::drawTexturedGradientMaskedTriangle(const Image<color_t_tex>& src_im, color_t_tex transparent_color, fVec2 srcP1, fVec2 srcP2, fVec2 srcP3, fVec2 dstP1, fVec2 dstP2, fVec2 dstP3, color_t_tex C1, color_t_tex C2, color_t_tex C3, float opacity)
         {
+        _damage(dstP1, dstP2, dstP3, 1);
         _drawTexturedTriangle<color_t_tex, true, true, true>(src_im, transparent_color, srcP1, srcP2, srcP3, dstP1, dstP2, dstP3, C1, C2, C3, opacity);
         }
 
@@ -3834,6 +3958,7 @@ namespace tgx
     template<typename color_t_tex, typename BLEND_OPERATOR>
     void Image<color_t>::drawTexturedTriangle(const Image<color_t_tex>& src_im, fVec2 srcP1, fVec2 srcP2, fVec2 srcP3, fVec2 dstP1, fVec2 dstP2, fVec2 dstP3, const BLEND_OPERATOR& blend_op)
         {
+        _damage(dstP1, dstP2, dstP3, 1);
         if ((!isValid()) || (!src_im.isValid())) return;
         const iVec2 texdim = src_im.dim();
         const iVec2 imdim = dim();
@@ -3862,6 +3987,8 @@ namespace tgx
 
         tgx::RasterizerParams<color_t, color_t_tex, float, BLEND_OPERATOR> rparam;
         rparam.im = this;
+        rparam.zbuf = nullptr;
+        rparam.hiz = nullptr;
         rparam.tex = &src_im;
         rparam.p_blend_op = &blend_op;
 
@@ -3898,6 +4025,8 @@ namespace tgx
 
         tgx::RasterizerParams<color_t, color_t, float> rparam;
         rparam.im = this;
+        rparam.zbuf = nullptr;
+        rparam.hiz = nullptr;
         rparam.tex = nullptr;
         rparam.opacity = opacity;
 
@@ -3947,6 +4076,8 @@ namespace tgx
 
         tgx::RasterizerParams<color_t, color_t_tex, float> rparam;
         rparam.im = this;
+        rparam.zbuf = nullptr;
+        rparam.hiz = nullptr;
         rparam.tex = &src_im;
         rparam.opacity = opacity;
         rparam.mask_color = transparent_color;
@@ -4006,6 +4137,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawQuad(iVec2 P1, iVec2 P2, iVec2 P3, iVec2 P4, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, P4, 0);
         if ((opacity >= 0.0f) && (opacity <= 1.0f))
             {
             const int32_t op = (int)(256 * opacity);
@@ -4035,6 +4167,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillQuad(iVec2 P1, iVec2 P2, iVec2 P3, iVec2 P4, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, P4, 0);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         if (((P1.x == P2.x) && (P3.x == P4.x) && (P2.y == P3.y) && (P1.y == P4.y)) || ((P1.x == P4.x) && (P2.x == P3.x) && (P1.y == P2.y) && (P3.y == P4.y)))
@@ -4062,6 +4195,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawQuadAA(fVec2 P1, fVec2 P2, fVec2 P3, fVec2 P4, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, P4, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         int op = (int)(256 * opacity);
@@ -4088,6 +4222,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillQuadAA(fVec2 P1, fVec2 P2, fVec2 P3, fVec2 P4, color_t color, float opacity)
         {
+        _damage(P1, P2, P3, P4, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         if (((P1.x == P2.x) && (P3.x == P4.x) && (P2.y == P3.y) && (P1.y == P4.y)) || ((P1.x == P4.x) && (P2.x == P3.x) && (P1.y == P2.y) && (P3.y == P4.y)))
@@ -4208,7 +4343,9 @@ namespace tgx
         while (1)
             {
             P = Q;
-            if (!next_point(Q))
+            const bool last = !next_point(Q);
+            _damage(P, Q, 0);
+            if (last)
                 { // last point 
                 BSeg seg(P, Q);
                 _bseg_draw(seg, true, true, color, 0, op, true);
@@ -4248,7 +4385,9 @@ namespace tgx
         while (1)
             {
             P = Q;
-            if (!next_point(Q))
+            const bool last = !next_point(Q);
+            _damage(P, Q, 2);
+            if (last)
                 { // last point 
                 BSeg seg(P, Q);
                 _bseg_draw_AA(seg, true, true, color, op, true);
@@ -4322,6 +4461,7 @@ namespace tgx
                 if (!I1.setAsIntersection(I0, P1 + H0, P1 + H1, P2 + H1)) return; //fail
                 if (!J1.setAsIntersection(J0, P1 - H0, P1 - H1, P2 - H1)) return; //fail
                 }          
+            _damage(I0, J0, I1, J1, 2);
             tgx::BSeg J0J1(J0, J1); tgx::BSeg J1J0 = J0J1.get_reverse();
             tgx::BSeg J1I1(J1, I1); tgx::BSeg I1J1 = J1I1.get_reverse();
             tgx::BSeg I1I0(I1, I0); tgx::BSeg I0I1 = I1I0.get_reverse();
@@ -4389,10 +4529,13 @@ namespace tgx
         while (1)
             {
             P = Q;
-            if (!next_point(Q))
+            const bool last = !next_point(Q);
+            _damage(P, Q, 0);
+            if (last)
                 { // last point 
                 auto bsPQ = BSeg(P, Q);
                 _bseg_draw(bsPQ, true, false, color, 0, op, true);
+                _damage(Q, Q0, 0);
                 auto bsQQ0 = BSeg(Q, Q0);
                 _bseg_draw(bsQQ0, true, false, color, 0, op, true);
                 return;
@@ -4441,6 +4584,7 @@ namespace tgx
             }
         if (nb < 3) return;
         C = C * (1.0f / nb);
+        _damage(iBox2(iVec2{ (int32_t)roundf(C.x), (int32_t)roundf(C.y) }));
         _drawPixel<true>(iVec2{ (int32_t)roundf(C.x), (int32_t)roundf(C.y) }, color, opacity);
         fVec2 P0, P1, P2; 
         P1 = fVec2(iP);
@@ -4460,6 +4604,7 @@ namespace tgx
                 next_point(iP);
                 P2 = fVec2(iP);
                 }
+            _damage(P1, P2, C, 1);
             BSeg P1P2(P1, P2); auto P2P1 = P1P2.get_reverse();
             BSeg P2C(P2, C); auto CP2 = P2C.get_reverse();
             BSeg CP1(C, P1); auto P1C = CP1.get_reverse();
@@ -4502,10 +4647,13 @@ namespace tgx
         while (1)
             {
             P = Q;
-            if (!next_point(Q))
+            const bool last = !next_point(Q);
+            _damage(P, Q, 2);
+            if (last)
                 { // last point 
                 auto bsPQ = BSeg(P, Q);
                 _bseg_draw_AA(bsPQ, true, false, color, op, true);
+                _damage(Q, Q0, 2);
                 auto bsQQ0 = BSeg(Q, Q0);
                 _bseg_draw_AA(bsQQ0, true, false, color, op, true);
                 return;
@@ -4575,6 +4723,7 @@ namespace tgx
                 {
                 next_point(P2);
                 }
+            _damage(P1, P2, C, 2);
             BSeg P1P2(P1, P2); auto P2P1 = P1P2.get_reverse();
             BSeg P2C(P2, C); auto CP2 = P2C.get_reverse();
             BSeg CP1(C, P1); auto P1C = CP1.get_reverse();
@@ -4663,6 +4812,7 @@ namespace tgx
             I1 = I2;
             H2 = (P[3] - P[2]).getRotate90().getNormalize_fast() * thickness;
             if (!I2.setAsIntersection(P[1] + H1, P[2] + H1, P[2] + H2, P[3] + H2)) return; //fail
+            _damage(P[0], P[1], I0, I1, 2);
             tgx::BSeg P0P1(P[0], P[1]); tgx::BSeg P1P0 = P0P1.get_reverse();
             tgx::BSeg P1I1(P[1], I1); tgx::BSeg I1P1 = P1I1.get_reverse();
             tgx::BSeg I1I0(I1, I0); tgx::BSeg I0I1 = I1I0.get_reverse();
@@ -4764,6 +4914,8 @@ namespace tgx
             I1 = I2;
             H2 = (P[3] - P[2]).getRotate90().getNormalize_fast() * thickness;
             if (!I2.setAsIntersection(P[1] + H1, P[2] + H1, P[2] + H2, P[3] + H2)) return; //fail
+            _damage(P[0], P[1], I0, I1, 2);
+            _damage(C, I0, I1, 2);
             tgx::BSeg P0P1(P[0], P[1]); tgx::BSeg P1P0 = P0P1.get_reverse();
             tgx::BSeg P1I1(P[1], I1); tgx::BSeg I1P1 = P1I1.get_reverse();
             tgx::BSeg I1I0(I1, I0); tgx::BSeg I0I1 = I1I0.get_reverse();
@@ -4828,6 +4980,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawCircle(iVec2 center, int r, color_t color, float opacity)
         {
+        _damage(iBox2(center.x - r, center.x + r, center.y - r, center.y + r));
         if ((center.x - r >= 0) && (center.x + r < _lx) && (center.y - r >= 0) && (center.y + r < _ly))
             _drawFilledCircle<true, false, false>(center.x, center.y, r, color, color, opacity);
         else
@@ -4838,6 +4991,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillCircle(iVec2 center, int r, color_t interior_color, color_t outline_color, float opacity)
         {
+        _damage(iBox2(center.x - r, center.x + r, center.y - r, center.y + r));
         if ((center.x - r >= 0) && (center.x + r < _lx) && (center.y - r >= 0) && (center.y + r < _ly))
             _drawFilledCircle<true, true, false>(center.x, center.y, r, outline_color, interior_color, opacity);
         else
@@ -5188,6 +5342,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillCircleAA(fVec2 center, float r, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if ((!isValid())||(r<=0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _fillSmoothQuarterCircleInterHPsub(center, r, 0, 1, 1, color, opacity, 0);
@@ -5200,6 +5355,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillCircleSectorAA(fVec2 center, float r, float angle_start, float angle_end, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         const int op = (int)(opacity * 256);
@@ -5362,6 +5518,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawCircleAA(fVec2 center, float r, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if ((!isValid()) || (r <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _drawSmoothQuarterCircleInterHPsub(center, r, 0, 1, 1, color, opacity, 0);
@@ -5374,6 +5531,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawCircleArcAA(fVec2 center, float r, float angle_start, float angle_end, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         //const int op = (int)(opacity * 256);
@@ -5537,6 +5695,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawThickCircleAA(fVec2 center, float r, float thickness, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if ((!isValid()) || (r <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;        
         _drawSmoothThickQuarterCircleInterHPsub(center, r, thickness, 0, 1, 1, color, opacity, 0);
@@ -5549,6 +5708,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawThickCircleArcAA(fVec2 center, float r, float angle_start, float angle_end, float thickness, color_t color, float opacity)
         {
+        _damage(center, r, r, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         //const int op = (int)(opacity * 256);
@@ -5746,6 +5906,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillThickCircleAA(fVec2 center, float r, float thickness, color_t color_interior, color_t color_border, float opacity)
         {
+        _damage(center, r, r, 2);
         if ((!isValid()) || (r <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _fillSmoothThickQuarterCircleInterHPsub(center, r, thickness, 0, 1, 1, color_interior, color_border, opacity, 0);
@@ -5758,6 +5919,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillThickCircleSectorAA(fVec2 center, float r, float angle_start, float angle_end, float thickness, color_t color_interior, color_t color_border, float opacity)
         {
+        _damage(center, r, r, 2);
         if (!isValid()) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         const int op = (int)(opacity * 256);
@@ -5927,6 +6089,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawEllipse(iVec2 center, iVec2 radiuses, color_t color, float opacity)
         {
+        _damage(iBox2(center.x - radiuses.x, center.x + radiuses.x, center.y - radiuses.y, center.y + radiuses.y));
         const int cx = center.x;
         const int cy = center.y;
         const int rx = radiuses.x;
@@ -5941,6 +6104,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillEllipse(iVec2 center, iVec2 radiuses, color_t interior_color, color_t outline_color, float opacity)
         {
+        _damage(iBox2(center.x - radiuses.x, center.x + radiuses.x, center.y - radiuses.y, center.y + radiuses.y));
         const int cx = center.x;
         const int cy = center.y;
         const int rx = radiuses.x;
@@ -6010,6 +6174,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawEllipseAA(fVec2 center, fVec2 radiuses, color_t color, float opacity)
         {
+        _damage(center, radiuses.x, radiuses.y, 2);
         if ((!isValid()) || (radiuses.x <= 0) || (radiuses.y<= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _drawSmoothQuarterEllipse(center, radiuses.x, radiuses.y, 0, 1, 1, color, opacity);
@@ -6077,6 +6242,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawThickEllipseAA(fVec2 center, fVec2 radiuses, float thickness, color_t color, float opacity)
         {
+        _damage(center, radiuses.x, radiuses.y, 2);
         if ((!isValid()) || (radiuses.x <= 0) || (radiuses.y <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _drawSmoothThickQuarterEllipse(center, radiuses.x, radiuses.y, thickness, 0, 1, 1, color, opacity);
@@ -6143,6 +6309,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillEllipseAA(fVec2 center, fVec2 radiuses, color_t color, float opacity)
         {
+        _damage(center, radiuses.x, radiuses.y, 2);
         if ((!isValid()) || (radiuses.x <= 0) || (radiuses.y <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;
         _fillSmoothQuarterEllipse(center, radiuses.x, radiuses.y, 0, 1, 1, color, opacity);
@@ -6218,6 +6385,7 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::fillThickEllipseAA(fVec2 center, fVec2 radiuses, float thickness, color_t color_interior, color_t color_border, float opacity)
         {
+        _damage(center, radiuses.x, radiuses.y, 2);
         if ((!isValid()) || (radiuses.x <= 0) || (radiuses.y <= 0)) return;
         if ((opacity < 0) || (opacity > 1)) opacity = 1.0f;        
         _fillSmoothThickQuarterEllipse(center, radiuses.x, radiuses.y, thickness, 0, 1, 1, color_interior, color_border, opacity);
@@ -6246,12 +6414,14 @@ namespace tgx
     template<typename color_t>
     void Image<color_t>::drawQuadBezier(iVec2 P1, iVec2 P2, iVec2 PC, float wc, bool drawP2, color_t color, float opacity)
         {
+        _damage(P1, P2, PC, 1);
         _drawQuadBezier(P1, P2, PC, wc, drawP2, color, opacity);
         }
 
     template<typename color_t>
     void Image<color_t>::drawCubicBezier(iVec2 P1, iVec2 P2, iVec2 PA, iVec2 PB, bool drawP2, color_t color, float opacity)
         {
+        _damage(P1, P2, PA, PB, 1);
         _drawCubicBezier(P1, P2, PA, PB, drawP2, color, opacity);
         }
 
@@ -6260,6 +6430,7 @@ namespace tgx
     template<int SPLINE_MAX_POINTS>
     void Image<color_t>::drawQuadSpline(int nbpoints, const iVec2 tabPoints[], bool draw_last_point, color_t color, float opacity)
         {
+        _damage(nbpoints, tabPoints, 1);
         _drawQuadSpline<SPLINE_MAX_POINTS>(nbpoints, tabPoints, draw_last_point, color, opacity);
         }
 
@@ -6268,6 +6439,7 @@ namespace tgx
     template<int SPLINE_MAX_POINTS>
     void Image<color_t>::drawCubicSpline(int nbpoints, const iVec2 tabPoints[], bool draw_last_point, color_t color, float opacity)
         {
+        _damage(nbpoints, tabPoints, 1);
         _drawCubicSpline<SPLINE_MAX_POINTS>(nbpoints, tabPoints, draw_last_point, color, opacity);
         }
 
@@ -6276,6 +6448,7 @@ namespace tgx
     template<int SPLINE_MAX_POINTS>
     void Image<color_t>::drawClosedSpline(int nbpoints, const iVec2 tabPoints[], color_t color, float opacity)
         {
+        _damage(nbpoints, tabPoints, 1);
         _drawClosedSpline<SPLINE_MAX_POINTS>(nbpoints, tabPoints, color, opacity);
         }
 
@@ -7656,6 +7829,7 @@ namespace tgx
             {
             sx = _lx - x;
             }
+        _damage(iBox2(x, x + sx - 1, y, y + sy - 1));
         return true;
         }
 
@@ -36,10 +36,41 @@
 #include <stdint.h>
 
 
+/** Maximum number of levels in a MeshLOD chain. */
+#ifndef TGX_MESH_LOD_MAX
+#define TGX_MESH_LOD_MAX 4
+#endif
+
+/** Relative margin by which the projected size must cross a threshold before a MeshLOD changes level. */
+#ifndef TGX_MESH_LOD_HYSTERESIS
+#define TGX_MESH_LOD_HYSTERESIS 0.15f
+#endif
+
+
 namespace tgx
 {
 
     
+    /**
+     * Meshlet cluster of a `Mesh3D`: a group of consecutive chains of the face array with a
+     * bounding sphere and a normal cone used by `Renderer3D::drawMesh()` to reject the whole 
+     * group with a single test.
+     * 
+     * The cluster is back-facing when the camera position E (in model space) satisfies
+     * `dot(center - E, cone_axis) >= cone_cutoff * |center - E| + (1 + cone_cutoff) * radius`.
+     */
+    struct MeshCluster
+        {
+        fVec3 center;           ///< Center of the bounding sphere of the triangles (model space).
+        float radius;           ///< Radius of the bounding sphere.
+        fVec3 cone_axis;        ///< Axis of the cone containing the normals of the triangles (unit vector).
+        float cone_cutoff;      ///< Sine of the half angle of the cone (>= 1 if the normals are too spread out to use the cone).
+        uint16_t face_offset;   ///< Position of the first chain of the cluster in the face array.
+        uint16_t nb_faces;      ///< Number of triangles in the cluster.
+        };
+
+
+
     /**
      * 3D mesh data stucture.
      * 
@@ -149,6 +180,16 @@ namespace tgx
      * 4/6   5/8  7/7
      * 8/7   9/4  5/5
      * ```
+     * 
+     * **Meshlet clusters (optional)**
+     * 
+     * The chains of the face array may be grouped in clusters of a few dozen triangles described 
+     * by the `cluster` array (see `MeshCluster`). Clusters are stored in the order of the face 
+     * array and each one covers the chains from its `face_offset` up to the `face_offset` of the 
+     * next cluster (or up to the end tag for the last one). `Renderer3D::drawMesh()` then rejects 
+     * whole clusters that are outside of the view frustum or back-facing before doing any vertex 
+     * work. Meshes without clusters (`cluster = nullptr`) are drawn as usual. Use the host tool 
+     * `host/mesh_meshlets.cpp` to create the clusters of an existing mesh. 
      */
     template<typename color_t> 
     struct Mesh3D
@@ -183,6 +224,65 @@ namespace tgx
         fBox3 bounding_box;             ///< Object bounding box.
         
         const char* name;               ///< Mesh name, or nullptr
+
+        uint16_t nb_clusters = 0;               ///< Number of meshlet clusters (0 if none, may be omitted in the initializer).
+        const MeshCluster* cluster = nullptr;   ///< Meshlet clusters array (nullptr if none, may be omitted in the initializer).
+        };
+
+
+
+
+    /**
+     * Level of detail (LOD) chain for `Renderer3D::drawMeshLOD()`.
+     * 
+     * Holds several versions of the same object with decreasing triangle counts (level 0 being the 
+     * most detailed). When drawing, the renderer computes the diameter in pixels of the projected 
+     * bounding sphere of the level 0 mesh and picks level `i` while this diameter is at least 
+     * `min_size[i]` pixels (the last level is used below `min_size[nb_levels - 2]`). 
+     * 
+     * To prevent flickering when the object stays around a threshold, the selected level only 
+     * changes when the diameter crosses the threshold by more than `TGX_MESH_LOD_HYSTERESIS` 
+     * (relative): the last selected level is kept in `current`, so the structure must be in RAM 
+     * (one structure per instance of the object drawn). 
+     * 
+     * The host tool `host/mesh_lod.cpp` generates the levels from an existing mesh header. All the 
+     * levels share the material (and texture) of the original mesh. 
+     */
+    template<typename color_t>
+    struct MeshLOD
+        {
+        const Mesh3D<color_t>* level[TGX_MESH_LOD_MAX]; ///< meshes from the most detailed (level 0) to the coarsest.
+        float min_size[TGX_MESH_LOD_MAX];   ///< level i is used while the projected diameter is at least min_size[i] pixels (decreasing, unused for the last level).
+        int nb_levels;                      ///< number of levels (1 to TGX_MESH_LOD_MAX).
+        int current;                        ///< level selected by the last draw (set to -1 initially).
+
+
+        /**
+         * Select the level to draw for a given projected diameter (in pixels) and update `current`.
+         * 
+         * @returns the selected level or -1 if there is no level.
+         */
+        int select(float diameter)
+            {
+            if (nb_levels <= 0) return -1;
+            int k = 0;
+            while ((k < nb_levels - 1) && (diameter < min_size[k])) k++;
+            if ((current >= 0) && (current < nb_levels))
+                { // hysteresis: move from the current level only if the threshold is crossed by a margin
+                int l = current;
+                if (k > current)
+                    {
+                    while ((l < k) && (diameter < min_size[l] * (1.0f - TGX_MESH_LOD_HYSTERESIS))) l++;
+                    }
+                else
+                    {
+                    while ((l > k) && (diameter >= min_size[l - 1] * (1.0f + TGX_MESH_LOD_HYSTERESIS))) l--;
+                    }
+                k = l;
+                }
+            current = k;
+            return k;
+            }
         };
 
 
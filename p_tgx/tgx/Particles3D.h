@@ -0,0 +1,244 @@
+/**
+ * @file Particles3D.h
+ * Particle storage (structure of arrays) drawn as batched sprites by `Renderer3D::drawParticles()`.
+ */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _TGX_PARTICLES3D_H_
+#define _TGX_PARTICLES3D_H_
+
+// only C++, no plain C
+#ifdef __cplusplus
+
+
+#include "Misc.h"
+#include "Vec3.h"
+#include "Color.h"
+#include "Image.h"
+
+#include <stdint.h>
+
+
+namespace tgx
+{
+
+
+    /**
+    * Entry of the screen buffer of a `Particles3D`: a visible particle after the projection pass of
+    * `Renderer3D::drawParticles()`. The user only provides the memory: the fields are managed by
+    * the renderer.
+    */
+    struct ParticleScreenEntry
+        {
+        float w;            ///< depth as stored in the z-buffer before its normalization (larger is closer)
+        float depth;        ///< distance to the camera plane (used by the back to front sort)
+        int16_t x, y;       ///< center of the sprite on the image
+        uint16_t r;         ///< half size of the sprite in pixels (the sprite covers 2r+1 pixels)
+        uint16_t index;     ///< index of the particle
+        };
+
+
+
+    /**
+    * Particles stored as a structure of arrays, for `Renderer3D::drawParticles()`.
+    *
+    * Each attribute of the particles is held in its own array: the positions (mandatory) and,
+    * optionally, the velocities, the remaining lives, the sizes, the colors and the opacities. The
+    * attributes without an array take the default value set with `setSize()`, `setColor()` and
+    * `setOpacity()`. `update()` moves the particles and removes the dead ones, but the application
+    * may also fill and animate the arrays itself (`setNbParticles()`).
+    *
+    * `Renderer3D::drawParticles()` draws every particle as a sprite facing the camera (a billboard)
+    * whose size follows the perspective:
+    * 1. a single pass projects all the particles into the screen buffer and drops the invisible ones.
+    * 2. with PARTICLES_SORT, the visible particles are ordered back to front with a bucket sort on
+    *    their depth, which is what blending needs (the order within a bucket is the index order).
+    * 3. the sprites are drawn with a depth test against the z-buffer but without writing to it:
+    *    particles are hidden by the meshes drawn before them and do not hide each other.
+    *
+    * The sprite is an image whose texels equal to a transparent color are skipped (as with
+    * `Image::blitMasked()`); the other texels are multiplied by the color of the particle and
+    * blended with its opacity. Without sprite, the particles are drawn as discs of their color.
+    *
+    * @remark
+    * 1. No memory allocation is performed: the user provides every array (with `max_particles`
+    *    elements), including the screen buffer and the sort order.
+    * 2. The number of particles is at most 65535.
+    */
+    template<typename color_t> class Particles3D
+        {
+
+        public:
+
+            static constexpr int PARTICLES_SORT = 1;        ///< draw the particles back to front (needed for blending, not for opaque sprites)
+            static constexpr int NB_SORT_BUCKETS = 256;     ///< number of buckets of the depth sort
+
+
+            /**
+            * Constructor. Create an empty particle system.
+            *
+            * @param   position        array for the positions of the particles (in model space).
+            * @param   max_particles   number of elements of each array (at most 65535).
+            * @param   screen          screen buffer used by `Renderer3D::drawParticles()`.
+            * @param   order           array for the draw order (may be nullptr if the particles are never sorted).
+            * @param   sort_mode       PARTICLES_SORT to draw back to front, 0 to draw in the index order.
+            */
+            Particles3D(fVec3* position, int max_particles, ParticleScreenEntry* screen, uint16_t* order = nullptr, int sort_mode = PARTICLES_SORT);
+
+
+            /** Set the array of velocities (model units per unit of time) or nullptr. Used by `update()`. */
+            void setVelocities(fVec3* velocity) { _vel = velocity; }
+
+            /** Set the array of remaining lives (in units of time) or nullptr. Used by `update()`: particles die when their life drops to 0. */
+            void setLives(float* life) { _life = life; }
+
+            /** Set the array of sizes (half width of the sprite in model units) or nullptr to use the default size. */
+            void setSizes(float* size) { _size = size; }
+
+            /** Set the array of colors or nullptr to use the default color. */
+            void setColors(color_t* color) { _color = color; }
+
+            /** Set the array of opacities (0 = transparent, 255 = opaque) or nullptr to use the default opacity. */
+            void setOpacities(uint8_t* opacity) { _opacity = opacity; }
+
+
+            /** Set the default size (half width of the sprite in model units). */
+            void setSize(float size) { _def_size = size; }
+
+            /** Set the default color. */
+            void setColor(color_t color) { _def_color = color; }
+
+            /** Set the default opacity in [0.0f, 1.0f]. */
+            void setOpacity(float opacity) { _def_opacity = (opacity <= 0.0f) ? 0 : ((opacity >= 1.0f) ? 255 : (uint8_t)(opacity * 255.0f + 0.5f)); }
+
+
+            /**
+            * Set the sprite image (or nullptr to draw discs).
+            *
+            * @param   sprite              sprite image, stretched on the 2r+1 pixels of each particle.
+            * @param   transparent_color   texels of this color are not drawn.
+            */
+            void setSprite(const Image<color_t>* sprite, color_t transparent_color) { _sprite = sprite; _transparent = transparent_color; }
+
+
+            /** Set the sort mode: PARTICLES_SORT or 0 (ignored if there is no order array). */
+            void setSortMode(int sort_mode) { _sort_mode = (_order) ? (sort_mode & PARTICLES_SORT) : 0; }
+
+            /** Return the sort mode. */
+            int sortMode() const { return _sort_mode; }
+
+
+            /** Remove all the particles. */
+            void clear() { _nb = 0; }
+
+            /** Return the number of particles. */
+            int nbParticles() const { return _nb; }
+
+            /** Set the number of particles, when the application fills the arrays itself. */
+            void setNbParticles(int nb) { _nb = clamp(nb, 0, _max); }
+
+            /** Return the capacity. */
+            int maxParticles() const { return _max; }
+
+
+            /**
+            * Add a particle. The attributes with an array take the given values (velocity, life) or
+            * the default ones (size, color, opacity).
+            *
+            * @returns the index of the new particle or -1 if the arrays are full.
+            */
+            int spawn(const fVec3& pos, const fVec3& vel = fVec3(0, 0, 0), float life = 1.0f);
+
+
+            /** Remove particle i: the last particle takes its index. */
+            void kill(int i);
+
+
+            /**
+            * Move the particles: the positions by their velocity and the velocities by the
+            * acceleration, over a time step dt. With an array of lives, the lives decrease by dt and
+            * the particles whose life drops to 0 are removed (see `kill()`).
+            */
+            void update(float dt, const fVec3& acceleration = fVec3(0, 0, 0));
+
+
+            /** Position of particle i. */
+            fVec3& position(int i) { return _pos[i]; }
+
+            /** Position of particle i. */
+            const fVec3& position(int i) const { return _pos[i]; }
+
+            /** Size (half width in model units) of particle i. */
+            float size(int i) const { return (_size) ? _size[i] : _def_size; }
+
+            /** Color of particle i. */
+            color_t color(int i) const { return (_color) ? _color[i] : _def_color; }
+
+            /** Opacity (0 to 255) of particle i. */
+            int opacity(int i) const { return (_opacity) ? _opacity[i] : _def_opacity; }
+
+            /** Sprite image (or nullptr). */
+            const Image<color_t>* sprite() const { return _sprite; }
+
+            /** Transparent color of the sprite. */
+            color_t transparentColor() const { return _transparent; }
+
+            /** Entry k of the screen buffer. */
+            ParticleScreenEntry& screen(int k) { return _screen[k]; }
+
+
+            /**
+            * Order the first nb entries of the screen buffer back to front (bucket sort on their
+            * depth). Called by `Renderer3D::drawParticles()` after the projection pass.
+            */
+            void sort(int nb);
+
+
+            /** Return the index in the screen buffer of the entry drawn at position k after `sort()` (k if the particles are not sorted). */
+            int order(int k) const { return (_sort_mode) ? _order[k] : k; }
+
+
+        private:
+
+            fVec3* _pos;                    // positions
+            fVec3* _vel;                    // velocities (or nullptr)
+            float* _life;                   // remaining lives (or nullptr)
+            float* _size;                   // sizes (or nullptr)
+            color_t* _color;                // colors (or nullptr)
+            uint8_t* _opacity;              // opacities (or nullptr)
+            ParticleScreenEntry* _screen;   // screen buffer
+            uint16_t* _order;               // draw order
+            int _max;                       // capacity
+            int _nb;                        // number of particles
+            int _sort_mode;                 // PARTICLES_SORT or 0
+            float _def_size;                // default size
+            color_t _def_color;             // default color
+            uint8_t _def_opacity;           // default opacity
+            const Image<color_t>* _sprite;  // sprite (or nullptr for discs)
+            color_t _transparent;           // transparent color of the sprite
+        };
+
+
+}
+
+
+#include "Particles3D.inl"
+
+
+#endif
+
+#endif
+
+/** end of file */
@@ -0,0 +1,112 @@
+/** @file Particles3D.inl */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+#ifndef _TGX_PARTICLES3D_INL_
+#define _TGX_PARTICLES3D_INL_
+
+
+namespace tgx
+    {
+
+
+    template<typename color_t>
+    Particles3D<color_t>::Particles3D(fVec3* position, int max_particles, ParticleScreenEntry* screen, uint16_t* order, int sort_mode)
+        : _pos(position), _vel(nullptr), _life(nullptr), _size(nullptr), _color(nullptr), _opacity(nullptr), _screen(screen), _order(order), _nb(0),
+          _def_size(0.05f), _def_color(RGB32_White), _def_opacity(255), _sprite(nullptr), _transparent(RGB32_Black)
+        {
+        _max = ((position) && (screen)) ? clamp(max_particles, 0, 65535) : 0;
+        setSortMode(sort_mode);
+        }
+
+
+    template<typename color_t>
+    int Particles3D<color_t>::spawn(const fVec3& pos, const fVec3& vel, float life)
+        {
+        if (_nb >= _max) return -1;
+        const int i = _nb++;
+        _pos[i] = pos;
+        if (_vel) _vel[i] = vel;
+        if (_life) _life[i] = life;
+        if (_size) _size[i] = _def_size;
+        if (_color) _color[i] = _def_color;
+        if (_opacity) _opacity[i] = _def_opacity;
+        return i;
+        }
+
+
+    template<typename color_t>
+    void Particles3D<color_t>::kill(int i)
+        {
+        if ((i < 0) || (i >= _nb)) return;
+        const int j = --_nb;
+        if (i == j) return;
+        _pos[i] = _pos[j];
+        if (_vel) _vel[i] = _vel[j];
+        if (_life) _life[i] = _life[j];
+        if (_size) _size[i] = _size[j];
+        if (_color) _color[i] = _color[j];
+        if (_opacity) _opacity[i] = _opacity[j];
+        }
+
+
+    template<typename color_t>
+    void Particles3D<color_t>::update(float dt, const fVec3& acceleration)
+        {
+        if (_vel)
+            {
+            const fVec3 dv = acceleration * dt;
+            for (int i = 0; i < _nb; i++)
+                {
+                _pos[i] += _vel[i] * dt;
+                _vel[i] += dv;
+                }
+            }
+        if (_life)
+            {
+            int i = 0;
+            while (i < _nb)
+                {
+                _life[i] -= dt;
+                if (_life[i] <= 0.0f) kill(i); else i++; // the last particle moved to i is checked next
+                }
+            }
+        }
+
+
+    template<typename color_t>
+    void Particles3D<color_t>::sort(int nb)
+        {
+        if ((_sort_mode == 0) || (nb <= 0)) return;
+        float dmin = _screen[0].depth, dmax = dmin;
+        for (int k = 1; k < nb; k++)
+            {
+            const float d = _screen[k].depth;
+            if (d < dmin) dmin = d;
+            if (d > dmax) dmax = d;
+            }
+        // counting sort on the bucket of each entry: bucket 0 holds the farthest particles.
+        const float s = (dmax > dmin) ? ((NB_SORT_BUCKETS - 0.01f) / (dmax - dmin)) : 0.0f;
+        uint16_t start[NB_SORT_BUCKETS + 1];
+        memset(start, 0, sizeof(start));
+        for (int k = 0; k < nb; k++) start[1 + (int)((dmax - _screen[k].depth) * s)]++;
+        for (int b = 1; b <= NB_SORT_BUCKETS; b++) start[b] += start[b - 1];
+        for (int k = 0; k < nb; k++) _order[start[(int)((dmax - _screen[k].depth) * s)]++] = (uint16_t)k;
+        }
+
+
+    }
+
+#endif
+
+/** end of file */
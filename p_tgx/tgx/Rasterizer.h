@@ -61,6 +61,7 @@ namespace tgx
     * - Top-left rule to prevent drawing pixels twice. 
     * - Tile rasterization: large viewport can be splitted in multiple sub-images.
     * - templated shader functions so to implement: z-buffer testing, shading, texturing...
+    * - Optional coarse depth test (when `data.hiz` is set): triangles hidden in their whole bounding box are rejected before setup.
     *
     * 
     * @tparam SHADER_FUNCTION     the shader function to call.          
@@ -162,6 +163,18 @@ namespace tgx
         ox -= offset_x;
         oy -= offset_y;
 
+        if ((data.hiz) && (data.zbuf))
+            { // coarse depth test: reject the triangle if it is hidden everywhere in its bounding box (small triangles are not tested).
+            data.hiz->rebind(data.zbuf, data.im->lx(), data.im->ly());
+            data.hiz->test = false;
+            if (sx * sy >= TGX_HIZ_MIN_AREA)
+                {
+                if (data.hiz->triangleHidden(ox, oy, sx, sy, data.wa * V0.w + data.wb, data.wa * V1.w + data.wb, data.wa * V2.w + data.wb)) return;
+                }
+            }
+
+        data.im->markDirty(iBox2(ox, ox + sx - 1, oy, oy + sy - 1)); // damage tracking (no-op if the image has no dirty region)
+
         int32_t dx1 = P1.y - P0.y;
         int32_t dy1 = P0.x - P1.x;
         int32_t dx2 = P2.y - P1.y;
@@ -261,6 +274,29 @@ namespace tgx
         }
 
 
+    /**
+    * Return the box of viewport pixels that `rasterizeTriangle()` may draw for the triangle (V0,V1,V2).
+    * 
+    * The box is computed with the same fixed point arithmetic as the rasterizer so every pixel drawn 
+    * by `rasterizeTriangle(LX, LY, V0, V1, V2, ...)` lies inside it, whatever the offset and size of 
+    * the sub-image. Used to sort triangles into tiles before rasterization. 
+    *
+    * @param LX, LY     Viewport size.
+    * @param V0,V1,V2   Normalized coordinates of the vertices (same as for `rasterizeTriangle()`).
+    */
+    inline iBox2 rasterizeTriangleBox(const int LX, const int LY, const fVec4 & V0, const fVec4 & V1, const fVec4 & V2)
+        {
+        const float mx = (float)(TGX_RASTERIZE_MULT128(LX));
+        const float my = (float)(TGX_RASTERIZE_MULT128(LY));
+        const int32_t x0 = lfloorf(V0.x * mx), x1 = lfloorf(V1.x * mx), x2 = lfloorf(V2.x * mx);
+        const int32_t y0 = lfloorf(V0.y * my), y1 = lfloorf(V1.y * my), y2 = lfloorf(V2.y * my);
+        return iBox2((min(min(x0, x1), x2) + TGX_RASTERIZE_MULT128(LX)) / TGX_RASTERIZE_SUBPIXEL256,
+                     (max(max(x0, x1), x2) + TGX_RASTERIZE_MULT128(LX)) / TGX_RASTERIZE_SUBPIXEL256,
+                     (min(min(y0, y1), y2) + TGX_RASTERIZE_MULT128(LY)) / TGX_RASTERIZE_SUBPIXEL256,
+                     (max(max(y0, y1), y2) + TGX_RASTERIZE_MULT128(LY)) / TGX_RASTERIZE_SUBPIXEL256);
+        }
+
+
 
 }
 
@@ -0,0 +1,149 @@
+/** @file RenderQueue3D.inl */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+#ifndef _TGX_RENDERQUEUE3D_INL_
+#define _TGX_RENDERQUEUE3D_INL_
+
+
+namespace tgx
+    {
+
+
+    namespace tgx_internals
+        {
+
+        /** mix a 32 bit value into a hash */
+        inline uint32_t queueHash(uint32_t h, uint32_t v)
+            {
+            h ^= v + 0x9E3779B9 + (h << 6) + (h >> 2);
+            return h;
+            }
+
+        /** bits of a float for hashing */
+        inline uint32_t queueFloatBits(float f)
+            {
+            union { float f; uint32_t u; } c;
+            c.f = f;
+            return c.u;
+            }
+
+        /**
+        * state key of a queue item: shading and texturing flags in the high bits, then the specular
+        * exponent, then a hash of the material (or of the mesh when it uses its own material).
+        */
+        inline uint32_t queueKey(int shaders, int exponent, uint32_t material)
+            {
+            const uint32_t s = (((uint32_t)shaders) >> 5) & 0x3FF; // GOURAUD ... TEXTURE_CLAMP
+            return (s << 22) | (((uint32_t)clamp(exponent, 0, 127)) << 15) | ((material ^ (material >> 15) ^ (material >> 30)) & 0x7FFF);
+            }
+
+        }
+
+
+    template<typename color_t>
+    RenderQueue3D<color_t>::RenderQueue3D(RenderItem<color_t>* items, uint16_t* order, int max_items, int sort_mode) : _items(items), _order(order), _nb_items(0)
+        {
+        _max_items = ((items) && (order)) ? clamp(max_items, 0, 65535) : 0;
+        setSortMode(sort_mode);
+        }
+
+
+    template<typename color_t>
+    int RenderQueue3D<color_t>::submit(const Mesh3D<color_t>* mesh, const fMat4& M, int shaders, bool draw_chained_meshes)
+        {
+        if ((mesh == nullptr) || (_nb_items >= _max_items)) return -1;
+        RenderItem<color_t>& I = _items[_nb_items];
+        I.model = M;
+        I.mesh = mesh;
+        I.color = mesh->color;
+        I.ambiant_strength = mesh->ambiant_strength;
+        I.diffuse_strength = mesh->diffuse_strength;
+        I.specular_strength = mesh->specular_strength;
+        I.specular_exponent = mesh->specular_exponent;
+        I.shaders = shaders;
+        I.depth = 0.0f;
+        I.flags = RenderItem<color_t>::QUEUE_MESH_MATERIAL | ((draw_chained_meshes) ? RenderItem<color_t>::QUEUE_CHAINED : 0);
+        const uintptr_t p = (uintptr_t)mesh;
+        I.key = tgx_internals::queueKey(shaders, mesh->specular_exponent, tgx_internals::queueHash((uint32_t)p, (uint32_t)(((uint64_t)p) >> 32)));
+        return _nb_items++;
+        }
+
+
+    template<typename color_t>
+    int RenderQueue3D<color_t>::submit(const Mesh3D<color_t>* mesh, const fMat4& M, int shaders, RGBf color, float ambiantStrength, float diffuseStrength, float specularStrength, int specularExponent, bool draw_chained_meshes)
+        {
+        if ((mesh == nullptr) || (_nb_items >= _max_items)) return -1;
+        RenderItem<color_t>& I = _items[_nb_items];
+        I.model = M;
+        I.mesh = mesh;
+        I.color = color;
+        I.ambiant_strength = ambiantStrength;
+        I.diffuse_strength = diffuseStrength;
+        I.specular_strength = specularStrength;
+        I.specular_exponent = specularExponent;
+        I.shaders = shaders;
+        I.depth = 0.0f;
+        I.flags = ((draw_chained_meshes) ? RenderItem<color_t>::QUEUE_CHAINED : 0);
+        uint32_t h = tgx_internals::queueFloatBits(color.R);
+        h = tgx_internals::queueHash(h, tgx_internals::queueFloatBits(color.G));
+        h = tgx_internals::queueHash(h, tgx_internals::queueFloatBits(color.B));
+        h = tgx_internals::queueHash(h, tgx_internals::queueFloatBits(ambiantStrength));
+        h = tgx_internals::queueHash(h, tgx_internals::queueFloatBits(diffuseStrength));
+        h = tgx_internals::queueHash(h, tgx_internals::queueFloatBits(specularStrength));
+        I.key = tgx_internals::queueKey(shaders, specularExponent, h);
+        return _nb_items++;
+        }
+
+
+    template<typename color_t>
+    bool RenderQueue3D<color_t>::_before(int a, int b) const
+        {
+        const RenderItem<color_t>& A = _items[a];
+        const RenderItem<color_t>& B = _items[b];
+        if ((_sort_mode & QUEUE_SORT_STATE) && (A.key != B.key)) return (A.key < B.key);
+        if ((_sort_mode & QUEUE_SORT_DEPTH) && (A.depth != B.depth)) return (A.depth < B.depth);
+        return (a < b); // keep the submission order otherwise
+        }
+
+
+    template<typename color_t>
+    void RenderQueue3D<color_t>::sort()
+        {
+        for (int k = 0; k < _nb_items; k++) _order[k] = (uint16_t)k;
+        if (_sort_mode == 0) return;
+        // shell sort: no allocation and no recursion.
+        static const int gaps[] = { 701, 301, 132, 57, 23, 10, 4, 1 };
+        for (int g = 0; g < (int)(sizeof(gaps) / sizeof(gaps[0])); g++)
+            {
+            const int gap = gaps[g];
+            for (int i = gap; i < _nb_items; i++)
+                {
+                const uint16_t v = _order[i];
+                int j = i;
+                while ((j >= gap) && (_before(v, _order[j - gap])))
+                    {
+                    _order[j] = _order[j - gap];
+                    j -= gap;
+                    }
+                _order[j] = v;
+                }
+            }
+        }
+
+
+    }
+
+#endif
+
+/** end of file */
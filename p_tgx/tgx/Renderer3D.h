@@ -36,9 +36,14 @@
 #include "Image.h"
 
 #include "Shaders.h"
+#include "VertexBatch.h"
 #include "Rasterizer.h"
 
 #include "Mesh3D.h"
+#include "Scene3D.h"
+#include "RenderQueue3D.h"
+#include "Particles3D.h"
+#include "SphereMesh3D.h"
 
 
 
@@ -59,6 +64,109 @@ namespace tgx
 
 
 
+    /**
+    * Entry of the post-transform vertex cache used by `Renderer3D::drawMesh()` (see `Renderer3D::setVertexCache()`).
+    *
+    * Holds the transformed and lit version of a mesh vertex for the current drawing call. The 
+    * user only provides the memory: the fields are managed by the renderer.
+    */
+    struct VertexCacheEntry
+        {
+        uint16_t draw_id;       ///< drawing call that filled the entry (entry is free if different from the current one)
+        uint16_t index;         ///< index of the vertex in the mesh
+        uint16_t indn;          ///< index of the normal used to compute color (if flags has VCACHE_COLOR)
+        uint8_t flags;          ///< VCACHE_xxx flags
+        uint8_t outcode;        ///< clipping outcode of the projected vertex
+        fVec4 P;                ///< position after the model-view transform
+        fVec4 Q;                ///< projected position (after the perspective divide)
+        RGBf color;             ///< lit color (Gouraud shading)
+
+        static constexpr uint8_t VCACHE_PROJ = 1;       ///< Q and outcode are valid
+        static constexpr uint8_t VCACHE_COLOR = 2;      ///< color is valid
+        static constexpr uint8_t VCACHE_FLIPPED = 4;    ///< color was computed with the normal reversed
+        };
+
+
+
+    /**
+    * Entry of the triangle sort buffer used by `Renderer3D::drawMesh()` (see `Renderer3D::setTriangleSortBuffer()`).
+    *
+    * Holds a visible triangle of the current mesh between the culling pass and the front to back (or
+    * back to front) rasterization pass. The user only provides the memory: the fields are managed by
+    * the renderer.
+    */
+    struct TriangleSortEntry
+        {
+        uint16_t key;           ///< depth key (smaller is drawn first)
+        uint16_t rank;          ///< scratch for the radix sort
+        uint16_t order;         ///< the k-th entry holds the index of the k-th triangle to draw
+        uint16_t perm;          ///< positions of the first two vertices of the strip order among the three stored vertices, and clipping flag
+        uint16_t indv[3];       ///< vertex indices
+        uint16_t indt[3];       ///< texture coords indices
+        uint16_t indn[3];       ///< normal indices
+        };
+
+
+
+    /**
+    * Octahedral quantization of a direction, as used by the normal lighting table of `Renderer3D`
+    * (see `Renderer3D::setNormalLUT()`).
+    *
+    * The unit sphere is mapped onto an octahedron which is unfolded into a square of 2^bits x 2^bits
+    * cells (`bits` in [1, 8], i.e. up to an 8+8 bit code).
+    *
+    * @param   N       direction (does not need to be normalized).
+    * @param   bits    number of bits per axis.
+    *
+    * @returns the index of the cell containing the direction, in [0, 4^bits).
+    */
+    TGX_INLINE inline int octahedralIndex(const fVec3& N, const int bits)
+        {
+        const float ax = fabsf(N.x);
+        const float ay = fabsf(N.y);
+        const float az = fabsf(N.z);
+        const float s = ax + ay + az;
+        if (!(s > 0.0f)) return 0; // degenerate
+        const float h = (float)(1 << (bits - 1));
+        const float is = h / s; // single division: the projection on the octahedron and the scaling to cells
+        float u = N.x * is, v = N.y * is;
+        if (N.z < 0)
+            { // fold the lower half
+            u = copysignf(h - ay * is, N.x);
+            v = copysignf(h - ax * is, N.y);
+            }
+        const int n = (1 << bits) - 1;
+        int iu = (int)(u + h); if (iu > n) iu = n; if (iu < 0) iu = 0;
+        int iv = (int)(v + h); if (iv > n) iv = n; if (iv < 0) iv = 0;
+        return iu + (iv << bits);
+        }
+
+
+    /**
+    * Center direction (normalized) of a cell of the octahedral quantization. See `octahedralIndex()`.
+    */
+    inline fVec3 octahedralDirection(const int index, const int bits)
+        {
+        const float ih = 1.0f / (float)(1 << (bits - 1));
+        const int n = (1 << bits) - 1;
+        float u = ((index & n) + 0.5f) * ih - 1.0f;
+        float v = ((index >> bits) + 0.5f) * ih - 1.0f;
+        const float au = (u < 0) ? -u : u;
+        const float av = (v < 0) ? -v : v;
+        const float z = 1.0f - au - av;
+        if (z < 0)
+            { // unfold the lower half
+            const float fu = 1.0f - av, fv = 1.0f - au;
+            u = (u >= 0) ? fu : -fu;
+            v = (v >= 0) ? fv : -fv;
+            }
+        fVec3 D(u, v, z);
+        D.normalize();
+        return D;
+        }
+
+
+
     /**
     * Class for drawing 3D objects onto a `Image` [**MAIN CLASS FOR THE 3D API**].
     *
@@ -77,6 +185,7 @@ namespace tgx
     *                               - `SHADER_NOTEXTURE`: enable rendering without texturing
     *                               - `SHADER_TEXTURE_NEAREST`: enable rendering with texturing using point sampling
     *                               - `SHADER_TEXTURE_BILINEAR`: enable rendering with texturing using bilinear sampling
+    *                               - `SHADER_TEXTURE_SUBDIV`: enable perspective correct texturing with span subdivision (in addition to the exact one)
     *                               - `SHADER_TEXTURE_WRAP_POW2`: texture can use 'wrap around' mode with dimensions of texture being power of two.
     *                               - `SHADER_TEXTURE_CLAMP`: texture can use 'clamping to edge' mode. 
     *
@@ -90,6 +199,8 @@ namespace tgx
     *    if the Renderer3D object state is not valid (e.g. incorrect image size, enabled but missing z-buffer...) then the operation
     *    will fails silently. In particular, if drawing without a Z-buffer is performed, the flag `SHADER_NOZBUFFER` **must** be set
     *    in LOADED_SHADERS. Similarly, if drawing without texturing is performed, the flag `SHADER_NOTEXTURE` **must** be set in LOADED_SHADERS.
+    *    Only the shader variants allowed by LOADED_SHADERS are compiled: they are stored in a dispatch table generated at compile time
+    *    and the variant to use is looked up once per drawing call (not per triangle).
     *
     * 2. Z-buffer testing is enabled as soon as a valid z-buffer is provided (with `Renderer3D::setZbuffer()`).
     *    Do not forget to erase the z-buffer with `Renderer3D::clearZbuffer()` at the start of a new frame.
@@ -128,7 +239,7 @@ namespace tgx
         static_assert(TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS,TGX_SHADER_MASK_ZBUFFER), "At least one of the two shaders SHADER_NOZBUFFER or SHADER_ZBUFFER must be enabled");        
         static_assert(TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS,TGX_SHADER_MASK_SHADING), "At least one of the two shaders SHADER_FLAT or SHADER_GOURAUD must be enabled");        
         static_assert(TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS,TGX_SHADER_MASK_TEXTURE), "At least one of the two shaders SHADER_TEXTURE or SHADER_NOTEXTURE must be enabled");                              
-        static_assert((~(TGX_SHADER_HAS_TEXTURE(ENABLED_SHADERS))) || (TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS,TGX_SHADER_MASK_TEXTURE_QUALITY)),"When using texturing, at least one of the two shaders SHADER_TEXTURE_BILINEAR or SHADER_TEXTURE_NEAREST must be enabled");
+        static_assert((~(TGX_SHADER_HAS_TEXTURE(ENABLED_SHADERS))) || (TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS,(SHADER_TEXTURE_BILINEAR | SHADER_TEXTURE_NEAREST))),"When using texturing, at least one of the two shaders SHADER_TEXTURE_BILINEAR or SHADER_TEXTURE_NEAREST must be enabled");
         static_assert((~(TGX_SHADER_HAS_TEXTURE(ENABLED_SHADERS))) || (TGX_SHADER_HAS_ONE_FLAG(ENABLED_SHADERS, TGX_SHADER_MASK_TEXTURE_MODE)), "When using texturing, at least one of the two shaders SHADER_TEXTURE_WRAP_POW2 or SHADER_TEXTURE_CLAMP must be enabled");
 
 
@@ -384,10 +495,245 @@ namespace tgx
         *
         * @remark The z-buffer is intentionally not cleared between draw() calls to enable 
         * rendering of multiple objects on the same scene.
+        * 
+        * @see setZbufferEpochs() to clear the z-buffer only once every few frames.
         */
         void clearZbuffer();
 
 
+        /**
+        * Fill the image with a color and clear the z-buffer.
+        *
+        * Same as `getImage()->fillScreen(color)` followed by `clearZbuffer()` but, when the z-buffer 
+        * must really be cleared, both buffers are cleared in a single pass, by bands of 8 rows.
+        */
+        void clearImageAndZbuffer(color_t color);
+
+
+        /**
+        * Set the number of frames that share a real clear of the z-buffer.
+        *
+        * `clearZbuffer()` writes the whole z-buffer every frame (150KB for a 320x240 uint16_t 
+        * z-buffer). With `nb_epochs > 1`, it only does so once every `nb_epochs` calls. In between, 
+        * it just moves the depth mapping to a new range (epoch) above the ranges of the previous 
+        * frames: the values left in the z-buffer are then farther than anything drawn in the new 
+        * frame and always lose the depth test.
+        *
+        * @param nb_epochs  number of frames per real clear, between 1 (clear every frame, the default) and 256.
+        *
+        * @remark
+        * 1. With a uint16_t z-buffer, each epoch gets `65536/nb_epochs` depth values so this costs 
+        *    log2(nb_epochs) bits of depth precision. With a float z-buffer, the depth of epoch `k` 
+        *    is mapped to [k, k+1], which mostly costs precision for distant objects. 
+        * 2. The z-buffer is cleared for real by the next call to `clearZbuffer()` after changing the 
+        *    number of epochs or the z-buffer, or after the image grows. 
+        * 3. The values stored in the z-buffer depend on the epoch so they should not be used directly. 
+        *    The coarse depth buffer (see `setHiZbuffer()`) is not affected.
+        */
+        void setZbufferEpochs(int nb_epochs);
+
+
+        /**
+        * Set the buffers of the coarse depth buffer (hierarchical z-buffer).
+        *
+        * The coarse depth buffer holds the farthest depth of each block of 8x8 pixels of the z-buffer.
+        * When it is set, `drawMesh()` first tests the bounding box of the mesh against the blocks it
+        * covers and skips the whole mesh if it is hidden. Then each triangle (large enough) is tested
+        * against the blocks covered by its bounding rectangle and rejected before rasterization if it
+        * is hidden in every block. During rasterization, blocks where the triangle is hidden are
+        * skipped instead of being tested pixel by pixel. It speeds up scenes where large occluders
+        * are drawn first.
+        *
+        * @param zmin   buffer of size at least `hiZbufferSize(image.width(), image.height())`.
+        * @param dirty  buffer of the same size (one flag per block).
+        *
+        * @remark
+        * 1. Pass nullptr to disable the coarse depth buffer.
+        * 2. It is updated automatically when the image or the z-buffer changes but the z-buffer must
+        *    only be modified by the renderer (`clearZbuffer()` and the drawing methods).
+        * 3. It is not used by `drawBands()` and `endTiles()`, which use their own z-buffers.
+        * 4. The blocks written are flagged at each span and recomputed when a large triangle is
+        *    tested, so a scene with little occlusion (a single mesh) runs a few percent slower
+        *    with the coarse depth buffer than without.
+        */
+        void setHiZbuffer(ZBUFFER_t* zmin, uint8_t* dirty);
+
+
+        /**
+        * Return the number of blocks of the coarse depth buffer for an image of size lx x ly.
+        */
+        static int hiZbufferSize(int lx, int ly) { return ((lx + 7) >> 3) * ((ly + 7) >> 3); }
+
+
+        /**
+        * Query the statistics of the coarse depth buffer since the last call to `resetHiZStats()`.
+        *
+        * @param[out]   meshes_culled   number of meshes rejected by `drawMesh()` before any transformation (using their bounding box).
+        * @param[out]   tris_tested     number of triangles tested.
+        * @param[out]   tris_culled     number of triangles rejected before rasterization.
+        * @param[out]   blocks_tested   number of 8 pixels block spans tested during rasterization.
+        * @param[out]   blocks_culled   number of 8 pixels block spans skipped during rasterization.
+        */
+        void getHiZStats(uint32_t& meshes_culled, uint32_t& tris_tested, uint32_t& tris_culled, uint32_t& blocks_tested, uint32_t& blocks_culled) const;
+
+
+        /**
+        * Reset the statistics of the coarse depth buffer.
+        */
+        void resetHiZStats();
+
+
+        /**
+        * Set the post-transform vertex cache used by `drawMesh()`.
+        *
+        * Vertices shared between triangles strips (chains) of a mesh are normally transformed, 
+        * projected and lit again in every chain. With a vertex cache, each vertex is processed once 
+        * per drawing call as long as it stays in the cache:
+        * 
+        * - If `size` is at least the number of vertices of the mesh, every vertex has its own entry 
+        *   (full array mode) and is never processed twice.
+        * - Otherwise, the cache is direct-mapped: a vertex uses the entry `index % N` where N is 
+        *   the largest power of two not larger than size, and may be evicted by another vertex.
+        *
+        * Each entry uses `sizeof(VertexCacheEntry)` bytes (52 bytes). The output is identical with 
+        * or without the cache. 
+        *
+        * @param cache  buffer of entries (or nullptr to disable the cache).
+        * @param size   number of entries in the buffer (at most 32768).
+        */
+        void setVertexCache(VertexCacheEntry* cache, int size);
+
+
+        /**
+        * Query the statistics of the vertex cache since the last call to `resetVertexCacheStats()`.
+        *
+        * @param[out]   lookups     number of vertices fetched by `drawMesh()` at the start of a chain or when 
+        *                           a chain moves to a new vertex (vertices reused inside a chain are not counted).
+        * @param[out]   hits        number of those vertices found in the cache (hit rate = hits / lookups).
+        */
+        void getVertexCacheStats(uint32_t& lookups, uint32_t& hits) const;
+
+
+        /**
+        * Reset the statistics of the vertex cache.
+        */
+        void resetVertexCacheStats();
+
+
+        /**
+        * Set the buffer used by the batched vertex stage of `drawMesh()`.
+        *
+        * When a mesh fits in the buffer, `drawMesh()` first transforms and projects all its 
+        * vertices, and lights all its normals (Gouraud shading), in a single pass over the arrays 
+        * of the mesh (using SSE or NEON on hosts that support it, see `TGX_VERTEX_BATCH_SIMD`). The 
+        * results are stored as a structure of arrays and the triangle loop only reads them. 
+        * 
+        * This trades the lazy per triangle computations (vertices used only by culled triangles 
+        * are never projected or lit) for a tight loop without branches that is also easy to 
+        * profile on its own (see `batchTransform()`, `batchProject()` and `batchNormalDots()`). 
+        * The output is identical with or without the batch stage. When set, it replaces the 
+        * vertex cache (see `setVertexCache()`) for the meshes that fit in the buffer. 
+        *
+        * @param buffer     buffer (or nullptr to disable the batch stage).
+        * @param size       number of floats in the buffer. A mesh fits if `vertexBatchBufferSize(mesh->nb_vertices, mesh->nb_normals) <= size`.
+        */
+        void setVertexBatchBuffer(float* buffer, int size);
+
+
+        /**
+        * Return the number of floats needed by the batched vertex stage for a mesh with 
+        * `nb_vertices` vertices and `nb_normals` normals (33 bytes per vertex plus 12 bytes per normal). 
+        */
+        static int vertexBatchBufferSize(int nb_vertices, int nb_normals) { const int n4 = (nb_vertices + 3) & ~3; return 8 * n4 + n4 / 4 + 3 * nb_normals; }
+
+
+        /**
+        * Set the buffer used by the front to back mode and by the painter's mode of `drawMesh()`.
+        *
+        * Meshes are normally rasterized in the order of their face array, so a far triangle is often 
+        * shaded (texture fetch and lighting for every pixel) and then overwritten by a closer one. 
+        * When a mesh has at most `size` triangles and the z-buffer is enabled, `drawMesh()` works in 
+        * two phases instead: it first transforms, culls and projects the triangles and records the 
+        * visible ones with the depth of their closest vertex, then sorts them with a radix sort and 
+        * rasterizes them front to back so that the depth test rejects most hidden pixels before they 
+        * are shaded. Triangles that need clipping are drawn during the first phase.
+        * 
+        * When the z-buffer is disabled (`SHADER_NOZBUFFER`), the same buffer gives a painter's mode 
+        * instead: the triangles (including those that need clipping) are sorted by the distance of their 
+        * center and rasterized back to front, so that a closed mesh is drawn correctly without any depth 
+        * memory (a 26 bytes entry per triangle instead of a z-buffer value per pixel). The order is only 
+        * approximate for long triangles that overlap, and meshes are not sorted against each other: draw 
+        * them back to front (see `RenderQueue3D` with QUEUE_SORT_DEPTH). 
+        * 
+        * Each entry uses `sizeof(TriangleSortEntry)` bytes (26 bytes). The vertices are fetched again 
+        * during the second phase so this mode works best with the vertex cache (see `setVertexCache()`) 
+        * or the batched vertex stage (see `setVertexBatchBuffer()`). The image is the same as without 
+        * sorting except for fragments at exactly the same depth (and, when culling is disabled, the 
+        * lighting of vertices shared by a front and a back facing triangle). It is not used by 
+        * `drawBands()` and the tiled rendering.
+        * 
+        * Use `getFragmentStats()` to measure the overdraw.
+        *
+        * @param buffer     buffer (or nullptr to disable the front to back and painter's modes).
+        * @param size       number of entries in the buffer (at most 65535).
+        */
+        void setTriangleSortBuffer(TriangleSortEntry* buffer, int size);
+
+
+        /**
+        * Query the number of fragments shaded (pixels that passed the depth test and were written) 
+        * since the last call to `resetFragmentStats()`. Divided by the number of pixels covered, it 
+        * gives the overdraw.
+        */
+        uint32_t getFragmentStats() const { return _fragments; }
+
+
+        /**
+        * Reset the counter of shaded fragments.
+        */
+        void resetFragmentStats() { _fragments = 0; }
+
+
+        /**
+        * Set the table used to light meshes from quantized normals.
+        *
+        * Without the table, `drawMesh()` evaluates the Phong model for every lit vertex (Gouraud 
+        * shading) or face (flat shading): dot products with the light and half vectors, a lookup in 
+        * the specular table and the color computations, plus a normalization of the face normal for 
+        * flat shading. With the table, the normal in view space is quantized with an octahedral 
+        * encoding (see `octahedralIndex()`) and its color is read from the table, which holds the 
+        * lighting of the center direction of every cell. The table is only recomputed when the 
+        * light (in view space) or the material changes: a change of model matrix or of the material 
+        * color (e.g. with `drawMeshInstanced()`) does not need a new table.
+        *
+        * The number of bits per axis sets the trade-off between precision and memory (and the 
+        * cost of recomputing the table): the table has 4^bits entries of 12 bytes and a normal is 
+        * at most about 6.5 degrees (5 bits, 12KB), 3.6 degrees (6 bits, 48KB) or 0.9 degree 
+        * (8 bits: an 8+8 code, 768KB) away from the direction it is lit with. 5 or 6 bits are good 
+        * choices for Gouraud shading on a microcontroller (7 and 8 bits do not fit in the RAM of the
+        * RP2040).
+        *
+        * The table is disabled by default and it only helps when the lighting dominates the frame
+        * time: on a microcontroller without floating point unit (the lookup needs one division and
+        * about 15 float operations against about 40 for the Phong model) with meshes whose triangles
+        * are small. With a floating point unit, the division of the quantization costs as much as
+        * the Phong model, so the table is not faster (`host/bench_normal_lut.cpp` on the host: a
+        * few percent faster with 5 or 6 bits, no faster with 8 bits where the table misses the cache).
+        *
+        * @param lut    table with at least `normalLUTSize(bits)` entries (or nullptr to disable it).
+        * @param bits   number of bits per axis of the quantized normals, between 1 and 8.
+        *
+        * @remark The triangles that need clipping are still lit exactly. 
+        */
+        void setNormalLUT(RGBf* lut, int bits);
+
+
+        /**
+        * Return the number of entries of the normal lighting table for a given number of bits per axis.
+        */
+        static int normalLUTSize(int bits) { return 1 << (2 * bits); }
+
+
         /**
         * Set the shaders to use for subsequent drawing operations. 
         * 
@@ -442,6 +788,16 @@ namespace tgx
         * @param quality    Texture quality flag:
         *                   - `SHADER_TEXTURE_NEAREST`:    Use simple point sampling when texturing (fastest method).
         *                   - `SHADER_TEXTURE_BILINEAR`:   Use bilinear interpolation when texturing (slower but higher quality).
+        *
+        *                   Optionally or'ed with:
+        *                   - `SHADER_TEXTURE_SUBDIV`:     With perspective projection, compute the exact perspective division only every
+        *                                                  `TGX_TEXTURE_SUBDIV_SPAN` pixels along each scanline and interpolate the texture
+        *                                                  coordinates linearly (in fixed point) in between. The texture may 'swim'
+        *                                                  slightly on large triangles seen at grazing angles. If the flag is not set, the 
+        *                                                  perspective division is exact for every pixel. This saves the per pixel float
+        *                                                  division so it helps when the division is slow (no FPU) or with bilinear
+        *                                                  filtering. On a MCU with a single precision FPU (e.g. the Cortex-M33 of the
+        *                                                  RP2350), nearest sampling with the exact division is usually as fast or faster.
         */
         void setTextureQuality(Shader quality);
 
@@ -823,6 +1179,147 @@ namespace tgx
         void drawMesh(const Mesh3D<color_t>* mesh, bool use_mesh_material = true, bool draw_chained_meshes = true);
 
 
+        /**
+         * Draw several instances of a Mesh3D object, each one with its own model matrix.
+         * 
+         * Same result as calling `setModelMatrix(matrices[i])` followed by `drawMesh()` for each 
+         * instance but the per mesh setup (material, specular table, shader selection) is done once 
+         * for all the instances and each instance is first tested against the view frustum with a 
+         * cheap world space box test (the box of the mesh is transformed once, without projecting its 
+         * corners) so that off-screen instances cost almost nothing.
+         * 
+         * @param   mesh                The mesh to draw. 
+         * @param   count               Number of instances.
+         * @param   matrices            Model matrices of the instances (array of size count).
+         * @param   colors              Optional colors of the instances (array of size count or `nullptr`). When set, 
+         *                              the color of instance i replaces the object color (of the mesh or of the current 
+         *                              material) for all the meshes drawn for this instance.
+         * @param   use_mesh_material   True (default) to use mesh material, otherwise use the current material instead.
+         * @param   draw_chained_meshes True (default) to draw also the chained meshes, in any.
+         *                              
+         * @remark
+         * - The model matrix of the renderer is restored when the method returns. 
+         * - With chained meshes, all the instances of a mesh are drawn before the next mesh of the chain.
+         * - Instances of a mesh without bounding box are never culled (but `drawMesh()` may still discard them).
+         */
+        void drawMeshInstanced(const Mesh3D<color_t>* mesh, int count, const fMat4* matrices, const RGBf* colors = nullptr, bool use_mesh_material = true, bool draw_chained_meshes = true);
+
+
+        /**
+        * Query the statistics of the meshlet clusters (see `MeshCluster`) since the last call to `resetMeshletStats()`.
+        *
+        * @param[out]   clusters_tested     number of clusters tested by `drawMesh()`.
+        * @param[out]   frustum_culled      number of clusters rejected because their bounding sphere is outside of the frustum.
+        * @param[out]   backface_culled     number of clusters rejected because all their triangles are back-facing.
+        */
+        void getMeshletStats(uint32_t& clusters_tested, uint32_t& frustum_culled, uint32_t& backface_culled) const;
+
+
+        /**
+        * Reset the statistics of the meshlet clusters.
+        */
+        void resetMeshletStats();
+
+
+        /**
+         * Draw the level of a LOD chain that matches the size of the object on the screen.
+         * 
+         * The level is selected with `MeshLOD::select()` from the projected diameter of the bounding 
+         * sphere of the level 0 mesh (see `screenDiameter()`), with hysteresis so that levels do not 
+         * flicker, then drawn with `drawMesh()`.
+         * 
+         * @param   lod                 The LOD chain (its `current` field is updated).
+         * @param   use_mesh_material   True (default) to use the mesh material, otherwise use the current material.
+         * @param   draw_chained_meshes True (default) to draw also the chained meshes of the selected level, in any.
+         *                              
+         * @remark If the level 0 mesh has no bounding box, level 0 is always drawn.
+         */
+        void drawMeshLOD(MeshLOD<color_t>* lod, bool use_mesh_material = true, bool draw_chained_meshes = true);
+
+
+        /**
+         * Return the diameter (in pixels) of the bounding sphere of a box (in model space) once 
+         * projected on the screen with the current model, view and projection matrices. 
+         * 
+         * Returns a huge value if the sphere crosses the plane of the camera. Assumes that the model 
+         * matrix has a uniform scaling.
+         */
+        float screenDiameter(const fBox3& box);
+
+
+        /**
+         * Draw all the visible meshes of a scene.
+         * 
+         * The scene is first brought up to date (see `Scene3D::update()`). Then its bounding volume 
+         * hierarchy is tested against the view frustum: a subtree whose box is outside of the frustum is 
+         * skipped as a whole (none of its meshes, nor their chained meshes, are visited) and the boxes of 
+         * a subtree completely inside of the frustum are not tested anymore. Each remaining mesh is drawn 
+         * with `drawMesh()` using the world transform of its node as model matrix, and the material of 
+         * the node or of the mesh. 
+         * 
+         * @param   scene   The scene to draw.
+         *                              
+         * @remark
+         * - The view matrix, projection, shaders, lighting, z-buffer... are those of the renderer. The model 
+         *   matrix and the material of the renderer are restored when the method returns. 
+         * - The meshes are drawn in the order of the hierarchy, not in the order of the nodes. 
+         * - The frustum planes are computed once per call so, unlike `drawMesh()`, the bounding box of an 
+         *   off-screen mesh is never transformed.
+         */
+        void drawScene(Scene3D<color_t>* scene);
+
+
+        /**
+        * Query the statistics of `drawScene()` since the last call to `resetSceneStats()`.
+        *
+        * @param[out]   boxes_tested    number of boxes (nodes of the hierarchy and meshes) tested against the frustum.
+        * @param[out]   boxes_culled    number of boxes found outside of the frustum.
+        * @param[out]   nodes_drawn     number of scene nodes drawn with `drawMesh()`.
+        */
+        void getSceneStats(uint32_t& boxes_tested, uint32_t& boxes_culled, uint32_t& nodes_drawn) const;
+
+
+        /**
+        * Reset the statistics of `drawScene()`.
+        */
+        void resetSceneStats();
+
+
+        /**
+         * Draw all the items of a render queue.
+         * 
+         * The depth of each item is computed with the current view matrix and the queue is sorted 
+         * according to its sort mode (see `RenderQueue3D`). The items are then drawn with `drawMesh()` 
+         * in this order: `setShaders()` is only called when the shaders of an item differ from those 
+         * of the previous item and `setMaterial()` only when the material differs, so that a queue sorted 
+         * by state changes each state once. 
+         * 
+         * @param   queue   The queue to draw. It is not emptied.
+         *                              
+         * @remark
+         * - The view matrix, projection, lighting, z-buffer... are those of the renderer. The model 
+         *   matrix, the shaders and the material of the renderer are restored when the method returns. 
+         * - Use `getStateStats()` to count the state changes and the rebuilds of the specular table.
+         */
+        void drawQueue(RenderQueue3D<color_t>* queue);
+
+
+        /**
+        * Query the number of state changes since the last call to `resetStateStats()`.
+        *
+        * @param[out]   shader_changes      number of calls to `setShaders()`, `setTextureQuality()` or `setTextureWrappingMode()` that changed the shaders.
+        * @param[out]   material_changes    number of calls to `setMaterial()` (or to one of the `setMaterialXXX()` methods) that changed the material.
+        * @param[out]   specular_rebuilds   number of times the specular power table was rebuilt (on a change of specular exponent between draw calls).
+        */
+        void getStateStats(uint32_t& shader_changes, uint32_t& material_changes, uint32_t& specular_rebuilds) const;
+
+
+        /**
+        * Reset the counters of `getStateStats()`.
+        */
+        void resetStateStats();
+
+
         /**
          * Draw a single triangle.
          * 
@@ -1143,6 +1640,51 @@ namespace tgx
         void drawAdaptativeSphere(const Image<color_t>* texture, float quality = 1.0f);
 
 
+        /**
+         * Set the cache of sphere tessellations used by `drawSphere()` and `drawAdaptativeSphere()`
+         * (see `SphereMeshCache`).
+         *
+         * With a cache, the tessellation of the sphere is built once as a `Mesh3D` and drawn with
+         * `drawMesh()` instead of being recomputed with trigonometric functions at each call. The
+         * image is the same up to the diagonal chosen for each quad of the UV-sphere. The
+         * wireframe spheres do not use the cache.
+         *
+         * @param   cache   the cache, or nullptr to disable it (default).
+         */
+        void setSphereCache(SphereMeshCache<color_t>* cache) { _sphere_cache = cache; }
+
+
+        /**
+         * Draw a list of spheres as impostors: each sphere is rasterized directly as its outline on
+         * the screen, with the depth and normal of every pixel computed analytically.
+         *
+         * No mesh is created: a sphere costs a single projection plus the pixels it covers, whatever
+         * its size, which makes it much faster than `drawSphere()` for molecules, point clouds or
+         * particles made of many small spheres. The depth written in the z-buffer is the depth of the
+         * sphere so impostors intersect correctly with each other and with meshes.
+         *
+         * @remark
+         * - Spheres are lit per pixel with the Phong model of the scene (or with the normal lighting
+         *   table when one is set, see `setNormalLUT()`) whatever the shading mode. Textures are
+         *   ignored.
+         * - Centers are in model space and radii in model units: the model transform should be a
+         *   similarity (a rotation, a translation and a uniform scaling).
+         * - The outline of each sphere (an ellipse away from the center of the screen with a
+         *   perspective projection) is exact: the depth and normal of every pixel come from the
+         *   intersection of its line of sight with the sphere.
+         * - Spheres crossing the near plane are cut by it. Without z-buffer, spheres are drawn in the
+         *   order of the array.
+         * - Impostors are not binned by `beginTiles()`: between `beginTiles()` and `endTiles()`, they
+         *   are drawn immediately into the image with its own z-buffer (see `endTiles()`).
+         *
+         * @param   nb_spheres  number of spheres to draw.
+         * @param   centers     array of centers (in model space).
+         * @param   radii       array of radii (in model space).
+         * @param   colors      array of colors or nullptr to use the material color for every sphere.
+         */
+        void drawSpheres(int nb_spheres, const fVec3* centers, const float* radii, const RGBf* colors = nullptr);
+
+
 
 
 
@@ -1646,6 +2188,209 @@ namespace tgx
         void drawDots(int nb_dots, const fVec3* pos_list, const int* radius_ind, const int* radius, const int* colors_ind, const color_t* colors, const int* opacities_ind, const float* opacities);
 
 
+        /**
+         * Draw a particle system: one sprite facing the camera per particle (see `Particles3D`).
+         *
+         * Unlike `drawDots()`, the particles are processed in batches: a first pass projects all of
+         * them into the screen buffer of the particle system, they are then sorted back to front if
+         * the sort mode of the particle system asks for it, and the sprites are finally drawn in
+         * that order. The size of a sprite follows the perspective (the sizes are in model units).
+         *
+         * @remark
+         * - With a z-buffer, each sprite is tested against the depth of its particle but the
+         *   z-buffer is not written: draw the particles after the opaque meshes.
+         * - Particles are not binned by `beginTiles()`: between `beginTiles()` and `endTiles()`, they
+         *   are drawn immediately, tested against the z-buffer of the image, and the binned meshes
+         *   are drawn over them. Draw them after `endTiles()` instead.
+         * - The scene lightning is ignored.
+         * - The model transform should be a similarity (the sizes are scaled uniformly).
+         *
+         * @param   particles   the particle system to draw.
+         *
+         * @returns the number of particles drawn (the others are outside of the view frustum).
+         */
+        int drawParticles(Particles3D<color_t>* particles);
+
+
+
+
+
+        ///@}
+        /*****************************************************************************************
+        *****************************************************************************************/
+        /**
+         * @name Band rendering
+         *
+         * Methods for rendering the whole viewport as a sequence of horizontal bands, each one
+         * using a small color buffer and z-buffer, instead of full size buffers.
+         */
+        ///@{
+        /*****************************************************************************************
+        ******************************************************************************************/
+
+
+        /**
+         * Set the buffer used to bin the triangles of meshes by band during `drawBands()`.
+         *
+         * The buffer holds one entry for each triangle (plus one per mesh) drawn with `drawMesh()`
+         * during a frame. The return value of `drawBands()` is the number of entries that were
+         * needed. If the buffer is too small (or not set), the triangles that do not fit are still
+         * drawn correctly but they are processed in every band.
+         *
+         * @param   bins    buffer (or nullptr to disable binning).
+         * @param   size    number of entries in the buffer.
+         */
+        void setBinBuffer(uint16_t* bins, int size);
+
+
+        /**
+         * Render the whole viewport as horizontal bands of `band_ly` rows.
+         *
+         * The `draw()` functor issues the draw calls of the scene (e.g. `renderer.drawMesh(...)`). It
+         * is called once for a binning pass where nothing is drawn but where the triangles of each
+         * mesh are transformed, culled and sorted by band, and then once for each band. During the band
+         * passes, drawMesh() only processes the triangles that intersect the current band (lightning,
+         * projection and rasterization) and other drawing methods are simply clipped to the band.
+         *
+         * Each band is drawn in one of the two color buffers (cleared with `background`) with the
+         * `band_zbuf` z-buffer then passed to `flush(const Image<color_t>& band, int y)` where `y` is the
+         * row of the viewport where the band starts. The next band is drawn in the other buffer while
+         * the first one is sent to the screen, so:
+         *
+         * - `flush()` may return before the transfer of `band` is done but it must wait for the
+         *   transfer of the band given in the previous call to complete.
+         * - `flush()` is called one last time with an invalid image, when every band has been drawn:
+         *   it must then wait for the last transfer to complete.
+         *
+         * @param   band_ly     height of the bands (the last band may be smaller).
+         * @param   band_buf1   first color buffer, of size at least `viewport_width * band_ly`.
+         * @param   band_buf2   second color buffer (same size) or nullptr to use a single buffer
+         *                      (then `flush()` must complete the transfer before returning).
+         * @param   band_zbuf   z-buffer of size at least `viewport_width * band_ly` (or nullptr if
+         *                      no depth testing is needed).
+         * @param   background  color used to clear the bands before drawing.
+         * @param   draw        functor `void draw()` that issues the draw calls for the scene.
+         * @param   flush       functor `void flush(const Image<color_t>& band, int y)`.
+         *
+         * @returns the number of bin entries used by the binning pass (see setBinBuffer()).
+         *
+         * @remark
+         * 1. The image, z-buffer and offset of the renderer are ignored during the call and restored
+         *    afterward. The viewport is covered entirely by the bands.
+         * 2. `draw()` must issue exactly the same draw calls, with the same parameters, each time it is
+         *    called during a `drawBands()` call.
+         * 3. Only `drawMesh()` uses the bins. Wireframes, pixels, dots and single triangles/quads
+         *    are redrawn for each band.
+         * 4. Band rendering trades speed for memory. The transformed vertices are not kept between
+         *    the passes (that would take as much memory as the bands save): the binning pass
+         *    transforms every triangle and each band pass reads the bins of every mesh then
+         *    transforms, lights and rasterizes again the triangles of the band, so the triangles
+         *    that straddle several bands are processed several times. For the bunny scene of
+         *    `pgx_bunny.cpp` at 240x320 on the host, it is about 1.5x slower than drawing into full
+         *    size buffers with bands of 16 rows, 1.35x with 32 rows and 1.2x with 64 rows.
+         */
+        template<typename DRAW_FUN, typename FLUSH_FUN>
+        int drawBands(int band_ly, color_t* band_buf1, color_t* band_buf2, ZBUFFER_t* band_zbuf, color_t background, DRAW_FUN draw, FLUSH_FUN flush);
+
+
+
+
+        ///@}
+
+
+
+        /*****************************************************************************************
+        ******************************************************************************************/
+        /**
+         * @name Tile rendering
+         *
+         * Methods for rendering the image tile by tile: the triangles are transformed, lit and
+         * clipped as usual but, instead of being rasterized directly into the image, they are sorted
+         * into per-tile bins. Each tile is then rasterized into a small color buffer and z-buffer and
+         * written back to the image once. The tiles give the same pixels as drawing the triangles
+         * directly with a full size z-buffer.
+         *
+         * Tile rendering replaces the full size z-buffer by the tile buffers and the triangle buffer
+         * so it only saves memory when the scene is small enough: every triangle in view takes
+         * `tileTriangleSize()` bytes (120 bytes on a 32 bits MCU) until `endTiles()`. For example, the
+         * 153600 bytes of a 320x240 16 bits z-buffer hold about 1200 triangles. It is also slower
+         * than direct rendering (around 1.3x to 1.5x for a scene of small triangles on the host):
+         * the triangles crossing several tiles are set up once per tile and the tiles are copied
+         * from and back to the image.
+         */
+        ///@{
+        /*****************************************************************************************
+        ******************************************************************************************/
+
+
+        /**
+         * Set the tile size and the buffers into which each tile is rasterized.
+         *
+         * @param   tile_lx, tile_ly    size of the tiles (e.g. 32x32 or 64x16).
+         * @param   tile_buf            color buffer of size at least `tile_lx * tile_ly`.
+         * @param   tile_zbuf           z-buffer of size at least `tile_lx * tile_ly` (or nullptr if no
+         *                              depth testing is needed).
+         */
+        void setTileBuffers(int tile_lx, int tile_ly, color_t* tile_buf, ZBUFFER_t* tile_zbuf);
+
+
+        /**
+         * Set the buffers that hold the binned triangles between `beginTiles()` and `endTiles()`.
+         *
+         * @param   tri_buf     buffer for the transformed triangles. Each triangle takes
+         *                      `tileTriangleSize()` bytes and at most 65535 triangles are stored.
+         * @param   tri_size    size of `tri_buf` in bytes.
+         * @param   bins        buffer for the per-tile bins: one entry per tile plus one entry for each
+         *                      (triangle, tile) pair. At most 65535 entries are used. If it is too
+         *                      small (or nullptr), every tile scans the whole list of triangles instead.
+         * @param   bins_size   number of entries in `bins`.
+         */
+        void setTriangleBuffer(void* tri_buf, int tri_size, uint16_t* bins, int bins_size);
+
+
+        /**
+         * Return the number of bytes used by each triangle in the buffer set with `setTriangleBuffer()`
+         * (120 bytes on 32 bits platforms, 128 bytes on 64 bits platforms).
+         */
+        static int tileTriangleSize();
+
+
+        /**
+         * Start binning: until `endTiles()` is called, the triangles drawn by `drawMesh()`,
+         * `drawTriangle()`, `drawQuad()`... and their variants are stored in the triangle buffer
+         * instead of being rasterized.
+         *
+         * Does nothing if the image is split into more than 256 tiles horizontally or vertically.
+         */
+        void beginTiles();
+
+
+        /**
+         * Rasterize the triangles binned since `beginTiles()`, tile by tile, and stop binning.
+         *
+         * For each tile covered by at least one triangle, the tile is copied from the image into the
+         * tile color buffer, the tile z-buffer is cleared, the triangles of the tile are rasterized and
+         * the tile is written back to the image. Tiles without triangles are not touched.
+         *
+         * @returns the number of triangles that were binned. If this is larger than
+         *          `tri_size / tileTriangleSize()`, the triangle buffer was too small and the
+         *          extra triangles were dropped.
+         *
+         * @remark
+         * 1. The z-buffer set with `setZbuffer()` is neither read nor written by the binned triangles:
+         *    depth testing only happens between the triangles binned since `beginTiles()`, with the
+         *    tile z-buffer, so the binned triangles are drawn over everything drawn before
+         *    `beginTiles()`.
+         * 2. Wireframes, pixels, dots, sphere impostors (`drawSpheres()`) and particles are not
+         *    binned: they are drawn immediately, with the z-buffer of the image if one is set, and
+         *    therefore end up below the binned triangles.
+         * 3. The projection and the image must not change between `beginTiles()` and `endTiles()`.
+         *    Materials, textures, shaders and model matrices may change as usual.
+         * 4. Tile rendering cannot be used inside `drawBands()`.
+         */
+        int endTiles();
+
+
 
 
 
@@ -1679,14 +2424,106 @@ namespace tgx
         /** Make sure we can perform a drawing operation */
         TGX_INLINE bool _validDraw() const
             {
-            return ((_lx > 0) && (_ly > 0) && (_uni.im != nullptr) && (_uni.im->isValid()));
+            return ((_lx > 0) && (_ly > 0) && (_uni.im != nullptr) && (_uni.im->isValid()) && (_band_pass != BAND_BINNING)); // nothing is drawn during the binning pass of drawBands()
             }
 
 
+        /***********************************************************
+        * Band rendering
+        ************************************************************/
+
+        static constexpr int BAND_OFF = 0;              // normal rendering
+        static constexpr int BAND_BINNING = 1;          // binning pass of drawBands()
+        static constexpr int BAND_RENDER = 2;           // band pass of drawBands()
+
+        static constexpr uint16_t BIN_NONE = 0x00FF;    // bin entry: triangle in no band (culled or discarded)
+        static constexpr uint16_t BIN_ALL = 0xFF00;     // bin entry: triangle in every band (or unknown)
+
+        /** read a bin entry (BIN_ALL if out of the bin buffer) */
+        TGX_INLINE uint16_t _readBin(int pos) const { return ((pos < _bins_size) ? _bins[pos] : BIN_ALL); }
+
+        /** write a bin entry (ignored if out of the bin buffer) */
+        TGX_INLINE void _writeBin(int pos, uint16_t v) { if (pos < _bins_size) _bins[pos] = v; }
+
+        /** true if the bin entry intersects the current band */
+        TGX_INLINE bool _inBand(uint16_t v) const { return ((_band >= (v & 255)) && (_band <= (v >> 8))); }
+
+        /** bin entry for the rows spanned by the normalized y coordinates [ymin, ymax] (with one pixel of margin) */
+        TGX_INLINE uint16_t _binRange(float ymin, float ymax) const
+            {
+            const int lo = clamp((int)floorf((ymin + 1.0f) * _band_scale - _band_margin), 0, _nb_bands - 1);
+            const int hi = clamp((int)floorf((ymax + 1.0f) * _band_scale + _band_margin), 0, _nb_bands - 1);
+            return (uint16_t)(lo | (hi << 8));
+            }
+
+
+        /***********************************************************
+        * Tile rendering
+        ************************************************************/
+
+        /** vertex of a binned triangle: the fields of RasterizerVec4 read by the rasterizer and the 3D shaders */
+        struct TileVertex
+            {
+            float x, y, w;                  // normalized coordinates and w
+            RGBf color;                     // vertex color (Gouraud shading)
+            fVec2 T;                        // texture coords
+            };
+
+        /** triangle stored in the triangle buffer between beginTiles() and endTiles() */
+        struct TileTriangle
+            {
+            TileVertex V[3];                // projected vertices with their varying parameters
+            RGBf facecolor;                 // color for flat shading
+            uint8_t tx0, tx1, ty0, ty1;     // range of tiles covered by the triangle (at most 256 per axis)
+            const Image<color_t>* tex;      // texture
+            ShaderFunction<color_t, ZBUFFER_t> shader_fn; // shader for the triangle
+            };
+
+        /** set the shaders used for the next triangles and look up the corresponding shader in the dispatch table */
+        TGX_INLINE void _setShaderType(int raster_type)
+            {
+            if (_tile_binning)
+                { // binned triangles are rasterized by endTiles() with the tile z-buffer instead of the z-buffer of the image
+                if (_tile_zbuf)
+                    {
+                    TGX_SHADER_ADD_ZBUFFER(raster_type)
+                    TGX_SHADER_REMOVE_NOZBUFFER(raster_type)
+                    }
+                else
+                    {
+                    TGX_SHADER_ADD_NOZBUFFER(raster_type)
+                    TGX_SHADER_REMOVE_ZBUFFER(raster_type)
+                    }
+                }
+            _uni.shader_type = raster_type;
+            _shader_fn = shader_lookup<ENABLED_SHADERS, color_t, ZBUFFER_t>(raster_type);
+            }
+
+        /** rasterize a triangle or, between beginTiles() and endTiles(), store it in the triangle buffer */
+        TGX_INLINE void _rasterizeTriangle(const RasterizerVec4& V1, const RasterizerVec4& V2, const RasterizerVec4& V3)
+            {
+            if (_shader_fn == nullptr) return; // no shader enabled for these flags
+            if (_tile_binning) 
+                _binTriangle(V1, V2, V3);
+            else
+                rasterizeTriangle(_lx, _ly, V1, V2, V3, _ox, _oy, _uni, _shader_fn);
+            }
+
+        /** test the bounding box of a mesh against the coarse depth buffer: return true if the mesh is hidden */
+        TGX_NOINLINE bool _hizCulledBox(const fBox3& bb, const fMat4& M);
+
+        /** store a triangle in the triangle buffer */
+        TGX_NOINLINE void _binTriangle(const RasterizerVec4& V1, const RasterizerVec4& V2, const RasterizerVec4& V3);
+
+
         /** recompute the wa and wa scaling constants. called after every change of the projection matrix or projection mode */
         TGX_NOINLINE void _recompute_wa_wb();
 
 
+        /** start a new epoch of the z-buffer (see setZbufferEpochs()): return true if the z-buffer must be cleared for real */
+        bool _nextZbufferEpoch();
+
+
         /***********************************************************
         * Making sure shader flags are coherent
         ************************************************************/
@@ -1740,10 +2577,110 @@ namespace tgx
             const RGBf& Vcol0, const RGBf& Vcol1, const RGBf& Vcol2, const RGBf& Vcol3);
 
 
+        /** Return true if the box is outside of one of the frustum planes whose bit is set in mask (the bits of the planes the box is inside of are cleared). */
+        TGX_INLINE bool _sceneCulledBox(const fBox3& B, const fVec4* planes, int& mask)
+            {
+            _scene_boxes_tested++;
+            for (int p = 0; p < 6; p++)
+                {
+                if (!(mask & (1 << p))) continue;
+                const fVec4& L = planes[p];
+                const float dmax = L.x * ((L.x > 0) ? B.maxX : B.minX) + L.y * ((L.y > 0) ? B.maxY : B.minY) + L.z * ((L.z > 0) ? B.maxZ : B.minZ) + L.w;
+                if (dmax < 0) { _scene_boxes_culled++; return true; }
+                const float dmin = L.x * ((L.x > 0) ? B.minX : B.maxX) + L.y * ((L.y > 0) ? B.minY : B.maxY) + L.z * ((L.z > 0) ? B.minZ : B.maxZ) + L.w;
+                if (dmin >= 0) mask &= ~(1 << p);
+                }
+            return false;
+            }
+
+
+        /** Return true if the box B, mapped to world space by the affine transform M, is outside of one of the frustum planes (in world space). */
+        TGX_INLINE bool _instanceCulledBox(const fBox3& B, const fMat4& M, const fVec4* planes) const
+            {
+            // world space box around the transformed box: center and half extents (Arvo).
+            const float cx = (B.minX + B.maxX) * 0.5f, cy = (B.minY + B.maxY) * 0.5f, cz = (B.minZ + B.maxZ) * 0.5f;
+            const float ex = (B.maxX - B.minX) * 0.5f, ey = (B.maxY - B.minY) * 0.5f, ez = (B.maxZ - B.minZ) * 0.5f;
+            const fVec4 C = M.mult1(fVec3(cx, cy, cz));
+            const float Ex = fabsf(M.M[0]) * ex + fabsf(M.M[4]) * ey + fabsf(M.M[8]) * ez;
+            const float Ey = fabsf(M.M[1]) * ex + fabsf(M.M[5]) * ey + fabsf(M.M[9]) * ez;
+            const float Ez = fabsf(M.M[2]) * ex + fabsf(M.M[6]) * ey + fabsf(M.M[10]) * ez;
+            for (int p = 0; p < 6; p++)
+                {
+                const fVec4& L = planes[p];
+                if (L.x * C.x + L.y * C.y + L.z * C.z + L.w + fabsf(L.x) * Ex + fabsf(L.y) * Ey + fabsf(L.z) * Ez < 0) return true;
+                }
+            return false;
+            }
+
+
+        /** Compute the 6 frustum planes (same bounds as _discardBox()) in the space mapped to clip space by M: P is inside if dot(plane, (P,1)) >= 0 for all planes. */
+        void _frustumPlanes(const fMat4& M, fVec4* planes) const;
+
+
+        /** Prepare the cluster tests of the current mesh: normalized frustum planes and eye position (or view direction in ortho) in model space, 
+            and the culling direction in model space (0 = no cone test, -1 if the model matrix is a mirror). */
+        void _clusterSetup(fVec4* planes, fVec3& eye, float& cone_dir, const bool ortho) const;
+
+
+        /** Return true if a meshlet cluster is outside of the frustum or entirely back-facing. */
+        TGX_INLINE bool _clusterCulled(const MeshCluster& C, const fVec4* planes, const fVec3& eye, const float cone_dir, const bool ortho)
+            {
+            _meshlet_tested++;
+            for (int p = 0; p < 6; p++)
+                {
+                if (planes[p].x * C.center.x + planes[p].y * C.center.y + planes[p].z * C.center.z + planes[p].w < -C.radius) { _meshlet_frustum_culled++; return true; }
+                }
+            if ((cone_dir == 0) || (C.cone_cutoff >= 1.0f)) return false;
+            if (ortho)
+                { // eye is the view direction
+                if (cone_dir * dotProduct(eye, C.cone_axis) < C.cone_cutoff) return false;
+                }
+            else
+                {
+                const fVec3 D = C.center - eye;
+                if (cone_dir * dotProduct(D, C.cone_axis) < C.cone_cutoff * D.norm() + (1.0f + C.cone_cutoff) * C.radius) return false;
+                }
+            _meshlet_backface_culled++;
+            return true;
+            }
+
+
         /** Method called by drawMesh() which does the actual drawing. */
         void _drawMesh(const int RASTER_TYPE, const Mesh3D<color_t>* mesh);
 
 
+        /** Batched vertex stage of _drawMesh(): transform, project and light the whole mesh (return false if it does not fit in the buffer). */
+        bool _batchMesh(const Mesh3D<color_t>* mesh, const bool gouraud, const bool texture, const bool ortho, const float clipbound_xy);
+
+
+        /** Recompute the normal lighting table if the light or the material changed since it was computed. */
+        void _updateNormalLUT();
+
+
+        /** Color of a vertex or face with normal N (in view space, not necessarily normalized), from the normal lighting table. */
+        template<bool TEXTURE> TGX_INLINE inline RGBf _lutPhong(const fVec3& N) const
+            {
+            RGBf col = _nlut[octahedralIndex(N, _nlut_bits)];
+            if (!(TEXTURE)) col *= _r_objectColor;
+            col.clamp();
+            return col;
+            }
+
+
+        /** Second phase of the front to back / painter's mode of _drawMesh(): sort the nb triangles recorded in the sort buffer and rasterize them. */
+        void _drawSortedTriangles(const int RASTER_TYPE, const Mesh3D<color_t>* mesh, const int nb, const int vmask);
+
+
+        /** Depth key for the sort buffer: smaller for larger w, with the precision of a 16 bit float. */
+        TGX_INLINE static uint16_t _tsortKey(float w)
+            {
+            if (!(w > 0.0f)) return 0xFFFF;
+            union { float f; uint32_t u; } c;
+            c.f = w;
+            return (uint16_t)(0xFFFF - (c.u >> 16));
+            }
+
+
 
         /***********************************************************
         * Drawing wireframe
@@ -1789,10 +2726,11 @@ namespace tgx
             {
             if (CHECKRANGE && ((x < 0) || (x >= _uni.im->lx()) || (y < 0) || (y >= _uni.im->ly()))) return;           
             ZBUFFER_t& W = _uni.zbuf[x + _uni.im->lx() * y];
-            const ZBUFFER_t aa =  (std::is_same<ZBUFFER_t, uint16_t>::value) ? ((ZBUFFER_t)(z * _uni.wa + _uni.wb)) : ((ZBUFFER_t)z);
+            const ZBUFFER_t aa = (ZBUFFER_t)(z * _uni.wa + _uni.wb);
             if (W < aa)
                 {
                 W = aa;
+                if ((_uni.hiz) && (_uni.hiz->zbuf == _uni.zbuf)) _uni.hiz->markDirty(x, x, y);
                 if (USE_BLENDING) _uni.im->template drawPixel<false>({ x, y }, color, opacity); else _uni.im->template drawPixel<false>({ x, y }, color);
                 }
             }
@@ -1824,6 +2762,18 @@ namespace tgx
         template<bool WIREFRAME, bool DRAWFAST> void _drawSphere(int nb_sectors, int nb_stacks, const Image<color_t>* texture, float thickness, color_t color, float opacity);
 
 
+        /** draw a unit sphere mesh of the sphere cache */
+        void _drawSphereMesh(const Mesh3D<color_t>* sphere, const Image<color_t>* texture);
+
+
+        /** Draw the sprite of a projected particle with a depth test but without writing to the z-buffer. */
+        template<bool USE_ZBUFFER, bool USE_SPRITE, bool USE_TINT> void _drawParticle(const ParticleScreenEntry& E, color_t color, int opacity, const Image<color_t>* sprite, color_t transparent);
+
+
+        /** Rasterize the impostor of the sphere with center C and radius r in view space: exact outline, depth and normal of every pixel. */
+        template<bool USE_ZBUFFER, bool ORTHO> void _drawSphereImpostor(const fVec3& C, float r, const RGBf& color);
+
+
 
         /***********************************************************
         * CLIPPING
@@ -2057,12 +3007,13 @@ namespace tgx
         fMat4   _projM;             // projection matrix
 
         RasterizerParams<color_t, color_t,ZBUFFER_t>  _uni; // rasterizer param (contain the image pointer and the zbuffer pointer).
+        ShaderFunction<color_t, ZBUFFER_t> _shader_fn;      // shader for _uni.shader_type, from the dispatch table (set by _setShaderType()).
 
         float _culling_dir;         // culling direction postive/negative or 0 to disable back face culling.
 
         int   _shaders;             // the shaders to use. 
         int   _texture_wrap_mode;   // wrapping mode (wrap_pow2 or clamp)
-        int   _texture_quality;     // texturing quality (nearest or bilinear)
+        int   _texture_quality;     // texturing quality (nearest or bilinear, possibly with subdiv)
 
         // *** scene parameters ***
 
@@ -2098,6 +3049,102 @@ namespace tgx
         RGBf _r_objectColor;        // color to use for drawing the object (either _color or mesh->color).
 
 
+        // *** band rendering ***
+
+        uint16_t* _bins;            // bin buffer: band range of each triangle drawn with drawMesh()
+        int   _bins_size;           // number of entries in the bin buffer
+        int   _bin_pos;             // current position in the bin buffer
+        int   _band_pass;           // BAND_OFF, BAND_BINNING or BAND_RENDER
+        int   _band;                // index of the band being drawn
+        int   _nb_bands;            // number of bands
+        float _band_scale;          // converts a normalized y coordinate + 1 into a band index
+        float _band_margin;         // one pixel in band units
+
+
+        // *** tile rendering ***
+
+        int   _tile_lx, _tile_ly;       // tile size
+        color_t* _tile_buf;             // tile color buffer
+        ZBUFFER_t* _tile_zbuf;          // tile z-buffer
+        TileTriangle* _tile_tris;       // triangle buffer
+        int   _tile_tris_size;          // number of triangles that fit in the triangle buffer
+        uint16_t* _tile_bins;           // per-tile bins
+        int   _tile_bins_size;          // number of entries in the bin buffer
+        int   _tile_nb_tris;            // number of triangles binned since beginTiles()
+        bool  _tile_binning;            // true between beginTiles() and endTiles()
+
+
+        // *** coarse depth buffer ***
+
+        HiZBuffer<ZBUFFER_t> _hiz;      // coarse depth buffer (used when _uni.hiz = &_hiz)
+
+
+        // *** post-transform vertex cache ***
+
+        VertexCacheEntry* _vcache;      // vertex cache (nullptr if disabled)
+        int _vcache_size;               // number of entries
+        int _vcache_mask;               // mask for direct-mapped mode: largest power of two <= _vcache_size, minus one
+        uint16_t _vcache_id;            // id of the current drawing call (stamp of valid entries)
+        uint32_t _vcache_lookups;       // statistics
+        uint32_t _vcache_hits;          //
+
+
+        // *** scene statistics ***
+
+        uint32_t _scene_boxes_tested;   // boxes tested against the frustum by drawScene()
+        uint32_t _scene_boxes_culled;   // boxes outside of the frustum
+        uint32_t _scene_nodes_drawn;    // nodes drawn
+
+
+        // *** state change statistics ***
+
+        uint32_t _state_shader_changes;     // calls that changed the shaders
+        uint32_t _state_material_changes;   // calls that changed the material
+        uint32_t _state_specular_rebuilds;  // rebuilds of the specular power table
+
+
+        // *** meshlet statistics ***
+
+        uint32_t _meshlet_tested;           // clusters tested by drawMesh()
+        uint32_t _meshlet_frustum_culled;   // clusters outside of the frustum
+        uint32_t _meshlet_backface_culled;  // back-facing clusters
+
+
+        // *** front to back mode ***
+
+        TriangleSortEntry* _tsort;      // triangle sort buffer (nullptr if disabled)
+        int _tsort_size;                // number of entries
+        uint32_t _fragments;            // fragments shaded (statistics)
+
+        int _zepochs;                   // number of frames per real clear of the z-buffer
+        int _zepoch;                    // current epoch
+        const ZBUFFER_t* _zepoch_zbuf;  // z-buffer at the last real clear (nullptr to force one)
+        int _zepoch_size;               // number of values zeroed by the last real clear
+
+        RGBf* _nlut;                    // normal lighting table (nullptr if disabled)
+        int _nlut_bits;                 // bits per axis of the quantized normals
+        bool _nlut_valid;               // false if the table must be recomputed
+        float _nlut_key[16];            // light and material used to compute the table
+
+        SphereMeshCache<color_t>* _sphere_cache;    // cache of sphere tessellations (nullptr if disabled)
+
+
+        // *** batched vertex stage ***
+
+        float* _vbatch;                 // buffer of the batch stage (nullptr if disabled)
+        int _vbatch_size;               // number of floats in the buffer
+        const float* _vb_px;            // positions after the model-view transform (nullptr if the current mesh is not batched)
+        const float* _vb_py;            //
+        const float* _vb_pz;            //
+        const float* _vb_pw;            //
+        const float* _vb_qx;            // projected positions
+        const float* _vb_qy;            //
+        const float* _vb_qz;            //
+        const float* _vb_qw;            //
+        const uint8_t* _vb_outcode;     // clipping outcodes
+        const RGBf* _vb_color;          // lit color for each normal (Gouraud shading)
+
+
         /**
         * Vector with additional attributes used by draw() methods.
         * **/
@@ -2106,11 +3153,137 @@ namespace tgx
             fVec4 P;       // after model-view matrix multiplication
             fVec4 N;       // normal vector after model-view matrix multiplication
             bool missedP;  // true if the attributes should be computed
+            bool missedV;  // true if P should be computed
+            int indv;      // index for vertex in array
             int indn;      // index for normal vector in array
             int indt;      // index for texture vector in array
+            int outcode;   // clipping outcode (if the clip test is needed)
+            VertexCacheEntry* cache; // entry of the vertex cache for the vertex (or nullptr)
             };
 
 
+        static constexpr uint16_t TSORT_CLIPPED = 16; // flag in TriangleSortEntry::perm: the triangle needs clipping (painter's mode only)
+
+
+        /** 
+        * Record a triangle in the sort buffer. Front to back mode: key of the closest vertex (largest w). 
+        * Painter's mode: key of the center (largest distance first) which is also valid for triangles that 
+        * need clipping since it only uses the view space positions.
+        */
+        TGX_INLINE static void _tsortRecord(TriangleSortEntry& S, const ExtVec4& QQA, const ExtVec4& QQB, const ExtVec4& QQC, const ExtVec4* PPC0, const ExtVec4* PPC1, const bool painter, const bool clipped, const bool TEXTURE, const bool GOURAUD)
+            {
+            S.key = (painter) ? _tsortKey(-(QQA.P.z + QQB.P.z + QQC.P.z)) : _tsortKey(max(max(QQA.w, QQB.w), QQC.w));
+            S.perm = (uint16_t)(((PPC0 == &QQA) ? 0 : ((PPC0 == &QQB) ? 1 : 2)) | (((PPC1 == &QQA) ? 0 : ((PPC1 == &QQB) ? 1 : 2)) << 2) | ((clipped) ? TSORT_CLIPPED : 0));
+            S.indv[0] = (uint16_t)QQA.indv; S.indv[1] = (uint16_t)QQB.indv; S.indv[2] = (uint16_t)QQC.indv;
+            if (TEXTURE) { S.indt[0] = (uint16_t)QQA.indt; S.indt[1] = (uint16_t)QQB.indt; S.indt[2] = (uint16_t)QQC.indt; }
+            if (GOURAUD) { S.indn[0] = (uint16_t)QQA.indn; S.indn[1] = (uint16_t)QQB.indn; S.indn[2] = (uint16_t)QQC.indn; }
+            }
+
+
+        /** true if the vertex cache entry e holds vertex V in the current drawing call */
+        TGX_INLINE bool _vcacheOwns(const VertexCacheEntry* e, const ExtVec4* V) const 
+            { 
+            return ((e != nullptr) && (e->draw_id == _vcache_id) && (e->index == V->indv)); 
+            }
+
+        /** compute the position of vertex V after the model-view transform, or fetch it from the vertex cache */
+        TGX_INLINE void _fetchVertex(ExtVec4* V, const fVec3* tab_vert, const int vmask)
+            {
+            V->missedV = false;
+            V->cache = nullptr;
+            if (_vb_px)
+                { // batched
+                const int i = V->indv;
+                V->P = fVec4(_vb_px[i], _vb_py[i], _vb_pz[i], _vb_pw[i]);
+                return;
+                }
+            if (_vcache)
+                {
+                VertexCacheEntry* e = _vcache + (V->indv & vmask);
+                V->cache = e;
+                _vcache_lookups++;
+                if (_vcacheOwns(e, V)) 
+                    {
+                    _vcache_hits++;
+                    V->P = e->P;
+                    return;
+                    }
+                V->P = _r_modelViewM.mult1(tab_vert[V->indv]);
+                e->draw_id = _vcache_id; // claim the entry
+                e->index = (uint16_t)V->indv;
+                e->flags = 0;
+                e->P = V->P;
+                return;
+                }
+            V->P = _r_modelViewM.mult1(tab_vert[V->indv]);
+            }
+
+        /** project vertex V (and compute its outcode if needed) or fetch the projection from the vertex cache */
+        TGX_INLINE void _projectVertex(ExtVec4* V, const bool ortho, const bool cliptest, const float clipbound_xy)
+            {
+            if (_vb_px)
+                { // batched
+                const int i = V->indv;
+                V->x = _vb_qx[i]; V->y = _vb_qy[i]; V->z = _vb_qz[i]; V->w = _vb_qw[i];
+                V->outcode = (cliptest) ? _vb_outcode[i] : 0;
+                return;
+                }
+            VertexCacheEntry* e = V->cache;
+            const bool owned = _vcacheOwns(e, V);
+            if ((owned) && (e->flags & VertexCacheEntry::VCACHE_PROJ))
+                {
+                *((fVec4*)V) = e->Q;
+                V->outcode = e->outcode;
+                return;
+                }
+            *((fVec4*)V) = _projM * V->P;
+            if (ortho) { V->w = 1.0f - V->z; } else { V->zdivide(); }
+            V->outcode = 0;
+            if (cliptest)
+                {
+                V->outcode = ((V->P.z >= 0) ? 1 : 0)
+                           | ((V->x < -clipbound_xy) ? 2 : 0) | ((V->x > clipbound_xy) ? 4 : 0)
+                           | ((V->y < -clipbound_xy) ? 8 : 0) | ((V->y > clipbound_xy) ? 16 : 0)
+                           | ((V->z < -1) ? 32 : 0) | ((V->z > 1) ? 64 : 0);
+                }
+            if (owned)
+                {
+                e->Q = *((fVec4*)V);
+                e->outcode = (uint8_t)V->outcode;
+                e->flags |= VertexCacheEntry::VCACHE_PROJ;
+                }
+            }
+
+        /** compute the lit color of vertex V (Gouraud shading) or fetch it from the vertex cache */
+        template<bool TEXTURE> TGX_INLINE void _shadeVertex(ExtVec4* V, const fVec3* tab_norm, const float icu)
+            {
+            if ((_vb_color) && (icu > 0))
+                { // batched (normals are lit with icu = 1)
+                V->color = _vb_color[V->indn];
+                return;
+                }
+            VertexCacheEntry* e = V->cache;
+            const bool owned = _vcacheOwns(e, V);
+            const uint8_t flipped = ((icu < 0) ? VertexCacheEntry::VCACHE_FLIPPED : 0);
+            if ((owned) && (e->flags & VertexCacheEntry::VCACHE_COLOR) && (e->indn == V->indn) && ((e->flags & VertexCacheEntry::VCACHE_FLIPPED) == flipped))
+                {
+                V->color = e->color;
+                return;
+                }
+            V->N = _r_modelViewM.mult0(tab_norm[V->indn]);
+            if (_nlut)
+                V->color = _lutPhong<TEXTURE>((icu > 0) ? V->N : -V->N);
+            else
+                V->color = _phong<TEXTURE>(icu * dotProduct(V->N, _r_light_inorm), icu * dotProduct(V->N, _r_H_inorm));
+            if (owned)
+                {
+                e->color = V->color;
+                e->indn = (uint16_t)V->indn;
+                e->flags = (uint8_t)((e->flags & ~VertexCacheEntry::VCACHE_FLIPPED) | VertexCacheEntry::VCACHE_COLOR | flipped);
+                }
+            }
+
+
     };
 
 
@@ -41,9 +41,72 @@ namespace tgx
             
             _uni.tex = nullptr; 
             _uni.shader_type = 0; 
+            _shader_fn = nullptr;
             _uni.zbuf = nullptr; 
             _uni.facecolor = RGBf(1.0f, 1.0f, 1.0f);
 
+            _bins = nullptr;
+            _bins_size = 0;
+            _bin_pos = 0;
+            _band_pass = BAND_OFF;
+            _band = 0;
+            _nb_bands = 1;
+            _band_scale = 0.0f;
+            _band_margin = 0.0f;
+
+            _tile_lx = 0;
+            _tile_ly = 0;
+            _tile_buf = nullptr;
+            _tile_zbuf = nullptr;
+            _tile_tris = nullptr;
+            _tile_tris_size = 0;
+            _tile_bins = nullptr;
+            _tile_bins_size = 0;
+            _tile_nb_tris = 0;
+            _tile_binning = false;
+            _uni.tile_x = 0;
+
+            _uni.hiz = nullptr;
+            memset(&_hiz, 0, sizeof(_hiz));
+
+            _vcache = nullptr;
+            _vcache_size = 0;
+            _vcache_mask = 0;
+            _vcache_id = 0;
+            _vcache_lookups = 0;
+            _vcache_hits = 0;
+
+            _scene_boxes_tested = 0;
+            _scene_boxes_culled = 0;
+            _scene_nodes_drawn = 0;
+
+            _meshlet_tested = 0;
+            _meshlet_frustum_culled = 0;
+            _meshlet_backface_culled = 0;
+
+            _tsort = nullptr;
+            _tsort_size = 0;
+            _fragments = 0;
+            _uni.fragments = &_fragments;
+
+            _zepochs = 1;
+            _zepoch = 0;
+            _zepoch_zbuf = nullptr;
+            _zepoch_size = 0;
+
+            _nlut = nullptr;
+            _nlut_bits = 1;
+            _nlut_valid = false;
+
+            _sphere_cache = nullptr;
+
+            _vbatch = nullptr;
+            _vbatch_size = 0;
+            _vb_px = _vb_py = _vb_pz = _vb_pw = nullptr;
+            _vb_qx = _vb_qy = _vb_qz = _vb_qw = nullptr;
+            _vb_outcode = nullptr;
+            _vb_color = nullptr;
+
             setViewportSize(viewportSize);
             setImage(im);
             setOffset(0, 0); // no offset
@@ -79,12 +142,15 @@ namespace tgx
             setTextureWrappingMode(SHADER_TEXTURE_CLAMP); // slow but safer (no need to be power of 2)
             setTextureQuality(SHADER_TEXTURE_NEAREST); // dirty but fast
             setZbuffer(zbuffer);
+
+            resetStateStats();
             }
 
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_precomputeSpecularTable2(int exponent)
             {
+            _state_specular_rebuilds++;
             _currentpow = exponent;
             float specularExponent = (float)exponent;
             if (exponent > 0)
@@ -248,21 +314,475 @@ namespace tgx
             static_assert(TGX_SHADER_HAS_ZBUFFER(ENABLED_SHADERS), "shader TGX_SHADER_ZBUFFER must be enabled to use clearZbuffer()");
             if ((_uni.zbuf) && (_uni.im != nullptr) && (_uni.im->isValid()))
                 {
-                memset(_uni.zbuf, 0, _uni.im->lx() * _uni.im->ly() * sizeof(ZBUFFER_t));
+                if (_nextZbufferEpoch()) memset(_uni.zbuf, 0, _uni.im->lx() * _uni.im->ly() * sizeof(ZBUFFER_t));
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::clearImageAndZbuffer(color_t color)
+            {
+            if ((_uni.im == nullptr) || (!_uni.im->isValid())) return;
+            if ((!TGX_SHADER_HAS_ZBUFFER(ENABLED_SHADERS)) || (_uni.zbuf == nullptr) || (!_nextZbufferEpoch()))
+                { // only the image to clear
+                _uni.im->fillScreen(color);
+                return;
+                }
+            // bands of 8 rows of both buffers, each filled with its fast fill method.
+            const int lx = _uni.im->lx();
+            const int ly = _uni.im->ly();
+            for (int y = 0; y < ly; y += 8)
+                {
+                const int h = min(8, ly - y);
+                _uni.im->fillRect(iBox2(0, lx - 1, y, y + h - 1), color);
+                memset(_uni.zbuf + y * lx, 0, h * lx * sizeof(ZBUFFER_t));
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setZbufferEpochs(int nb_epochs)
+            {
+            _zepochs = clamp(nb_epochs, 1, 256);
+            _zepoch = 0;
+            _zepoch_zbuf = nullptr; // next clear is a real one
+            _recompute_wa_wb();
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        bool Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_nextZbufferEpoch()
+            {
+            const int size = _uni.im->lx() * _uni.im->ly();
+            // stale values are from the previous epochs of the current cycle, as long as the image did not grow.
+            const bool full = (_zepoch + 1 >= _zepochs) || (_zepoch_zbuf != _uni.zbuf) || (size > _zepoch_size);
+            if (full)
+                {
+                _zepoch = 0;
+                _zepoch_zbuf = _uni.zbuf;
+                _zepoch_size = size;
+                }
+            else
+                {
+                _zepoch++;
+                }
+            if (_zepochs > 1) _recompute_wa_wb();
+            if (_uni.hiz)
+                { // the block values stay lower bounds of the z-buffer, even with the stale values.
+                _hiz.bind(_uni.zbuf, _uni.im->lx(), _uni.im->ly());
+                _hiz.clear();
+                }
+            return full;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setHiZbuffer(ZBUFFER_t* zmin, uint8_t* dirty)
+            {
+            if ((zmin == nullptr) || (dirty == nullptr))
+                {
+                _uni.hiz = nullptr;
+                return;
+                }
+            _hiz.zmin = zmin;
+            _hiz.dirty = dirty;
+            _hiz.zbuf = nullptr; // bound to the z-buffer on first use
+            _hiz.lx = 0;
+            _hiz.ly = 0;
+            _uni.hiz = &_hiz;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::getHiZStats(uint32_t& meshes_culled, uint32_t& tris_tested, uint32_t& tris_culled, uint32_t& blocks_tested, uint32_t& blocks_culled) const
+            {
+            meshes_culled = _hiz.nb_meshes_culled;
+            tris_tested = _hiz.nb_tris_tested;
+            tris_culled = _hiz.nb_tris_culled;
+            blocks_tested = _hiz.nb_blocks_tested;
+            blocks_culled = _hiz.nb_blocks_culled;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::resetHiZStats()
+            {
+            _hiz.nb_meshes_culled = 0;
+            _hiz.nb_tris_tested = 0;
+            _hiz.nb_tris_culled = 0;
+            _hiz.nb_blocks_tested = 0;
+            _hiz.nb_blocks_culled = 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setVertexCache(VertexCacheEntry* cache, int size)
+            {
+            if ((cache == nullptr) || (size <= 0))
+                {
+                _vcache = nullptr;
+                _vcache_size = 0;
+                _vcache_mask = 0;
+                return;
+                }
+            if (size > 32768) size = 32768;
+            _vcache = cache;
+            _vcache_size = size;
+            _vcache_mask = 1;
+            while (2 * _vcache_mask <= size) _vcache_mask *= 2;
+            _vcache_mask--;
+            for (int i = 0; i < size; i++) _vcache[i].draw_id = 0;
+            _vcache_id = 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::getVertexCacheStats(uint32_t& lookups, uint32_t& hits) const
+            {
+            lookups = _vcache_lookups;
+            hits = _vcache_hits;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::resetVertexCacheStats()
+            {
+            _vcache_lookups = 0;
+            _vcache_hits = 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setVertexBatchBuffer(float* buffer, int size)
+            {
+            _vbatch = buffer;
+            _vbatch_size = (buffer) ? max(size, 0) : 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setTriangleSortBuffer(TriangleSortEntry* buffer, int size)
+            {
+            _tsort = buffer;
+            _tsort_size = (buffer) ? clamp(size, 0, 65535) : 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setNormalLUT(RGBf* lut, int bits)
+            {
+            _nlut = lut;
+            _nlut_bits = clamp(bits, 1, 8);
+            _nlut_valid = false;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_updateNormalLUT()
+            {
+            // the table does not depend on the object color: it is applied (with the clamping) at lookup.
+            const float key[16] = { _r_light.x, _r_light.y, _r_light.z, _r_H.x, _r_H.y, _r_H.z,
+                                    _r_ambiantColor.R, _r_ambiantColor.G, _r_ambiantColor.B,
+                                    _r_diffuseColor.R, _r_diffuseColor.G, _r_diffuseColor.B,
+                                    _r_specularColor.R, _r_specularColor.G, _r_specularColor.B, (float)_currentpow };
+            if ((_nlut_valid) && (memcmp(key, _nlut_key, sizeof(key)) == 0)) return;
+            memcpy(_nlut_key, key, sizeof(key));
+            _nlut_valid = true;
+            const int nb = normalLUTSize(_nlut_bits);
+            for (int i = 0; i < nb; i++)
+                {
+                const fVec3 D = octahedralDirection(i, _nlut_bits);
+                RGBf col = _r_ambiantColor;
+                col += _r_diffuseColor * max(dotProduct(D, _r_light), 0.0f);
+                col += _r_specularColor * _powSpecular(dotProduct(D, _r_H));
+                _nlut[i] = col;
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        bool Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_hizCulledBox(const fBox3& bb, const fMat4& M)
+            {
+            if ((_uni.zbuf == nullptr) || ((bb.minX == 0) && (bb.maxX == 0) && (bb.minY == 0) && (bb.maxY == 0) && (bb.minZ == 0) && (bb.maxZ == 0))) return false; // no depth test or no bounding box
+            _hiz.rebind(_uni.zbuf, _uni.im->lx(), _uni.im->ly());
+
+            // project the corners of the box (which is entirely inside the clipping bounds). The mesh 
+            // projects inside their bounding rectangle and its depth is at most their largest depth.
+            float xmin = 2, xmax = -2, ymin = 2, ymax = -2, w = 0;
+            for (int i = 0; i < 8; i++)
+                {
+                fVec4 P = M.mult1(fVec3((i & 1) ? bb.maxX : bb.minX, (i & 2) ? bb.maxY : bb.minY, (i & 4) ? bb.maxZ : bb.minZ));
+                if (_ortho) P.w = 1.0f - P.z; else P.zdivide();
+                xmin = min(xmin, P.x); xmax = max(xmax, P.x);
+                ymin = min(ymin, P.y); ymax = max(ymax, P.y);
+                w = (i == 0) ? P.w : max(w, P.w);
+                }
+            const int x0 = (int)floorf((xmin + 1.0f) * 0.5f * _lx) - 1 - _ox;
+            const int x1 = (int)floorf((xmax + 1.0f) * 0.5f * _lx) + 1 - _ox;
+            const int y0 = (int)floorf((ymin + 1.0f) * 0.5f * _ly) - 1 - _oy;
+            const int y1 = (int)floorf((ymax + 1.0f) * 0.5f * _ly) + 1 - _oy;
+            return _hiz.hidden(x0, x1, y0, y1, HiZBuffer<ZBUFFER_t>::margin(_uni.wa * w + _uni.wb));
+            }
+
+
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setBinBuffer(uint16_t* bins, int size)
+            {
+            _bins = bins;
+            _bins_size = (bins) ? max(size, 0) : 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        template<typename DRAW_FUN, typename FLUSH_FUN>
+        int Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawBands(int band_ly, color_t* band_buf1, color_t* band_buf2, ZBUFFER_t* band_zbuf, color_t background, DRAW_FUN draw, FLUSH_FUN flush)
+            {
+            if ((_lx <= 0) || (_ly <= 0) || (band_ly <= 0) || (band_buf1 == nullptr)) return 0;
+            if (band_buf2 == nullptr) band_buf2 = band_buf1;
+            band_ly = max(band_ly, (_ly + 254) / 255); // bin entries store band indices on 8 bits
+
+            Image<color_t>* const saved_im = _uni.im;
+            ZBUFFER_t* const saved_zbuf = _uni.zbuf;
+            HiZBuffer<ZBUFFER_t>* const saved_hiz = _uni.hiz;
+            const int saved_ox = _ox;
+            const int saved_oy = _oy;
+            _uni.hiz = nullptr; // the band z-buffer has no coarse depth buffer
+
+            _nb_bands = (_ly + band_ly - 1) / band_ly;
+            _band_scale = (0.5f * _ly) / band_ly;
+            _band_margin = 1.0f / band_ly;
+
+            // binning pass: nothing is drawn, the image only gives the viewport bounds to the culling tests.
+            Image<color_t> im(band_buf1, _lx, _ly);
+            _uni.im = &im;
+            _ox = 0;
+            _oy = 0;
+            _band_pass = BAND_BINNING;
+            _bin_pos = 0;
+            draw();
+            const int nb_bins = _bin_pos;
+
+            // band passes
+            _uni.zbuf = band_zbuf;
+            _rectifyShaderZbuffer();
+            _band_pass = BAND_RENDER;
+            color_t* buf = band_buf1;
+            for (int b = 0; b < _nb_bands; b++)
+                {
+                const int y = b * band_ly;
+                im.set(buf, _lx, min(band_ly, _ly - y));
+                im.fillScreen(background);
+                if (band_zbuf) memset(band_zbuf, 0, im.lx() * im.ly() * sizeof(ZBUFFER_t));
+                _oy = y;
+                _band = b;
+                _bin_pos = 0;
+                draw();
+                flush((const Image<color_t>&)im, y);
+                buf = (buf == band_buf1) ? band_buf2 : band_buf1;
+                }
+            im.setInvalid();
+            flush((const Image<color_t>&)im, _ly); // wait for the last transfer
+
+            _band_pass = BAND_OFF;
+            _uni.im = saved_im;
+            _uni.zbuf = saved_zbuf;
+            _uni.hiz = saved_hiz;
+            _rectifyShaderZbuffer();
+            _ox = saved_ox;
+            _oy = saved_oy;
+            return nb_bins;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setTileBuffers(int tile_lx, int tile_ly, color_t* tile_buf, ZBUFFER_t* tile_zbuf)
+            {
+            _tile_lx = max(tile_lx, 1);
+            _tile_ly = max(tile_ly, 1);
+            _tile_buf = tile_buf;
+            _tile_zbuf = tile_zbuf;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setTriangleBuffer(void* tri_buf, int tri_size, uint16_t* bins, int bins_size)
+            {
+            _tile_tris = nullptr;
+            _tile_tris_size = 0;
+            if ((tri_buf) && (tri_size > 0))
+                { // align the buffer for TileTriangle
+                const uintptr_t a = alignof(TileTriangle);
+                const uintptr_t p = (uintptr_t)tri_buf;
+                const uintptr_t q = (p + a - 1) & ~(a - 1);
+                if ((int)(q - p) < tri_size)
+                    {
+                    _tile_tris = (TileTriangle*)q;
+                    _tile_tris_size = min((int)((tri_size - (int)(q - p)) / sizeof(TileTriangle)), 65535); // the bins hold 16 bit triangle indices
+                    }
+                }
+            _tile_bins = bins;
+            _tile_bins_size = (bins) ? min(max(bins_size, 0), 65535) : 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        int Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::tileTriangleSize()
+            {
+            return (int)sizeof(TileTriangle);
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::beginTiles()
+            {
+            if ((_tile_binning) || (_band_pass != BAND_OFF) || (_tile_buf == nullptr) || (!_validDraw())) return;
+            if ((_uni.im->lx() > 256 * _tile_lx) || (_uni.im->ly() > 256 * _tile_ly)) return; // at most 256 tiles per axis
+            _tile_nb_tris = 0;
+            _tile_binning = true; // the z-buffer of the image stays in place, see _setShaderType()
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_binTriangle(const RasterizerVec4& V1, const RasterizerVec4& V2, const RasterizerVec4& V3)
+            {
+            // box of pixels that may be drawn, relative to the image.
+            iBox2 B = rasterizeTriangleBox(_lx, _ly, V1, V2, V3);
+            B.minX -= _ox; B.maxX -= _ox;
+            B.minY -= _oy; B.maxY -= _oy;
+            B &= iBox2(0, _uni.im->lx() - 1, 0, _uni.im->ly() - 1);
+            if (B.isEmpty()) return;
+            if (_tile_nb_tris < _tile_tris_size)
+                {
+                TileTriangle& T = _tile_tris[_tile_nb_tris];
+                const RasterizerVec4* P[3] = { &V1, &V2, &V3 };
+                for (int i = 0; i < 3; i++)
+                    {
+                    T.V[i].x = P[i]->x;
+                    T.V[i].y = P[i]->y;
+                    T.V[i].w = P[i]->w;
+                    T.V[i].color = P[i]->color;
+                    T.V[i].T = P[i]->T;
+                    }
+                T.facecolor = _uni.facecolor;
+                T.tex = _uni.tex;
+                T.shader_fn = _shader_fn;
+                T.tx0 = (uint8_t)(B.minX / _tile_lx);
+                T.tx1 = (uint8_t)(B.maxX / _tile_lx);
+                T.ty0 = (uint8_t)(B.minY / _tile_ly);
+                T.ty1 = (uint8_t)(B.maxY / _tile_ly);
+                }
+            _tile_nb_tris++;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        int Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::endTiles()
+            {
+            if (!_tile_binning) return 0;
+            _tile_binning = false;
+            Image<color_t>* const im = _uni.im;
+            const int nb_tris = min(_tile_nb_tris, _tile_tris_size);
+            const int nx = (im->lx() + _tile_lx - 1) / _tile_lx;
+            const int ny = (im->ly() + _tile_ly - 1) / _tile_ly;
+            const int nb_tiles = nx * ny;
+
+            // counting sort of the triangles into the bins: bins[t] is first the number of triangles of tile t, 
+            // then the end of its list once the lists are filled. The list of tile t starts at bins[t-1].
+            uint16_t* const bins = _tile_bins;
+            bool binned = ((bins != nullptr) && (nb_tiles < _tile_bins_size));
+            if (binned)
+                {
+                memset(bins, 0, nb_tiles * sizeof(uint16_t));
+                int total = nb_tiles;
+                for (int i = 0; i < nb_tris; i++)
+                    {
+                    const TileTriangle& T = _tile_tris[i];
+                    for (int ty = T.ty0; ty <= T.ty1; ty++) for (int tx = T.tx0; tx <= T.tx1; tx++) bins[ty * nx + tx]++;
+                    total += (T.tx1 - T.tx0 + 1) * (T.ty1 - T.ty0 + 1);
+                    }
+                if (total <= _tile_bins_size)
+                    {
+                    int pos = nb_tiles;
+                    for (int t = 0; t < nb_tiles; t++) { pos += bins[t]; bins[t] = (uint16_t)(pos - bins[t]); } // start of each list
+                    for (int i = 0; i < nb_tris; i++)
+                        {
+                        const TileTriangle& T = _tile_tris[i];
+                        for (int ty = T.ty0; ty <= T.ty1; ty++) for (int tx = T.tx0; tx <= T.tx1; tx++) bins[bins[ty * nx + tx]++] = (uint16_t)i;
+                        }
+                    }
+                else binned = false;
                 }
+
+            // rasterize each tile in the tile buffers (the tile z-buffer has no coarse depth buffer).
+            HiZBuffer<ZBUFFER_t>* const saved_hiz = _uni.hiz;
+            ZBUFFER_t* const saved_zbuf = _uni.zbuf;
+            _uni.hiz = nullptr;
+            _uni.zbuf = _tile_zbuf;
+            Image<color_t> tile;
+            _uni.im = &tile;
+            RasterizerVec4 P[3];
+            for (int i = 0; i < 3; i++) { P[i].z = 0.0f; P[i].A = 1.0f; } // not used by the 3D shaders
+            for (int ty = 0; ty < ny; ty++)
+                {
+                for (int tx = 0; tx < nx; tx++)
+                    {
+                    const int t = ty * nx + tx;
+                    int start = 0, end = nb_tris;
+                    if (binned)
+                        {
+                        start = (t == 0) ? nb_tiles : bins[t - 1];
+                        end = bins[t];
+                        }
+                    if (start >= end) continue; // empty tile
+                    const iBox2 B(tx * _tile_lx, min((tx + 1) * _tile_lx, im->lx()) - 1, ty * _tile_ly, min((ty + 1) * _tile_ly, im->ly()) - 1);
+                    tile.set(_tile_buf, B.lx(), B.ly());
+                    tile.blit(im->getCrop(B), { 0, 0 });
+                    if (_tile_zbuf) memset(_tile_zbuf, 0, B.lx() * B.ly() * sizeof(ZBUFFER_t));
+                    _uni.tile_x = B.minX;
+                    for (int k = start; k < end; k++)
+                        {
+                        const TileTriangle& T = _tile_tris[binned ? bins[k] : k];
+                        if ((!binned) && ((tx < T.tx0) || (tx > T.tx1) || (ty < T.ty0) || (ty > T.ty1))) continue;
+                        for (int i = 0; i < 3; i++)
+                            {
+                            P[i].x = T.V[i].x;
+                            P[i].y = T.V[i].y;
+                            P[i].w = T.V[i].w;
+                            P[i].color = T.V[i].color;
+                            P[i].T = T.V[i].T;
+                            }
+                        _uni.facecolor = T.facecolor;
+                        _uni.tex = T.tex;
+                        rasterizeTriangle(_lx, _ly, P[0], P[1], P[2], _ox + B.minX, _oy + B.minY, _uni, T.shader_fn);
+                        }
+                    im->blit(tile, { B.minX, B.minY });
+                    }
+                }
+
+            _uni.im = im;
+            _uni.tile_x = 0;
+            _uni.hiz = saved_hiz;
+            _uni.zbuf = saved_zbuf;
+            return _tile_nb_tris;
             }
 
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setShaders(Shader shaders)
             {
-            _rectifyShaderShading(shaders);
+            const int old_shaders = _shaders;
+            const uint32_t old_changes = _state_shader_changes;
+            _rectifyShaderShading(shaders); // may call setTextureWrappingMode() and setTextureQuality()
+            _state_shader_changes = old_changes + ((_shaders != old_shaders) ? 1 : 0);
             }
 
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setTextureWrappingMode(Shader wrap_mode)
             {
+            const int old_shaders = _shaders;
             if (TGX_SHADER_HAS_TEXTURE_CLAMP(wrap_mode))
                 {
                 if (TGX_SHADER_HAS_TEXTURE_CLAMP(ENABLED_SHADERS))
@@ -277,26 +797,34 @@ namespace tgx
                     _texture_wrap_mode = SHADER_TEXTURE_CLAMP; // fallback
                 }
                 _rectifyShaderTextureWrapping();
+            if (_shaders != old_shaders) _state_shader_changes++;
             }
 
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setTextureQuality(Shader quality)
             {
+            const int old_shaders = _shaders;
             if (TGX_SHADER_HAS_TEXTURE_BILINEAR(quality))
                 {
                 if (TGX_SHADER_HAS_TEXTURE_BILINEAR(ENABLED_SHADERS))
                     _texture_quality = SHADER_TEXTURE_BILINEAR;
                 else
                     _texture_quality = SHADER_TEXTURE_NEAREST; // fallback
-                } else
+                } else if (TGX_SHADER_HAS_TEXTURE_NEAREST(quality))
                 {
                 if (TGX_SHADER_HAS_TEXTURE_NEAREST(ENABLED_SHADERS))
                     _texture_quality = SHADER_TEXTURE_NEAREST;
                 else
                     _texture_quality = SHADER_TEXTURE_BILINEAR; // fallback
+                } else
+                { // keep the current sampling mode
+                _texture_quality &= (SHADER_TEXTURE_BILINEAR | SHADER_TEXTURE_NEAREST);
                 }
-                _rectifyShaderTextureQuality();
+            if ((TGX_SHADER_HAS_TEXTURE_SUBDIV(quality)) && (TGX_SHADER_HAS_TEXTURE_SUBDIV(ENABLED_SHADERS)))
+                _texture_quality |= SHADER_TEXTURE_SUBDIV;
+            _rectifyShaderTextureQuality();
+            if (_shaders != old_shaders) _state_shader_changes++;
             }
 
 
@@ -485,6 +1013,7 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterialColor(RGBf color)
             {
+            if ((color.R != _color.R) || (color.G != _color.G) || (color.B != _color.B)) _state_material_changes++;
             _color = color;
             // recompute
             _r_objectColor = _color;
@@ -494,7 +1023,9 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterialAmbiantStrength(float strenght)
             {
+            const float old_strength = _ambiantStrength;
             _ambiantStrength = clamp(strenght, 0.0f, 10.0f); // allow values larger than 1 to simulate emissive surfaces.
+            if (_ambiantStrength != old_strength) _state_material_changes++;
             // recompute
             _r_ambiantColor = _ambiantColor * _ambiantStrength;
             }
@@ -503,7 +1034,9 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterialDiffuseStrength(float strenght)
             {
+            const float old_strength = _diffuseStrength;
             _diffuseStrength = clamp(strenght, 0.0f, 10.0f); // allow values larger than 1 to simulate emissive surfaces.
+            if (_diffuseStrength != old_strength) _state_material_changes++;
             // recompute
             _r_diffuseColor = _diffuseColor * _diffuseStrength;
             }
@@ -512,7 +1045,9 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterialSpecularStrength(float strenght)
             {
+            const float old_strength = _specularStrength;
             _specularStrength = clamp(strenght, 0.0f, 10.0f); // allow values larger than 1 to simulate emissive surfaces.
+            if (_specularStrength != old_strength) _state_material_changes++;
             // recompute
             _r_specularColor = _specularColor * _specularStrength;
             }
@@ -521,18 +1056,22 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterialSpecularExponent(int exponent)
             {
+            const int old_exponent = _specularExponent;
             _specularExponent = clamp(exponent, 0, 100);
+            if (_specularExponent != old_exponent) _state_material_changes++;
             }
 
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::setMaterial(RGBf color, float ambiantStrength, float diffuseStrength, float specularStrength, int specularExponent)
             {
+            const uint32_t old_changes = _state_material_changes;
             this->setMaterialColor(color);
             this->setMaterialAmbiantStrength(ambiantStrength);
             this->setMaterialDiffuseStrength(diffuseStrength);
             this->setMaterialSpecularStrength(specularStrength);
             this->setMaterialSpecularExponent(specularExponent);
+            _state_material_changes = old_changes + ((_state_material_changes != old_changes) ? 1 : 0); // count one change for the whole material
             }
 
 
@@ -684,7 +1223,7 @@ namespace tgx
             const RGBf& col0, const RGBf& col1, const RGBf& col2)
             {
 
-            _uni.shader_type = RASTER_TYPE; // just in case
+            _setShaderType(RASTER_TYPE); // just in case
 
             // face culling (unneeded but we must compute cu anyway). 
             fVec3 faceN = crossProduct(*Q1 - *Q0, *Q2 - *Q0);
@@ -859,7 +1398,7 @@ namespace tgx
                         V2.zdivide();
                         V3.zdivide();
                         }
-                    rasterizeTriangle(_lx, _ly, V1, V2, V3, _ox, _oy, _uni, shader_select<ENABLED_SHADERS, color_t, ZBUFFER_t>);
+                    _rasterizeTriangle(V1, V2, V3);
                     return;
                     }
                 }
@@ -889,7 +1428,7 @@ namespace tgx
                            const RGBf & Vcol0, const RGBf & Vcol1, const RGBf & Vcol2)
             {
             const bool ortho = _ortho;
-            _uni.shader_type = RASTER_TYPE;
+            _setShaderType(RASTER_TYPE);
 
             // compute position in view space.
             const fVec4 Q0 = _r_modelViewM.mult1(*P0);
@@ -991,7 +1530,7 @@ namespace tgx
                 }
 
             // go rasterize !          
-            rasterizeTriangle(_lx, _ly, PPC0, PPC1, PPC2, _ox, _oy, _uni, shader_select<ENABLED_SHADERS, color_t, ZBUFFER_t>);
+            _rasterizeTriangle(PPC0, PPC1, PPC2);
 
             return;
             }
@@ -1007,7 +1546,7 @@ namespace tgx
             {
             const bool ortho = _ortho; 
 
-            _uni.shader_type = RASTER_TYPE;
+            _setShaderType(RASTER_TYPE);
 
             // compute position in wiew space.
             const fVec4 Q0 = _r_modelViewM.mult1(*P0);
@@ -1129,8 +1668,8 @@ namespace tgx
                 }
 
             // go rasterize !
-            rasterizeTriangle(_lx, _ly, PPC0, PPC1, PPC2, _ox, _oy, _uni, shader_select<ENABLED_SHADERS, color_t, ZBUFFER_t>);
-            rasterizeTriangle(_lx, _ly, PPC0, PPC2, PPC3, _ox, _oy, _uni, shader_select<ENABLED_SHADERS, color_t, ZBUFFER_t>);
+            _rasterizeTriangle(PPC0, PPC1, PPC2);
+            _rasterizeTriangle(PPC0, PPC2, PPC3);
             
             return;
             }
@@ -1142,7 +1681,7 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawMesh(const Mesh3D<color_t>* mesh, bool use_mesh_material, bool draw_chained_meshes)
             {
-            if (!_validDraw()) return;
+            if ((_band_pass != BAND_BINNING) && (!_validDraw())) return;
 
             while (mesh)
                 {
@@ -1165,35 +1704,381 @@ namespace tgx
                     }
                 mesh = ((draw_chained_meshes) ? mesh->next : nullptr);
                 }
-
-            if (use_mesh_material)
-                { // restore material pre-computed values
-                _r_ambiantColor = _ambiantColor * _ambiantStrength;
-                _r_diffuseColor = _diffuseColor * _diffuseStrength;
-                _r_specularColor = _specularColor * _specularStrength;
-                _r_objectColor = _color;
+
+            if (use_mesh_material)
+                { // restore material pre-computed values
+                _r_ambiantColor = _ambiantColor * _ambiantStrength;
+                _r_diffuseColor = _diffuseColor * _diffuseStrength;
+                _r_specularColor = _specularColor * _specularStrength;
+                _r_objectColor = _color;
+                }
+            }
+
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawMeshInstanced(const Mesh3D<color_t>* mesh, int count, const fMat4* matrices, const RGBf* colors, bool use_mesh_material, bool draw_chained_meshes)
+            {
+            if ((matrices == nullptr) || (count <= 0)) return;
+            if ((_band_pass != BAND_BINNING) && (!_validDraw())) return;
+
+            // frustum planes in world space
+            fVec4 planes[6];
+            _frustumPlanes(_projM * _viewM, planes);
+
+            const fMat4 saved_modelM = _modelM;
+            while (mesh)
+                {
+                if (mesh->vertice)
+                    {
+                    // per mesh setup, done once for all the instances
+                    if (use_mesh_material)
+                        {
+                        _r_ambiantColor = _ambiantColor * mesh->ambiant_strength;
+                        _r_diffuseColor = _diffuseColor * mesh->diffuse_strength;
+                        _r_specularColor = _specularColor * mesh->specular_strength;
+                        _r_objectColor = mesh->color;
+                        }
+                    const RGBf object_color = _r_objectColor;
+                    _precomputeSpecularTable(use_mesh_material ? mesh->specular_exponent : _specularExponent);
+                    int raster_type = _shaders;
+                    if (mesh->normal == nullptr) { TGX_SHADER_REMOVE_GOURAUD(raster_type) }
+                    if ((mesh->texcoord == nullptr) || (mesh->texture == nullptr)) TGX_SHADER_REMOVE_TEXTURE(raster_type)
+                    const fBox3& bb = mesh->bounding_box;
+                    const bool bounded = ((bb.minX != 0) || (bb.maxX != 0) || (bb.minY != 0) || (bb.maxY != 0) || (bb.minZ != 0) || (bb.maxZ != 0));
+
+                    for (int i = 0; i < count; i++)
+                        {
+                        // the band bins must see the same sequence of _drawMesh() calls in every pass: the culling only depends on the matrices so it is the same in every pass.
+                        if ((bounded) && (_instanceCulledBox(bb, matrices[i], planes))) continue;
+                        _modelM = matrices[i];
+                        _r_modelViewM = _viewM * _modelM;
+                        _r_inorm = _r_modelViewM.mult0(fVec3{ 0,0,1 }).invnorm();
+                        _r_light_inorm = _r_light * _r_inorm;
+                        _r_H_inorm = _r_H * _r_inorm;
+                        if (colors) _r_objectColor = colors[i];
+                        _drawMesh(raster_type, mesh);
+                        }
+                    _r_objectColor = object_color;
+                    }
+                mesh = ((draw_chained_meshes) ? mesh->next : nullptr);
+                }
+            setModelMatrix(saved_modelM);
+
+            if (use_mesh_material)
+                { // restore material pre-computed values
+                _r_ambiantColor = _ambiantColor * _ambiantStrength;
+                _r_diffuseColor = _diffuseColor * _diffuseStrength;
+                _r_specularColor = _specularColor * _specularStrength;
+                _r_objectColor = _color;
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawMeshLOD(MeshLOD<color_t>* lod, bool use_mesh_material, bool draw_chained_meshes)
+            {
+            if ((lod == nullptr) || (lod->nb_levels <= 0) || (lod->level[0] == nullptr)) return;
+            const fBox3& bb = lod->level[0]->bounding_box;
+            int k = 0;
+            if ((bb.minX != 0) || (bb.maxX != 0) || (bb.minY != 0) || (bb.maxY != 0) || (bb.minZ != 0) || (bb.maxZ != 0))
+                {
+                k = lod->select(screenDiameter(bb));
+                }
+            drawMesh(lod->level[k], use_mesh_material, draw_chained_meshes);
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        float Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::screenDiameter(const fBox3& box)
+            {
+            // same method as _unitSphereScreenDiameter() for the bounding sphere of the box.
+            const float ONEOVERSQRT2 = 0.70710678118f;
+            const fVec3 C((box.minX + box.maxX) * 0.5f, (box.minY + box.maxY) * 0.5f, (box.minZ + box.maxZ) * 0.5f);
+            const float R = fVec3(box.maxX - C.x, box.maxY - C.y, box.maxZ - C.z).norm_fast(); // radius in model space
+            fVec4 P0 = _r_modelViewM.mult1(C);
+            const float r = R * fVec3(_r_modelViewM.mult0(fVec3(1, 0, 0))).norm_fast(); // radius after modelview transform
+            if ((!_ortho) && (P0.z > -r)) return 1.0e30f; // the sphere reaches the plane of the camera
+            fVec4 P2 = { P0.x - r * ONEOVERSQRT2, P0.y - r * ONEOVERSQRT2, P0.z, P0.w };
+            fVec4 Q0 = _projM * P0;
+            fVec4 Q2 = _projM * P2;
+            if (!_ortho)
+                {
+                Q0.zdivide();
+                Q2.zdivide();
+                }
+            return tgx::fast_sqrt(((Q2.x - Q0.x) * (Q2.x - Q0.x) * _lx * _lx) + ((Q2.y - Q0.y) * (Q2.y - Q0.y) * _ly * _ly)); // diameter on the screen
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawScene(Scene3D<color_t>* scene)
+            {
+            if ((scene == nullptr) || ((_band_pass != BAND_BINNING) && (!_validDraw()))) return;
+            scene->update();
+            if (scene->nbBVHNodes() == 0) return;
+
+            // frustum planes in world space
+            fVec4 planes[6];
+            _frustumPlanes(_projM * _viewM, planes);
+
+            const fMat4 saved_modelM = _modelM;
+            const RGBf saved_color = _color;
+            const float saved_ambiant = _ambiantStrength, saved_diffuse = _diffuseStrength, saved_specular = _specularStrength;
+            const int saved_exponent = _specularExponent;
+            bool material_changed = false;
+
+            int stack_node[64];
+            int stack_mask[64];
+            int sp = 0;
+            stack_node[sp] = 0;
+            stack_mask[sp++] = 63; // test all the planes
+            while (sp > 0)
+                {
+                sp--;
+                const SceneBVHNode& B = scene->bvhNode(stack_node[sp]);
+                int mask = stack_mask[sp];
+                if ((mask) && (_sceneCulledBox(B.box, planes, mask))) continue; // whole subtree is off-screen
+                if (B.child >= 0)
+                    {
+                    stack_node[sp] = B.child + 1; stack_mask[sp++] = mask;
+                    stack_node[sp] = B.child; stack_mask[sp++] = mask;
+                    continue;
+                    }
+                for (int k = B.first; k < B.first + B.count; k++)
+                    {
+                    const SceneNode<color_t>& N = scene->node(scene->bvhNode(k).item);
+                    if (!(N.flags & SceneNode<color_t>::SCENE_SHOWN)) continue;
+                    int m = mask;
+                    if ((B.count > 1) && (m) && (_sceneCulledBox(N.box, planes, m))) continue;
+                    setModelMatrix(N.world);
+                    const bool chained = ((N.flags & SceneNode<color_t>::SCENE_CHAINED) != 0);
+                    if (N.flags & SceneNode<color_t>::SCENE_MESH_MATERIAL)
+                        {
+                        drawMesh(N.mesh, true, chained);
+                        }
+                    else
+                        {
+                        setMaterial(N.color, N.ambiant_strength, N.diffuse_strength, N.specular_strength, N.specular_exponent);
+                        material_changed = true;
+                        drawMesh(N.mesh, false, chained);
+                        }
+                    _scene_nodes_drawn++;
+                    }
+                }
+
+            setModelMatrix(saved_modelM);
+            if (material_changed) setMaterial(saved_color, saved_ambiant, saved_diffuse, saved_specular, saved_exponent);
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawQueue(RenderQueue3D<color_t>* queue)
+            {
+            if ((queue == nullptr) || (queue->nbItems() == 0) || ((_band_pass != BAND_BINNING) && (!_validDraw()))) return;
+
+            // depth of the items in view space, then sort.
+            if (queue->sortMode() & RenderQueue3D<color_t>::QUEUE_SORT_DEPTH)
+                {
+                for (int k = 0; k < queue->nbItems(); k++)
+                    {
+                    RenderItem<color_t>& I = queue->item(k);
+                    const fBox3& bb = I.mesh->bounding_box;
+                    const fVec3 C((bb.minX + bb.maxX) * 0.5f, (bb.minY + bb.maxY) * 0.5f, (bb.minZ + bb.maxZ) * 0.5f); // origin if there is no bounding box
+                    const float d = -(_viewM.mult1(I.model.mult1(C))).z;
+                    I.depth = (TGX_SHADER_HAS_ZBUFFER(_shaders)) ? d : -d; // back to front without z-buffer
+                    }
+                }
+            queue->sort();
+
+            const fMat4 saved_modelM = _modelM;
+            const RGBf saved_color = _color;
+            const float saved_ambiant = _ambiantStrength, saved_diffuse = _diffuseStrength, saved_specular = _specularStrength;
+            const int saved_exponent = _specularExponent;
+            const int saved_shaders = _shaders, saved_wrap = _texture_wrap_mode, saved_quality = _texture_quality;
+            bool material_changed = false;
+
+            int shaders = -1;
+            for (int k = 0; k < queue->nbItems(); k++)
+                {
+                const RenderItem<color_t>& I = queue->item(queue->order(k));
+                if (I.shaders != shaders)
+                    {
+                    shaders = I.shaders;
+                    setShaders((Shader)shaders);
+                    }
+                setModelMatrix(I.model);
+                const bool chained = ((I.flags & RenderItem<color_t>::QUEUE_CHAINED) != 0);
+                if (I.flags & RenderItem<color_t>::QUEUE_MESH_MATERIAL)
+                    {
+                    drawMesh(I.mesh, true, chained);
+                    }
+                else
+                    {
+                    setMaterial(I.color, I.ambiant_strength, I.diffuse_strength, I.specular_strength, I.specular_exponent); // counted only if the material changes
+                    material_changed = true;
+                    drawMesh(I.mesh, false, chained);
+                    }
+                }
+
+            setModelMatrix(saved_modelM);
+            if (material_changed) setMaterial(saved_color, saved_ambiant, saved_diffuse, saved_specular, saved_exponent);
+            if (_shaders != saved_shaders)
+                { // restore the flags directly: setShaders() cannot express 'no texture' with a texture quality.
+                _state_shader_changes++;
+                _shaders = saved_shaders;
+                _texture_wrap_mode = saved_wrap;
+                _texture_quality = saved_quality;
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::getStateStats(uint32_t& shader_changes, uint32_t& material_changes, uint32_t& specular_rebuilds) const
+            {
+            shader_changes = _state_shader_changes;
+            material_changes = _state_material_changes;
+            specular_rebuilds = _state_specular_rebuilds;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::resetStateStats()
+            {
+            _state_shader_changes = 0;
+            _state_material_changes = 0;
+            _state_specular_rebuilds = 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_frustumPlanes(const fMat4& M, fVec4* planes) const
+            {
+            const fVec4 r0(M.M[0], M.M[4], M.M[8], M.M[12]);
+            const fVec4 r1(M.M[1], M.M[5], M.M[9], M.M[13]);
+            const fVec4 r2(M.M[2], M.M[6], M.M[10], M.M[14]);
+            const fVec4 r3(M.M[3], M.M[7], M.M[11], M.M[15]);
+            const float bx = (_ox - 1) * _ilx - 1.0f;
+            const float Bx = (_ox + _uni.im->width() + 1) * _ilx - 1.0f;
+            const float by = (_oy - 1) * _ily - 1.0f;
+            const float By = (_oy + _uni.im->height() + 1) * _ily - 1.0f;
+            planes[0] = r0 - r3 * bx;
+            planes[1] = r3 * Bx - r0;
+            planes[2] = r1 - r3 * by;
+            planes[3] = r3 * By - r1;
+            planes[4] = r2 + r3;
+            planes[5] = r3 - r2;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_clusterSetup(fVec4* planes, fVec3& eye, float& cone_dir, const bool ortho) const
+            {
+            // frustum planes in model space, normalized so that the distance to a sphere center can be compared with its radius.
+            _frustumPlanes(_projM * _r_modelViewM, planes);
+            for (int p = 0; p < 6; p++)
+                {
+                const float n = fVec3(planes[p].x, planes[p].y, planes[p].z).norm();
+                if (n > 0) planes[p] /= n;
+                }
+            // invert the linear part A of the modelview matrix (cofactors).
+            const float* M = _r_modelViewM.M;
+            const float c00 = M[5] * M[10] - M[9] * M[6], c01 = M[9] * M[2] - M[1] * M[10], c02 = M[1] * M[6] - M[5] * M[2];
+            const float c10 = M[8] * M[6] - M[4] * M[10], c11 = M[0] * M[10] - M[8] * M[2], c12 = M[4] * M[2] - M[0] * M[6];
+            const float c20 = M[4] * M[9] - M[8] * M[5], c21 = M[8] * M[1] - M[0] * M[9], c22 = M[0] * M[5] - M[4] * M[1];
+            const float det = M[0] * c00 + M[4] * c01 + M[8] * c02;
+            const float idet = (det != 0) ? (1.0f / det) : 0.0f;
+            cone_dir = (det > 0) ? (float)_culling_dir : ((det < 0) ? -(float)_culling_dir : 0.0f); // a mirror swaps front and back faces
+            if (ortho)
+                { // view direction (0,0,-1) in model space
+                eye = fVec3(-c20, -c21, -c22) * idet;
+                eye.normalize();
+                }
+            else
+                { // camera position (origin of view space) in model space: -A^-1 * translation
+                eye = fVec3(c00 * M[12] + c10 * M[13] + c20 * M[14], c01 * M[12] + c11 * M[13] + c21 * M[14], c02 * M[12] + c12 * M[13] + c22 * M[14]) * (-idet);
                 }
             }
 
 
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::getMeshletStats(uint32_t& clusters_tested, uint32_t& frustum_culled, uint32_t& backface_culled) const
+            {
+            clusters_tested = _meshlet_tested;
+            frustum_culled = _meshlet_frustum_culled;
+            backface_culled = _meshlet_backface_culled;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::resetMeshletStats()
+            {
+            _meshlet_tested = 0;
+            _meshlet_frustum_culled = 0;
+            _meshlet_backface_culled = 0;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::getSceneStats(uint32_t& boxes_tested, uint32_t& boxes_culled, uint32_t& nodes_drawn) const
+            {
+            boxes_tested = _scene_boxes_tested;
+            boxes_culled = _scene_boxes_culled;
+            nodes_drawn = _scene_nodes_drawn;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::resetSceneStats()
+            {
+            _scene_boxes_tested = 0;
+            _scene_boxes_culled = 0;
+            _scene_nodes_drawn = 0;
+            }
+
 
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>  TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawMesh(const int RASTER_TYPE, const Mesh3D<color_t>* mesh)
             {
-            _uni.shader_type = RASTER_TYPE;
+            _setShaderType(RASTER_TYPE);
             const bool ortho = _ortho;
+            if (_nlut) _updateNormalLUT();
 
             const bool TEXTURE = (bool)(TGX_SHADER_HAS_TEXTURE(RASTER_TYPE));
             const bool GOURAUD = (bool)(TGX_SHADER_HAS_GOURAUD(RASTER_TYPE));
 
+            // band rendering: the bins of the mesh are a header with the band range of the whole mesh
+            // followed by the band range of each triangle (see drawBands()).
+            const int band_pass = _band_pass;
+            const int bin_header = _bin_pos;
+            const int bin_end = bin_header + 1 + mesh->nb_faces;
+            int bin = bin_header + 1;
+            int bin_lo = 255, bin_hi = 0;
+            if (band_pass != BAND_OFF)
+                {
+                _bin_pos = bin_end;
+                if ((band_pass == BAND_RENDER) && (!_inBand(_readBin(bin_header)))) return; // nothing to draw in this band
+                }
+
             // check if the object is completely outside of the image for fast discard.
-            if (_discardBox(mesh->bounding_box, _projM * _r_modelViewM)) return;
+            if (_discardBox(mesh->bounding_box, _projM * _r_modelViewM))
+                {
+                if (band_pass == BAND_BINNING) _writeBin(bin_header, BIN_NONE);
+                return;
+                }
             
             const float CLIPBOUND_XY = _clipbound_xy();
 
             // check if the clipping test should be performed for each triangle in the mesh.
             const bool cliptestneeded = _clipTestNeeded(CLIPBOUND_XY, mesh->bounding_box, _projM * _r_modelViewM);
 
+            // check if the whole object is hidden by what is already in the z-buffer.
+            if ((_uni.hiz) && (!cliptestneeded) && (band_pass == BAND_OFF) && (!_tile_binning) && (_hizCulledBox(mesh->bounding_box, _projM * _r_modelViewM)))
+                {
+                _hiz.nb_meshes_culled++;
+                return;
+                }
+
             const fVec3* const tab_vert = mesh->vertice;  // array of vertices
             const fVec3* const tab_norm = mesh->normal;   // array of normals
             const fVec2* const tab_tex = mesh->texcoord;  // array of texture
@@ -1202,6 +2087,35 @@ namespace tgx
             // set the texture.
             _uni.tex = (const Image<color_t>*)mesh->texture;
 
+            // batched vertex stage: all the vertices are transformed, projected and lit up front if the mesh fits in the buffer.
+            const bool batched = _batchMesh(mesh, GOURAUD && (band_pass != BAND_BINNING), TEXTURE, ortho, CLIPBOUND_XY); // no lighting needed for binning
+
+            // new drawing call for the vertex cache: entries of previous calls become free. 
+            int vmask = 0;
+            if ((_vcache) && (!batched))
+                {
+                if (++_vcache_id == 0)
+                    { // wrap around: clear the stamps
+                    for (int i = 0; i < _vcache_size; i++) _vcache[i].draw_id = 0;
+                    _vcache_id = 1;
+                    }
+                vmask = (mesh->nb_vertices <= _vcache_size) ? 0x7FFF : _vcache_mask; // full array or direct-mapped
+                }
+
+            // meshlet clusters: each cluster is tested when the face pointer reaches its first chain.
+            const MeshCluster* cluster = mesh->cluster;
+            const MeshCluster* const cluster_end = (cluster) ? cluster + mesh->nb_clusters : nullptr;
+            const uint16_t* cluster_face = ((cluster) && (mesh->nb_clusters > 0)) ? mesh->face + cluster->face_offset : nullptr;
+            fVec4 cluster_planes[6];
+            fVec3 cluster_eye;
+            float cluster_dir = 0;
+            if (cluster_face) _clusterSetup(cluster_planes, cluster_eye, cluster_dir, ortho);
+
+            // front to back mode (back to front painter's mode without z-buffer): the visible triangles are recorded and rasterized after the whole mesh is culled.
+            const bool sorting = (_tsort) && (mesh->nb_faces <= _tsort_size) && (band_pass == BAND_OFF) && (!_tile_binning);
+            const bool painter = (sorting) && (!TGX_SHADER_HAS_ZBUFFER(RASTER_TYPE));
+            int nb_sorted = 0;
+
             ExtVec4 QQA, QQB, QQC;
             ExtVec4* PPC0 = &QQA;
             ExtVec4* PPC1 = &QQB;
@@ -1211,71 +2125,84 @@ namespace tgx
             while ((nbt = *(face++)) > 0)
                 { // starting a chain with nbt triangles
 
+                while (face - 1 == cluster_face)
+                    { // first chain of a cluster: skip the whole cluster if it cannot be seen
+                    const bool culled = _clusterCulled(*cluster, cluster_planes, cluster_eye, cluster_dir, ortho);
+                    const int cluster_faces = cluster->nb_faces;
+                    cluster++;
+                    cluster_face = (cluster < cluster_end) ? mesh->face + cluster->face_offset : nullptr;
+                    if (!culled) break;
+                    bin += cluster_faces; // keep the band bins in sync
+                    if (cluster_face == nullptr) goto mesh_done; // the last cluster spans the end of the face array
+                    face = cluster_face + 1;
+                    nbt = *cluster_face;
+                    }
+
                 // load the first triangle
-                const uint16_t v0 = *(face++);
+                PPC0->indv = *(face++);
                 if (TEXTURE) PPC0->indt = *(face++); else { if (tab_tex) face++; }
                 if (GOURAUD) PPC0->indn = *(face++); else { if (tab_norm) face++; }
 
-                const uint16_t v1 = *(face++);
+                PPC1->indv = *(face++);
                 if (TEXTURE) PPC1->indt = *(face++); else { if (tab_tex) face++; }
                 if (GOURAUD) PPC1->indn = *(face++); else { if (tab_norm) face++; }
 
-                const uint16_t v2 = *(face++);
+                PPC2->indv = *(face++);
                 if (TEXTURE) PPC2->indt = *(face++); else { if (tab_tex) face++; }
                 if (GOURAUD) PPC2->indn = *(face++); else { if (tab_norm) face++; }
 
-                // compute vertices position because we are sure we will need them...
-                PPC2->P = _r_modelViewM.mult1(tab_vert[v2]);
-                PPC0->P = _r_modelViewM.mult1(tab_vert[v0]);
-                PPC1->P = _r_modelViewM.mult1(tab_vert[v1]);
-
-                // ...but use lazy computation of other vertex attributes
+                // use lazy computation of vertex positions and attributes
+                PPC0->missedV = true;
+                PPC1->missedV = true;
+                PPC2->missedV = true;
                 PPC0->missedP = true;
                 PPC1->missedP = true;
                 PPC2->missedP = true;
 
                 while (1)
                     {
-                    // face culling
-                    fVec3 faceN = crossProduct(PPC1->P - PPC0->P, PPC2->P - PPC0->P);
-                    const float cu = (ortho) ? dotProduct(faceN, fVec3(0.0f, 0.0f, -1.0f)) : dotProduct(faceN, PPC0->P);
-                    if (cu * _culling_dir > 0) goto rasterize_next_triangle; // skip triangle !
-                    // triangle is not culled
+                    const int tbin = (bin < bin_end) ? bin++ : _bins_size; // bin entry of the triangle (BIN_ALL if nb_faces is wrong)
+                    fVec3 faceN;
+                    float cu;
+                    if ((band_pass == BAND_RENDER) && (!_inBand(_readBin(tbin)))) goto rasterize_next_triangle; // not in this band
 
-                    *((fVec4*)PPC2) = _projM * PPC2->P;
-                    if (ortho) { PPC2->w = 1.0f - PPC2->z; } else { PPC2->zdivide(); }
+                    if (PPC0->missedV) _fetchVertex(PPC0, tab_vert, vmask);
+                    if (PPC1->missedV) _fetchVertex(PPC1, tab_vert, vmask);
+                    if (PPC2->missedV) _fetchVertex(PPC2, tab_vert, vmask);
 
-                    if (PPC0->missedP)
-                        {
-                        *((fVec4*)PPC0) = _projM * PPC0->P;
-                        if (ortho) { PPC0->w = 1.0f - PPC0->z; } else { PPC0->zdivide(); }
-                        }
-                    if (PPC1->missedP)
-                        {
-                        *((fVec4*)PPC1) = _projM * PPC1->P;
-                        if (ortho) { PPC1->w = 1.0f - PPC1->z; } else { PPC1->zdivide(); }
+                    // face culling
+                    faceN = crossProduct(PPC1->P - PPC0->P, PPC2->P - PPC0->P);
+                    cu = (ortho) ? dotProduct(faceN, fVec3(0.0f, 0.0f, -1.0f)) : dotProduct(faceN, PPC0->P);
+                    if (cu * _culling_dir > 0)
+                        { // skip triangle !
+                        if (band_pass == BAND_BINNING) _writeBin(tbin, BIN_NONE);
+                        goto rasterize_next_triangle;
                         }
+                    // triangle is not culled
+
+                    _projectVertex(PPC2, ortho, cliptestneeded, CLIPBOUND_XY);
+                    if (PPC0->missedP) _projectVertex(PPC0, ortho, cliptestneeded, CLIPBOUND_XY);
+                    if (PPC1->missedP) _projectVertex(PPC1, ortho, cliptestneeded, CLIPBOUND_XY);
                         
                     // test if triangle must be clipped                                         
                     if (cliptestneeded)
                         {
-                        const float CLIPBOUND_XY = _clipbound_xy();
-                        const bool needclip = (PPC2->P.z >= 0)
-                            | (PPC2->x < -CLIPBOUND_XY) | (PPC2->x > CLIPBOUND_XY)
-                            | (PPC2->y < -CLIPBOUND_XY) | (PPC2->y > CLIPBOUND_XY)
-                            | (PPC2->z < -1) | (PPC2->z > 1)                      
-                            | (PPC0->P.z >= 0)
-                            | (PPC0->x < -CLIPBOUND_XY) | (PPC0->x > CLIPBOUND_XY)
-                            | (PPC0->y < -CLIPBOUND_XY) | (PPC0->y > CLIPBOUND_XY)
-                            | (PPC0->z < -1) | (PPC0->z > 1)
-                            | (PPC1->P.z >= 0)
-                            | (PPC1->x < -CLIPBOUND_XY) | (PPC1->x > CLIPBOUND_XY)
-                            | (PPC1->y < -CLIPBOUND_XY) | (PPC1->y > CLIPBOUND_XY)
-                            | (PPC1->z < -1) | (PPC1->z > 1);
+                        const bool needclip = ((PPC0->outcode | PPC1->outcode | PPC2->outcode) != 0);
                         if (needclip)
                             { // need cliiping, test is we can just discard the triangle if not shown on screen
-                            if (!_discardTriangle(*((fVec4*)PPC0), *((fVec4*)PPC1), *((fVec4*)PPC2)))
+                            if (band_pass == BAND_BINNING)
+                                { // draw clipped triangles in every band
+                                const bool discard = _discardTriangle(*((fVec4*)PPC0), *((fVec4*)PPC1), *((fVec4*)PPC2));
+                                _writeBin(tbin, discard ? BIN_NONE : BIN_ALL);
+                                if (!discard) { bin_lo = 0; bin_hi = 255; }
+                                }
+                            else if (!_discardTriangle(*((fVec4*)PPC0), *((fVec4*)PPC1), *((fVec4*)PPC2)))
                                 { // no, use the slow drawing method with clipping
+                                if (painter)
+                                    { // must be drawn in depth order with the other triangles
+                                    _tsortRecord(_tsort[nb_sorted++], QQA, QQB, QQC, PPC0, PPC1, true, true, TEXTURE, GOURAUD);
+                                    goto rasterize_next_triangle;
+                                    }
                                 _drawTriangleClipped(RASTER_TYPE,
                                                 &(PPC0->P), &(PPC1->P), &(PPC2->P),
                                                 ((GOURAUD) ? tab_norm + PPC0->indn : nullptr), ((GOURAUD) ? tab_norm + PPC1->indn : nullptr), ((GOURAUD) ? tab_norm + PPC2->indn : nullptr),                                
@@ -1286,43 +2213,61 @@ namespace tgx
                             }
                         }
 
+                    if (band_pass == BAND_BINNING)
+                        { // record the bands spanned by the triangle, nothing else to do
+                        const uint16_t range = _binRange(min(min(PPC0->y, PPC1->y), PPC2->y), max(max(PPC0->y, PPC1->y), PPC2->y));
+                        _writeBin(tbin, range);
+                        bin_lo = min(bin_lo, range & 255);
+                        bin_hi = max(bin_hi, range >> 8);
+                        goto rasterize_next_triangle;
+                        }
+
+                    if (sorting)
+                        { // record the triangle: it is shaded and rasterized by _drawSortedTriangles()
+                        _tsortRecord(_tsort[nb_sorted++], QQA, QQB, QQC, PPC0, PPC1, painter, false, TEXTURE, GOURAUD);
+                        // the attributes are not needed during this phase
+                        PPC0->missedP = false;
+                        PPC1->missedP = false;
+                        PPC2->missedP = false;
+                        goto rasterize_next_triangle;
+                        }
+
                     // ok, the triangle must be rasterized !
                     if (GOURAUD)
                         { // Gouraud shading : color on vertices
 
                         // reverse normal only when culling is disabled (and we assume in this case that normals are given for the CCW face).
                         const float icu = (_culling_dir != 0) ? 1.0f : ((cu > 0) ? -1.0f : 1.0f);
-                        if (PPC0->missedP)
+                        if (TEXTURE)
                             {
-                            PPC0->N = _r_modelViewM.mult0(tab_norm[PPC0->indn]);
-                            if (TEXTURE)
-                                PPC0->color = _phong<true>(icu * dotProduct(PPC0->N, _r_light_inorm), icu * dotProduct(PPC0->N, _r_H_inorm));
-                            else
-                                PPC0->color = _phong<false>(icu * dotProduct(PPC0->N, _r_light_inorm), icu * dotProduct(PPC0->N, _r_H_inorm));
+                            if (PPC0->missedP) _shadeVertex<true>(PPC0, tab_norm, icu);
+                            if (PPC1->missedP) _shadeVertex<true>(PPC1, tab_norm, icu);
+                            _shadeVertex<true>(PPC2, tab_norm, icu);
                             }
-                        if (PPC1->missedP)
+                        else
                             {
-                            PPC1->N = _r_modelViewM.mult0(tab_norm[PPC1->indn]);
-                            if (TEXTURE)
-                                PPC1->color = _phong<true>(icu * dotProduct(PPC1->N, _r_light_inorm), icu * dotProduct(PPC1->N, _r_H_inorm));
-                            else
-                                PPC1->color = _phong<false>(icu * dotProduct(PPC1->N, _r_light_inorm), icu * dotProduct(PPC1->N, _r_H_inorm));
+                            if (PPC0->missedP) _shadeVertex<false>(PPC0, tab_norm, icu);
+                            if (PPC1->missedP) _shadeVertex<false>(PPC1, tab_norm, icu);
+                            _shadeVertex<false>(PPC2, tab_norm, icu);
                             }
-                        PPC2->N = _r_modelViewM.mult0(tab_norm[PPC2->indn]);
-                        if (TEXTURE)
-                            PPC2->color = _phong<true>(icu * dotProduct(PPC2->N, _r_light_inorm), icu * dotProduct(PPC2->N, _r_H_inorm));
-                        else
-                            PPC2->color = _phong<false>(icu * dotProduct(PPC2->N, _r_light_inorm), icu * dotProduct(PPC2->N, _r_H_inorm));
 
                         }
                     else
                         { // flat shading : color on faces
                         const float icu = ((cu > 0) ? -1.0f : 1.0f); // -1 if we need to reverse the face normal.
-                        faceN.normalize_fast();
-                        if (TEXTURE)
-                            _uni.facecolor = _phong<true>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                        if (_nlut)
+                            { // no need to normalize
+                            if (icu < 0) faceN = -faceN;
+                            _uni.facecolor = (TEXTURE) ? _lutPhong<true>(faceN) : _lutPhong<false>(faceN);
+                            }
                         else
-                            _uni.facecolor = _phong<false>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                            {
+                            faceN.normalize_fast();
+                            if (TEXTURE)
+                                _uni.facecolor = _phong<true>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                            else
+                                _uni.facecolor = _phong<false>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                            }
                         }
 
                     if (TEXTURE)
@@ -1338,7 +2283,7 @@ namespace tgx
                     PPC2->missedP = false;
 
                     // go rasterize !                   
-                    rasterizeTriangle(_lx, _ly, (RasterizerVec4)QQA, (RasterizerVec4)QQB, (RasterizerVec4)QQC, _ox, _oy, _uni, shader_select<ENABLED_SHADERS, color_t, ZBUFFER_t>);
+                    _rasterizeTriangle(QQA, QQB, QQC);
               
                 rasterize_next_triangle:
 
@@ -1349,10 +2294,159 @@ namespace tgx
                     swap(((nv2 & 32768) ? PPC0 : PPC1), PPC2);
                     if (TEXTURE) PPC2->indt = *(face++); else { if (tab_tex) face++; }
                     if (GOURAUD) PPC2->indn = *(face++);  else { if (tab_norm) face++; }
-                    PPC2->P = _r_modelViewM.mult1(tab_vert[nv2 & 32767]);
+                    PPC2->indv = nv2 & 32767;
+                    PPC2->missedV = true;
                     PPC2->missedP = true;
                     }
                 }
+
+        mesh_done:
+            if (nb_sorted > 0) _drawSortedTriangles(RASTER_TYPE, mesh, nb_sorted, vmask);
+            if (band_pass == BAND_BINNING) _writeBin(bin_header, (uint16_t)(bin_lo | (bin_hi << 8)));
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>  TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawSortedTriangles(const int RASTER_TYPE, const Mesh3D<color_t>* mesh, const int nb, const int vmask)
+            {
+            const bool ortho = _ortho;
+            const bool TEXTURE = (bool)(TGX_SHADER_HAS_TEXTURE(RASTER_TYPE));
+            const bool GOURAUD = (bool)(TGX_SHADER_HAS_GOURAUD(RASTER_TYPE));
+            const fVec3* const tab_vert = mesh->vertice;
+            const fVec3* const tab_norm = mesh->normal;
+            const fVec2* const tab_tex = mesh->texcoord;
+            TriangleSortEntry* const S = _tsort;
+
+            // stable LSD radix sort of the 16 bit keys: low byte into rank, then high byte into order.
+            int count[256];
+            memset(count, 0, sizeof(count));
+            for (int i = 0; i < nb; i++) count[S[i].key & 255]++;
+            for (int d = 0, pos = 0; d < 256; d++) { const int c = count[d]; count[d] = pos; pos += c; }
+            for (int i = 0; i < nb; i++) S[count[S[i].key & 255]++].rank = (uint16_t)i;
+            memset(count, 0, sizeof(count));
+            for (int i = 0; i < nb; i++) count[S[i].key >> 8]++;
+            for (int d = 0, pos = 0; d < 256; d++) { const int c = count[d]; count[d] = pos; pos += c; }
+            for (int k = 0; k < nb; k++) { const int i = S[k].rank; S[count[S[i].key >> 8]++].order = (uint16_t)i; }
+
+            ExtVec4 QQ[3];
+            for (int k = 0; k < nb; k++)
+                {
+                const TriangleSortEntry& T = S[S[k].order];
+                for (int j = 0; j < 3; j++)
+                    {
+                    QQ[j].indv = T.indv[j];
+                    if (TEXTURE) QQ[j].indt = T.indt[j];
+                    if (GOURAUD) QQ[j].indn = T.indn[j];
+                    _fetchVertex(QQ + j, tab_vert, vmask);
+                    }
+                // same vertex order as in the first phase for the face normal.
+                ExtVec4* const PPC0 = QQ + (T.perm & 3);
+                ExtVec4* const PPC1 = QQ + ((T.perm >> 2) & 3);
+                ExtVec4* const PPC2 = QQ + (3 - (T.perm & 3) - ((T.perm >> 2) & 3));
+                if (T.perm & TSORT_CLIPPED)
+                    { // painter's mode: a triangle that needs clipping is drawn at its place in the order
+                    _drawTriangleClipped(RASTER_TYPE,
+                                    &(PPC0->P), &(PPC1->P), &(PPC2->P),
+                                    ((GOURAUD) ? tab_norm + PPC0->indn : nullptr), ((GOURAUD) ? tab_norm + PPC1->indn : nullptr), ((GOURAUD) ? tab_norm + PPC2->indn : nullptr),
+                                    ((TEXTURE) ? tab_tex + PPC0->indt : nullptr), ((TEXTURE) ? tab_tex + PPC1->indt : nullptr), ((TEXTURE) ? tab_tex + PPC2->indt : nullptr),
+                                    _uni.facecolor, _uni.facecolor, _uni.facecolor);
+                    continue;
+                    }
+                for (int j = 0; j < 3; j++) _projectVertex(QQ + j, ortho, false, 0.0f); // triangles that need clipping are not projected
+                fVec3 faceN = crossProduct(PPC1->P - PPC0->P, PPC2->P - PPC0->P);
+                const float cu = (ortho) ? dotProduct(faceN, fVec3(0.0f, 0.0f, -1.0f)) : dotProduct(faceN, PPC0->P);
+                if (GOURAUD)
+                    {
+                    const float icu = (_culling_dir != 0) ? 1.0f : ((cu > 0) ? -1.0f : 1.0f);
+                    for (int j = 0; j < 3; j++)
+                        {
+                        if (TEXTURE) _shadeVertex<true>(QQ + j, tab_norm, icu); else _shadeVertex<false>(QQ + j, tab_norm, icu);
+                        }
+                    }
+                else
+                    {
+                    const float icu = ((cu > 0) ? -1.0f : 1.0f);
+                    if (_nlut)
+                        {
+                        if (icu < 0) faceN = -faceN;
+                        _uni.facecolor = (TEXTURE) ? _lutPhong<true>(faceN) : _lutPhong<false>(faceN);
+                        }
+                    else
+                        {
+                        faceN.normalize_fast();
+                        if (TEXTURE)
+                            _uni.facecolor = _phong<true>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                        else
+                            _uni.facecolor = _phong<false>(icu * dotProduct(faceN, _r_light), icu * dotProduct(faceN, _r_H));
+                        }
+                    }
+                if (TEXTURE)
+                    {
+                    QQ[0].T = tab_tex[QQ[0].indt];
+                    QQ[1].T = tab_tex[QQ[1].indt];
+                    QQ[2].T = tab_tex[QQ[2].indt];
+                    }
+                _rasterizeTriangle(QQ[0], QQ[1], QQ[2]);
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        bool Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_batchMesh(const Mesh3D<color_t>* mesh, const bool gouraud, const bool texture, const bool ortho, const float clipbound_xy)
+            {
+            _vb_px = nullptr;
+            _vb_color = nullptr;
+            const int nbv = mesh->nb_vertices;
+            const int nbn = (gouraud) ? mesh->nb_normals : 0;
+            if ((_vbatch == nullptr) || (nbv <= 0) || (vertexBatchBufferSize(nbv, nbn) > _vbatch_size)) return false;
+
+            // layout: 8 arrays of n4 floats, n4 outcodes, nbn colors.
+            const int n4 = (nbv + 3) & ~3;
+            float* const px = _vbatch;
+            float* const py = px + n4;
+            float* const pz = py + n4;
+            float* const pw = pz + n4;
+            float* const qx = pw + n4;
+            float* const qy = qx + n4;
+            float* const qz = qy + n4;
+            float* const qw = qz + n4;
+            uint8_t* const outcode = (uint8_t*)(qw + n4);
+            RGBf* const color = (RGBf*)(qw + n4 + n4 / 4);
+
+            batchTransform(_r_modelViewM, mesh->vertice, nbv, px, py, pz, pw);
+            batchProject(_projM, ortho, clipbound_xy, nbv, px, py, pz, pw, qx, qy, qz, qw, outcode);
+            if ((nbn > 0) && (_nlut))
+                { // normal lighting table
+                for (int k = 0; k < nbn; k++)
+                    {
+                    const fVec3 N = _r_modelViewM.mult0(mesh->normal[k]);
+                    color[k] = (texture) ? _lutPhong<true>(N) : _lutPhong<false>(N);
+                    }
+                _vb_color = color;
+                }
+            else if (nbn > 0)
+                { // dot products by chunks on the stack, then the Phong model (table lookup for the specular term)
+                const int CHUNK = 64;
+                float vd[CHUNK], vs[CHUNK];
+                for (int k = 0; k < nbn; k += CHUNK)
+                    {
+                    const int l = min(CHUNK, nbn - k);
+                    batchNormalDots(_r_modelViewM, mesh->normal + k, l, _r_light_inorm, _r_H_inorm, vd, vs);
+                    if (texture)
+                        {
+                        for (int j = 0; j < l; j++) color[k + j] = _phong<true>(vd[j], vs[j]);
+                        }
+                    else
+                        {
+                        for (int j = 0; j < l; j++) color[k + j] = _phong<false>(vd[j], vs[j]);
+                        }
+                    }
+                _vb_color = color;
+                }
+            _vb_px = px; _vb_py = py; _vb_pz = pz; _vb_pw = pw;
+            _vb_qx = qx; _vb_qy = qy; _vb_qz = qz; _vb_qw = qw;
+            _vb_outcode = outcode;
+            return true;
             }
 
 
@@ -2430,11 +3524,11 @@ namespace tgx
                 if (!has_zbuffer)
                     {
                     if (USE_BLENDING)
-                        _uni.im->drawCircle({ x, y }, radius[r], colors[colors_ind[k]], opacities[opacities_ind[k]]);
+                        _uni.im->drawCircle({ x, y }, r, colors[colors_ind[k]], opacities[opacities_ind[k]]);
                     else if (USE_COLORS)
-                        _uni.im->drawCircle({ x, y }, radius[r], colors[colors_ind[k]]);
+                        _uni.im->drawCircle({ x, y }, r, colors[colors_ind[k]]);
                     else
-                        _uni.im->drawCircle({ x, y }, radius[r], _color);
+                        _uni.im->drawCircle({ x, y }, r, _color);
                     }
                 else
                     {
@@ -2573,6 +3667,138 @@ namespace tgx
 
 
 
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        int Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawParticles(Particles3D<color_t>* particles)
+            {
+            if ((particles == nullptr) || (!_validDraw())) return 0;
+            const int nb = particles->nbParticles();
+            const bool has_zbuffer = (TGX_SHADER_HAS_ZBUFFER(_shaders)) && (_uni.zbuf != nullptr); // z-buffer of the image, also between beginTiles() and endTiles()
+            const bool ortho = _ortho;
+            const int lx = _uni.im->lx(), ly = _uni.im->ly();
+            const float scale = fabsf(_projM[5]) * _ly / (2 * _r_inorm); // pixels per model unit at distance 1 (perspective) or everywhere (ortho)
+
+            // projection pass: visible particles in the screen buffer.
+            const fMat4 M = _projM * _r_modelViewM;
+            int nv = 0;
+            for (int i = 0; i < nb; i++)
+                {
+                fVec4 Q = M.mult1(particles->position(i));
+                const float depth = (ortho) ? Q.z : Q.w; // increases with the distance to the camera
+                if (ortho) { Q.w = 1.0f - Q.z; } else { Q.zdivide(); }
+                if ((Q.z < -1) | (Q.z > 1) | (Q.w <= 0)) continue;
+                const float fr = particles->size(i) * scale * ((ortho) ? 1.0f : Q.w) + 0.5f;
+                if (!(fr >= 0.0f)) continue;
+                const int r = (fr < 1000.0f) ? (int)fr : 1000;
+                const int x = (int)roundfp(((Q.x + 1) * _lx) / 2 - _ox);
+                const int y = (int)roundfp(((Q.y + 1) * _ly) / 2 - _oy);
+                if ((x + r < 0) || (x - r >= lx) || (y + r < 0) || (y - r >= ly)) continue;
+                ParticleScreenEntry& E = particles->screen(nv++);
+                E.w = Q.w;
+                E.depth = depth;
+                E.x = (int16_t)x;
+                E.y = (int16_t)y;
+                E.r = (uint16_t)r;
+                E.index = (uint16_t)i;
+                }
+
+            // back to front order (if requested) then drawing pass.
+            particles->sort(nv);
+            const Image<color_t>* sprite = particles->sprite();
+            if ((sprite) && (!sprite->isValid())) sprite = nullptr;
+            const color_t transparent = particles->transparentColor();
+            const color_t white = color_t(RGB32_White);
+            for (int k = 0; k < nv; k++)
+                {
+                const ParticleScreenEntry& E = particles->screen(particles->order(k));
+                const color_t color = particles->color(E.index);
+                const int opacity = particles->opacity(E.index);
+                if (opacity == 0) continue;
+                if (sprite == nullptr)
+                    {
+                    if (has_zbuffer) _drawParticle<true, false, false>(E, color, opacity, sprite, transparent); else _drawParticle<false, false, false>(E, color, opacity, sprite, transparent);
+                    }
+                else if (color == white)
+                    {
+                    if (has_zbuffer) _drawParticle<true, true, false>(E, color, opacity, sprite, transparent); else _drawParticle<false, true, false>(E, color, opacity, sprite, transparent);
+                    }
+                else
+                    {
+                    if (has_zbuffer) _drawParticle<true, true, true>(E, color, opacity, sprite, transparent); else _drawParticle<false, true, true>(E, color, opacity, sprite, transparent);
+                    }
+                }
+            return nv;
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        template<bool USE_ZBUFFER, bool USE_SPRITE, bool USE_TINT> TGX_INLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawParticle(const ParticleScreenEntry& E, color_t color, int opacity, const Image<color_t>* sprite, color_t transparent)
+            {
+            Image<color_t>& im = *_uni.im;
+            const int lx = im.lx(), ly = im.ly(), stride = im.stride();
+            const int r = E.r;
+            const int x0 = max(0, E.x - r), x1 = min(lx - 1, E.x + r);
+            const int y0 = max(0, E.y - r), y1 = min(ly - 1, E.y + r);
+            if ((x0 > x1) || (y0 > y1)) return;
+            const ZBUFFER_t aa = (USE_ZBUFFER) ? ((ZBUFFER_t)(E.w * _uni.wa + _uni.wb)) : ((ZBUFFER_t)0);
+            const uint32_t op = (uint32_t)(opacity + (opacity >> 7)); // [0,255] -> [0,256]
+            color_t* buf = im.data();
+            const ZBUFFER_t* zbuf = _uni.zbuf;
+            uint32_t nb_shaded = 0;
+            if (USE_SPRITE)
+                { // sprite stretched on the 2r+1 pixels of the particle (nearest texel)
+                int mr = 256, mg = 256, mb = 256;
+                if (USE_TINT)
+                    {
+                    const RGB32 c(color);
+                    mr = c.R + (c.R >> 7); mg = c.G + (c.G >> 7); mb = c.B + (c.B >> 7);
+                    }
+                const int sstride = sprite->stride();
+                const color_t* sbuf = sprite->data();
+                const int32_t du = (sprite->lx() << 16) / (2 * r + 1), dv = (sprite->ly() << 16) / (2 * r + 1);
+                for (int y = y0; y <= y1; y++)
+                    {
+                    const color_t* srow = sbuf + sstride * (((y - E.y + r) * dv) >> 16);
+                    color_t* row = buf + stride * y;
+                    const ZBUFFER_t* zrow = (USE_ZBUFFER) ? (zbuf + lx * y) : nullptr;
+                    int32_t u = (x0 - E.x + r) * du;
+                    for (int x = x0; x <= x1; x++, u += du)
+                        {
+                        if ((USE_ZBUFFER) && (!(zrow[x] < aa))) continue;
+                        color_t c = srow[u >> 16];
+                        if (c == transparent) continue;
+                        if (USE_TINT) c.mult256(mr, mg, mb);
+                        if (op >= 256) row[x] = c; else row[x].blend256(c, op);
+                        nb_shaded++;
+                        }
+                    }
+                }
+            else
+                { // disc of radius r + 1/2
+                const int rr = r * r + r;
+                for (int y = y0; y <= y1; y++)
+                    {
+                    const int dy = y - E.y;
+                    const int h = (int)tgx::fast_sqrt((float)(rr - dy * dy));
+                    const int xa = max(x0, E.x - h), xb = min(x1, E.x + h);
+                    color_t* row = buf + stride * y;
+                    const ZBUFFER_t* zrow = (USE_ZBUFFER) ? (zbuf + lx * y) : nullptr;
+                    for (int x = xa; x <= xb; x++)
+                        {
+                        if ((USE_ZBUFFER) && (!(zrow[x] < aa))) continue;
+                        if (op >= 256) row[x] = color; else row[x].blend256(color, op);
+                        nb_shaded++;
+                        }
+                    }
+                }
+            _fragments += nb_shaded;
+            im.markDirty(iBox2(x0, x1, y0, y1));
+            }
+
+
+
+
+
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
         float Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_unitSphereScreenDiameter()
             {
@@ -2719,6 +3945,15 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawSphere(int nb_sectors, int nb_stacks, const Image<color_t>* texture)
             {
+            if (_sphere_cache)
+                { // same bounds as _drawSphere()
+                const Mesh3D<color_t>* sphere = _sphere_cache->get(clamp(nb_sectors, 3, 256), max(nb_stacks, 3), (texture != nullptr));
+                if (sphere)
+                    {
+                    _drawSphereMesh(sphere, texture);
+                    return;
+                    }
+                }
             _drawSphere<false, false>(nb_sectors, nb_stacks, texture, 1.0f, color_t(_color), 1.0f);
             }
 
@@ -2741,6 +3976,157 @@ namespace tgx
             }
 
 
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawSpheres(int nb_spheres, const fVec3* centers, const float* radii, const RGBf* colors)
+            {
+            if (!_validDraw()) return;
+            if ((centers == nullptr) || (radii == nullptr)) return;
+            if (_nlut) _updateNormalLUT();
+            const bool has_zbuffer = (TGX_SHADER_HAS_ZBUFFER(_shaders)) && (_uni.zbuf != nullptr); // z-buffer of the image, also between beginTiles() and endTiles()
+            const float scale = 1.0f / _r_inorm; // scaling of the model-view transform
+            for (int k = 0; k < nb_spheres; k++)
+                {
+                const float r = radii[k] * scale;
+                if (!(r > 0.0f)) continue;
+                const fVec4 P = _r_modelViewM.mult1(centers[k]);
+                const fVec3 C(P.x, P.y, P.z);
+                const RGBf& color = (colors) ? colors[k] : _color;
+                if (_ortho)
+                    {
+                    if (has_zbuffer) _drawSphereImpostor<true, true>(C, r, color); else _drawSphereImpostor<false, true>(C, r, color);
+                    }
+                else
+                    {
+                    if (has_zbuffer) _drawSphereImpostor<true, false>(C, r, color); else _drawSphereImpostor<false, false>(C, r, color);
+                    }
+                }
+            }
+
+
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
+        template<bool USE_ZBUFFER, bool ORTHO> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawSphereImpostor(const fVec3& C, float r, const RGBf& color)
+            {
+            // A pixel (x, y) sees the points of view space (a*s + a0, b*s + b0, -s) with s >= 0 in perspective
+            // and (a, b, s) with s in R in orthographic projection, where a and b are affine in x and y.
+            Image<color_t>& im = *_uni.im;
+            const int lx = im.lx(), ly = im.ly(), stride = im.stride();
+            const float ax = 2.0f / (_lx * _projM[0]), ax0 = ((_ox * 2.0f / _lx) - 1.0f + ((ORTHO) ? -_projM[12] : _projM[8])) / _projM[0];
+            const float by = 2.0f / (_ly * _projM[5]), by0 = ((_oy * 2.0f / _ly) - 1.0f + ((ORTHO) ? -_projM[13] : _projM[9])) / _projM[5];
+            const float r2 = r * r;
+            const float m = C.x * C.x + C.y * C.y + C.z * C.z - r2; // > 0 when the camera is outside of the sphere
+            // depth range: w in [1/zfar, 1/znear] in perspective and in [0, 2] in ortho, as in the rasterizer.
+            const float pa = _projM[10], pb = _projM[14];
+            const float wmin = (ORTHO) ? 0.0f : ((pa + 1.0f) / pb);
+            const float wmax = (ORTHO) ? 2.0f : ((pa - 1.0f) / pb);
+            float bmin, bmax; // range of b covered by the sphere
+            if (ORTHO)
+                {
+                if ((1.0f - (pa * (C.z + r) + pb) < wmin) || (1.0f - (pa * (C.z - r) + pb) > wmax)) return; // behind the far plane or in front of the near plane
+                bmin = C.y - r; bmax = C.y + r;
+                }
+            else
+                {
+                if (C.z >= -r) return; // the camera is inside the sphere or behind it
+                if ((-1.0f / (C.z + r) < wmin) || (-1.0f / (C.z - r) > wmax)) return;
+                // b is the slope Y/(-Z) of the planes through the eye tangent to the sphere.
+                const float A = C.z * C.z - r2;
+                const float d = r * tgx::fast_sqrt(C.y * C.y + A);
+                bmin = (-C.y * C.z - d) / A; bmax = (-C.y * C.z + d) / A;
+                }
+            // rows covered (by is negative: the y axis goes down on the screen)
+            const float fy0 = (bmax - by0) / by, fy1 = (bmin - by0) / by;
+            const int y0 = max(0, (int)ceilf(min(fy0, fy1))), y1 = min(ly - 1, (int)floorf(max(fy0, fy1)));
+            if (y0 > y1) return;
+            color_t* buf = im.data();
+            ZBUFFER_t* zbuf = _uni.zbuf;
+            const float wa = _uni.wa, wb = _uni.wb;
+            const float ir = 1.0f / r;
+            iBox2 B(lx, -1, ly, -1); // pixels written
+            uint32_t nb_shaded = 0;
+            for (int y = y0; y <= y1; y++)
+                {
+                const float b = by * y + by0;
+                // span of the row: a such that the line of sight meets the sphere.
+                float amin, amax;
+                if (ORTHO)
+                    {
+                    const float t = r2 - (b - C.y) * (b - C.y);
+                    if (t < 0.0f) continue;
+                    const float h = tgx::fast_sqrt(t);
+                    amin = C.x - h; amax = C.x + h;
+                    }
+                else
+                    { // (a*Cx + e)^2 - (a^2 + b^2 + 1)*m >= 0 with e = b*Cy - Cz. The leading coefficient Cx^2 - m is < 0.
+                    const float e = b * C.y - C.z;
+                    const float A2 = C.x * C.x - m;
+                    const float t = C.x * C.x * e * e - A2 * (e * e - (b * b + 1.0f) * m);
+                    if (t < 0.0f) continue;
+                    const float h = tgx::fast_sqrt(t);
+                    amin = (-C.x * e + h) / A2; amax = (-C.x * e - h) / A2;
+                    }
+                const int x0 = max(0, (int)ceilf((amin - ax0) / ax)), x1 = min(lx - 1, (int)floorf((amax - ax0) / ax));
+                int wx0 = lx, wx1 = -1;
+                for (int x = x0; x <= x1; x++)
+                    {
+                    const float a = ax * x + ax0;
+                    fVec3 N; // normal at the visible point of the sphere
+                    float w;
+                    if (ORTHO)
+                        {
+                        N.x = (a - C.x) * ir;
+                        N.y = (b - C.y) * ir;
+                        N.z = tgx::fast_sqrt(max(1.0f - N.x * N.x - N.y * N.y, 0.0f));
+                        w = 1.0f - (pa * (C.z + r * N.z) + pb);
+                        }
+                    else
+                        { // first intersection of the ray s*(a, b, -1) with the sphere
+                        const float k = a * C.x + b * C.y - C.z;
+                        const float dd = a * a + b * b + 1.0f;
+                        const float s = (k - tgx::fast_sqrt(max(k * k - dd * m, 0.0f))) / dd;
+                        w = 1.0f / s;
+                        N.x = (s * a - C.x) * ir;
+                        N.y = (s * b - C.y) * ir;
+                        N.z = (-s - C.z) * ir;
+                        }
+                    if ((w < wmin) || (w > wmax)) continue;
+                    if (USE_ZBUFFER)
+                        {
+                        ZBUFFER_t& W = zbuf[x + lx * y];
+                        const ZBUFFER_t aa = (ZBUFFER_t)(w * wa + wb);
+                        if (!(W < aa)) continue;
+                        W = aa;
+                        }
+                    RGBf col;
+                    if (_nlut)
+                        {
+                        col = _nlut[octahedralIndex(N, _nlut_bits)];
+                        col *= color;
+                        col.clamp();
+                        }
+                    else
+                        {
+                        col = _phong(dotProduct(N, _r_light), dotProduct(N, _r_H), color);
+                        }
+                    buf[x + stride * y] = color_t(col);
+                    if (x < wx0) wx0 = x;
+                    wx1 = x;
+                    nb_shaded++;
+                    }
+                if (wx1 >= 0)
+                    {
+                    if ((USE_ZBUFFER) && (_uni.hiz) && (_uni.hiz->zbuf == zbuf)) _uni.hiz->markDirty(wx0, wx1, y);
+                    B |= iBox2(wx0, wx1, y, y);
+                    }
+                }
+            if (nb_shaded)
+                {
+                _fragments += nb_shaded;
+                im.markDirty(B);
+                }
+            }
+
+
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
         template<bool WIREFRAME, bool DRAWFAST> TGX_NOINLINE
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawSphere(int nb_sectors, int nb_stacks, const Image<color_t>* texture, float thickness, color_t color, float opacity)
@@ -2919,6 +4305,31 @@ namespace tgx
 
 
 
+        template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t> TGX_NOINLINE
+        void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_drawSphereMesh(const Mesh3D<color_t>* sphere, const Image<color_t>* texture)
+            {
+            const int save_shaders = _shaders;
+            if (texture == nullptr)
+                {
+                TGX_SHADER_REMOVE_TEXTURE(_shaders);
+                }
+
+            // set culling direction = 1 and save previous value
+            float save_culling = _culling_dir;
+            if (_culling_dir != 0) _culling_dir = 1;
+
+            Mesh3D<color_t> mesh = *sphere; // the cached mesh may be constant: set the texture on a copy
+            mesh.texture = texture;
+            drawMesh(&mesh, false, false);
+
+            // restore culling direction and shader
+            _culling_dir = save_culling;
+            _shaders = save_shaders;
+            }
+
+
+
+
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::drawWireFrameCube()
             {
@@ -3020,6 +4431,23 @@ namespace tgx
                     _uni.wb = 32768 * (_projM[10] + 1);
                     }
                 }
+            if (_zepochs > 1)
+                { // z-buffer epochs: map the depth above the range of the previous epochs.
+                if (std::is_same<ZBUFFER_t, float>::value)
+                    { // [k, k+1], whatever the projection
+                    float wmax = (_ortho) ? 2.0f : ((_projM[10] - 1.0f) / _projM[14]); // 1/znear in perspective
+                    if (!(wmax > 0.0f)) wmax = 1.0f;
+                    _uni.wa = 0.99f / wmax;
+                    _uni.wb = (float)_zepoch;
+                    }
+                else
+                    { // [k*S, (k+1)*S] with S = 65536/nb_epochs
+                    const int S = 65536 / _zepochs;
+                    const float r = S / 65536.0f;
+                    _uni.wa *= r;
+                    _uni.wb = _uni.wb * r + (float)(_zepoch * S);
+                    }
+                }
             }
 
 
@@ -3084,14 +4512,9 @@ namespace tgx
                 setTextureWrappingMode(SHADER_TEXTURE_CLAMP);
                 tex = true;
                 }
-            if (TGX_SHADER_HAS_TEXTURE_NEAREST(new_shaders))
+            if (TGX_SHADER_HAS_ONE_FLAG(new_shaders, TGX_SHADER_MASK_TEXTURE_QUALITY))
                 {
-                setTextureQuality(SHADER_TEXTURE_NEAREST);
-                tex = true;
-                }
-            if (TGX_SHADER_HAS_TEXTURE_BILINEAR(new_shaders))
-                {
-                setTextureQuality(SHADER_TEXTURE_BILINEAR);
+                setTextureQuality(new_shaders);
                 tex = true;
                 }
             if (tex)
@@ -3128,7 +4551,7 @@ namespace tgx
         template<typename color_t, Shader LOADED_SHADERS, typename ZBUFFER_t>
         void Renderer3D<color_t, LOADED_SHADERS, ZBUFFER_t>::_rectifyShaderTextureQuality()
             {
-            if (_texture_quality == SHADER_TEXTURE_BILINEAR)
+            if (TGX_SHADER_HAS_TEXTURE_BILINEAR(_texture_quality))
                 {
                 TGX_SHADER_ADD_TEXTURE_BILINEAR(_shaders)
                 TGX_SHADER_REMOVE_TEXTURE_NEAREST(_shaders)                    
@@ -3138,6 +4561,14 @@ namespace tgx
                 TGX_SHADER_ADD_TEXTURE_NEAREST(_shaders)                    
                 TGX_SHADER_REMOVE_TEXTURE_BILINEAR(_shaders)
                 }
+            if (TGX_SHADER_HAS_TEXTURE_SUBDIV(_texture_quality))
+                {
+                TGX_SHADER_ADD_TEXTURE_SUBDIV(_shaders)
+                }
+            else
+                {
+                TGX_SHADER_REMOVE_TEXTURE_SUBDIV(_shaders)
+                }
             }
 
 
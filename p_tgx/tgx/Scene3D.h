@@ -0,0 +1,255 @@
+/**
+ * @file Scene3D.h
+ * Retained scene: hierarchy of nodes with meshes and a bounding volume hierarchy for frustum culling.
+ */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _TGX_SCENE3D_H_
+#define _TGX_SCENE3D_H_
+
+// only C++, no plain C
+#ifdef __cplusplus
+
+
+#include "Misc.h"
+#include "Vec3.h"
+#include "Box3.h"
+#include "Mat4.h"
+#include "Color.h"
+#include "Mesh3D.h"
+
+#include <stdint.h>
+
+
+/** Maximum number of scene nodes referenced by a leaf of the bounding volume hierarchy. */
+#ifndef TGX_SCENE_BVH_LEAF_SIZE
+#define TGX_SCENE_BVH_LEAF_SIZE 4
+#endif
+
+
+namespace tgx
+{
+
+
+    /**
+    * Node of a `Scene3D`.
+    *
+    * A node has a transform relative to its parent and (optionally) a mesh drawn with this
+    * transform. The fields are managed through the methods of `Scene3D`.
+    */
+    template<typename color_t> struct SceneNode
+        {
+        fMat4 local;                    ///< transform relative to the parent node (or to the world for a root node)
+        fMat4 world;                    ///< transform from model space to world space (computed by `Scene3D::update()`)
+        fBox3 box;                      ///< bounding box of the mesh (and of its chained meshes) in world space (computed by `Scene3D::update()`)
+        const Mesh3D<color_t>* mesh;    ///< mesh of the node (or nullptr for a group node)
+        RGBf color;                     ///< material used when the node does not use the mesh material
+        float ambiant_strength;         ///<
+        float diffuse_strength;         ///<
+        float specular_strength;        ///<
+        int specular_exponent;          ///<
+        int parent;                     ///< index of the parent node (-1 for a root node)
+        uint8_t flags;                  ///< SCENE_xxx flags
+
+        static constexpr uint8_t SCENE_VISIBLE = 1;         ///< node is visible (set by the user)
+        static constexpr uint8_t SCENE_SHOWN = 2;           ///< node and all its ancestors are visible (computed)
+        static constexpr uint8_t SCENE_DIRTY = 4;           ///< local transform changed since the last update
+        static constexpr uint8_t SCENE_MOVED = 8;           ///< world transform changed during the current update
+        static constexpr uint8_t SCENE_CHAINED = 16;        ///< draw the chained meshes
+        static constexpr uint8_t SCENE_MESH_MATERIAL = 32;  ///< use the material of the mesh
+        static constexpr uint8_t SCENE_UNBOUNDED = 64;      ///< a mesh of the chain has no bounding box (the node is never culled)
+        };
+
+
+    /**
+    * Node of the bounding volume hierarchy of a `Scene3D`.
+    *
+    * Inner nodes have two children stored at consecutive indices `child` and `child + 1`. Leaves
+    * reference `count` scene nodes in the item list, starting at position `first`. The item list
+    * is stored in the `item` field of the same array: entry k of the list is `bvh[k].item`
+    * (it is unrelated to the tree node k).
+    */
+    struct SceneBVHNode
+        {
+        fBox3 box;          ///< bounding box of the subtree in world space
+        int child;          ///< index of the first child (-1 for a leaf)
+        uint16_t first;     ///< leaf: position of the first scene node in the item list
+        uint16_t count;     ///< leaf: number of scene nodes
+        uint16_t item;      ///< entry of the item list (index of a scene node)
+        };
+
+
+
+    /**
+    * Retained 3D scene for `Renderer3D::drawScene()`.
+    *
+    * A scene is a hierarchy of nodes, each node having a transform relative to its parent and
+    * (optionally) a mesh and a material. The world transforms and the world bounding boxes of
+    * the meshes are only recomputed when a transform changes, and the nodes with a mesh are
+    * grouped in a bounding volume hierarchy (BVH) of axis aligned boxes. `Renderer3D::drawScene()`
+    * tests the BVH against the view frustum so that a whole group of off-screen meshes is
+    * rejected with a single box test, without transforming their bounding boxes.
+    *
+    * @remark
+    * 1. No memory allocation is performed: the user provides the arrays for the nodes and for the BVH.
+    * 2. The parent of a node must be created before the node itself. Nodes cannot be removed, use
+    *    `setVisible()` to hide them or `clear()` to start again.
+    * 3. The bounding boxes of the meshes (`Mesh3D::bounding_box`) are used for culling: a mesh
+    *    without bounding box is never culled.
+    * 4. The BVH is rebuilt when nodes are added and refitted when transforms change: moving nodes
+    *    is cheap but a scene where most nodes move a lot may end up with a poor hierarchy. Call
+    *    `rebuild()` to force a full rebuild in this case.
+    */
+    template<typename color_t> class Scene3D
+        {
+
+        public:
+
+            /**
+            * Constructor. Create an empty scene.
+            *
+            * @param   nodes       array for the nodes of the scene.
+            * @param   bvh         array for the bounding volume hierarchy, with `2 * max_nodes` elements.
+            * @param   max_nodes   number of elements in the `nodes` array (at most 32767).
+            */
+            Scene3D(SceneNode<color_t>* nodes, SceneBVHNode* bvh, int max_nodes);
+
+
+            /**
+            * Remove all the nodes.
+            */
+            void clear();
+
+
+            /**
+            * Add a node to the scene.
+            *
+            * @param   mesh                    mesh of the node (or nullptr for a group node).
+            * @param   M                       transform relative to the parent node.
+            * @param   parent                  index of the parent node (or -1 for a root node).
+            * @param   draw_chained_meshes     true to also draw the meshes chained to `mesh`.
+            *
+            * @returns the index of the new node or -1 if the scene is full or the parent is invalid.
+            */
+            int addNode(const Mesh3D<color_t>* mesh, const fMat4& M, int parent = -1, bool draw_chained_meshes = true);
+
+
+            /**
+            * Return the number of nodes in the scene.
+            */
+            int nbNodes() const { return _nb_nodes; }
+
+
+            /**
+            * Return a node of the scene (0 <= index < nbNodes()).
+            */
+            const SceneNode<color_t>& node(int index) const { return _nodes[index]; }
+
+
+            /**
+            * Set the transform of a node relative to its parent. The node and all its descendants move.
+            */
+            void setTransform(int index, const fMat4& M);
+
+
+            /**
+            * Return the transform of a node relative to its parent.
+            */
+            const fMat4& getTransform(int index) const { return _nodes[index].local; }
+
+
+            /**
+            * Draw the mesh of a node with the given material instead of the material of the mesh.
+            */
+            void setMaterial(int index, RGBf color, float ambiantStrength, float diffuseStrength, float specularStrength, int specularExponent);
+
+
+            /**
+            * Draw the mesh of a node with the material of the mesh (default).
+            */
+            void useMeshMaterial(int index);
+
+
+            /**
+            * Show or hide a node (and all its descendants).
+            */
+            void setVisible(int index, bool visible);
+
+
+            /**
+            * Return true if the node is visible (its ancestors may still be hidden).
+            */
+            bool isVisible(int index) const { return ((_nodes[index].flags & SceneNode<color_t>::SCENE_VISIBLE) != 0); }
+
+
+            /**
+            * Bring the world transforms, the world bounding boxes and the BVH up to date.
+            *
+            * Only the nodes whose transform changed (and their descendants) are recomputed. Called
+            * automatically by `Renderer3D::drawScene()`.
+            */
+            void update();
+
+
+            /**
+            * Force a full rebuild of the BVH during the next update.
+            */
+            void rebuild() { _rebuild = true; }
+
+
+            /**
+            * Return the number of nodes of the BVH (0 if the scene has no mesh).
+            */
+            int nbBVHNodes() const { return _nb_bvh; }
+
+
+            /**
+            * Return a node of the BVH (0 <= index < nbBVHNodes()). Node 0 is the root.
+            */
+            const SceneBVHNode& bvhNode(int index) const { return _bvh[index]; }
+
+
+        private:
+
+            void _computeBox(SceneNode<color_t>& N);
+
+            void _buildBVH(int index, int first, int count, int depth);
+
+            void _refitBVH();
+
+            float _center(int item, int axis) const;
+
+            SceneNode<color_t>* _nodes;     // array of nodes
+            SceneBVHNode* _bvh;             // array of BVH nodes (2 * _max_nodes elements)
+            int _max_nodes;                 // capacity
+            int _nb_nodes;                  // number of nodes
+            int _nb_bvh;                    // number of BVH nodes
+            bool _dirty;                    // a transform or a visibility flag changed
+            bool _rebuild;                  // the BVH must be rebuilt
+        };
+
+
+}
+
+
+#include "Scene3D.inl"
+
+
+#endif
+
+#endif
+
+/** end of file */
+
@@ -0,0 +1,256 @@
+/** @file Scene3D.inl */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+#ifndef _TGX_SCENE3D_INL_
+#define _TGX_SCENE3D_INL_
+
+
+namespace tgx
+    {
+
+
+    template<typename color_t>
+    Scene3D<color_t>::Scene3D(SceneNode<color_t>* nodes, SceneBVHNode* bvh, int max_nodes) : _nodes(nodes), _bvh(bvh)
+        {
+        _max_nodes = ((nodes) && (bvh)) ? clamp(max_nodes, 0, 32767) : 0;
+        clear();
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::clear()
+        {
+        _nb_nodes = 0;
+        _nb_bvh = 0;
+        _dirty = false;
+        _rebuild = false;
+        }
+
+
+    template<typename color_t>
+    int Scene3D<color_t>::addNode(const Mesh3D<color_t>* mesh, const fMat4& M, int parent, bool draw_chained_meshes)
+        {
+        if ((_nb_nodes >= _max_nodes) || (parent < -1) || (parent >= _nb_nodes)) return -1;
+        SceneNode<color_t>& N = _nodes[_nb_nodes];
+        N.local = M;
+        N.world = M;
+        N.box = fBox3(1, -1, 1, -1, 1, -1); // empty
+        N.mesh = mesh;
+        N.color = RGBf(0.75f, 0.75f, 0.75f);
+        N.ambiant_strength = 0.15f;
+        N.diffuse_strength = 0.7f;
+        N.specular_strength = 0.5f;
+        N.specular_exponent = 16;
+        N.parent = parent;
+        N.flags = SceneNode<color_t>::SCENE_VISIBLE | SceneNode<color_t>::SCENE_DIRTY | SceneNode<color_t>::SCENE_MESH_MATERIAL
+                | ((draw_chained_meshes) ? SceneNode<color_t>::SCENE_CHAINED : 0);
+        _dirty = true;
+        if (mesh) _rebuild = true;
+        return _nb_nodes++;
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::setTransform(int index, const fMat4& M)
+        {
+        if ((index < 0) || (index >= _nb_nodes)) return;
+        _nodes[index].local = M;
+        _nodes[index].flags |= SceneNode<color_t>::SCENE_DIRTY;
+        _dirty = true;
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::setMaterial(int index, RGBf color, float ambiantStrength, float diffuseStrength, float specularStrength, int specularExponent)
+        {
+        if ((index < 0) || (index >= _nb_nodes)) return;
+        SceneNode<color_t>& N = _nodes[index];
+        N.color = color;
+        N.ambiant_strength = ambiantStrength;
+        N.diffuse_strength = diffuseStrength;
+        N.specular_strength = specularStrength;
+        N.specular_exponent = specularExponent;
+        N.flags &= ~SceneNode<color_t>::SCENE_MESH_MATERIAL;
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::useMeshMaterial(int index)
+        {
+        if ((index < 0) || (index >= _nb_nodes)) return;
+        _nodes[index].flags |= SceneNode<color_t>::SCENE_MESH_MATERIAL;
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::setVisible(int index, bool visible)
+        {
+        if ((index < 0) || (index >= _nb_nodes)) return;
+        if (visible) _nodes[index].flags |= SceneNode<color_t>::SCENE_VISIBLE; else _nodes[index].flags &= ~SceneNode<color_t>::SCENE_VISIBLE;
+        _dirty = true; // hidden nodes stay in the BVH, only the SCENE_SHOWN flags must be recomputed.
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::update()
+        {
+        if ((!_dirty) && (!_rebuild)) return;
+        bool refit = false;
+        // parents come before their children so a single pass is enough.
+        for (int i = 0; i < _nb_nodes; i++)
+            {
+            SceneNode<color_t>& N = _nodes[i];
+            const SceneNode<color_t>* P = (N.parent >= 0) ? _nodes + N.parent : nullptr;
+            const bool moved = ((N.flags & SceneNode<color_t>::SCENE_DIRTY) || ((P) && (P->flags & SceneNode<color_t>::SCENE_MOVED)));
+            N.flags &= ~(SceneNode<color_t>::SCENE_DIRTY | SceneNode<color_t>::SCENE_MOVED | SceneNode<color_t>::SCENE_SHOWN);
+            if (moved)
+                {
+                N.world = (P) ? (P->world * N.local) : N.local;
+                N.flags |= SceneNode<color_t>::SCENE_MOVED;
+                if (N.mesh) { _computeBox(N); refit = true; }
+                }
+            if ((N.flags & SceneNode<color_t>::SCENE_VISIBLE) && ((P == nullptr) || (P->flags & SceneNode<color_t>::SCENE_SHOWN))) N.flags |= SceneNode<color_t>::SCENE_SHOWN;
+            }
+        if (_rebuild)
+            {
+            int nb = 0;
+            for (int i = 0; i < _nb_nodes; i++)
+                {
+                if (_nodes[i].mesh) _bvh[nb++].item = (uint16_t)i;
+                }
+            _nb_bvh = 0;
+            if (nb > 0)
+                {
+                _nb_bvh = 1;
+                _buildBVH(0, 0, nb, 0);
+                }
+            }
+        else if (refit)
+            {
+            _refitBVH();
+            }
+        _dirty = false;
+        _rebuild = false;
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::_computeBox(SceneNode<color_t>& N)
+        {
+        N.flags &= ~SceneNode<color_t>::SCENE_UNBOUNDED;
+        N.box = fBox3(1, -1, 1, -1, 1, -1); // empty
+        const Mesh3D<color_t>* mesh = N.mesh;
+        while (mesh)
+            {
+            const fBox3& bb = mesh->bounding_box;
+            if ((bb.minX == 0) && (bb.maxX == 0) && (bb.minY == 0) && (bb.maxY == 0) && (bb.minZ == 0) && (bb.maxZ == 0))
+                { // no bounding box: never culled
+                N.flags |= SceneNode<color_t>::SCENE_UNBOUNDED;
+                N.box = fBox3(-1.0e30f, 1.0e30f, -1.0e30f, 1.0e30f, -1.0e30f, 1.0e30f);
+                return;
+                }
+            for (int k = 0; k < 8; k++)
+                {
+                const fVec3 P((k & 1) ? bb.maxX : bb.minX, (k & 2) ? bb.maxY : bb.minY, (k & 4) ? bb.maxZ : bb.minZ);
+                N.box |= fVec3(N.world.mult1(P));
+                }
+            mesh = (N.flags & SceneNode<color_t>::SCENE_CHAINED) ? mesh->next : nullptr;
+            }
+        }
+
+
+    template<typename color_t>
+    float Scene3D<color_t>::_center(int item, int axis) const
+        {
+        const fBox3& B = _nodes[_bvh[item].item].box;
+        switch (axis)
+            {
+            case 0: return (B.minX + B.maxX) * 0.5f;
+            case 1: return (B.minY + B.maxY) * 0.5f;
+            default: return (B.minZ + B.maxZ) * 0.5f;
+            }
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::_buildBVH(int index, int first, int count, int depth)
+        {
+        SceneBVHNode& B = _bvh[index];
+        B.box = _nodes[_bvh[first].item].box;
+        fBox3 C(fVec3(_center(first, 0), _center(first, 1), _center(first, 2))); // bounds of the box centers
+        for (int k = first + 1; k < first + count; k++)
+            {
+            B.box |= _nodes[_bvh[k].item].box;
+            C |= fVec3(_center(k, 0), _center(k, 1), _center(k, 2));
+            }
+        if ((count <= TGX_SCENE_BVH_LEAF_SIZE) || (depth >= 32))
+            {
+            B.child = -1;
+            B.first = (uint16_t)first;
+            B.count = (uint16_t)count;
+            return;
+            }
+        // split at the median of the box centers along the largest axis (quickselect).
+        const int axis = ((C.lx() >= C.ly()) && (C.lx() >= C.lz())) ? 0 : ((C.ly() >= C.lz()) ? 1 : 2);
+        const int mid = first + count / 2;
+        int lo = first, hi = first + count - 1;
+        while (lo < hi)
+            {
+            const float pivot = _center((lo + hi) / 2, axis);
+            int i = lo, j = hi;
+            while (i <= j)
+                {
+                while (_center(i, axis) < pivot) i++;
+                while (_center(j, axis) > pivot) j--;
+                if (i <= j)
+                    {
+                    const uint16_t t = _bvh[i].item; _bvh[i].item = _bvh[j].item; _bvh[j].item = t;
+                    i++; j--;
+                    }
+                }
+            if (mid <= j) hi = j; else if (mid >= i) lo = i; else break;
+            }
+        const int child = _nb_bvh;
+        _nb_bvh += 2;
+        B.child = child;
+        _buildBVH(child, first, mid - first, depth + 1);
+        _buildBVH(child + 1, mid, first + count - mid, depth + 1);
+        }
+
+
+    template<typename color_t>
+    void Scene3D<color_t>::_refitBVH()
+        {
+        // children are always stored after their parent.
+        for (int i = _nb_bvh - 1; i >= 0; i--)
+            {
+            SceneBVHNode& B = _bvh[i];
+            if (B.child < 0)
+                {
+                B.box = _nodes[_bvh[B.first].item].box;
+                for (int k = B.first + 1; k < B.first + B.count; k++) B.box |= _nodes[_bvh[k].item].box;
+                }
+            else
+                {
+                B.box = _bvh[B.child].box | _bvh[B.child + 1].box;
+                }
+            }
+        }
+
+
+    }
+
+#endif
+
+/** end of file */
@@ -33,6 +33,7 @@
 #include "Color.h"
 
 #include <stdint.h>
+#include <string.h>
 
 namespace tgx
 {
@@ -58,6 +59,9 @@ namespace tgx
         SHADER_NOTEXTURE = (1 << 7),            ///< disable texture mapping
         SHADER_TEXTURE = (1 << 8),              ///< enable texture mapping
 
+        // Optional texture quality flag: perspective correction computed every TGX_TEXTURE_SUBDIV_SPAN pixels (instead of every pixel)
+        SHADER_TEXTURE_SUBDIV = (1 << 9),       ///< use span subdivision for perspective correct texturing (no per pixel division, slightly less accurate)
+
         // Shaders for texture quality: nearest, bilinear
         SHADER_TEXTURE_NEAREST = (1 << 11),     ///< use point sampling texture mapping
         SHADER_TEXTURE_BILINEAR = (1 << 12),    ///< use bilinear texture sampling
@@ -89,7 +93,7 @@ namespace tgx
     #define TGX_SHADER_MASK_ZBUFFER         (SHADER_NOZBUFFER | SHADER_ZBUFFER)
     #define TGX_SHADER_MASK_SHADING         (SHADER_FLAT | SHADER_GOURAUD)
     #define TGX_SHADER_MASK_TEXTURE         (SHADER_NOTEXTURE | SHADER_TEXTURE)
-    #define TGX_SHADER_MASK_TEXTURE_QUALITY (SHADER_TEXTURE_BILINEAR | SHADER_TEXTURE_NEAREST)
+    #define TGX_SHADER_MASK_TEXTURE_QUALITY (SHADER_TEXTURE_BILINEAR | SHADER_TEXTURE_NEAREST | SHADER_TEXTURE_SUBDIV)
     #define TGX_SHADER_MASK_TEXTURE_MODE    (SHADER_TEXTURE_WRAP_POW2 | SHADER_TEXTURE_CLAMP)
     #define TGX_SHADER_MASK_ALL             (TGX_SHADER_MASK_PROJECTION | TGX_SHADER_MASK_ZBUFFER | TGX_SHADER_MASK_SHADING | TGX_SHADER_MASK_TEXTURE | TGX_SHADER_MASK_TEXTURE_QUALITY | TGX_SHADER_MASK_TEXTURE_MODE)
 
@@ -111,6 +115,7 @@ namespace tgx
     #define TGX_SHADER_HAS_TEXTURE_BILINEAR(shader_type) (TGX_SHADER_HAS_ONE_FLAG(shader_type , SHADER_TEXTURE_BILINEAR))
     #define TGX_SHADER_HAS_TEXTURE_WRAP_POW2(shader_type) (TGX_SHADER_HAS_ONE_FLAG(shader_type , SHADER_TEXTURE_WRAP_POW2))
     #define TGX_SHADER_HAS_TEXTURE_CLAMP(shader_type) (TGX_SHADER_HAS_ONE_FLAG(shader_type , SHADER_TEXTURE_CLAMP))
+    #define TGX_SHADER_HAS_TEXTURE_SUBDIV(shader_type) (TGX_SHADER_HAS_ONE_FLAG(shader_type , SHADER_TEXTURE_SUBDIV))
 
     #define TGX_SHADER_REMOVE_PERSPECTIVE(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_PERSPECTIVE)
     #define TGX_SHADER_REMOVE_ORTHO(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_ORTHO)
@@ -124,6 +129,7 @@ namespace tgx
     #define TGX_SHADER_REMOVE_TEXTURE_BILINEAR(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_TEXTURE_BILINEAR)
     #define TGX_SHADER_REMOVE_TEXTURE_WRAP_POW2(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_TEXTURE_WRAP_POW2)
     #define TGX_SHADER_REMOVE_TEXTURE_CLAMP(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_TEXTURE_CLAMP)
+    #define TGX_SHADER_REMOVE_TEXTURE_SUBDIV(shader_type) TGX_SHADER_REMOVE_FLAGS(shader_type , SHADER_TEXTURE_SUBDIV)
 
     #define TGX_SHADER_ADD_PERSPECTIVE(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_PERSPECTIVE)
     #define TGX_SHADER_ADD_ORTHO(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_ORTHO)
@@ -137,6 +143,13 @@ namespace tgx
     #define TGX_SHADER_ADD_TEXTURE_BILINEAR(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_TEXTURE_BILINEAR)
     #define TGX_SHADER_ADD_TEXTURE_WRAP_POW2(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_TEXTURE_WRAP_POW2)
     #define TGX_SHADER_ADD_TEXTURE_CLAMP(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_TEXTURE_CLAMP)
+    #define TGX_SHADER_ADD_TEXTURE_SUBDIV(shader_type) TGX_SHADER_ADD_FLAGS(shader_type , SHADER_TEXTURE_SUBDIV)
+
+
+    /** Number of pixels between two exact perspective divisions when using SHADER_TEXTURE_SUBDIV (texture coordinates are interpolated linearly in between). */
+    #ifndef TGX_TEXTURE_SUBDIV_SPAN
+    #define TGX_TEXTURE_SUBDIV_SPAN 16
+    #endif
 
 
     //forward declaration    
@@ -158,6 +171,137 @@ namespace tgx
 
 
 
+    /** Minimum size (in pixels) of the clipped bounding box of a triangle for testing it against the coarse depth buffer (smaller triangles are cheaper to rasterize than to test). */
+    #ifndef TGX_HIZ_MIN_AREA
+    #define TGX_HIZ_MIN_AREA 1024
+    #endif
+
+
+    /**
+    * Coarse depth buffer (**for internal use**).
+    *
+    * Holds, for each block of 8x8 pixels of a z-buffer, the farthest depth stored in the block
+    * (i.e. the smallest z-buffer value). The shaders flag the blocks they write to as dirty and the
+    * value of a dirty block is recomputed from the z-buffer the next time it is needed. A fragment
+    * whose depth is not larger than the value of its block is hidden.
+    **/
+    template<typename ZBUFFER_t> struct HiZBuffer
+        {
+        ZBUFFER_t *         zmin;                   ///< farthest depth of each block (valid when the block is not dirty).
+        uint8_t *           dirty;                  ///< non zero if the block was written since its value was computed.
+        const ZBUFFER_t *   zbuf;                   ///< z-buffer the blocks refer to.
+        int                 lx, ly;                 ///< size (and stride) of the z-buffer.
+        int                 nx, ny;                 ///< number of blocks.
+        uint32_t            nb_meshes_culled;       ///< number of meshes rejected before any transformation.
+        uint32_t            nb_tris_tested;         ///< number of triangles tested.
+        uint32_t            nb_tris_culled;         ///< number of triangles rejected before rasterization.
+        uint32_t            nb_blocks_tested;       ///< number of blocks tested by the shaders.
+        uint32_t            nb_blocks_culled;       ///< number of blocks skipped by the shaders.
+        float               znear;                  ///< upper bound for the depth values of the triangle being drawn.
+        bool                test;                   ///< true if the shader should skip the blocks where the triangle being drawn is hidden.
+
+        /** Attach to a z-buffer of size lx x ly with unknown content: every block is dirty. */
+        void bind(const ZBUFFER_t* z, int zlx, int zly)
+            {
+            zbuf = z; lx = zlx; ly = zly;
+            nx = (lx + 7) >> 3;
+            ny = (ly + 7) >> 3;
+            memset(dirty, 1, nx * ny);
+            }
+
+        /** Attach to a z-buffer only if it is not the current one. */
+        TGX_INLINE void rebind(const ZBUFFER_t* z, int zlx, int zly)
+            {
+            if ((z != zbuf) || (zlx != lx) || (zly != ly)) bind(z, zlx, zly);
+            }
+
+        /** The z-buffer was just cleared. */
+        void clear()
+            {
+            memset(zmin, 0, nx * ny * sizeof(ZBUFFER_t));
+            memset(dirty, 0, nx * ny);
+            }
+
+        /** Flag the blocks containing pixels [x0, x1] of row y as dirty. */
+        TGX_INLINE void markDirty(int x0, int x1, int y)
+            {
+            uint8_t* d = dirty + (y >> 3) * nx;
+            for (int b = (x0 >> 3); b <= (x1 >> 3); b++) d[b] = 1;
+            }
+
+        /** Farthest depth in block (bx, by). */
+        TGX_INLINE ZBUFFER_t farthest(int bx, int by)
+            {
+            const int i = bx + by * nx;
+            if (dirty[i]) _update(bx, by, i);
+            return zmin[i];
+            }
+
+        /** Lower bound for the farthest depth in block (bx, by), without recomputing dirty blocks 
+            (depths only increase between clears so the last computed value remains a lower bound). */
+        TGX_INLINE ZBUFFER_t farthestBound(int bx, int by) const
+            {
+            return zmin[bx + by * nx];
+            }
+
+        /** Add a margin to a depth value to account for rounding errors in the shaders. */
+        static TGX_INLINE float margin(float z) 
+            { 
+            return z + 0.0001f * (z < 0 ? -z : z) + ((std::is_same<ZBUFFER_t, uint16_t>::value) ? 1.0f : 0.0f); 
+            }
+
+        /** Return true if depth z is hidden in every block intersecting the box [x0, x1]x[y0, y1] (clipped to the z-buffer). 
+            With refresh_all, every dirty block of the box is recomputed (instead of stopping at the first visible one) 
+            so that the shader can then test the blocks with farthestBound(). */
+        bool hidden(int x0, int x1, int y0, int y1, float z, bool refresh_all = false)
+            {
+            if (x0 < 0) x0 = 0;
+            if (y0 < 0) y0 = 0;
+            if (x1 >= lx) x1 = lx - 1;
+            if (y1 >= ly) y1 = ly - 1;
+            if ((x0 > x1) || (y0 > y1)) return false;
+            bool h = true;
+            for (int by = (y0 >> 3); by <= (y1 >> 3); by++)
+                for (int bx = (x0 >> 3); bx <= (x1 >> 3); bx++)
+                    if (z > (float)farthest(bx, by)) 
+                        {
+                        if (!refresh_all) return false;
+                        h = false;
+                        }
+            return h;
+            }
+
+        /** Called by the rasterizer before drawing a triangle covering the box (x, y, sx, sy) of the z-buffer 
+            whose vertices have depth z1, z2, z3: return true if the triangle is hidden and sets znear and test. 
+            The rasterizer only calls it for boxes of at least TGX_HIZ_MIN_AREA pixels. */
+        TGX_NOINLINE bool triangleHidden(int x, int y, int sx, int sy, float z1, float z2, float z3)
+            {
+            // depths are interpolated over the triangle so they are bounded by their value at the vertices.
+            znear = margin((z1 > z2) ? ((z1 > z3) ? z1 : z3) : ((z2 > z3) ? z2 : z3));
+            test = true;
+            nb_tris_tested++;
+            if (!hidden(x, x + sx - 1, y, y + sy - 1, znear, true)) return false;
+            nb_tris_culled++;
+            return true;
+            }
+
+        /** recompute the value of a block */
+        TGX_NOINLINE void _update(int bx, int by, int i)
+            {
+            const int x0 = bx << 3, y0 = by << 3;
+            const int x1 = (x0 + 8 < lx) ? (x0 + 8) : lx;
+            const int y1 = (y0 + 8 < ly) ? (y0 + 8) : ly;
+            const ZBUFFER_t* p = zbuf + y0 * lx;
+            ZBUFFER_t m = p[x0];
+            for (int y = y0; y < y1; y++, p += lx)
+                for (int x = x0; x < x1; x++) if (p[x] < m) m = p[x];
+            zmin[i] = m;
+            dirty[i] = 0;
+            }
+        };
+
+
+
     /**
     * Uniform parameters passed to the shader (**for internal use**).
     *
@@ -176,6 +320,9 @@ namespace tgx
         float                       wa;             ///< constants such that f(w) = wa * w + wb maps w (= -1/z) to float(0, 65535) for conversion to uint16_t
         float                       wb;             ///< constants such that f(w) = wa * w + wb maps w (= -1/z) to float(0, 65535) for conversion to uint16_t
         const BLEND_OP *            p_blend_op;     ///< pointer to the blending operator to use (only with the 2D shader)        
+        HiZBuffer<ZBUFFER_t> *      hiz;            ///< coarse depth buffer, bound to zbuf (or nullptr if not used).
+        uint32_t *                  fragments;      ///< counter of the fragments shaded by the 3D shaders (or nullptr if not used).
+        int32_t                     tile_x;         ///< x position of the tile in the image during tile rendering (0 otherwise), see Renderer3D::endTiles().
         };
 
 
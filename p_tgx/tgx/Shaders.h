@@ -27,6 +27,8 @@
 
 #include "ShaderParams.h"
 
+#include <utility>
+
 namespace tgx
 {
 
@@ -68,13 +70,83 @@ namespace tgx
         }
 
 
+    /**
+    * Return ceil(-O / dx): the first pixel of the row on the inner side of an edge with dx > 0 
+    * (negative if the edge is to the left of the start of the row).
+    **/
+    TGX_INLINE inline int32_t shader_edge_start(const int32_t O, const int32_t dx)
+        {
+        int32_t q = O / dx;
+        if (q * dx > O) q--;  // floor division
+        return -q;
+        }
+
+
+    /**
+    * Incremental edge stepping (for an edge with dx > 0): return t = ceil(-O / dx), the first 
+    * pixel of the row on the inner side of the edge, and mq = -floor(dy / dx) such that 
+    * t + mq or t + mq - 1 is the value for the next row (see shader_edge_step()).
+    **/
+    TGX_INLINE inline void shader_edge_init(const int32_t O, const int32_t dx, const int32_t dy, int32_t& t, int32_t& mq)
+        {
+        t = shader_edge_start(O, dx);
+        int32_t q = dy / dx;
+        if (q * dx > dy) q--;
+        mq = -q;
+        }
+
+
+    /**
+    * Incremental edge stepping: update t computed with shader_edge_init() once O has been 
+    * moved to the next row. 
+    **/
+    TGX_INLINE inline void shader_edge_step(int32_t& t, const int32_t O, const int32_t dx, const int32_t mq)
+        {
+        t += mq;
+        if (O + (t - 1) * dx >= 0) t--;
+        }
+
+
+    /**
+    * Round an (already scaled) float to a fixed point value.
+    **/
+    TGX_INLINE inline int32_t shader_fixed(float v)
+        {
+        return (int32_t)((v >= 0.0f) ? (v + 0.5f) : (v - 0.5f));
+        }
+
+
+    /**
+    * Convert a texture coordinate (in texels) to 16.16 fixed point, clamped so that differences do not overflow.
+    **/
+    TGX_INLINE inline int32_t texcoord_to_fixed16(float v)
+        {
+        return (int32_t)(((v < -16383.0f) ? -16383.0f : ((v > 16383.0f) ? 16383.0f : v)) * 65536.0f);
+        }
+
+
     /**
     * UBER-SHADER for all 3D rendering variants.
     * Uses compile-time flags to generate optimized code for each specific case.
+    * 
+    * When TEXTURE_SUBDIV is set (perspective texturing only), the perspective division is computed 
+    * every TGX_TEXTURE_SUBDIV_SPAN pixels along the scanline (from the start of the span) and the 
+    * texture coordinates are interpolated linearly in 16.16 fixed point in between.
+    * 
+    * When drawing a tile (data.tile_x > 0), the varyings of a span clipped by the left of the tile 
+    * are stepped from where the span starts in the image so the tile gets the same pixels as when
+    * the whole image is drawn at once. 
+    * 
+    * No division is performed per pixel or per scanline: the first pixel of each scanline is found by 
+    * incremental edge stepping and the Gouraud varyings are stepped in fixed point (barycentric weights 
+    * in 8.24 for the color interpolation, color multipliers in 10.22 with texturing). Compared to the 
+    * exact per pixel division, the Gouraud color may differ by one unit (of the color channel, or of 
+    * the 0..256 multiplier applied to the texel) on a few pixels. Depth and texture coordinates are 
+    * stepped in float, as before.
     **/
     template<typename color_t, typename ZBUFFER_t,
              bool USE_ZBUFFER, bool USE_GOURAUD, bool USE_TEXTURE,
-             bool USE_ORTHO, bool TEXTURE_BILINEAR, bool TEXTURE_WRAP>
+             bool USE_ORTHO, bool TEXTURE_BILINEAR, bool TEXTURE_WRAP, bool TEXTURE_SUBDIV = false>
     void uber_shader(const int32_t oox, const int32_t ooy, const int32_t lx, const int32_t ly,
         const int32_t dx1, const int32_t dy1, int32_t O1, const RasterizerVec4& fP1,
         const int32_t dx2, const int32_t dy2, int32_t O2, const RasterizerVec4& fP2,
@@ -90,17 +162,23 @@ namespace tgx
         const int32_t E = ((pa == 0) ? 1 : 0);
         const int32_t aera = pa + E;
 
+        static_assert((!TEXTURE_SUBDIV) || (USE_TEXTURE && !USE_ORTHO), "span subdivision is only for perspective texturing");
+
         // --- Z-Buffer setup ---
         ZBUFFER_t* zbuf = nullptr;
         int32_t zstride = 0;
         float wa = 0.0f, wb = 0.0f;
         float fP1a_z = 0.0f, fP2a_z = 0.0f, fP3a_z = 0.0f;
         float dw_z = 0.0f;
+        HiZBuffer<ZBUFFER_t>* hiz = nullptr;  // coarse depth buffer
+        int32_t yy = ooy;                       // current row (for the coarse depth buffer)
+        uint32_t* const fragments = data.fragments; // counter of shaded fragments (overdraw statistics)
 
         if constexpr (USE_ZBUFFER)
             {
             zstride = data.im->lx();
             zbuf = data.zbuf + oox + (ooy * zstride);
+            hiz = data.hiz;
             wa = data.wa;
             wb = data.wb;
 
@@ -117,11 +195,13 @@ namespace tgx
         // --- Shading & Texturing setup ---
         color_t flat_color;
         color_t col1_g, col2_g, col3_g;
-        int shiftC = 0, aeraShifted = 0;
         int fPR = 0, fPG = 0, fPB = 0; // Flat color components
         int fP1R = 0, fP1G = 0, fP1B = 0; // Gouraud color components
         int fP21R = 0, fP21G = 0, fP21B = 0;
         int fP31R = 0, fP31G = 0, fP31B = 0;
+        float gws = 0.0f;                           // Gouraud: scale from edge functions to fixed point values 
+        int32_t gdW2 = 0, gdW3 = 0;                 // Gouraud (no texture): steps of the weights of vertices 2 and 3 (8.24)
+        int32_t gdR = 0, gdG = 0, gdB = 0;          // Gouraud (texture): steps of the color multipliers (10.22)
 
         float invaera_persp = 0.0f;
         float fP1a_p = 0.0f, fP2a_p = 0.0f, fP3a_p = 0.0f;
@@ -142,14 +222,19 @@ namespace tgx
                 fP1R = (int)(256 * cf1.R); fP1G = (int)(256 * cf1.G); fP1B = (int)(256 * cf1.B);
                 fP21R = (int)(256 * (cf2.R - cf1.R)); fP21G = (int)(256 * (cf2.G - cf1.G)); fP21B = (int)(256 * (cf2.B - cf1.B));
                 fP31R = (int)(256 * (cf3.R - cf1.R)); fP31G = (int)(256 * (cf3.G - cf1.G)); fP31B = (int)(256 * (cf3.B - cf1.B));
+                gws = 4194304.0f * fast_inv((float)aera);
+                gdR = shader_fixed(((float)dx2 * fP21R + (float)dx3 * fP31R) * gws);
+                gdG = shader_fixed(((float)dx2 * fP21G + (float)dx3 * fP31G) * gws);
+                gdB = shader_fixed(((float)dx2 * fP21B + (float)dx3 * fP31B) * gws);
                 }
             else
                 {
                 col1_g = (color_t)fP1.color;
                 col2_g = (color_t)fP2.color;
                 col3_g = (color_t)fP3.color;
-                shiftC = (aera > (1 << 22)) ? 10 : 0;
-                aeraShifted = aera >> shiftC;
+                gws = 16777216.0f * fast_inv((float)aera);
+                gdW2 = shader_fixed(dx2 * gws);
+                gdW3 = shader_fixed(dx3 * gws);
                 }
             }
         else // Flat shading
@@ -197,14 +282,24 @@ namespace tgx
             dty = ((T1.y * dx1) + (T2.y * dx2) + (T3.y * dx3));
             }
 
+        // --- Tile rendering: spans clipped by the left of the tile are interpolated from the left of the image ---
+        const bool tile_clip = (oox == 0) && (data.tile_x > 0);
+
+        // --- Incremental edge stepping, started on the first row where the edge clips the span ---
+        int32_t t1 = 0, mq1 = 0;
+        int32_t t2 = 0, mq2 = 0;
+        int32_t t3 = 0, mq3 = 0;
+        bool st1 = false, st2 = false, st3 = false;
+
         // --- Scanline iteration ---
         while ((uintptr_t)(buf) < end)
             {
             // --- Clipping and finding start x (bx) ---
             int32_t bx = 0;
             if (O1 < 0)
-                {
-                bx = (-O1 + dx1 - 1u) / dx1;
+                { // edge 1 always has dx1 > 0
+                if (!st1) { shader_edge_init(O1, dx1, dy1, t1, mq1); st1 = true; }
+                bx = t1;
                 }
             if (O2 < 0)
                 {
@@ -214,10 +309,12 @@ namespace tgx
                     const int32_t by = (-O2 + dy2 - 1u) / dy2;
                     O1 += (by * dy1); O2 += (by * dy2); O3 += (by * dy3);
                     buf += by * stride;
-                    if constexpr (USE_ZBUFFER) zbuf += by * zstride;
+                    if constexpr (USE_ZBUFFER) { zbuf += by * zstride; yy += by; }
+                    st1 = st2 = st3 = false;
                     continue;
                     }
-                bx = max(bx, (int32_t)((-O2 + dx2 - 1u) / dx2));
+                if (!st2) { shader_edge_init(O2, dx2, dy2, t2, mq2); st2 = true; }
+                bx = max(bx, t2);
                 }
             if (O3 < 0)
                 {
@@ -227,16 +324,25 @@ namespace tgx
                     const int32_t by = (-O3 + dy3 - 1u) / dy3;
                     O1 += (by * dy1); O2 += (by * dy2); O3 += (by * dy3);
                     buf += by * stride;
-                    if constexpr (USE_ZBUFFER) zbuf += by * zstride;
+                    if constexpr (USE_ZBUFFER) { zbuf += by * zstride; yy += by; }
+                    st1 = st2 = st3 = false;
                     continue;
                     }
-                bx = max(bx, (int32_t)((-O3 + dx3 - 1u) / dx3));
+                if (!st3) { shader_edge_init(O3, dx3, dy3, t3, mq3); st3 = true; }
+                bx = max(bx, t3);
                 }
 
             // --- Per-scanline setup ---
-            int32_t C1 = O1 + (dx1 * bx) + E;
-            int32_t C2 = O2 + (dx2 * bx);
-            int32_t C3 = O3 + (dx3 * bx);
+            int32_t sx = bx; // where the interpolation of the varying parameters starts
+            if ((tile_clip) && (bx == 0))
+                { // the span may start left of the tile: start where it would start when drawing the whole image
+                sx = max(-data.tile_x, shader_edge_start(O1, dx1));
+                if (dx2 > 0) sx = max(sx, shader_edge_start(O2, dx2));
+                if (dx3 > 0) sx = max(sx, shader_edge_start(O3, dx3));
+                }
+            int32_t C1 = O1 + (dx1 * sx) + E;
+            int32_t C2 = O2 + (dx2 * sx);
+            int32_t C3 = O3 + (dx3 * sx);
 
             float cw_z = 0.0f;
             if constexpr (USE_ZBUFFER)
@@ -250,7 +356,7 @@ namespace tgx
 
             float cw_p = 0.0f;
             float tx = 0.0f, ty = 0.0f;
-            if constexpr (USE_TEXTURE)
+            if constexpr (USE_TEXTURE && !TEXTURE_SUBDIV) // (the subdivision computes its own texture coords)
                 {
                 tx = ((T1.x * C1) + (T2.x * C2) + (T3.x * C3));
                 ty = ((T1.y * C1) + (T2.y * C2) + (T3.y * C3));
@@ -260,27 +366,106 @@ namespace tgx
                     }
                 }
 
+            int32_t gW2 = 0, gW3 = 0;       // Gouraud (no texture): weights of vertices 2 and 3 (8.24)
+            int32_t gR = 0, gG = 0, gB = 0; // Gouraud (texture): color multipliers (10.22), biased by 1/256 so that rounding never makes them negative
+            if constexpr (USE_GOURAUD)
+                {
+                if constexpr (USE_TEXTURE)
+                    {
+                    gR = (fP1R << 22) + (1 << 14) + shader_fixed(((float)C2 * fP21R + (float)C3 * fP31R) * gws);
+                    gG = (fP1G << 22) + (1 << 14) + shader_fixed(((float)C2 * fP21G + (float)C3 * fP31G) * gws);
+                    gB = (fP1B << 22) + (1 << 14) + shader_fixed(((float)C2 * fP21B + (float)C3 * fP31B) * gws);
+                    }
+                else
+                    {
+                    gW2 = shader_fixed(C2 * gws);
+                    gW3 = shader_fixed(C3 * gws);
+                    }
+                }
+
+            // --- Span subdivision: segments of TGX_TEXTURE_SUBDIV_SPAN pixels from the start of the span ---
+            const int32_t sub_x0 = sx;  // start of the span
+            int32_t sub_end = -1;       // end of the current segment
+            int32_t sub_u = 0, sub_v = 0, sub_du = 0, sub_dv = 0; // texture coords at bx and their steps (16.16 fixed point)
+            float sub_u1 = 0.0f, sub_v1 = 0.0f; // exact texture coords at sub_end
+
+            // --- Step to the start of the tile with the same additions as in the pixel loop ---
+            for (; sx < bx; sx++)
+                {
+                C2 += dx2;
+                C3 += dx3;
+                if constexpr (USE_GOURAUD)
+                    {
+                    if constexpr (USE_TEXTURE) { gR += gdR; gG += gdG; gB += gdB; }
+                    else { gW2 += gdW2; gW3 += gdW3; }
+                    }
+                if constexpr (USE_ZBUFFER) cw_z += dw_z;
+                if constexpr (USE_TEXTURE && !TEXTURE_SUBDIV)
+                    {
+                    tx += dtx;
+                    ty += dty;
+                    if constexpr (!USE_ORTHO) cw_p += dw_p;
+                    }
+                }
+
+            // --- Coarse depth buffer: test the block when entering it ---
+            // seg_end is the end of the span, or the start of the next block when the coarse depth 
+            // buffer is tested, so that the pixel loop has a single test on bx in both cases.
+            const int32_t bx_start = bx;
+            int32_t seg_end = lx;
+            bool written = false;
+            int32_t nb_shaded = 0;  // fragments shaded on this span
+            if constexpr (USE_ZBUFFER)
+                {
+                if ((hiz) && (hiz->test)) seg_end = bx;
+                }
+
             // --- Pixel loop ---
-            while ((bx < lx) && ((C2 | C3) >= 0))
+            while ((C2 | C3) >= 0)
                 {
+                if (bx >= seg_end)
+                    {
+                    if (bx >= lx) break; // end of the span
+                    if constexpr (USE_ZBUFFER)
+                        { // start of a block of the coarse depth buffer
+                        const int32_t x = oox + bx;
+                        seg_end = min(bx + 8 - (x & 7), lx);
+                        hiz->nb_blocks_tested++;
+                        if (hiz->znear <= (float)hiz->farthestBound(x >> 3, yy >> 3))
+                            { // the whole block is hidden: skip to the next one. 
+                            hiz->nb_blocks_culled++;
+                            const int32_t k = seg_end - bx;
+                            C2 += k * dx2;
+                            C3 += k * dx3;
+                            bx += k;
+                            cw_z += k * dw_z;
+                            if constexpr (USE_GOURAUD)
+                                {
+                                if constexpr (USE_TEXTURE) { gR += k * gdR; gG += k * gdG; gB += k * gdB; }
+                                else { gW2 += k * gdW2; gW3 += k * gdW3; }
+                                }
+                            if constexpr (USE_TEXTURE && !TEXTURE_SUBDIV)
+                                {
+                                tx += k * dtx;
+                                ty += k * dty;
+                                if constexpr (!USE_ORTHO) cw_p += k * dw_p;
+                                }
+                            if constexpr (TEXTURE_SUBDIV) sub_end = -1; // restart the subdivision at the next pixel drawn
+                            continue;
+                            }
+                        }
+                    }
+
                 bool z_pass = true;
                 if constexpr (USE_ZBUFFER)
                     {
                     ZBUFFER_t& W = zbuf[bx];
-                    ZBUFFER_t current_z;
-
-                    if constexpr (std::is_same<ZBUFFER_t, uint16_t>::value)
-                        {
-                         current_z = (USE_ORTHO) ? ((ZBUFFER_t)(cw_z * wa + wb)) : ((ZBUFFER_t)cw_z);
-                        }
-                    else
-                        {
-                         current_z = (ZBUFFER_t)cw_z;
-                        }
+                    const ZBUFFER_t current_z = (USE_ORTHO) ? ((ZBUFFER_t)(cw_z * wa + wb)) : ((ZBUFFER_t)cw_z); // (wa, wb) = (1, 0) for a float z-buffer without epochs
 
                     if (W < current_z)
                         {
                         W = current_z;
+                        written = true;
                         }
                     else
                         {
@@ -291,25 +476,94 @@ namespace tgx
                 if (z_pass)
                     {
                     color_t final_color;
+                    nb_shaded++;
 
                     if constexpr (USE_TEXTURE)
                         {
-                        float icw = 1.0f;
-                        if constexpr (!USE_ORTHO)
+                        int ttx, tty;
+                        float ax = 0.0f, ay = 0.0f;
+                        if constexpr (TEXTURE_SUBDIV)
                             {
-                            icw = fast_inv(cw_p);
+                            if (bx >= sub_end)
+                                { // enter the segment that contains bx. The segments do not depend on the pixels drawn 
+                                  // before (z-buffer, coarse depth buffer, tiles) and their ends are computed exactly. 
+                                const int32_t g = (bx - sub_x0) % TGX_TEXTURE_SUBDIV_SPAN; // position of bx in the segment
+                                float u0, v0;
+                                if (bx == sub_end)
+                                    { // continue from the end of the previous segment
+                                    u0 = sub_u1; 
+                                    v0 = sub_v1;
+                                    }
+                                else
+                                    {
+                                    const int32_t c2 = C2 - g * dx2, c3 = C3 - g * dx3, c1 = aera - c2 - c3;
+                                    const float icw = fast_inv((c1 * fP1a_p) + (c2 * fP2a_p) + (c3 * fP3a_p));
+                                    u0 = ((T1.x * c1) + (T2.x * c2) + (T3.x * c3)) * icw;
+                                    v0 = ((T1.y * c1) + (T2.y * c2) + (T3.y * c3)) * icw;
+                                    }
+                                // the segment ends at sub_end, the texture coords are interpolated up to the 
+                                // last pixel of the span if it comes first (inside the triangle, not clipped).
+                                const int32_t n = TGX_TEXTURE_SUBDIV_SPAN - g;
+                                int32_t m = n;
+                                if (C2 + m * dx2 < 0) m = C2 / (-dx2);
+                                if (C3 + m * dx3 < 0) m = min(m, C3 / (-dx3));
+                                sub_u = texcoord_to_fixed16(u0);
+                                sub_v = texcoord_to_fixed16(v0);
+                                sub_du = 0;
+                                sub_dv = 0;
+                                if (g + m > 0)
+                                    {
+                                    const int32_t c2 = C2 + m * dx2, c3 = C3 + m * dx3, c1 = aera - c2 - c3;
+                                    const float icw1 = fast_inv((c1 * fP1a_p) + (c2 * fP2a_p) + (c3 * fP3a_p));
+                                    sub_u1 = ((T1.x * c1) + (T2.x * c2) + (T3.x * c3)) * icw1;
+                                    sub_v1 = ((T1.y * c1) + (T2.y * c2) + (T3.y * c3)) * icw1;
+                                    const float in = fast_inv((float)(g + m));
+                                    sub_du = (int32_t)((texcoord_to_fixed16(sub_u1) - sub_u) * in);
+                                    sub_dv = (int32_t)((texcoord_to_fixed16(sub_v1) - sub_v) * in);
+                                    sub_u += g * sub_du;
+                                    sub_v += g * sub_dv;
+                                    }
+                                sub_end = bx + n;
+                                }
+                            if constexpr (TEXTURE_BILINEAR)
+                                { // floor, as lfloorf() in the exact path
+                                ttx = (sub_u >> 16);
+                                tty = (sub_v >> 16);
+                                ax = (sub_u & 0xFFFF) * (1.0f / 65536.0f);
+                                ay = (sub_v & 0xFFFF) * (1.0f / 65536.0f);
+                                }
+                            else
+                                { // truncate toward zero, as (int) in the exact path
+                                ttx = sub_u / 65536;
+                                tty = sub_v / 65536;
+                                }
+                            }
+                        else
+                            {
+                            float icw = 1.0f;
+                            if constexpr (!USE_ORTHO)
+                                {
+                                icw = fast_inv(cw_p);
+                                }
+
+                            const float xx = tx * icw;
+                            const float yy = ty * icw;
+                            if constexpr (TEXTURE_BILINEAR)
+                                {
+                                ttx = lfloorf(xx);
+                                tty = lfloorf(yy);
+                                ax = xx - ttx;
+                                ay = yy - tty;
+                                }
+                            else
+                                {
+                                ttx = (int)(xx);
+                                tty = (int)(yy);
+                                }
                             }
-
-                        float xx = tx * icw;
-                        float yy = ty * icw;
 
                         if constexpr (TEXTURE_BILINEAR)
                             {
-                            const int ttx = lfloorf(xx);
-                            const int tty = lfloorf(yy);
-                            const float ax = xx - ttx;
-                            const float ay = yy - tty;
-
                             const int minx = TEXTURE_WRAP ? (ttx & texsize_x_mm) : shaderclip(ttx, texsize_x_mm);
                             const int maxx = TEXTURE_WRAP ? ((ttx + 1) & texsize_x_mm) : shaderclip(ttx + 1, texsize_x_mm);
                             const int miny = (TEXTURE_WRAP ? (tty & texsize_y_mm) : shaderclip(tty, texsize_y_mm)) * texstride;
@@ -319,17 +573,14 @@ namespace tgx
                             }
                         else // Nearest neighbor
                             {
-                            const int ttx = TEXTURE_WRAP ? ((int)(xx)) & texsize_x_mm : shaderclip((int)(xx), texsize_x_mm);
-                            const int tty = TEXTURE_WRAP ? ((int)(yy)) & texsize_y_mm : shaderclip((int)(yy), texsize_y_mm);
+                            ttx = TEXTURE_WRAP ? (ttx & texsize_x_mm) : shaderclip(ttx, texsize_x_mm);
+                            tty = TEXTURE_WRAP ? (tty & texsize_y_mm) : shaderclip(tty, texsize_y_mm);
                             final_color = tex[ttx + tty * texstride];
                             }
 
                         if constexpr (USE_GOURAUD)
                             {
-                            const int r = fP1R + ((C2 * fP21R + C3 * fP31R) / aera);
-                            const int g = fP1G + ((C2 * fP21G + C3 * fP31G) / aera);
-                            const int b = fP1B + ((C2 * fP21B + C3 * fP31B) / aera);
-                            final_color.mult256(r, g, b);
+                            final_color.mult256(gR >> 22, gG >> 22, gB >> 22);
                             }
                         else // Flat
                             {
@@ -340,7 +591,7 @@ namespace tgx
                         {
                         if constexpr (USE_GOURAUD)
                             {
-                            final_color = interpolateColorsTriangle(col2_g, C2 >> shiftC, col3_g, C3 >> shiftC, col1_g, aeraShifted);
+                            final_color = interpolateColorsTriangle(col2_g, gW2 >> 8, col3_g, gW3 >> 8, col1_g, 65536);
                             }
                         else // Flat
                             {
@@ -355,230 +606,160 @@ namespace tgx
                 C3 += dx3;
                 bx++;
 
+                if constexpr (USE_GOURAUD)
+                    {
+                    if constexpr (USE_TEXTURE) { gR += gdR; gG += gdG; gB += gdB; }
+                    else { gW2 += gdW2; gW3 += gdW3; }
+                    }
+
                 if constexpr (USE_ZBUFFER) cw_z += dw_z;
 
                 if constexpr (USE_TEXTURE)
                     {
-                    tx += dtx;
-                    ty += dty;
-                    if constexpr (!USE_ORTHO) cw_p += dw_p;
+                    if constexpr (TEXTURE_SUBDIV)
+                        {
+                        sub_u += sub_du;
+                        sub_v += sub_dv;
+                        }
+                    else
+                        {
+                        tx += dtx;
+                        ty += dty;
+                        if constexpr (!USE_ORTHO) cw_p += dw_p;
+                        }
                     }
                 }
 
+            if constexpr (USE_ZBUFFER)
+                {
+                if ((hiz) && (written)) hiz->markDirty(oox + bx_start, oox + bx - 1, yy);
+                }
+            if (fragments) *fragments += nb_shaded;
+
             // --- Increment for next scanline ---
             O1 += dy1;
             O2 += dy2;
             O3 += dy3;
+            if (st1) shader_edge_step(t1, O1, dx1, mq1);
+            if (st2) shader_edge_step(t2, O2, dx2, mq2);
+            if (st3) shader_edge_step(t3, O3, dx3, mq3);
             buf += stride;
-            if constexpr (USE_ZBUFFER) zbuf += zstride;
+            if constexpr (USE_ZBUFFER) { zbuf += zstride; yy++; }
             }
         }
 
 
     /**
-    * META-Shader THAT DISPATCH TO THE CORRECT Shader ABOVE (IF ENABLED).
+    * Signature of the triangle shaders called by rasterizeTriangle() for Renderer3D.
     **/
-    template<int SHADER_FLAGS_ENABLED, typename color_t, typename ZBUFFER_t> void shader_select(const int32_t oox, const int32_t ooy, const int32_t lx, const int32_t ly,
+    template<typename color_t, typename ZBUFFER_t>
+    using ShaderFunction = void (*)(const int32_t oox, const int32_t ooy, const int32_t lx, const int32_t ly,
         const int32_t dx1, const int32_t dy1, int32_t O1, const RasterizerVec4& fP1,
         const int32_t dx2, const int32_t dy2, int32_t O2, const RasterizerVec4& fP2,
         const int32_t dx3, const int32_t dy3, int32_t O3, const RasterizerVec4& fP3,
-        const RasterizerParams<color_t, color_t, ZBUFFER_t> & data)
+        const RasterizerParams<color_t, color_t, ZBUFFER_t>& data);
+
+
+    /** Bits of the packed key that selects an uber_shader variant in the dispatch table. */
+    #define TGX_SHADER_KEY_ZBUFFER          1
+    #define TGX_SHADER_KEY_ORTHO            2
+    #define TGX_SHADER_KEY_TEXTURE          4
+    #define TGX_SHADER_KEY_GOURAUD          8
+    #define TGX_SHADER_KEY_BILINEAR         16
+    #define TGX_SHADER_KEY_WRAP             32
+    #define TGX_SHADER_KEY_SUBDIV           64
+    #define TGX_SHADER_KEY_COUNT            128
+
+
+    /**
+    * Return the key of the uber_shader variant used to draw triangles with the given shader flags, 
+    * or -1 if no variant compatible with these flags is enabled in SHADER_FLAGS_ENABLED.
+    * 
+    * When a flag is requested but not enabled, falls back to the other option (texture clamping 
+    * -> wrapping, bilinear -> nearest, subdivided -> exact perspective texturing) if it is enabled. 
+    **/
+    template<int SHADER_FLAGS_ENABLED> constexpr int shader_key(const int raster_type)
         {
-        int raster_type = data.shader_type;
-        if (TGX_SHADER_HAS_ZBUFFER(SHADER_FLAGS_ENABLED) && (TGX_SHADER_HAS_ZBUFFER(raster_type)))
-            { // USING ZBUFFER
-            if (TGX_SHADER_HAS_ORTHO(SHADER_FLAGS_ENABLED) && (TGX_SHADER_HAS_ORTHO(raster_type)))
-                { // USING ORTHOGRAPHIC PROJECTION
-                if (TGX_SHADER_HAS_TEXTURE(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE(raster_type))
-                    { // Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        { // Gouraud
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, true, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, true, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, true, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        { // Flat
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, true, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, true, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, true, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    }
-                else if (TGX_SHADER_HAS_NOTEXTURE(SHADER_FLAGS_ENABLED))
-                    { // No Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        uber_shader<color_t, ZBUFFER_t, true, true, false, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        uber_shader<color_t, ZBUFFER_t, true, false, false, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    }
-                }
-            else if (TGX_SHADER_HAS_PERSPECTIVE(SHADER_FLAGS_ENABLED))
-                { // USING PERSPECTIVE PROJECTION
-                if (TGX_SHADER_HAS_TEXTURE(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE(raster_type))
-                    { // Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        { // Gouraud
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, false, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, false, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, true, true, false, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        { // Flat
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, false, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, false, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, true, false, true, false, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    }
-                else if (TGX_SHADER_HAS_NOTEXTURE(SHADER_FLAGS_ENABLED))
-                    { // No Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        uber_shader<color_t, ZBUFFER_t, true, true, false, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        uber_shader<color_t, ZBUFFER_t, true, false, false, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    }
-                }
-            }
-        else if (TGX_SHADER_HAS_NOZBUFFER(SHADER_FLAGS_ENABLED))
-            { // NOT USING Z-BUFFER
-            if (TGX_SHADER_HAS_ORTHO(SHADER_FLAGS_ENABLED) && (TGX_SHADER_HAS_ORTHO(raster_type)))
-                { // USING ORTHOGRAPHIC PROJECTION
-                if (TGX_SHADER_HAS_TEXTURE(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE(raster_type))
-                    { // Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        { // Gouraud
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, true, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, true, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, true, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        { // Flat
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, true, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, true, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, true, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    }
-                else if (TGX_SHADER_HAS_NOTEXTURE(SHADER_FLAGS_ENABLED))
-                    { // No Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        uber_shader<color_t, ZBUFFER_t, false, true, false, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        uber_shader<color_t, ZBUFFER_t, false, false, false, true, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    }
-                }
-            else if (TGX_SHADER_HAS_PERSPECTIVE(SHADER_FLAGS_ENABLED))
-                { // USING PERSPECTIVE PROJECTION
-                if (TGX_SHADER_HAS_TEXTURE(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE(raster_type))
-                    { // Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        { // Gouraud
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, false, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, false, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, true, true, false, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        { // Flat
-                        if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type))
-                            { // Bilinear
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, false, true, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, false, true, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        else if (TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED))
-                            { // Nearest
-                            if (TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            else if (TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED))
-                                uber_shader<color_t, ZBUFFER_t, false, false, true, false, false, true>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                            }
-                        }
-                    }
-                else if (TGX_SHADER_HAS_NOTEXTURE(SHADER_FLAGS_ENABLED))
-                    { // No Texture
-                    if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type))
-                        uber_shader<color_t, ZBUFFER_t, false, true, false, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    else if (TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED))
-                        uber_shader<color_t, ZBUFFER_t, false, false, false, false, false, false>(oox, ooy, lx, ly, dx1, dy1, O1, fP1, dx2, dy2, O2, fP2, dx3, dy3, O3, fP3, data);
-                    }
+        int key = 0;
+        if (TGX_SHADER_HAS_ZBUFFER(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_ZBUFFER(raster_type)) key |= TGX_SHADER_KEY_ZBUFFER;
+        else if (!TGX_SHADER_HAS_NOZBUFFER(SHADER_FLAGS_ENABLED)) return -1;
+        if (TGX_SHADER_HAS_ORTHO(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_ORTHO(raster_type)) key |= TGX_SHADER_KEY_ORTHO;
+        else if (!TGX_SHADER_HAS_PERSPECTIVE(SHADER_FLAGS_ENABLED)) return -1;
+        if (TGX_SHADER_HAS_GOURAUD(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_GOURAUD(raster_type)) key |= TGX_SHADER_KEY_GOURAUD;
+        else if (!TGX_SHADER_HAS_FLAT(SHADER_FLAGS_ENABLED)) return -1;
+        if (TGX_SHADER_HAS_TEXTURE(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE(raster_type))
+            {
+            key |= TGX_SHADER_KEY_TEXTURE;
+            if (TGX_SHADER_HAS_TEXTURE_BILINEAR(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_BILINEAR(raster_type)) key |= TGX_SHADER_KEY_BILINEAR;
+            else if (!TGX_SHADER_HAS_TEXTURE_NEAREST(SHADER_FLAGS_ENABLED)) return -1;
+            if (!(TGX_SHADER_HAS_TEXTURE_CLAMP(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_CLAMP(raster_type)))
+                {
+                if (!TGX_SHADER_HAS_TEXTURE_WRAP_POW2(SHADER_FLAGS_ENABLED)) return -1;
+                key |= TGX_SHADER_KEY_WRAP;
                 }
+            if ((!(key & TGX_SHADER_KEY_ORTHO)) && TGX_SHADER_HAS_TEXTURE_SUBDIV(SHADER_FLAGS_ENABLED) && TGX_SHADER_HAS_TEXTURE_SUBDIV(raster_type)) key |= TGX_SHADER_KEY_SUBDIV;
             }
+        else if (!TGX_SHADER_HAS_NOTEXTURE(SHADER_FLAGS_ENABLED)) return -1;
+        return key;
+        }
+
+
+    /**
+    * Return true if shader_key() may return key, i.e. if the corresponding variant must be instantiated.
+    **/
+    template<int SHADER_FLAGS_ENABLED> constexpr bool shader_key_used(const int key)
+        {
+        const int raster_type = ((key & TGX_SHADER_KEY_ZBUFFER) ? (int)SHADER_ZBUFFER : (int)SHADER_NOZBUFFER)
+                              | ((key & TGX_SHADER_KEY_ORTHO) ? (int)SHADER_ORTHO : (int)SHADER_PERSPECTIVE)
+                              | ((key & TGX_SHADER_KEY_TEXTURE) ? (int)SHADER_TEXTURE : (int)SHADER_NOTEXTURE)
+                              | ((key & TGX_SHADER_KEY_GOURAUD) ? (int)SHADER_GOURAUD : (int)SHADER_FLAT)
+                              | ((key & TGX_SHADER_KEY_BILINEAR) ? (int)SHADER_TEXTURE_BILINEAR : (int)SHADER_TEXTURE_NEAREST)
+                              | ((key & TGX_SHADER_KEY_WRAP) ? (int)SHADER_TEXTURE_WRAP_POW2 : (int)SHADER_TEXTURE_CLAMP)
+                              | ((key & TGX_SHADER_KEY_SUBDIV) ? (int)SHADER_TEXTURE_SUBDIV : 0);
+        return (shader_key<SHADER_FLAGS_ENABLED>(raster_type) == key);
+        }
+
+
+    /**
+    * Entry of the dispatch table: the uber_shader variant for a given key or nullptr if the key 
+    * is not used (in which case the variant is not instantiated).
+    **/
+    template<int SHADER_FLAGS_ENABLED, typename color_t, typename ZBUFFER_t, int KEY>
+    constexpr ShaderFunction<color_t, ZBUFFER_t> shader_table_entry()
+        {
+        if constexpr (shader_key_used<SHADER_FLAGS_ENABLED>(KEY))
+            return &uber_shader<color_t, ZBUFFER_t,
+                                ((KEY & TGX_SHADER_KEY_ZBUFFER) != 0), ((KEY & TGX_SHADER_KEY_GOURAUD) != 0), ((KEY & TGX_SHADER_KEY_TEXTURE) != 0),
+                                ((KEY & TGX_SHADER_KEY_ORTHO) != 0), ((KEY & TGX_SHADER_KEY_BILINEAR) != 0), ((KEY & TGX_SHADER_KEY_WRAP) != 0),
+                                ((KEY & TGX_SHADER_KEY_SUBDIV) != 0)>;
+        else
+            return nullptr;
+        }
+
+
+    /**
+    * Dispatch table of the uber_shader variants enabled by SHADER_FLAGS_ENABLED, indexed by shader_key(). 
+    * Generated at compile time and stored in flash.
+    **/
+    template<int SHADER_FLAGS_ENABLED, typename color_t, typename ZBUFFER_t, typename KEYS = std::make_integer_sequence<int, TGX_SHADER_KEY_COUNT>>
+    struct ShaderTable;
+
+    template<int SHADER_FLAGS_ENABLED, typename color_t, typename ZBUFFER_t, int... KEYS>
+    struct ShaderTable<SHADER_FLAGS_ENABLED, color_t, ZBUFFER_t, std::integer_sequence<int, KEYS...>>
+        {
+        static constexpr ShaderFunction<color_t, ZBUFFER_t> table[TGX_SHADER_KEY_COUNT] = { shader_table_entry<SHADER_FLAGS_ENABLED, color_t, ZBUFFER_t, KEYS>()... };
+        };
+
+
+    /**
+    * Return the shader to use for triangles drawn with the given shader flags (nullptr if none is enabled).
+    * Called once per drawing call (not per triangle) by Renderer3D.
+    **/
+    template<int SHADER_FLAGS_ENABLED, typename color_t, typename ZBUFFER_t>
+    TGX_INLINE inline ShaderFunction<color_t, ZBUFFER_t> shader_lookup(const int raster_type)
+        {
+        const int key = shader_key<SHADER_FLAGS_ENABLED>(raster_type);
+        return ((key < 0) ? nullptr : ShaderTable<SHADER_FLAGS_ENABLED, color_t, ZBUFFER_t>::table[key]);
         }
 
 
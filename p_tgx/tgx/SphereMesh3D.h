@@ -0,0 +1,192 @@
+/**
+ * @file SphereMesh3D.h
+ * Sphere tessellations as `Mesh3D` objects and their cache for `Renderer3D::drawSphere()`.
+ */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _TGX_SPHEREMESH3D_H_
+#define _TGX_SPHEREMESH3D_H_
+
+// only C++, no plain C
+#ifdef __cplusplus
+
+
+#include "Misc.h"
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Color.h"
+#include "Mesh3D.h"
+
+#include <stdint.h>
+
+
+namespace tgx
+{
+
+
+    /** Number of vertices of the unit sphere mesh with the given tessellation (the normals are the vertices). */
+    constexpr int sphereMeshNbVertices(int nb_sectors, int nb_stacks) { return nb_sectors * (nb_stacks - 1) + 2; }
+
+    /** Number of texture coords of the unit sphere mesh with the given tessellation (0 if not textured). */
+    constexpr int sphereMeshNbTexcoords(int nb_sectors, int nb_stacks, bool textured) { return (textured) ? ((nb_sectors + 1) * (nb_stacks - 1) + 2) : 0; }
+
+    /** Size of the face array of the unit sphere mesh: one chain per stack, then the end tag. */
+    constexpr int sphereMeshLenFace(int nb_sectors, int nb_stacks, bool textured) { return 2 * (1 + (nb_sectors + 2) * ((textured) ? 3 : 2)) + (nb_stacks - 2) * (1 + (2 * nb_sectors + 2) * ((textured) ? 3 : 2)) + 1; }
+
+    /** Number of bytes used by `buildSphereMesh()` for the arrays of the unit sphere mesh with the given tessellation. */
+    constexpr int sphereMeshSize(int nb_sectors, int nb_stacks, bool textured) { return 12 * sphereMeshNbVertices(nb_sectors, nb_stacks) + 8 * sphereMeshNbTexcoords(nb_sectors, nb_stacks, textured) + 2 * sphereMeshLenFace(nb_sectors, nb_stacks, textured); }
+
+
+    /**
+    * Build the unit sphere (centered at the origin) as a `Mesh3D`, with the same tessellation,
+    * winding and texture mapping as `Renderer3D::drawSphere()`: `nb_stacks` stacks from the
+    * north pole (0,1,0) to the south pole and `nb_sectors` sectors around the Y axis.
+    *
+    * The vertex, texcoord and face arrays are written in `buffer` (the normal array is the vertex
+    * array). Each stack is a single chain of triangles so the mesh goes through the regular path
+    * of `Renderer3D::drawMesh()`. The texture pointer of the mesh is set to nullptr.
+    *
+    * @param   mesh            the mesh to fill.
+    * @param   nb_sectors      number of sectors in [3, 256].
+    * @param   nb_stacks       number of stacks (at least 3 and the mesh has at most 32767 vertices).
+    * @param   textured        true to create the texture coords.
+    * @param   buffer          memory for the arrays, aligned on 4 bytes.
+    * @param   buffer_size     size of the buffer in bytes, at least `sphereMeshSize(nb_sectors, nb_stacks, textured)`.
+    *
+    * @returns false (and the mesh is not modified) if the parameters are invalid or the buffer is too small.
+    */
+    template<typename color_t> bool buildSphereMesh(Mesh3D<color_t>* mesh, int nb_sectors, int nb_stacks, bool textured, void* buffer, int buffer_size);
+
+
+
+    /**
+    * Cache of sphere tessellations for `Renderer3D::drawSphere()` and `Renderer3D::drawAdaptativeSphere()`.
+    *
+    * Without a cache, each call to `drawSphere()` computes the vertices, normals and texture
+    * coords of the sphere with trigonometric functions and draws it triangle by triangle. With a
+    * cache set by `Renderer3D::setSphereCache()`, the tessellation is built once as a `Mesh3D`
+    * (see `buildSphereMesh()`) and the following draws with the same (sectors, stacks, textured)
+    * key use `drawMesh()`: vertex cache, frustum culling of the bounding box...
+    *
+    * The memory given to the constructor is split in slots of equal size, each one holding a
+    * tessellation. When all the slots are used, the least recently used one is rebuilt.
+    * Tessellations that do not fit in a slot are drawn without the cache. Since
+    * `drawAdaptativeSphere()` only uses a few levels for a given scene, a handful of slots
+    * is usually enough.
+    *
+    * Tessellations may also be generated ahead of time as constant meshes (e.g. in flash) with the
+    * host tool `host/mesh_sphere.cpp` and registered with `addStatic()`: they are never evicted and
+    * use no slot.
+    *
+    * @remark
+    * No memory allocation is performed: the user provides the buffer for the slots.
+    */
+    template<typename color_t> class SphereMeshCache
+        {
+
+        public:
+
+            static constexpr int MAX_SLOTS = 8;     ///< maximum number of slots
+            static constexpr int MAX_STATIC = 8;    ///< maximum number of static meshes
+
+
+            /**
+            * Constructor.
+            *
+            * @param   buffer          memory for the slots (may be nullptr to only use static meshes).
+            * @param   buffer_size     size of the buffer in bytes.
+            * @param   nb_slots        number of slots in [1, MAX_SLOTS]: each one gets `buffer_size / nb_slots` bytes.
+            */
+            SphereMeshCache(void* buffer, int buffer_size, int nb_slots = 4);
+
+
+            /**
+            * Register a constant mesh of the unit sphere for the key (nb_sectors, nb_stacks, textured).
+            *
+            * @returns false if mesh is nullptr or MAX_STATIC meshes are already registered.
+            */
+            bool addStatic(const Mesh3D<color_t>* mesh, int nb_sectors, int nb_stacks, bool textured);
+
+
+            /**
+            * Return the mesh of the unit sphere with the given tessellation: a static mesh, a slot
+            * already built or the least recently used slot rebuilt.
+            *
+            * @returns nullptr if the tessellation does not fit in a slot.
+            */
+            const Mesh3D<color_t>* get(int nb_sectors, int nb_stacks, bool textured);
+
+
+            /** Empty the slots (the static meshes are kept). */
+            void clear();
+
+
+            /** Return the size in bytes of a slot. */
+            int slotSize() const { return _slot_size; }
+
+
+            /** Return the number of calls to `get()` answered without building a mesh. */
+            uint32_t nbHits() const { return _hits; }
+
+
+            /** Return the number of meshes built by `get()`. */
+            uint32_t nbBuilds() const { return _builds; }
+
+
+            /** Reset the hit and build counters. */
+            void resetStats() { _hits = 0; _builds = 0; }
+
+
+        private:
+
+            /** key of a tessellation */
+            static constexpr uint32_t _key(int nb_sectors, int nb_stacks, bool textured) { return (((uint32_t)nb_sectors) << 16) | (((uint32_t)nb_stacks) << 1) | ((textured) ? 1 : 0); }
+
+            struct Slot
+                {
+                Mesh3D<color_t> mesh;           // mesh built in the slot memory
+                uint32_t key;                   // key of the mesh (0 if the slot is empty)
+                uint32_t last_use;              // time of the last use (for the LRU)
+                };
+
+            struct Static
+                {
+                const Mesh3D<color_t>* mesh;    // constant mesh
+                uint32_t key;                   // key of the mesh
+                };
+
+            uint8_t* _buffer;                   // memory of the slots
+            int _slot_size;                     // size of a slot in bytes
+            int _nb_slots;                      // number of slots
+            int _nb_static;                     // number of static meshes
+            uint32_t _time;                     // use counter (for the LRU)
+            uint32_t _hits;                     // number of hits
+            uint32_t _builds;                   // number of meshes built
+            Slot _slots[MAX_SLOTS];             // slots
+            Static _static[MAX_STATIC];         // static meshes
+        };
+
+
+}
+
+
+#include "SphereMesh3D.inl"
+
+
+#endif
+
+#endif
+
+/** end of file */
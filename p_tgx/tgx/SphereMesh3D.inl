@@ -0,0 +1,198 @@
+/** @file SphereMesh3D.inl */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+#ifndef _TGX_SPHEREMESH3D_INL_
+#define _TGX_SPHEREMESH3D_INL_
+
+
+namespace tgx
+    {
+
+
+    template<typename color_t>
+    bool buildSphereMesh(Mesh3D<color_t>* mesh, int nb_sectors, int nb_stacks, bool textured, void* buffer, int buffer_size)
+        {
+        if ((mesh == nullptr) || (buffer == nullptr)) return false;
+        if ((nb_sectors < 3) || (nb_sectors > 256) || (nb_stacks < 3)) return false;
+        const int nv = sphereMeshNbVertices(nb_sectors, nb_stacks);
+        if ((nv > 32767) || (buffer_size < sphereMeshSize(nb_sectors, nb_stacks, textured))) return false;
+        const int nt = sphereMeshNbTexcoords(nb_sectors, nb_stacks, textured);
+        fVec3* vert = (fVec3*)buffer;
+        fVec2* tex = (fVec2*)(vert + nv);
+        uint16_t* face = (uint16_t*)(tex + nt);
+
+        // vertices: north pole, the rings from north to south, south pole.
+        // texcoords: the poles, then nb_sectors + 1 columns per ring (the first and last columns
+        // are the same vertex, on the seam at the last sector).
+        const float MPI = 3.141592653589793238f;
+        const float d_sector = 2 * MPI / nb_sectors;
+        const float d_stack = MPI / nb_stacks;
+        vert[0] = fVec3(0, 1, 0);
+        vert[nv - 1] = fVec3(0, -1, 0);
+        for (int j = 1; j < nb_stacks; j++)
+            {
+            const float cosPhi = cosf(d_stack * j);
+            const float sinPhi = sinf(d_stack * j);
+            fVec3* ring = vert + 1 + (j - 1) * nb_sectors;
+            for (int i = 0; i < nb_sectors; i++) ring[i] = fVec3(sinPhi * cosf(i * d_sector), cosPhi, sinPhi * sinf(i * d_sector));
+            if (textured)
+                {
+                fVec2* T = tex + 2 + (j - 1) * (nb_sectors + 1);
+                const float v = 0.5f * cosPhi + 0.5f;
+                for (int c = 0; c <= nb_sectors; c++) T[c] = fVec2(((float)c) / nb_sectors, v);
+                }
+            }
+        if (textured)
+            {
+            tex[0] = fVec2(0, 1);
+            tex[1] = fVec2(0, 0);
+            }
+
+        // faces: one chain per stack (fans for the caps, strips in between), with the same
+        // winding as Renderer3D::drawSphere(). The normal index is the vertex index.
+        uint16_t* f = face;
+        auto put = [&](int v, int t, bool dbit)
+            {
+            *(f++) = (uint16_t)(v | ((dbit) ? 32768 : 0));
+            if (textured) *(f++) = (uint16_t)t;
+            *(f++) = (uint16_t)v;
+            };
+        auto vcol = [&](int j, int c) { return 1 + (j - 1) * nb_sectors + ((c + nb_sectors - 1) % nb_sectors); };
+        auto tcol = [&](int j, int c) { return 2 + (j - 1) * (nb_sectors + 1) + c; };
+
+        // north cap: triangles (N, C[c], C[c-1]) for c = nb_sectors down to 1
+        *(f++) = (uint16_t)nb_sectors;
+        put(0, 0, false);
+        for (int c = nb_sectors; c >= 0; c--) put(vcol(1, c), tcol(1, c), false);
+
+        // stacks: triangles (A[c-1], A[c], B[c-1]) and (A[c], B[c], B[c-1]) between rings A and B
+        for (int j = 1; j < nb_stacks - 1; j++)
+            {
+            *(f++) = (uint16_t)(2 * nb_sectors);
+            put(vcol(j, 0), tcol(j, 0), false);
+            put(vcol(j, 1), tcol(j, 1), false);
+            put(vcol(j + 1, 0), tcol(j + 1, 0), false);
+            put(vcol(j + 1, 1), tcol(j + 1, 1), true);
+            for (int c = 2; c <= nb_sectors; c++)
+                {
+                put(vcol(j, c), tcol(j, c), true);
+                put(vcol(j + 1, c), tcol(j + 1, c), false);
+                }
+            }
+
+        // south cap: triangles (S, C[c-1], C[c]) for c = 1 to nb_sectors
+        *(f++) = (uint16_t)nb_sectors;
+        put(nv - 1, 1, false);
+        for (int c = 0; c <= nb_sectors; c++) put(vcol(nb_stacks - 1, c), tcol(nb_stacks - 1, c), false);
+        *(f++) = 0;
+
+        mesh->id = 1;
+        mesh->nb_vertices = (uint16_t)nv;
+        mesh->nb_texcoords = (uint16_t)nt;
+        mesh->nb_normals = (uint16_t)nv;
+        mesh->nb_faces = (uint16_t)(2 * nb_sectors * (nb_stacks - 1));
+        mesh->len_face = (uint16_t)(f - face);
+        mesh->vertice = vert;
+        mesh->texcoord = (textured) ? tex : nullptr;
+        mesh->normal = vert;
+        mesh->face = face;
+        mesh->texture = nullptr;
+        mesh->color = RGBf(1.0f, 1.0f, 1.0f);
+        mesh->ambiant_strength = 0.2f;
+        mesh->diffuse_strength = 0.7f;
+        mesh->specular_strength = 0.5f;
+        mesh->specular_exponent = 16;
+        mesh->next = nullptr;
+        mesh->bounding_box = fBox3(-1, 1, -1, 1, -1, 1);
+        mesh->name = "sphere";
+        mesh->nb_clusters = 0;
+        mesh->cluster = nullptr;
+        return true;
+        }
+
+
+
+    template<typename color_t>
+    SphereMeshCache<color_t>::SphereMeshCache(void* buffer, int buffer_size, int nb_slots)
+        : _buffer(nullptr), _slot_size(0), _nb_slots(clamp(nb_slots, 1, MAX_SLOTS)), _nb_static(0), _time(0), _hits(0), _builds(0)
+        {
+        if ((buffer) && (buffer_size > 0))
+            { // align the slots on 4 bytes
+            const int skip = (int)((4 - (((uintptr_t)buffer) & 3)) & 3);
+            _buffer = ((uint8_t*)buffer) + skip;
+            _slot_size = ((buffer_size - skip) / _nb_slots) & (~3);
+            if (_slot_size < 0) _slot_size = 0;
+            }
+        clear();
+        }
+
+
+    template<typename color_t>
+    bool SphereMeshCache<color_t>::addStatic(const Mesh3D<color_t>* mesh, int nb_sectors, int nb_stacks, bool textured)
+        {
+        if ((mesh == nullptr) || (_nb_static >= MAX_STATIC)) return false;
+        _static[_nb_static].mesh = mesh;
+        _static[_nb_static].key = _key(nb_sectors, nb_stacks, textured);
+        _nb_static++;
+        return true;
+        }
+
+
+    template<typename color_t>
+    const Mesh3D<color_t>* SphereMeshCache<color_t>::get(int nb_sectors, int nb_stacks, bool textured)
+        {
+        const uint32_t key = _key(nb_sectors, nb_stacks, textured);
+        for (int k = 0; k < _nb_static; k++)
+            {
+            if (_static[k].key == key) { _hits++; return _static[k].mesh; }
+            }
+        int lru = 0;
+        for (int k = 0; k < _nb_slots; k++)
+            {
+            if (_slots[k].key == key)
+                {
+                _slots[k].last_use = ++_time;
+                _hits++;
+                return &_slots[k].mesh;
+                }
+            if (_slots[k].last_use < _slots[lru].last_use) lru = k; // empty slots have last_use = 0
+            }
+        if (sphereMeshSize(nb_sectors, nb_stacks, textured) > _slot_size) return nullptr;
+        Slot& S = _slots[lru];
+        S.key = 0;
+        S.last_use = 0;
+        if (!buildSphereMesh(&S.mesh, nb_sectors, nb_stacks, textured, _buffer + lru * _slot_size, _slot_size)) return nullptr;
+        S.key = key;
+        S.last_use = ++_time;
+        _builds++;
+        return &S.mesh;
+        }
+
+
+    template<typename color_t>
+    void SphereMeshCache<color_t>::clear()
+        {
+        for (int k = 0; k < MAX_SLOTS; k++)
+            {
+            _slots[k].key = 0;
+            _slots[k].last_use = 0;
+            }
+        }
+
+
+    }
+
+#endif
+
+/** end of file */
@@ -0,0 +1,366 @@
+/**
+ * @file VertexBatch.h
+ * Batched (structure of arrays) vertex transform, projection and lighting kernels.
+ */
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+//version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef _TGX_VERTEXBATCH_H_
+#define _TGX_VERTEXBATCH_H_
+
+// only C++, no plain C
+#ifdef __cplusplus
+
+
+#include "Misc.h"
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Mat4.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+/**
+* SIMD instruction set used by the batch kernels:
+* - 1 : SSE2 (x86 hosts)
+* - 2 : NEON (ARM hosts, Cortex-A)
+* - 0 : plain C++, unrolled two vertices at a time (MCUs with a scalar FPU such as the Cortex-M33 of the RP2350).
+*
+* Detected automatically. Define it to 0 before including tgx to force the plain C++ version.
+*/
+#ifndef TGX_VERTEX_BATCH_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+        #define TGX_VERTEX_BATCH_SIMD 1
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define TGX_VERTEX_BATCH_SIMD 2
+    #else
+        #define TGX_VERTEX_BATCH_SIMD 0
+    #endif
+#endif
+
+#if (TGX_VERTEX_BATCH_SIMD == 1)
+    #include <emmintrin.h>
+#elif (TGX_VERTEX_BATCH_SIMD == 2)
+    #include <arm_neon.h>
+#endif
+
+
+namespace tgx
+{
+
+
+    /**
+    * Transform a whole array of positions by a matrix: (x[i], y[i], z[i], w[i]) = M * (V[i], 1).
+    *
+    * Same result as calling `M.mult1(V[i])` for each vertex (the operations are performed in the
+    * same order) but the output is stored as a structure of arrays.
+    *
+    * @param       M           transformation matrix (the model-view matrix for a mesh).
+    * @param       V           array of n positions.
+    * @param       n           number of positions.
+    * @param[out]  x,y,z,w     output arrays of size at least n.
+    */
+    void batchTransform(const fMat4& M, const fVec3* V, int n, float* x, float* y, float* z, float* w);
+
+
+    /**
+    * Project a whole array of positions in view space and compute their clipping outcodes.
+    *
+    * For each vertex, Q = M * P followed by the perspective divide (or w = 1 - z for an orthographic
+    * projection), exactly as the per vertex code of `Renderer3D`. The outcode has bit 0 set if the
+    * vertex is behind the camera (P.z >= 0), bits 1-4 set if Q.x / Q.y are below / above the
+    * [-clipbound_xy, clipbound_xy] range and bits 5-6 if Q.z is outside of [-1, 1].
+    *
+    * @param       M                   projection matrix.
+    * @param       ortho               true for an orthographic projection.
+    * @param       clipbound_xy        bound used for the x and y coordinates in the outcode.
+    * @param       n                   number of positions.
+    * @param       px,py,pz,pw         input arrays (positions in view space).
+    * @param[out]  qx,qy,qz,qw         output arrays (projected positions).
+    * @param[out]  outcode             output array (clipping outcodes).
+    */
+    void batchProject(const fMat4& M, bool ortho, float clipbound_xy, int n,
+                      const float* px, const float* py, const float* pz, const float* pw,
+                      float* qx, float* qy, float* qz, float* qw, uint8_t* outcode);
+
+
+    /**
+    * Rotate a whole array of normals and compute their dot products with two vectors:
+    * d1[i] = dotProduct(M.mult0(N[i]), L1) and d2[i] = dotProduct(M.mult0(N[i]), L2).
+    *
+    * Used for the diffuse and specular terms of the lighting (L1 = light, L2 = halfway vector).
+    *
+    * @param       M       transformation matrix (only the 3x3 upper left part is used).
+    * @param       N       array of n normals.
+    * @param       n       number of normals.
+    * @param       L1, L2  vectors to compute the dot products with.
+    * @param[out]  d1, d2  output arrays of size at least n.
+    */
+    void batchNormalDots(const fMat4& M, const fVec3* N, int n, const fVec3& L1, const fVec3& L2, float* d1, float* d2);
+
+
+
+
+
+#ifndef DOXYGEN_EXCLUDE
+
+    /** projection and outcode of a single vertex (tail of the SIMD loops and plain C++ version) */
+    TGX_INLINE inline void _batchProject1(const fMat4& M, bool ortho, float cb, const float px, const float py, const float pz, const float pw,
+                                          float& qx, float& qy, float& qz, float& qw, uint8_t& outcode)
+        {
+        fVec4 Q = M * fVec4(px, py, pz, pw);
+        if (ortho) { Q.w = 1.0f - Q.z; } else { Q.zdivide(); }
+        qx = Q.x; qy = Q.y; qz = Q.z; qw = Q.w;
+        outcode = (uint8_t)(((pz >= 0) ? 1 : 0)
+                          | ((Q.x < -cb) ? 2 : 0) | ((Q.x > cb) ? 4 : 0)
+                          | ((Q.y < -cb) ? 8 : 0) | ((Q.y > cb) ? 16 : 0)
+                          | ((Q.z < -1) ? 32 : 0) | ((Q.z > 1) ? 64 : 0));
+        }
+
+#endif
+
+
+
+    inline void batchTransform(const fMat4& M, const fVec3* V, int n, float* x, float* y, float* z, float* w)
+        {
+        int i = 0;
+#if (TGX_VERTEX_BATCH_SIMD == 1)
+        const __m128 m0 = _mm_set1_ps(M.M[0]), m1 = _mm_set1_ps(M.M[1]), m2 = _mm_set1_ps(M.M[2]), m3 = _mm_set1_ps(M.M[3]);
+        const __m128 m4 = _mm_set1_ps(M.M[4]), m5 = _mm_set1_ps(M.M[5]), m6 = _mm_set1_ps(M.M[6]), m7 = _mm_set1_ps(M.M[7]);
+        const __m128 m8 = _mm_set1_ps(M.M[8]), m9 = _mm_set1_ps(M.M[9]), m10 = _mm_set1_ps(M.M[10]), m11 = _mm_set1_ps(M.M[11]);
+        const __m128 m12 = _mm_set1_ps(M.M[12]), m13 = _mm_set1_ps(M.M[13]), m14 = _mm_set1_ps(M.M[14]), m15 = _mm_set1_ps(M.M[15]);
+        for (; i + 4 <= n; i += 4)
+            {
+            const __m128 vx = _mm_set_ps(V[i + 3].x, V[i + 2].x, V[i + 1].x, V[i].x);
+            const __m128 vy = _mm_set_ps(V[i + 3].y, V[i + 2].y, V[i + 1].y, V[i].y);
+            const __m128 vz = _mm_set_ps(V[i + 3].z, V[i + 2].z, V[i + 1].z, V[i].z);
+            _mm_storeu_ps(x + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, vx), _mm_mul_ps(m4, vy)), _mm_mul_ps(m8, vz)), m12));
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, vx), _mm_mul_ps(m5, vy)), _mm_mul_ps(m9, vz)), m13));
+            _mm_storeu_ps(z + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, vx), _mm_mul_ps(m6, vy)), _mm_mul_ps(m10, vz)), m14));
+            _mm_storeu_ps(w + i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, vx), _mm_mul_ps(m7, vy)), _mm_mul_ps(m11, vz)), m15));
+            }
+#elif (TGX_VERTEX_BATCH_SIMD == 2)
+        const float32x4_t m0 = vdupq_n_f32(M.M[0]), m1 = vdupq_n_f32(M.M[1]), m2 = vdupq_n_f32(M.M[2]), m3 = vdupq_n_f32(M.M[3]);
+        const float32x4_t m4 = vdupq_n_f32(M.M[4]), m5 = vdupq_n_f32(M.M[5]), m6 = vdupq_n_f32(M.M[6]), m7 = vdupq_n_f32(M.M[7]);
+        const float32x4_t m8 = vdupq_n_f32(M.M[8]), m9 = vdupq_n_f32(M.M[9]), m10 = vdupq_n_f32(M.M[10]), m11 = vdupq_n_f32(M.M[11]);
+        const float32x4_t m12 = vdupq_n_f32(M.M[12]), m13 = vdupq_n_f32(M.M[13]), m14 = vdupq_n_f32(M.M[14]), m15 = vdupq_n_f32(M.M[15]);
+        for (; i + 4 <= n; i += 4)
+            {
+            const float32x4x3_t v = vld3q_f32((const float*)(V + i)); // deinterleave x, y, z
+            vst1q_f32(x + i, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m0, v.val[0]), vmulq_f32(m4, v.val[1])), vmulq_f32(m8, v.val[2])), m12));
+            vst1q_f32(y + i, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m1, v.val[0]), vmulq_f32(m5, v.val[1])), vmulq_f32(m9, v.val[2])), m13));
+            vst1q_f32(z + i, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m2, v.val[0]), vmulq_f32(m6, v.val[1])), vmulq_f32(m10, v.val[2])), m14));
+            vst1q_f32(w + i, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m3, v.val[0]), vmulq_f32(m7, v.val[1])), vmulq_f32(m11, v.val[2])), m15));
+            }
+#else
+        // two vertices per iteration: the 12 coefficients, the 6 inputs and the 8 outputs fit
+        // in the 32 single precision registers of the FPU and the independent multiply-adds of
+        // both vertices interleave, hiding the latency of the FPU pipeline.
+        const float m0 = M.M[0], m1 = M.M[1], m2 = M.M[2], m3 = M.M[3];
+        const float m4 = M.M[4], m5 = M.M[5], m6 = M.M[6], m7 = M.M[7];
+        const float m8 = M.M[8], m9 = M.M[9], m10 = M.M[10], m11 = M.M[11];
+        const float m12 = M.M[12], m13 = M.M[13], m14 = M.M[14], m15 = M.M[15];
+        for (; i + 2 <= n; i += 2)
+            {
+            const float ax = V[i].x, ay = V[i].y, az = V[i].z;
+            const float bx = V[i + 1].x, by = V[i + 1].y, bz = V[i + 1].z;
+            x[i] = m0 * ax + m4 * ay + m8 * az + m12;   x[i + 1] = m0 * bx + m4 * by + m8 * bz + m12;
+            y[i] = m1 * ax + m5 * ay + m9 * az + m13;   y[i + 1] = m1 * bx + m5 * by + m9 * bz + m13;
+            z[i] = m2 * ax + m6 * ay + m10 * az + m14;  z[i + 1] = m2 * bx + m6 * by + m10 * bz + m14;
+            w[i] = m3 * ax + m7 * ay + m11 * az + m15;  w[i + 1] = m3 * bx + m7 * by + m11 * bz + m15;
+            }
+#endif
+        for (; i < n; i++)
+            {
+            const fVec4 P = M.mult1(V[i]);
+            x[i] = P.x; y[i] = P.y; z[i] = P.z; w[i] = P.w;
+            }
+        }
+
+
+    inline void batchProject(const fMat4& M, bool ortho, float clipbound_xy, int n,
+                             const float* px, const float* py, const float* pz, const float* pw,
+                             float* qx, float* qy, float* qz, float* qw, uint8_t* outcode)
+        {
+        int i = 0;
+#if (TGX_VERTEX_BATCH_SIMD == 1)
+        const __m128 m0 = _mm_set1_ps(M.M[0]), m1 = _mm_set1_ps(M.M[1]), m2 = _mm_set1_ps(M.M[2]), m3 = _mm_set1_ps(M.M[3]);
+        const __m128 m4 = _mm_set1_ps(M.M[4]), m5 = _mm_set1_ps(M.M[5]), m6 = _mm_set1_ps(M.M[6]), m7 = _mm_set1_ps(M.M[7]);
+        const __m128 m8 = _mm_set1_ps(M.M[8]), m9 = _mm_set1_ps(M.M[9]), m10 = _mm_set1_ps(M.M[10]), m11 = _mm_set1_ps(M.M[11]);
+        const __m128 m12 = _mm_set1_ps(M.M[12]), m13 = _mm_set1_ps(M.M[13]), m14 = _mm_set1_ps(M.M[14]), m15 = _mm_set1_ps(M.M[15]);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), mone = _mm_set1_ps(-1.0f);
+        const __m128 cb = _mm_set1_ps(clipbound_xy), mcb = _mm_set1_ps(-clipbound_xy);
+        for (; i + 4 <= n; i += 4)
+            {
+            const __m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i), z = _mm_loadu_ps(pz + i), w = _mm_loadu_ps(pw + i);
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m8, z)), _mm_mul_ps(m12, w));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m9, z)), _mm_mul_ps(m13, w));
+            __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_mul_ps(m10, z)), _mm_mul_ps(m14, w));
+            __m128 rw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m7, y)), _mm_mul_ps(m11, z)), _mm_mul_ps(m15, w));
+            if (ortho)
+                {
+                rw = _mm_sub_ps(one, rz);
+                }
+            else
+                { // same as fast_inv(): 1/w, or 1 if w = 0
+                const __m128 w0 = _mm_cmpeq_ps(rw, zero);
+                const __m128 iw = _mm_or_ps(_mm_and_ps(w0, one), _mm_andnot_ps(w0, _mm_div_ps(one, rw)));
+                rx = _mm_mul_ps(iw, rx);
+                ry = _mm_mul_ps(iw, ry);
+                rz = _mm_mul_ps(iw, rz);
+                rw = iw;
+                }
+            _mm_storeu_ps(qx + i, rx);
+            _mm_storeu_ps(qy + i, ry);
+            _mm_storeu_ps(qz + i, rz);
+            _mm_storeu_ps(qw + i, rw);
+            __m128i oc = _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(z, zero)), _mm_set1_epi32(1));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(rx, mcb)), _mm_set1_epi32(2)));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(rx, cb)), _mm_set1_epi32(4)));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(ry, mcb)), _mm_set1_epi32(8)));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(ry, cb)), _mm_set1_epi32(16)));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(rz, mone)), _mm_set1_epi32(32)));
+            oc = _mm_or_si128(oc, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(rz, one)), _mm_set1_epi32(64)));
+            oc = _mm_packs_epi32(oc, oc);   // 4 x 32 bits -> 4 x 16 bits
+            oc = _mm_packus_epi16(oc, oc);  // -> 4 x 8 bits
+            const int32_t oc4 = _mm_cvtsi128_si32(oc);
+            memcpy(outcode + i, &oc4, 4);
+            }
+#elif (TGX_VERTEX_BATCH_SIMD == 2)
+        const float32x4_t m0 = vdupq_n_f32(M.M[0]), m1 = vdupq_n_f32(M.M[1]), m2 = vdupq_n_f32(M.M[2]), m3 = vdupq_n_f32(M.M[3]);
+        const float32x4_t m4 = vdupq_n_f32(M.M[4]), m5 = vdupq_n_f32(M.M[5]), m6 = vdupq_n_f32(M.M[6]), m7 = vdupq_n_f32(M.M[7]);
+        const float32x4_t m8 = vdupq_n_f32(M.M[8]), m9 = vdupq_n_f32(M.M[9]), m10 = vdupq_n_f32(M.M[10]), m11 = vdupq_n_f32(M.M[11]);
+        const float32x4_t m12 = vdupq_n_f32(M.M[12]), m13 = vdupq_n_f32(M.M[13]), m14 = vdupq_n_f32(M.M[14]), m15 = vdupq_n_f32(M.M[15]);
+        const float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f), mone = vdupq_n_f32(-1.0f);
+        const float32x4_t cb = vdupq_n_f32(clipbound_xy), mcb = vdupq_n_f32(-clipbound_xy);
+        for (; i + 4 <= n; i += 4)
+            {
+            const float32x4_t x = vld1q_f32(px + i), y = vld1q_f32(py + i), z = vld1q_f32(pz + i), w = vld1q_f32(pw + i);
+            float32x4_t rx = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m0, x), vmulq_f32(m4, y)), vmulq_f32(m8, z)), vmulq_f32(m12, w));
+            float32x4_t ry = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m1, x), vmulq_f32(m5, y)), vmulq_f32(m9, z)), vmulq_f32(m13, w));
+            float32x4_t rz = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m2, x), vmulq_f32(m6, y)), vmulq_f32(m10, z)), vmulq_f32(m14, w));
+            float32x4_t rw = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m3, x), vmulq_f32(m7, y)), vmulq_f32(m11, z)), vmulq_f32(m15, w));
+            if (ortho)
+                {
+                rw = vsubq_f32(one, rz);
+                }
+            else
+                { // same as fast_inv(): 1/w, or 1 if w = 0
+    #if defined(__aarch64__)
+                float32x4_t iw = vdivq_f32(one, rw);
+    #else
+                float32x4_t iw = vrecpeq_f32(rw); // estimate + 2 Newton-Raphson steps
+                iw = vmulq_f32(vrecpsq_f32(rw, iw), iw);
+                iw = vmulq_f32(vrecpsq_f32(rw, iw), iw);
+    #endif
+                iw = vbslq_f32(vceqq_f32(rw, zero), one, iw);
+                rx = vmulq_f32(iw, rx);
+                ry = vmulq_f32(iw, ry);
+                rz = vmulq_f32(iw, rz);
+                rw = iw;
+                }
+            vst1q_f32(qx + i, rx);
+            vst1q_f32(qy + i, ry);
+            vst1q_f32(qz + i, rz);
+            vst1q_f32(qw + i, rw);
+            uint32x4_t oc = vandq_u32(vcgeq_f32(z, zero), vdupq_n_u32(1));
+            oc = vorrq_u32(oc, vandq_u32(vcltq_f32(rx, mcb), vdupq_n_u32(2)));
+            oc = vorrq_u32(oc, vandq_u32(vcgtq_f32(rx, cb), vdupq_n_u32(4)));
+            oc = vorrq_u32(oc, vandq_u32(vcltq_f32(ry, mcb), vdupq_n_u32(8)));
+            oc = vorrq_u32(oc, vandq_u32(vcgtq_f32(ry, cb), vdupq_n_u32(16)));
+            oc = vorrq_u32(oc, vandq_u32(vcltq_f32(rz, mone), vdupq_n_u32(32)));
+            oc = vorrq_u32(oc, vandq_u32(vcgtq_f32(rz, one), vdupq_n_u32(64)));
+            outcode[i] = (uint8_t)vgetq_lane_u32(oc, 0);
+            outcode[i + 1] = (uint8_t)vgetq_lane_u32(oc, 1);
+            outcode[i + 2] = (uint8_t)vgetq_lane_u32(oc, 2);
+            outcode[i + 3] = (uint8_t)vgetq_lane_u32(oc, 3);
+            }
+#endif
+        for (; i < n; i++)
+            {
+            _batchProject1(M, ortho, clipbound_xy, px[i], py[i], pz[i], pw[i], qx[i], qy[i], qz[i], qw[i], outcode[i]);
+            }
+        }
+
+
+    inline void batchNormalDots(const fMat4& M, const fVec3* N, int n, const fVec3& L1, const fVec3& L2, float* d1, float* d2)
+        {
+        int i = 0;
+#if (TGX_VERTEX_BATCH_SIMD == 1)
+        const __m128 m0 = _mm_set1_ps(M.M[0]), m1 = _mm_set1_ps(M.M[1]), m2 = _mm_set1_ps(M.M[2]);
+        const __m128 m4 = _mm_set1_ps(M.M[4]), m5 = _mm_set1_ps(M.M[5]), m6 = _mm_set1_ps(M.M[6]);
+        const __m128 m8 = _mm_set1_ps(M.M[8]), m9 = _mm_set1_ps(M.M[9]), m10 = _mm_set1_ps(M.M[10]);
+        const __m128 ax = _mm_set1_ps(L1.x), ay = _mm_set1_ps(L1.y), az = _mm_set1_ps(L1.z);
+        const __m128 bx = _mm_set1_ps(L2.x), by = _mm_set1_ps(L2.y), bz = _mm_set1_ps(L2.z);
+        for (; i + 4 <= n; i += 4)
+            {
+            const __m128 vx = _mm_set_ps(N[i + 3].x, N[i + 2].x, N[i + 1].x, N[i].x);
+            const __m128 vy = _mm_set_ps(N[i + 3].y, N[i + 2].y, N[i + 1].y, N[i].y);
+            const __m128 vz = _mm_set_ps(N[i + 3].z, N[i + 2].z, N[i + 1].z, N[i].z);
+            const __m128 nx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, vx), _mm_mul_ps(m4, vy)), _mm_mul_ps(m8, vz));
+            const __m128 ny = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, vx), _mm_mul_ps(m5, vy)), _mm_mul_ps(m9, vz));
+            const __m128 nz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, vx), _mm_mul_ps(m6, vy)), _mm_mul_ps(m10, vz));
+            _mm_storeu_ps(d1 + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, ax), _mm_mul_ps(ny, ay)), _mm_mul_ps(nz, az)));
+            _mm_storeu_ps(d2 + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, bx), _mm_mul_ps(ny, by)), _mm_mul_ps(nz, bz)));
+            }
+#elif (TGX_VERTEX_BATCH_SIMD == 2)
+        const float32x4_t m0 = vdupq_n_f32(M.M[0]), m1 = vdupq_n_f32(M.M[1]), m2 = vdupq_n_f32(M.M[2]);
+        const float32x4_t m4 = vdupq_n_f32(M.M[4]), m5 = vdupq_n_f32(M.M[5]), m6 = vdupq_n_f32(M.M[6]);
+        const float32x4_t m8 = vdupq_n_f32(M.M[8]), m9 = vdupq_n_f32(M.M[9]), m10 = vdupq_n_f32(M.M[10]);
+        const float32x4_t ax = vdupq_n_f32(L1.x), ay = vdupq_n_f32(L1.y), az = vdupq_n_f32(L1.z);
+        const float32x4_t bx = vdupq_n_f32(L2.x), by = vdupq_n_f32(L2.y), bz = vdupq_n_f32(L2.z);
+        for (; i + 4 <= n; i += 4)
+            {
+            const float32x4x3_t v = vld3q_f32((const float*)(N + i)); // deinterleave x, y, z
+            const float32x4_t nx = vaddq_f32(vaddq_f32(vmulq_f32(m0, v.val[0]), vmulq_f32(m4, v.val[1])), vmulq_f32(m8, v.val[2]));
+            const float32x4_t ny = vaddq_f32(vaddq_f32(vmulq_f32(m1, v.val[0]), vmulq_f32(m5, v.val[1])), vmulq_f32(m9, v.val[2]));
+            const float32x4_t nz = vaddq_f32(vaddq_f32(vmulq_f32(m2, v.val[0]), vmulq_f32(m6, v.val[1])), vmulq_f32(m10, v.val[2]));
+            vst1q_f32(d1 + i, vaddq_f32(vaddq_f32(vmulq_f32(nx, ax), vmulq_f32(ny, ay)), vmulq_f32(nz, az)));
+            vst1q_f32(d2 + i, vaddq_f32(vaddq_f32(vmulq_f32(nx, bx), vmulq_f32(ny, by)), vmulq_f32(nz, bz)));
+            }
+#else
+        // two normals per iteration (see batchTransform()).
+        const float m0 = M.M[0], m1 = M.M[1], m2 = M.M[2];
+        const float m4 = M.M[4], m5 = M.M[5], m6 = M.M[6];
+        const float m8 = M.M[8], m9 = M.M[9], m10 = M.M[10];
+        for (; i + 2 <= n; i += 2)
+            {
+            const float ax = N[i].x, ay = N[i].y, az = N[i].z;
+            const float bx = N[i + 1].x, by = N[i + 1].y, bz = N[i + 1].z;
+            const float anx = m0 * ax + m4 * ay + m8 * az, bnx = m0 * bx + m4 * by + m8 * bz;
+            const float any = m1 * ax + m5 * ay + m9 * az, bny = m1 * bx + m5 * by + m9 * bz;
+            const float anz = m2 * ax + m6 * ay + m10 * az, bnz = m2 * bx + m6 * by + m10 * bz;
+            d1[i] = anx * L1.x + any * L1.y + anz * L1.z;  d1[i + 1] = bnx * L1.x + bny * L1.y + bnz * L1.z;
+            d2[i] = anx * L2.x + any * L2.y + anz * L2.z;  d2[i + 1] = bnx * L2.x + bny * L2.y + bnz * L2.z;
+            }
+#endif
+        for (; i < n; i++)
+            {
+            const fVec3 NN = M.mult0(N[i]);
+            d1[i] = dotProduct(NN, L1);
+            d2[i] = dotProduct(NN, L2);
+            }
+        }
+
+
+}
+
+
+#endif
+
+#endif
+
+/** end of file */
+
@@ -0,0 +1,28 @@
+//
+// texture [bunny_fig] - RGB565 big endian (wire order) version of bunny_fig_texture.h
+//
+// The pixels are byte-swapped at compile time from bunny_fig_texture_data so the
+// converted texture is constant data (in flash) and no second copy of the image
+// is stored in the sources.
+//
+#pragma once
+
+#include <tgx.h>
+#include "bunny_fig_texture.h"
+
+
+struct _bunny_fig_texture_be_t
+    {
+    uint16_t data[256*256];
+
+    constexpr _bunny_fig_texture_be_t(const uint16_t * src) : data()
+        {
+        for (int i = 0; i < 256*256; i++) data[i] = (uint16_t)((src[i] >> 8) | (src[i] << 8));
+        }
+    };
+
+constexpr _bunny_fig_texture_be_t bunny_fig_texture_be_data(bunny_fig_texture_data);
+
+const tgx::Image<tgx::RGB565BE> bunny_fig_texture_be((void*)bunny_fig_texture_be_data.data, 256, 256);
+
+/** end of file bunny_fig_texture_be.h */
@@ -38,6 +38,10 @@
 #include "Color.h"
 #include "Image.h"
 #include "Mesh3D.h"
+#include "Scene3D.h"
+#include "RenderQueue3D.h"
+#include "Particles3D.h"
+#include "SphereMesh3D.h"
 #include "Renderer3D.h"
 
 #endif